@@ -28,6 +28,10 @@
 #include <sys/select.h>
 #include <unistd.h>
 
+#if defined (__SSE2__)
+#include <immintrin.h>
+#endif
+
 #include "AbstractConnection.h"
 #include "Utils.h"
 
@@ -43,9 +47,9 @@ using std::setw;
 
 //! Get the next packet from the RSP connection
 
-//! Modeled on the stub version supplied with GDB. This allows the user to
-//! replace the character read function, which is why we get stuff a character
-//! at at time.
+//! Modeled on the stub version supplied with GDB. The body is taken from the
+//! receive buffer a run at a time, up to the next '$' or '#', with the
+//! checksum computed as the run is scanned.
 
 //! Unlike the reference implementation, we don't deal with sequence
 //! numbers. GDB has never used them, and this implementation is only intended
@@ -86,15 +90,34 @@ AbstractConnection::getPkt (RspPacket *pkt)
       // Read until a '#' or end of buffer is found
       checksum =  0;
       count    =  0;
+      ch       =  0;
       while (count < bufSize - 1)
 	{
-	  ch = getRspChar ();
-
-	  if (-1 == ch)
+	  if ((mRxPos == mRxLen) && !fillRxBuf (true))
 	    {
 	      return  false;		// Connection failed
 	    }
 
+	  // Take chars up to any '$' or '#', updating the checksum
+	  const char  *src   = &(mRxBuf[mRxPos]);
+	  std::size_t  avail = mRxLen - mRxPos;
+	  std::size_t  n;
+
+	  if (avail > static_cast<std::size_t> (bufSize - 1 - count))
+	    avail = bufSize - 1 - count;
+
+	  n = scanBody (src, avail, checksum);
+	  memcpy (&(pkt->data[count]), src, n);
+	  count  += n;
+	  mRxPos += n;
+
+	  if (n == avail)
+	    {
+	      continue;
+	    }
+
+	  ch = mRxBuf[mRxPos++];
+
 	  // If we hit a start of line char begin all over again
 	  if ('$' == ch)
 	    {
@@ -104,16 +127,8 @@ AbstractConnection::getPkt (RspPacket *pkt)
 	      continue;
 	    }
 
-	  // Break out if we get the end of line char
-	  if ('#' == ch)
-	    {
-	      break;
-	    }
-
-	  // Update the checksum and add the char to the buffer
-	  checksum         = checksum + (unsigned char)ch;
-	  pkt->data[count] = (char)ch;
-	  count++;
+	  // Otherwise it is the end of line char
+	  break;
 	}
 
       // Mark the end of the buffer with EOS - it's convenient for non-binary
@@ -148,7 +163,7 @@ AbstractConnection::getPkt (RspPacket *pkt)
 	    {
 	      cerr << "Warning: Bad RSP checksum: Computed 0x"
 			<< setw (2) << setfill ('0') << hex
-			<< checksum << ", received 0x" << xmitcsum
+			<< (int) checksum << ", received 0x" << (int) xmitcsum
 			<< setfill (' ') << dec << endl;
 	      if (!putRspChar ('-'))		// Failed checksum
 		{
@@ -188,6 +203,16 @@ AbstractConnection::getPkt (RspPacket *pkt)
 //! are escaped by preceding them with '}' and then XORing the character with
 //! 0x20.
 
+//! A run of the same character is run-length encoded as the character, '*'
+//! and a count of the repeats plus 29, where that is shorter, which it is
+//! for 3 repeats or more. Counts which would be '#' or '$' are not allowed,
+//! so those runs are shortened, leaving the rest to go out as they are.
+
+//! The packet is encoded once, into a buffer which is put out in one go and
+//! again if the client asks. Runs of chars which need neither escaping nor
+//! run-length encoding are found and summed into the checksum a block at a
+//! time, so only the chars around them are handled one by one.
+
 //! @param[in] pkt  The Packet to transmit
 
 //! @return  TRUE to indicate success, FALSE otherwise (means a communications
@@ -195,57 +220,75 @@ AbstractConnection::getPkt (RspPacket *pkt)
 bool
 AbstractConnection::putPkt (RspPacket *pkt)
 {
-  int  len = pkt->getLen ();
-  int  ch;				// Ack char
+  int            len      = pkt->getLen ();
+  unsigned char  checksum = 0;		// Computed checksum
+  int            count    = 0;		// Index into the buffer
+  int            ch;			// Ack char
 
-  // Construct $<packet info>#<checksum>. Repeat until the GDB client
-  // acknowledges satisfactory receipt.
-  do
+  mTxBuf.clear ();
+  mTxBuf.reserve (len + 4);
+  mTxBuf += '$';			// Start char
+
+  // Body of the packet
+  while (count < len)
     {
-      unsigned char checksum = 0;	// Computed checksum
-      int           count    = 0;	// Index into the buffer
+      // Chars which go out as they are
+      std::size_t  n = scanPlain (&(pkt->data[count]), len - count, checksum);
+
+      mTxBuf.append (&(pkt->data[count]), n);
+      count += n;
 
-      if (!putRspChar ('$'))		// Start char
+      if (count == len)
 	{
-	  return  false;		// Comms failure
+	  break;
 	}
 
+      unsigned char  ch = pkt->data[count++];
 
-      // Body of the packet
-      for (count = 0; count < len; count++)
+      // Check for escaped chars
+      if (('$' == ch) || ('#' == ch) || ('*' == ch) || ('}' == ch))
 	{
-	  unsigned char  ch = pkt->data[count];
+	  ch       ^= 0x20;
+	  checksum += (unsigned char)'}';
+	  mTxBuf   += '}';
+	}
+      else
+	{
+	  // Count the repeats which follow, up to the largest count
+	  int  rpt = 0;
 
-	  // Check for escaped chars
-	  if (('$' == ch) || ('#' == ch) || ('*' == ch) || ('}' == ch))
-	    {
-	      ch       ^= 0x20;
-	      checksum += (unsigned char)'}';
-	      if (!putRspChar ('}'))
-		{
-		  return  false;	// Comms failure
-		}
+	  while ((count + rpt < len) && (rpt < RLE_MAX_REPEATS)
+		 && (pkt->data[count + rpt] == (char) ch))
+	    rpt++;
 
-	    }
+	  if (('#' - RLE_BIAS == rpt) || ('$' - RLE_BIAS == rpt))
+	    rpt = '#' - RLE_BIAS - 1;
 
-	  checksum += ch;
-	  if (!putRspChar (ch))
+	  if (rpt >= RLE_MIN_REPEATS)
 	    {
-	      return  false;		// Comms failure
+	      unsigned char  rptCh = rpt + RLE_BIAS;
+
+	      checksum += ch + (unsigned char)'*' + rptCh;
+	      count    += rpt;
+	      mTxBuf   += ch;
+	      mTxBuf   += '*';
+	      mTxBuf   += rptCh;
+	      continue;
 	    }
 	}
 
-      if (!putRspChar ('#'))		// End char
-	{
-	  return  false;		// Comms failure
-	}
+      checksum += ch;
+      mTxBuf   += ch;
+    }
 
-      // Computed checksum
-      if (!putRspChar (Utils::hex2Char (checksum >> 4)))
-	{
-	  return  false;		// Comms failure
-	}
-      if (!putRspChar (Utils::hex2Char (checksum % 16)))
+  mTxBuf += '#';			// End char
+  mTxBuf += Utils::hex2Char (checksum >> 4);
+  mTxBuf += Utils::hex2Char (checksum % 16);
+
+  // Repeat until the GDB client acknowledges satisfactory receipt.
+  do
+    {
+      if (!putRspBytesRaw (mTxBuf.data (), mTxBuf.size ()))
 	{
 	  return  false;		// Comms failure
 	}
@@ -271,16 +314,13 @@ AbstractConnection::putPkt (RspPacket *pkt)
 
 //! Put a single character out on the RSP connection
 
-//! Potentially we can have an OS specific implemenation of the underlying
-//! routine.
-
 //! @param[in] c  The character to put out
 //! @return  TRUE if char sent OK, FALSE if not (communications failure)
 
 bool
 AbstractConnection::putRspChar (char  c)
 {
-  return  putRspCharRaw (c);
+  return  putRspBytesRaw (&c, 1);
 
 }	// putRspChar ()
 
@@ -288,74 +328,203 @@ AbstractConnection::putRspChar (char  c)
 
 //! Get a single character from the RSP connection with buffering
 
-//! Utility routine for use by other functions.  This is built on the raw
-//! read function.
-
-//! This function will first return the possibly buffered character (buffering
-//! caused by calling 'haveBreak'.  If the character read is the break
-//! character then we record this fact, and fetch the next character.
+//! Utility routine for use by other functions. The character comes from the
+//! receive buffer, which is refilled from the connection when empty.
 
 //! @return  The character received or -1 on failure
 
 int
 AbstractConnection::getRspChar ()
 {
-  int ch;
+  if ((mRxPos == mRxLen) && !fillRxBuf (true))
+    return  -1;
 
-  if (mNumGetBufChars > 1)
-    cerr << "Warning: Too many cached characters ("
-	 << dec << mNumGetBufChars << ")" << endl;
+  return  mRxBuf[mRxPos++] & 0xff;	// No sign extend!
 
-  if (mNumGetBufChars > 0)
-    {
-      ch = mGetCharBuf;
-      mNumGetBufChars = 0;
-    }
-  else
-    ch = getRspCharRaw (true);
+}	// getRspChar ()
 
-  return  ch;
 
-}	// getRspChar ()
+//! Refill the receive buffer
+
+//! Only called when the buffer is empty. Takes as many characters as the
+//! connection has, up to the size of the buffer.
+
+//! @param[in] blocking  True if the read should block.
+//! @return  TRUE if there are now characters in the buffer, FALSE on failure
+//!          or if none were available and blocking is false.
+
+bool
+AbstractConnection::fillRxBuf (bool  blocking)
+{
+  int  n = getRspBytesRaw (mRxBuf.data (), mRxBuf.size (), blocking);
+
+  if (n <= 0)
+    return  false;
+
+  mRxPos = 0;
+  mRxLen = n;
+  return  true;
+
+}	// fillRxBuf ()
 
 
 //! Have we received a break character.
 
 //! Since we only check fo this between packets, we don't have to worry about
-//! being in the middle of a packet.
-
-//! @Note  We only peek, so no character is actually consumed from the input.
+//! being in the middle of a packet. So only the next character is looked
+//! at, and it is only consumed if it is the break character.
 
 //! @return  TRUE if we have received a break character, FALSE otherwise.
 
 bool
 AbstractConnection::haveBreak ()
 {
-  if (!mHavePendingBreak
-      && mNumGetBufChars == 0)
+  // Non-blocking read to possibly get some characters.
+
+  if ((mRxPos == mRxLen) && !fillRxBuf (false))
+    return  false;
+
+  if (BREAK_CHAR == mRxBuf[mRxPos])
     {
-      // Non-blocking read to possibly get a character.
+      mRxPos++;
+      return  true;
+    }
+  else
+    return  false;
 
-      int nextChar = getRspCharRaw (false);
+}	// haveBreak ()
 
-      if (nextChar != -1)
-	{
-	  if (nextChar == BREAK_CHAR)
-	    mHavePendingBreak = true;
-	  else
-	    {
-	      mGetCharBuf = nextChar;
-	      mNumGetBufChars = 1;
-	    }
-	}
+
+//! Scan the body of a packet being received
+
+//! Finds the first '$' or '#', adding the chars before it to the
+//! checksum. Where the compiler targets SSE2, 16 chars at a time are
+//! compared against both, and if there is neither, summed with a sum of
+//! absolute differences against zero. The block with a '$' or '#' is
+//! finished one char at a time.
+
+//! @param[in]     buf       The chars to scan
+//! @param[in]     len       The number of chars to scan
+//! @param[in,out] checksum  The checksum, updated with the chars before
+//!                          any '$' or '#'.
+//! @return  The offset of the first '$' or '#', or len if there is none.
+
+std::size_t
+AbstractConnection::scanBody (const char    *buf,
+			      std::size_t    len,
+			      unsigned char &checksum)
+{
+  std::size_t   i   = 0;
+  unsigned int  sum = checksum;
+
+#if defined (__SSE2__)
+  const __m128i  dollar = _mm_set1_epi8 ('$');
+  const __m128i  hash   = _mm_set1_epi8 ('#');
+  const __m128i  zero   = _mm_setzero_si128 ();
+
+  for (; i + 16 <= len; i += 16)
+    {
+      __m128i  v = _mm_loadu_si128 ((const __m128i *) (buf + i));
+
+      if (0 != _mm_movemask_epi8 (_mm_or_si128 (_mm_cmpeq_epi8 (v, dollar),
+						_mm_cmpeq_epi8 (v, hash))))
+	break;
+
+      __m128i  s = _mm_sad_epu8 (v, zero);
+
+      sum += _mm_cvtsi128_si32 (s) + _mm_cvtsi128_si32 (_mm_srli_si128 (s, 8));
     }
+#endif
 
-  if (mHavePendingBreak)
+  for (; i < len; i++)
     {
-      mHavePendingBreak = false;
-      return true;
+      if (('$' == buf[i]) || ('#' == buf[i]))
+	break;
+
+      sum += (unsigned char) buf[i];
     }
-  else
-    return false;
 
-}	// haveBreak ()
+  checksum = sum;
+  return  i;
+
+}	// scanBody ()
+
+
+//! Scan the body of a packet to be put out
+
+//! Finds the first char which must be escaped or which starts a run worth
+//! run-length encoding, adding the chars before it to the checksum. Where
+//! the compiler targets SSE2, 16 chars at a time are compared against the
+//! chars to be escaped, and against the chars 1, 2 and 3 later to find
+//! runs. If there are none, the chars are summed with a sum of absolute
+//! differences against zero. The rest is done one char at a time.
+
+//! @param[in]     buf       The chars to scan
+//! @param[in]     len       The number of chars to scan
+//! @param[in,out] checksum  The checksum, updated with the chars before
+//!                          the one found.
+//! @return  The offset of the first char to escape or encode, or len if
+//!          there is none.
+
+std::size_t
+AbstractConnection::scanPlain (const char    *buf,
+			       std::size_t    len,
+			       unsigned char &checksum)
+{
+  std::size_t   i   = 0;
+  unsigned int  sum = checksum;
+
+#if defined (__SSE2__)
+  const __m128i  dollar = _mm_set1_epi8 ('$');
+  const __m128i  hash   = _mm_set1_epi8 ('#');
+  const __m128i  star   = _mm_set1_epi8 ('*');
+  const __m128i  brace  = _mm_set1_epi8 ('}');
+  const __m128i  zero   = _mm_setzero_si128 ();
+
+  for (; i + 16 + RLE_MIN_REPEATS <= len; i += 16)
+    {
+      __m128i  v   = _mm_loadu_si128 ((const __m128i *) (buf + i));
+      __m128i  run = _mm_cmpeq_epi8 (v, v);
+
+      for (int  r = 1; r <= RLE_MIN_REPEATS; r++)
+	run = _mm_and_si128 (run, _mm_cmpeq_epi8
+			     (v, _mm_loadu_si128 ((const __m128i *)
+						  (buf + i + r))));
+
+      __m128i  stop = _mm_or_si128 (_mm_or_si128 (_mm_cmpeq_epi8 (v, dollar),
+						  _mm_cmpeq_epi8 (v, hash)),
+				    _mm_or_si128 (_mm_cmpeq_epi8 (v, star),
+						  _mm_cmpeq_epi8 (v, brace)));
+
+      if (0 != _mm_movemask_epi8 (_mm_or_si128 (stop, run)))
+	break;
+
+      __m128i  s = _mm_sad_epu8 (v, zero);
+
+      sum += _mm_cvtsi128_si32 (s) + _mm_cvtsi128_si32 (_mm_srli_si128 (s, 8));
+    }
+#endif
+
+  for (; i < len; i++)
+    {
+      char  ch = buf[i];
+
+      if (('$' == ch) || ('#' == ch) || ('*' == ch) || ('}' == ch))
+	break;
+
+      int  rpt = 0;
+
+      while ((i + rpt + 1 < len) && (rpt < RLE_MIN_REPEATS)
+	     && (buf[i + rpt + 1] == ch))
+	rpt++;
+
+      if (RLE_MIN_REPEATS == rpt)
+	break;
+
+      sum += (unsigned char) ch;
+    }
+
+  checksum = sum;
+  return  i;
+
+}	// scanPlain ()
@@ -20,6 +20,10 @@
 #ifndef ABSTRACT_CONNECTION_H
 #define ABSTRACT_CONNECTION_H
 
+#include <cstddef>
+#include <string>
+#include <vector>
+
 #include "RspPacket.h"
 #include "TraceFlags.h"
 
@@ -29,6 +33,10 @@
 //! This class is entirely passive. It is up to the caller to determine that a
 //! packet will become available before calling ::getPkt ().
 
+//! Characters are received into a buffer as many at a time as are
+//! available, and each packet is encoded into a buffer and put out in one
+//! go, so the packet code can scan whole runs of characters at once.
+
 class AbstractConnection
 {
 public:
@@ -53,16 +61,24 @@ public:
 
   virtual bool  haveBreak ();
 
+  // Access to the underlying client socket, if there is one
+
+  virtual int   getClientFd ();
+  virtual void  setClientFd (int  fd);
+
 protected:
 
   //! Trace flags
 
   TraceFlags *traceFlags;
 
-  // Internal OS specific routines to handle individual chars.
+  // Internal OS specific routines to handle buffers of chars.
 
-  virtual bool  putRspCharRaw (char  c) = 0;
-  virtual int   getRspCharRaw (bool blocking) = 0;
+  virtual bool  putRspBytesRaw (const char  *buf,
+				std::size_t  len) = 0;
+  virtual int   getRspBytesRaw (char        *buf,
+				std::size_t  size,
+				bool         blocking) = 0;
 
 private:
 
@@ -70,20 +86,53 @@ private:
 
   static const int BREAK_CHAR = 3;
 
-  //! Has a BREAK arrived?
+  //! Run-length encoding: repeat counts are sent as a character this much
+  //! higher
+
+  static const int RLE_BIAS = 29;
+
+  //! Fewest repeats worth run-length encoding
+
+  static const int RLE_MIN_REPEATS = 3;
+
+  //! Most repeats in one run, sent as '~'
+
+  static const int RLE_MAX_REPEATS = '~' - RLE_BIAS;
+
+  //! Size of the receive buffer
+
+  static const std::size_t RX_BUF_SIZE = 64 * 1024;
+
+  //! The receive buffer
+
+  std::vector<char>  mRxBuf;
 
-  bool mHavePendingBreak;
+  //! Offset of the next char to be used in the receive buffer
 
-  //! The buffered char for get RspChar
-  int  mGetCharBuf;
+  std::size_t  mRxPos;
 
-  //! Count of how many buffered chars we have
-  int  mNumGetBufChars;
+  //! Number of chars in the receive buffer
+
+  std::size_t  mRxLen;
+
+  //! The packet being put out, kept in case it must be sent again
+
+  std::string  mTxBuf;
 
   // Internal routines to handle individual chars
 
   bool  putRspChar (char  c);
   int   getRspChar ();
+  bool  fillRxBuf (bool  blocking);
+
+  // Scanning packets
+
+  static std::size_t  scanBody (const char    *buf,
+				std::size_t    len,
+				unsigned char &checksum);
+  static std::size_t  scanPlain (const char    *buf,
+				 std::size_t    len,
+				 unsigned char &checksum);
 };	// AbstractConnection ()
 
 // Default implementation of the destructor.
@@ -97,8 +146,24 @@ AbstractConnection::~AbstractConnection ()
 inline
 AbstractConnection::AbstractConnection (TraceFlags *_traceFlags) :
   traceFlags (_traceFlags),
-  mHavePendingBreak (false),
-  mNumGetBufChars (0)
+  mRxBuf (RX_BUF_SIZE),
+  mRxPos (0),
+  mRxLen (0)
+{
+  // Nothing.
+}
+
+// Default implementation of the client socket accessors, for connections
+// which do not have a socket.
+
+inline int
+AbstractConnection::getClientFd ()
+{
+  return -1;
+}
+
+inline void
+AbstractConnection::setClientFd (int  fd __attribute__ ((unused)))
 {
   // Nothing.
 }
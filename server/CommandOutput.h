@@ -0,0 +1,123 @@
+// Output of monitor commands
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef COMMAND_OUTPUT_H
+#define COMMAND_OUTPUT_H
+
+#include <cstddef>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+
+//! A stream for the output of monitor commands.
+
+//! The text is kept in a buffer which is emptied by reset (), but keeps its
+//! memory, so once it has grown to the largest output, running a command
+//! allocates nothing more. Unlike std::ostringstream, the text can be read
+//! in place.
+
+class CommandOutput : public std::ostream
+{
+public:
+
+  //! Constructor
+
+  //! The buffer is only attached once it has been constructed.
+
+  CommandOutput ()
+    : std::ostream (nullptr)
+  {
+    rdbuf (&mBuf);
+  }
+
+  //! Forget the text, but keep the memory
+
+  //! Any formatting left by the last command is also undone.
+
+  void reset ()
+  {
+    mBuf.mText.clear ();
+    std::ostream::clear ();		// Any error state
+    flags (std::ios_base::dec | std::ios_base::skipws);
+    precision (6);
+    fill (' ');
+    width (0);
+  }
+
+  //! The text
+
+  const char *data () const
+  {
+    return mBuf.mText.data ();
+  }
+
+  //! The number of characters of text
+
+  std::size_t size () const
+  {
+    return mBuf.mText.size ();
+  }
+
+
+private:
+
+  //! The stream buffer, appending to a string
+
+  class Buf : public std::streambuf
+  {
+  public:
+
+    //! The text
+    std::string  mText;
+
+  protected:
+
+    //! Append a character
+
+    int_type overflow (int_type  c) override
+    {
+      if (!traits_type::eq_int_type (c, traits_type::eof ()))
+	mText.push_back (traits_type::to_char_type (c));
+
+      return traits_type::not_eof (c);
+    }
+
+    //! Append characters
+
+    std::streamsize xsputn (const char *s,
+			    std::streamsize  n) override
+    {
+      mText.append (s, n);
+      return n;
+    }
+  };
+
+  //! The stream buffer
+  Buf  mBuf;
+};
+
+
+#endif	// COMMAND_OUTPUT_H
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// show-trailing-whitespace: t
+// End:
@@ -0,0 +1,397 @@
+// Fork based checkpoints: implementation
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// ----------------------------------------------------------------------------
+
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "ForkCheckpoints.h"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::flush;
+using std::map;
+using std::string;
+using std::vector;
+
+
+//! Constructor
+
+ForkCheckpoints::ForkCheckpoints ()
+{
+}	// ForkCheckpoints ()
+
+
+//! Destructor
+
+//! Closing the control sockets lets any checkpoints nobody else knows about
+//! exit.
+
+ForkCheckpoints::~ForkCheckpoints ()
+{
+  closeAll ();
+
+}	// ~ForkCheckpoints ()
+
+
+//! Save a checkpoint
+
+//! Fork, with the child becoming the checkpoint. An existing checkpoint of
+//! the same name is replaced.
+
+//! The child does not return until (and unless) it is restored, when it
+//! returns RESTORED in the new live process.
+
+//! @param[in]  name         Name of the checkpoint
+//! @param[in]  clientFd     The client socket, which the checkpoint must not
+//!                          keep open
+//! @param[out] newClientFd  The client socket, if we are RESTORED
+//! @return  What happened
+
+ForkCheckpoints::SaveRes
+ForkCheckpoints::save (const string & name,
+		       int            clientFd,
+		       int &          newClientFd)
+{
+  remove (name);
+
+  if (mCheckpoints.size () >= MAX_CHECKPOINTS)
+    {
+      cerr << "Warning: Too many checkpoints: " << name << " not saved"
+	   << endl;
+      return  SaveRes::FAILED;
+    }
+
+  int  sv[2];
+
+  if (socketpair (AF_UNIX, SOCK_SEQPACKET, 0, sv) < 0)
+    {
+      cerr << "Warning: Cannot create checkpoint socket: " << strerror (errno)
+	   << endl;
+      return  SaveRes::FAILED;
+    }
+
+  // Checkpoints are never waited for, so don't leave zombies. Anything
+  // buffered must be written once, not once per process.
+  signal (SIGCHLD, SIG_IGN);
+  cout << flush;
+  cerr << flush;
+
+  pid_t  pid = fork ();
+
+  if (pid < 0)
+    {
+      cerr << "Warning: Cannot fork checkpoint: " << strerror (errno) << endl;
+      close (sv[0]);
+      close (sv[1]);
+      return  SaveRes::FAILED;
+    }
+
+  if (pid > 0)
+    {
+      // Still the live process
+      close (sv[1]);
+      mCheckpoints[name] = sv[0];
+      return  SaveRes::SAVED;
+    }
+
+  // We are the checkpoint. Let go of everything the live process uses.
+  close (sv[0]);
+  close (clientFd);
+  closeAll ();
+
+  return  waitForRestore (name, sv[1], newClientFd);
+
+}	// save ()
+
+
+//! Restore a checkpoint
+
+//! Hand over the client and all our other checkpoints. On success the caller
+//! must stop using the client and exit, since the restored process is now
+//! serving it.
+
+//! @param[in] name      Name of the checkpoint
+//! @param[in] clientFd  The client socket
+//! @return  TRUE if the checkpoint has taken over, FALSE otherwise
+
+bool
+ForkCheckpoints::restore (const string & name,
+			  int            clientFd)
+{
+  auto  it = mCheckpoints.find (name);
+
+  if (it == mCheckpoints.end ())
+    return  false;
+
+  // The client goes first, followed by the other checkpoints, whose names
+  // are sent as newline separated text.
+  vector<int>  fds;
+  string  names;
+
+  fds.push_back (clientFd);
+
+  for (auto & cp : mCheckpoints)
+    if (cp.first != name)
+      {
+	fds.push_back (cp.second);
+	names.append (cp.first);
+	names.append ("\n");
+      }
+
+  if (names.size () >= MAX_NAMES_SIZE)
+    {
+      cerr << "Warning: Checkpoint names too long to restore" << endl;
+      return  false;
+    }
+
+  vector<char>  ctrl (CMSG_SPACE (fds.size () * sizeof (int)));
+  struct iovec  iov;
+  struct msghdr  msg;
+
+  // Always send at least the terminating NUL.
+  iov.iov_base = const_cast<char *> (names.c_str ());
+  iov.iov_len = names.size () + 1;
+
+  memset (&msg, 0, sizeof (msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = ctrl.data ();
+  msg.msg_controllen = ctrl.size ();
+
+  struct cmsghdr * cmsg = CMSG_FIRSTHDR (&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN (fds.size () * sizeof (int));
+  memcpy (CMSG_DATA (cmsg), fds.data (), fds.size () * sizeof (int));
+
+  cout << flush;
+  cerr << flush;
+
+  if (sendmsg (it->second, &msg, MSG_NOSIGNAL) < 0)
+    {
+      // The checkpoint has gone away
+      cerr << "Warning: Cannot restore checkpoint " << name << ": "
+	   << strerror (errno) << endl;
+      remove (name);
+      return  false;
+    }
+
+  return  true;
+
+}	// restore ()
+
+
+//! Forget about a checkpoint
+
+//! The checkpoint process exits once no live process knows about it.
+
+//! @param[in] name  Name of the checkpoint
+//! @return  TRUE if there was such a checkpoint, FALSE otherwise
+
+bool
+ForkCheckpoints::remove (const string & name)
+{
+  auto  it = mCheckpoints.find (name);
+
+  if (it == mCheckpoints.end ())
+    return  false;
+
+  close (it->second);
+  mCheckpoints.erase (it);
+  return  true;
+
+}	// remove ()
+
+
+//! List the checkpoints
+
+//! @param[in] s  Stream to write the names to, one per line
+
+void
+ForkCheckpoints::list (std::ostream & s) const
+{
+  for (auto & cp : mCheckpoints)
+    s << cp.first << endl;
+
+}	// list ()
+
+
+//! Checkpoint process main loop
+
+//! Wait for a live process to hand over to us, then fork the new live
+//! process and go back to waiting, so that we can be restored again. Exit
+//! once no live process can reach us.
+
+//! @param[in]  name         Our name
+//! @param[in]  ctrlFd       Our end of the control socket
+//! @param[out] newClientFd  The client socket handed over to us
+//! @return  RESTORED, in the new live process only
+
+ForkCheckpoints::SaveRes
+ForkCheckpoints::waitForRestore (const string & name,
+				 int            ctrlFd,
+				 int &          newClientFd)
+{
+  // Interrupts from the terminal are for the live process
+  signal (SIGINT, SIG_IGN);
+
+  while (true)
+    {
+      char  names[MAX_NAMES_SIZE];
+      vector<char>  ctrl (CMSG_SPACE ((MAX_CHECKPOINTS + 1) * sizeof (int)));
+      struct iovec  iov;
+      struct msghdr  msg;
+
+      iov.iov_base = names;
+      iov.iov_len = sizeof (names);
+
+      memset (&msg, 0, sizeof (msg));
+      msg.msg_iov = &iov;
+      msg.msg_iovlen = 1;
+      msg.msg_control = ctrl.data ();
+      msg.msg_controllen = ctrl.size ();
+
+      ssize_t  n = recvmsg (ctrlFd, &msg, 0);
+
+      if (n < 0 && EINTR == errno)
+	continue;
+
+      if (n <= 0)
+	_exit (EXIT_SUCCESS);		// Nobody can restore us now
+
+      vector<int>  fds;
+
+      for (struct cmsghdr * cmsg = CMSG_FIRSTHDR (&msg);
+	   nullptr != cmsg;
+	   cmsg = CMSG_NXTHDR (&msg, cmsg))
+	if ((SOL_SOCKET == cmsg->cmsg_level) && (SCM_RIGHTS == cmsg->cmsg_type))
+	  {
+	    std::size_t  num = (cmsg->cmsg_len - CMSG_LEN (0)) / sizeof (int);
+	    int * data = reinterpret_cast<int *> (CMSG_DATA (cmsg));
+
+	    fds.insert (fds.end (), data, data + num);
+	  }
+
+      names[n - 1] = '\0';
+
+      if (fds.empty () || (0 != (msg.msg_flags & MSG_CTRUNC)))
+	{
+	  cerr << "Warning: Bad handoff to checkpoint " << name << endl;
+
+	  for (int fd : fds)
+	    close (fd);
+
+	  continue;
+	}
+
+      // A fresh control socket, so we can be restored again by the new live
+      // process.
+      int  sv[2];
+
+      if (socketpair (AF_UNIX, SOCK_SEQPACKET, 0, sv) < 0)
+	{
+	  cerr << "Warning: Cannot create checkpoint socket: "
+	       << strerror (errno) << endl;
+	  sv[0] = -1;
+	  sv[1] = -1;
+	}
+
+      pid_t  pid = (sv[0] < 0) ? -1 : fork ();
+
+      if (0 == pid)
+	{
+	  // The new live process.
+	  signal (SIGINT, SIG_DFL);
+	  close (sv[0]);
+	  close (ctrlFd);
+
+	  char * start = names;
+	  std::size_t  i = 1;
+
+	  while (('\0' != *start) && (i < fds.size ()))
+	    {
+	      char * end = strchr (start, '\n');
+
+	      if (nullptr == end)
+		break;
+
+	      mCheckpoints[string (start, end - start)] = fds[i++];
+	      start = end + 1;
+	    }
+
+	  // Anything we couldn't name is no use to us
+	  for (; i < fds.size (); i++)
+	    close (fds[i]);
+
+	  mCheckpoints[name] = sv[1];
+	  newClientFd = fds[0];
+	  return  SaveRes::RESTORED;
+	}
+
+      if (pid < 0)
+	cerr << "Warning: Cannot restore checkpoint " << name
+	     << ": client lost" << endl;
+
+      // Still the checkpoint. Everything we were sent belongs to the new live
+      // process.
+      for (int fd : fds)
+	close (fd);
+
+      if (sv[0] >= 0)
+	{
+	  close (sv[1]);
+
+	  if (pid < 0)
+	    close (sv[0]);
+	  else
+	    {
+	      close (ctrlFd);
+	      ctrlFd = sv[0];
+	    }
+	}
+    }
+}	// waitForRestore ()
+
+
+//! Close all our control sockets
+
+void
+ForkCheckpoints::closeAll ()
+{
+  for (auto & cp : mCheckpoints)
+    close (cp.second);
+
+  mCheckpoints.clear ();
+
+}	// closeAll ()
+
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// End:
@@ -0,0 +1,110 @@
+// Fork based checkpoints: declaration
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FORK_CHECKPOINTS_H
+#define FORK_CHECKPOINTS_H
+
+#include <iostream>
+#include <map>
+#include <string>
+
+
+//! Checkpoints of the whole server process, made with fork ().
+
+//! Saving a checkpoint forks the process. The child is the checkpoint: it
+//! does nothing but wait on a control socket shared with the live process,
+//! while the kernel shares all unchanged memory copy-on-write. The whole
+//! simulator state, whatever the target, is captured for free.
+
+//! Restoring a checkpoint is a handoff. The live process sends the client
+//! socket and the control sockets of all the other checkpoints to the
+//! checkpoint, using SCM_RIGHTS, and then exits. The checkpoint forks again,
+//! so it remains available, and the new child carries on serving the client
+//! from the checkpointed state.
+
+//! This only works for a single threaded server talking to GDB over a
+//! socket.
+
+class ForkCheckpoints
+{
+public:
+
+  //! The result of saving a checkpoint
+
+  enum class SaveRes
+    {
+      //! We are still the live process, and the checkpoint exists
+      SAVED,
+
+      //! We are a new live process, restored from the checkpoint. The client
+      //! file descriptor has changed.
+      RESTORED,
+
+      //! The checkpoint could not be made
+      FAILED
+    };
+
+  // Constructor and destructor
+
+  ForkCheckpoints ();
+  ~ForkCheckpoints ();
+
+  // Save and restore
+
+  SaveRes  save (const std::string & name,
+		 int                 clientFd,
+		 int &               newClientFd);
+  bool  restore (const std::string & name,
+		 int                 clientFd);
+
+  // Manage checkpoints
+
+  bool  remove (const std::string & name);
+  void  list (std::ostream & s) const;
+
+private:
+
+  //! Most checkpoints we can hand over in one message
+
+  static const std::size_t  MAX_CHECKPOINTS = 64;
+
+  //! Size of the buffer for checkpoint names in a handoff message
+
+  static const std::size_t  MAX_NAMES_SIZE = 4096;
+
+  //! Control socket for each checkpoint, by name
+
+  std::map<std::string, int>  mCheckpoints;
+
+  // Helper functions
+
+  SaveRes  waitForRestore (const std::string & name,
+			   int                 ctrlFd,
+			   int &               newClientFd);
+  void  closeAll ();
+
+};	// ForkCheckpoints ()
+
+#endif	// FORK_CHECKPOINTS_H
+
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// End:
@@ -30,16 +30,22 @@
 
 //! A wrapper for the implementation class
 
+//! If a target pool is supplied, it is used for cold resets, and the server
+//! takes ownership of the CPU, handing it back to the pool when done.
+
 //! @param[in] rspPort      RSP port to use.
 //! @param[in] _cpu         The simulated CPU
 //! @param[in] _traceFlags  Flags controlling tracing
+//! @param[in] _pool        Pool of pre-built targets, or nullptr
 
 GdbServer::GdbServer (AbstractConnection * _conn,
 			      ITarget * _cpu,
 			      TraceFlags * _traceFlags,
-			      GdbServer::KillBehaviour _killBehaviour)
+			      GdbServer::KillBehaviour _killBehaviour,
+			      TargetPool * _pool)
 {
-  mServerImpl = new GdbServerImpl (_conn, _cpu, _traceFlags, _killBehaviour);
+  mServerImpl = new GdbServerImpl (this, _conn, _cpu, _traceFlags,
+				   _killBehaviour, _pool);
 
 }	// GdbServer::GdbServer ()
 
@@ -53,6 +59,21 @@ GdbServer::~GdbServer ()
 }	// GdbServer::~GdbServer
 
 
+//! Record when the client connected
+
+//! Only needed when the connection was accepted before the server was
+//! created, so time to first packet includes getting a target.
+
+//! @param[in] start  When the client connected
+
+void
+GdbServer::sessionStart (std::chrono::system_clock::time_point  start)
+{
+  mServerImpl->sessionStart (start);
+
+}	// GdbServer::sessionStart ()
+
+
 //! Main loop to listen for RSP requests
 
 //! Wrap the implementation class
@@ -80,6 +101,22 @@ GdbServer::command (const std::string  cmd,
 }	// GdbServer::rspServer ()
 
 
+//! Simulated time of the session served by the calling thread.
+
+//! Verilator's $time support has no context, so each thread records the
+//! server it is running.
+
+//! @return  The time stamp of the target, or 0.0 if this thread is not
+//!          running a server.
+
+double
+GdbServer::timeStamp ()
+{
+  return  GdbServerImpl::timeStamp ();
+
+}	// GdbServer::timeStamp ()
+
+
 //! Output operator for KillBehavior enumeration
 
 //! @param[in] s  The stream to output to.
@@ -96,6 +133,7 @@ operator<< (std::ostream & s,
     {
     case GdbServer::KillBehaviour::RESET_ON_KILL: name = "reset";   break;
     case GdbServer::KillBehaviour::EXIT_ON_KILL:  name = "exit";    break;
+    case GdbServer::KillBehaviour::END_SESSION:   name = "session"; break;
     default:                                      name = "unknown"; break;
     }
 
@@ -26,6 +26,7 @@
 
 // Headers
 
+#include <chrono>
 #include <string>
 
 // Classes needed for the declaration
@@ -33,6 +34,7 @@
 class AbstractConnection;
 class GdbServerImpl;
 class ITarget;
+class TargetPool;
 class TraceFlags;
 
 
@@ -53,7 +55,11 @@ public:
       RESET_ON_KILL,
 
       //! Stop the target, close the connection and return.
-      EXIT_ON_KILL
+      EXIT_ON_KILL,
+
+      //! As EXIT_ON_KILL, but also return when the client disconnects,
+      //! rather than waiting for a new one. Used for multi-session serving.
+      END_SESSION
     };
 
   // Constructor and destructor
@@ -61,9 +67,14 @@ public:
   GdbServer (AbstractConnection * _conn,
 	     ITarget * _cpu,
 	     TraceFlags * _traceFlags,
-	     KillBehaviour _killBehaviour);
+	     KillBehaviour _killBehaviour,
+	     TargetPool * _pool = nullptr);
   ~GdbServer ();
 
+  // When the client connected, if before the server was created
+
+  void sessionStart (std::chrono::system_clock::time_point  start);
+
   // Main loop to listen for and service RSP requests.
 
   int rspServer ();
@@ -73,6 +84,10 @@ public:
   bool command (const std::string  cmd,
 		std::ostream & stream);
 
+  // Verilator $time support for the session served by this thread
+
+  static double timeStamp ();
+
 
 private:
 
@@ -21,19 +21,22 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <cstdlib>
 #include <cstring>
 #include <ctime>
+#include <functional>
 #include <stdexcept>
 #include <string>
-#include <sstream>
 #include <vector>
 #include <cassert>
 
 #include "GdbServerImpl.h"
 #include "Utils.h"
+#include "RspFormatter.h"
+#include "RspParser.h"
 #include "SyscallReplyPacket.h"
 
 using std::chrono::duration;
@@ -45,11 +48,11 @@ using std::dec;
 using std::endl;
 using std::hex;
 using std::localtime;
-using std::ostringstream;
+using std::placeholders::_1;
+using std::placeholders::_2;
 using std::setfill;
 using std::setw;
 using std::string;
-using std::stringstream;
 using std::vector;
 
 //! This is the length of time we spend running before leaving the model
@@ -61,77 +64,155 @@ using std::vector;
 const std::chrono::duration <double> GdbServerImpl::interruptTimeout
                                 = std::chrono::duration <double> (0.1);
 
+thread_local GdbServerImpl * GdbServerImpl::sThreadServer = nullptr;
+
 //! Constructor for the GDB RSP server.
 
 //! Allocate a packet data structure and a new RSP connection. By default no
 //! timeout for run/continue.
 
+//! @param[in] _server     The public server wrapping us
 //! @param[in] rspPort      RSP port to use.
 //! @param[in] _cpu         The simulated CPU
 //! @param[in] _traceFlags  Flags controlling tracing
+//! @param[in] _pool        Pool of targets for cold reset, or nullptr
 
-GdbServerImpl::GdbServerImpl (AbstractConnection * _conn,
+GdbServerImpl::GdbServerImpl (GdbServer * _server,
+			      AbstractConnection * _conn,
 			      ITarget * _cpu,
 			      TraceFlags * _traceFlags,
-			      GdbServer::KillBehaviour _killBehaviour) :
-  cpu (_cpu),
+			      GdbServer::KillBehaviour _killBehaviour,
+			      TargetPool * _pool) :
+  mServer (_server),
+  cpu (static_cast<ServerTarget *> (_cpu)),
+  mPool (_pool),
   traceFlags (_traceFlags),
   rsp (_conn),
   mTimeout (duration <double>::zero ()),
+  mCycleBudget (0),
+  mInstrBudget (0),
+  mRunForCycles (0),
+  mRunForInstrs (0),
+  mCycleLimit (ITarget::NO_LIMIT),
+  mInstrLimit (ITarget::NO_LIMIT),
   killBehaviour (_killBehaviour),
   mExitServer (false),
-  mSyscallContinuation (SYSCALL_NONE_PENDING)
+  mSessionStart (system_clock::now ()),
+  mAwaitingFirstPacket (true),
+  mFirstPacketLatency (duration <double>::zero ()),
+  mResetLatency (duration <double>::zero ()),
+  mRunTime (duration <double>::zero ()),
+  mRunCycles (0),
+  mRunStartCycles (0),
+  mSyscallContinuation (SYSCALL_NONE_PENDING),
+  mCmdBuf (RSP_PKT_SIZE),
+  mMemBuf (RSP_PKT_SIZE / 2)
 {
   pkt           = new RspPacket (RSP_PKT_SIZE);
   mpHash        = new MpHash ();
+  mCheckpoints  = new ForkCheckpoints ();
+  mHistory      = new ReverseHistory (cpu);
+
+  registerCommands ();
+  cpu->registerCommands (mTargetCommands);
 
 }	// GdbServerImpl ()
 
 
 //! Destructor
 
+//! If we have a pool, we own the CPU and give it back.
+
 GdbServerImpl::~GdbServerImpl ()
 {
+  if (nullptr != mPool)
+    mPool->retire (cpu);
+
+  delete  mHistory;
+  delete  mCheckpoints;
   delete  mpHash;
   delete  pkt;
 
 }	// ~GdbServerImpl
 
 
+//! Record when the client connected
+
+//! @param[in] start  When the client connected
+
+void
+GdbServerImpl::sessionStart (system_clock::time_point  start)
+{
+  mSessionStart = start;
+  mAwaitingFirstPacket = true;
+
+}	// sessionStart ()
+
+
 //! Main loop to listen for RSP requests
 
-//! This only terminates if there was an error.
+//! This only terminates if there was an error, or if our kill behaviour
+//! says we should exit.
 
 int
 GdbServerImpl::rspServer ()
 {
+  sThreadServer = this;
+
   // Loop processing commands forever
   while (!mExitServer)
     {
       // Make sure we are still connected.
       while (!rsp->isConnected ())
 	{
+	  // A session ends with its client
+	  if (killBehaviour == GdbServer::KillBehaviour::END_SESSION)
+	    {
+	      sThreadServer = nullptr;
+	      return EXIT_SUCCESS;
+	    }
+
 	  // Reconnect and stall the processor on a new connection
 	  if (!rsp->rspConnect ())
 	    {
 	      // Serious failure. Must abort execution.
 	      cerr << "*** Unable to continue: ABORTING" << endl;
+	      sThreadServer = nullptr;
 	      return EXIT_FAILURE;
 	    }
 
 	  // Reset this after making a new connection as the last exit
 	  // will have left it set.
 	  mSyscallContinuation = SYSCALL_NONE_PENDING;
+	  sessionStart (system_clock::now ());
 	}
 
       // Get a RSP client request
       rspClientRequest ();
     }
 
+  sThreadServer = nullptr;
   return EXIT_SUCCESS;
 }	// rspServer ()
 
 
+//! Time stamp of the server running on this thread
+
+//! @return  The target's idea of the current time, or 0.0 if we are called
+//!          from outside a server (for example while the model is being
+//!          constructed).
+
+double
+GdbServerImpl::timeStamp ()
+{
+  if (sThreadServer != nullptr)
+    return  sThreadServer->cpu->timeStamp ();
+  else
+    return  0.0;
+
+}	// timeStamp ()
+
+
 //! Callback for targets to use.
 
 //! Nothing implemented for now.
@@ -190,44 +271,44 @@ GdbServerImpl::rspSyscallRequest (SyscallContinuationType cType)
   cpu->readRegister (17, a7);
 
   // Work out which syscall we've got
+  RspFormatter  f (pkt);
+
   switch (a7) {
-    case 57   : sprintf (pkt->data, "Fclose,%" PRIxREG, a0);
+    case 57   : f.str ("Fclose,").hex (a0);
                 break;
-    case 62   : sprintf (pkt->data, "Flseek,%" PRIxREG
-                         ",%" PRIxREG ",%" PRIxREG, a0, a1, a2);
+    case 62   : f.str ("Flseek,").hex (a0).chr (',').hex (a1).chr (',')
+                  .hex (a2);
                 break;
-    case 63   : sprintf (pkt->data, "Fread,%" PRIxREG
-                         ",%" PRIxREG ",%" PRIxREG, a0, a1, a2);
+    case 63   : f.str ("Fread,").hex (a0).chr (',').hex (a1).chr (',')
+                  .hex (a2);
                 break;
-    case 64   : sprintf (pkt->data, "Fwrite,%" PRIxREG
-                         ",%" PRIxREG ",%" PRIxREG, a0, a1, a2);
+    case 64   : f.str ("Fwrite,").hex (a0).chr (',').hex (a1).chr (',')
+                  .hex (a2);
                 break;
-    case 80   : sprintf (pkt->data, "Ffstat,%" PRIxREG ",%" PRIxREG,
-                         a0, a1);
+    case 80   : f.str ("Ffstat,").hex (a0).chr (',').hex (a1);
                 break;
-    case 93   : sprintf (pkt->data, "W%" PRIxREG, a0);
+    case 93   : f.str ("W").hex (a0);
                 /* We never get a reply from an exit syscall, so don't
                    store a continuation state.  */
                 mSyscallContinuation = SYSCALL_NONE_PENDING;
                 break;
-    case 169  : sprintf (pkt->data, "Fgettimeofday,%" PRIxREG
-                         ",%" PRIxREG, a0, a1);
+    case 169  : f.str ("Fgettimeofday,").hex (a0).chr (',').hex (a1);
                 break;
-    case 1024 : sprintf (pkt->data, "Fopen,%" PRIxREG "/%x,%" PRIxREG
-                         ",%" PRIxREG, a0, stringLength (a0), a1, a2);
+    case 1024 : f.str ("Fopen,").hex (a0).chr ('/').hex (stringLength (a0))
+                  .chr (',').hex (a1).chr (',').hex (a2);
                 break;
-    case 1026 : sprintf (pkt->data, "Funlink,%" PRIxREG "/%x",
-                         a0, stringLength (a0));
+    case 1026 : f.str ("Funlink,").hex (a0).chr ('/')
+                  .hex (stringLength (a0));
                 break;
-    case 1038 : sprintf (pkt->data, "Fstat,%" PRIxREG "/%x,%"
-                         PRIxREG, a0, stringLength (a0), a1);
+    case 1038 : f.str ("Fstat,").hex (a0).chr ('/').hex (stringLength (a0))
+                  .chr (',').hex (a1);
                 break;
     default   : rspReportException (TargetSignal::TRAP);
                 return;
   }
 
   // Send the packet
-  pkt->setLen (strlen (pkt->data));
+  f.finish ();
   rsp->putPkt (pkt);
 }
 
@@ -260,7 +341,10 @@ GdbServerImpl::rspSyscallReply ()
       //        within a single GDB session which causes GCC regression
       //        tests to fail, so we sidestep it here with a HACK.
       if (retcode != -1)
-        cpu->writeRegister (10, retcode);
+        {
+          cpu->writeRegister (10, retcode);
+          mHistory->stateChanged ();
+        }
 
       if (p.hasCtrlC ())
         {
@@ -300,7 +384,8 @@ GdbServerImpl::rspContinue ()
 {
   // We have two timeouts to worry about.  The first is any timeout set by
   // the user (through "monitor timeout", the second is a timeout for
-  // checking for crtl-C.
+  // checking for crtl-C.  Limits in simulated time are set by armLimits and
+  // checked by the target.
   time_point <system_clock, duration <double> >  timeout_end =
     system_clock::now () + mTimeout;
 
@@ -312,6 +397,79 @@ GdbServerImpl::rspContinue ()
       return;
     }
 
+  // While recording history every instruction must be counted, so we step.
+  if (mHistory->isEnabled ())
+    {
+      for (int count = 1; ; count++)
+        {
+          ITarget::ResumeRes resType = mHistory->step ();
+
+          switch (resType)
+            {
+            case ITarget::ResumeRes::SYSCALL:
+
+              rspSyscallRequest (SYSCALL_THEN_FINISH_CONTINUE);
+              return;
+
+            case ITarget::ResumeRes::INTERRUPTED:
+
+              // At breakpoint
+              rspReportException (TargetSignal::TRAP);
+              return;
+
+            case ITarget::ResumeRes::DIVERGED:
+
+              // Differs from the reference model
+              rspReportException (TargetSignal::ABRT);
+              return;
+
+            case ITarget::ResumeRes::STEPPED:
+
+              // Stepping passes the target's own breakpoints, so look for
+              // them here.
+              if (mHistory->atBreak ())
+                {
+                  rspReportException (TargetSignal::TRAP);
+                  return;
+                }
+
+              break;
+
+            default:
+
+              // Should never occur.  We exit the gdbserver if this happens.
+              cerr << "*** ABORT: Unrecognized continue return from step: "
+                   << "terminating" << resType << endl;
+              exit (EXIT_FAILURE);
+            }
+
+          // Counted in simulated time, so checked every step
+
+          if ((cpu->getCycleCount () >= mCycleLimit)
+              || (cpu->getInstrCount () >= mInstrLimit))
+            {
+              rspReportException (TargetSignal::XCPU);	// Limit reached
+              return;
+            }
+
+          if (0 != count % RUN_SAMPLE_PERIOD)
+            continue;
+
+          if ((duration <double>::zero () != mTimeout)
+              && (timeout_end < system_clock::now ()))
+            {
+              rspReportException (TargetSignal::XCPU);	// Timeout
+              return;
+            }
+
+          if (rsp->haveBreak ())
+            {
+              rspReportException (TargetSignal::INT);	// Interrupt
+              return;
+            }
+        }
+    }
+
   for (;;)
     {
       ITarget::ResumeRes resType =
@@ -335,6 +493,19 @@ GdbServerImpl::rspContinue ()
           rspReportException (TargetSignal::TRAP);
           return;
 
+        case ITarget::ResumeRes::DIVERGED:
+
+          // Differs from the reference model
+          rspReportException (TargetSignal::ABRT);
+          return;
+
+        case ITarget::ResumeRes::LIMIT:
+
+          // Ran for the cycles or instructions allowed. The target has
+          // already stopped.
+          rspReportException (TargetSignal::XCPU);
+          return;
+
         case ITarget::ResumeRes::TIMEOUT:
 
           // Check for timeout, unless the timeout was zero
@@ -369,6 +540,41 @@ GdbServerImpl::rspContinue ()
     }
 }
 
+
+//! Set the limits for a new continue
+
+//! A "timeout cycles" or "timeout instrs" budget applies to every continue,
+//! while "runfor" applies just to the next one. Where there are both, the
+//! smaller wins. The limits are counts at which to stop, which the target
+//! checks as it runs. A continue restarted after a syscall keeps the limits
+//! it started with.
+
+void
+GdbServerImpl::armLimits ()
+{
+  auto limit = [] (uint64_t  count,
+		   uint64_t  budget,
+		   uint64_t  runFor) -> uint64_t
+    {
+      uint64_t  n = (0 == budget) ? runFor
+	: ((0 == runFor) ? budget : std::min (budget, runFor));
+
+      if ((0 == n) || (n > ITarget::NO_LIMIT - count))
+	return ITarget::NO_LIMIT;
+      else
+	return count + n;
+    };
+
+  mCycleLimit = limit (cpu->getCycleCount (), mCycleBudget, mRunForCycles);
+  mInstrLimit = limit (cpu->getInstrCount (), mInstrBudget, mRunForInstrs);
+  mRunForCycles = 0;
+  mRunForInstrs = 0;
+
+  cpu->setLimit (ITarget::LimitType::CYCLES, mCycleLimit);
+  cpu->setLimit (ITarget::LimitType::INSTRS, mInstrLimit);
+
+}	// armLimits ()
+
 //! Single step one machine instruction.
 
 void
@@ -382,7 +588,7 @@ GdbServerImpl::rspSingleStep ()
       return;
     }
 
-  ITarget::ResumeRes resType = cpu->resume (ITarget::ResumeType::STEP);
+  ITarget::ResumeRes resType = mHistory->step ();
 
   if (resType == ITarget::ResumeRes::SYSCALL)
     {
@@ -390,6 +596,12 @@ GdbServerImpl::rspSingleStep ()
       return;
     }
 
+  if (resType == ITarget::ResumeRes::DIVERGED)
+    {
+      rspReportException (TargetSignal::ABRT);
+      return;
+    }
+
   // Check for break now we've stopped.
   if (rsp->haveBreak ())
     {
@@ -402,6 +614,75 @@ GdbServerImpl::rspSingleStep ()
   return;
 }
 
+//! Step back one machine instruction.
+
+void
+GdbServerImpl::rspReverseStep ()
+{
+  rspReportReverse (mHistory->stepBack ());
+
+}	// rspReverseStep ()
+
+
+//! Continue backwards to the previous breakpoint.
+
+//! This replays the history a snapshot at a time, so can take a while. We
+//! check for an interrupt from GDB between each snapshot.
+
+void
+GdbServerImpl::rspReverseContinue ()
+{
+  // Check for break before going anywhere.
+  if (rsp->haveBreak ())
+    {
+      rspReportException (TargetSignal::INT);
+      return;
+    }
+
+  rspReportReverse (mHistory->continueBack ([this] {
+	return rsp->haveBreak ();
+      }));
+
+}	// rspReverseContinue ()
+
+
+//! Report how reverse execution stopped
+
+//! Reaching the start of the history is reported to GDB as such, so it can
+//! tell the user there is no more history.
+
+//! @param[in] res  How reverse execution stopped
+
+void
+GdbServerImpl::rspReportReverse (ReverseHistory::ReverseRes  res)
+{
+  switch (res)
+    {
+    case ReverseHistory::ReverseRes::STOPPED:
+
+      rspReportException (TargetSignal::TRAP);
+      return;
+
+    case ReverseHistory::ReverseRes::BEGIN:
+
+      pkt->packStr ("T05replaylog:begin;");
+      rsp->putPkt (pkt);
+      return;
+
+    case ReverseHistory::ReverseRes::INTERRUPTED:
+
+      rspReportException (TargetSignal::INT);
+      return;
+
+    case ReverseHistory::ReverseRes::FAILED:
+
+      pkt->packStr ("E01");
+      rsp->putPkt (pkt);
+      return;
+    }
+}	// rspReportReverse ()
+
+
 //! Deal with a request from the GDB client session
 
 //! In general, apart from the simplest requests, this function replies on
@@ -422,6 +703,16 @@ GdbServerImpl::rspClientRequest ()
       return;
     }
 
+  if (mAwaitingFirstPacket)
+    {
+      mFirstPacketLatency = system_clock::now () - mSessionStart;
+      mAwaitingFirstPacket = false;
+
+      if (traceFlags->traceConn ())
+	cout << "First packet after " << mFirstPacketLatency.count () << " s"
+	     << endl;
+    }
+
   switch (pkt->data[0])
     {
     case '!':
@@ -443,6 +734,18 @@ GdbServerImpl::rspClientRequest ()
       return;
 
     case 'b':
+      // Reverse step and continue
+      if (0 == strcmp ("bs", pkt->data))
+	{
+	  rspReverseStep ();
+	  return;
+	}
+      else if (0 == strcmp ("bc", pkt->data))
+	{
+	  rspReverseContinue ();
+	  return;
+	}
+
       // Setting baud rate is deprecated
       cerr << "Warning: RSP 'b' packet is deprecated and not "
 	   << "supported: ignored" << endl;
@@ -456,14 +759,19 @@ GdbServerImpl::rspClientRequest ()
 
     case 'F':
       // Handle the syscall reply then continue
+      startRun ();
       rspSyscallReply ();
+      endRun ();
       return;
 
     case 'c':
     case 'C':
       // @todo For now we use indentical code for 'C' (continue with signal)
       //       and just ignore the signal.
+      startRun ();
+      armLimits ();
       rspContinue ();
+      endRun ();
       return ;
 
     case 'd':
@@ -512,6 +820,7 @@ GdbServerImpl::rspClientRequest ()
       switch (killBehaviour)
 	{
 	case GdbServer::KillBehaviour::EXIT_ON_KILL:
+	case GdbServer::KillBehaviour::END_SESSION:
           mExitServer = true;
 	  break;
 
@@ -565,7 +874,9 @@ GdbServerImpl::rspClientRequest ()
     case 'S':
       // @todo For now we use indentical code for 'S' (step with signal)
       //       and just ignore the signal.
+      startRun ();
       rspSingleStep ();
+      endRun ();
       return;
 
     case 't':
@@ -633,12 +944,14 @@ GdbServerImpl::rspReportException (TargetSignal  sig)
 //! This means getting the value of each simulated register and packing it
 //! into the packet.
 
-//! Each byte is packed as a pair of hex digits.
+//! Each byte is packed as a pair of hex digits. The registers are gathered
+//! into a buffer first, so they can be converted in one go.
 
 void
 GdbServerImpl::rspReadAllRegs ()
 {
-  int  pktSize = 0;
+  uint8_t  regBytes[RISCV_NUM_REGS * sizeof (uint_reg_t)];
+  int      numBytes = 0;
 
   // The registers. GDB client expects them to be packed according to target
   // endianness.
@@ -648,14 +961,14 @@ GdbServerImpl::rspReadAllRegs ()
       int       byteSize;	// Size of reg in bytes
 
       byteSize = cpu->readRegister (regNum, val);
-      Utils::val2Hex (val, &(pkt->data[pktSize]), byteSize,
-		      true /* Little Endian */);
-      pktSize += byteSize * 2;	// 2 chars per hex digit
+
+      for (int  b = 0; b < byteSize; b++)
+	regBytes[numBytes++] = static_cast<uint8_t> (val >> (b * 8));
     }
 
   // Finalize the packet and send it
-  pkt->data[pktSize] = 0;
-  pkt->setLen (pktSize);
+  Utils::bin2Hex (pkt->data, regBytes, numBytes);
+  pkt->setLen (numBytes * 2);	// 2 chars per hex digit
   rsp->putPkt (pkt);
 
 }	// rspReadAllRegs ()
@@ -663,27 +976,40 @@ GdbServerImpl::rspReadAllRegs ()
 
 //! Handle a RSP write all registers request
 
-//! Each value is written into the simulated register.
+//! Each value is written into the simulated register. The hex digits,
+//! which follow the 'G', are all converted and checked in one go first.
 
 void
 GdbServerImpl::rspWriteAllRegs ()
 {
-  int  pktSize = 0;
+  std::size_t  byteSize = sizeof (uint_reg_t);
+  uint8_t      regBytes[RISCV_NUM_REGS * sizeof (uint_reg_t)];
+
+  if ((pkt->getLen () != static_cast<int> (1 + sizeof (regBytes) * 2))
+      || !Utils::hex2Bin (regBytes, &(pkt->data[1]), sizeof (regBytes)))
+    {
+      cerr << "Warning: Failed to recognize RSP write all registers command: "
+	   << pkt->data << endl;
+      pkt->packStr ("E01");
+      rsp->putPkt (pkt);
+      return;
+    }
 
   // The registers
   for (int  regNum = 0; regNum < RISCV_NUM_REGS; regNum++)
     {
-      std::size_t byteSize = sizeof (uint_reg_t);
+      uint_reg_t  val = 0;
 
-      uint32_t val = Utils::hex2Val (&(pkt->data[pktSize]), byteSize,
-				     true /* little endian */);
-      pktSize += byteSize * 2;	// 2 chars per hex digit
+      for (std::size_t  b = 0; b < byteSize; b++)
+	val |= static_cast<uint_reg_t> (regBytes[regNum * byteSize + b])
+	  << (b * 8);
 
       if (byteSize != cpu->writeRegister (regNum, val))
 	cerr << "Warning: Size != " << byteSize << " when writing reg "
 	     << regNum << "." << endl;
     }
 
+  mHistory->stateChanged ();
   pkt->packStr ("OK");
   rsp->putPkt (pkt);
 
@@ -704,10 +1030,11 @@ void
 GdbServerImpl::rspReadMem ()
 {
   uint32_t  addr;			// Where to read the memory
-  int       len;			// Number of bytes to read
-  int       off;			// Offset into the memory
+  std::size_t len;			// Number of bytes to read
+  RspParser  p (pkt);
 
-  if (2 != sscanf (pkt->data, "m%x,%x:", &addr, &len))
+  if (!(p.lit ('m') && p.hex (addr) && p.lit (',') && p.hex (len)
+	&& (p.atEnd () || p.lit (':'))))
     {
       cerr << "Warning: Failed to recognize RSP read memory command: "
 		<< pkt->data << endl;
@@ -716,8 +1043,9 @@ GdbServerImpl::rspReadMem ()
       return;
     }
 
-  // Make sure we won't overflow the buffer (2 chars per byte)
-  if ((len * 2) >= pkt->getBufSize())
+  // Make sure we won't overflow the buffer (2 chars per byte). The length is
+  // divided, not doubled, since doubling a huge length would wrap round.
+  if (len > static_cast<std::size_t> (pkt->getBufSize () - 1) / 2)
     {
       cerr << "Warning: Memory read " << pkt->data
 	   << " too large for RSP packet: truncated" << endl;
@@ -725,20 +1053,11 @@ GdbServerImpl::rspReadMem ()
     }
 
   // Refill the buffer with the reply
-  for (off = 0; off < len; off++)
-    {
-      uint8_t  ch;
-      if (1 == cpu->read (addr + off, &ch, 1))
-	{
-	  pkt->data[off * 2]     = Utils::hex2Char(ch >>   4);
-	  pkt->data[off * 2 + 1] = Utils::hex2Char(ch &  0xf);
-	}
-      else
-	cerr << "Warning: failed to read char" << endl;
-    }
+  if (len != cpu->read (addr, mMemBuf.data (), len))
+    cerr << "Warning: failed to read memory" << endl;
 
-  pkt->data[off * 2] = '\0';			// End of string
-  pkt->setLen (strlen (pkt->data));
+  Utils::bin2Hex (pkt->data, mMemBuf.data (), len);
+  pkt->setLen (len * 2);
   rsp->putPkt (pkt);
 
 }	// rsp_read_mem ()
@@ -759,9 +1078,11 @@ void
 GdbServerImpl::rspWriteMem ()
 {
   uint32_t  addr;			// Where to write the memory
-  int       len;			// Number of bytes to write
+  std::size_t len;			// Number of bytes to write
+  RspParser  p (pkt);
 
-  if (2 != sscanf (pkt->data, "M%x,%x:", &addr, &len))
+  if (!(p.lit ('M') && p.hex (addr) && p.lit (',') && p.hex (len)
+	&& p.lit (':')))
     {
       cerr << "Warning: Failed to recognize RSP write memory "
 		<< pkt->data << endl;
@@ -770,31 +1091,35 @@ GdbServerImpl::rspWriteMem ()
       return;
     }
 
-  // Find the start of the data and check there is the amount we expect.
-  char *symDat = (char *)(memchr (pkt->data, ':', pkt->getBufSize())) + 1;
-  int   datLen = pkt->getLen() - (symDat - pkt->data);
+  // The data follows the colon. Check there is the amount we expect.
+  const char *symDat = p.pos ();
+  std::size_t datLen = p.remaining ();
 
-  // Sanity check
-  if (len * 2 != datLen)
+  // Sanity check, without doubling len, which could wrap round
+  if ((0 != datLen % 2) || (len != datLen / 2))
     {
-      cerr << "Warning: Write of " << len * 2 << "digits requested, but "
+      cerr << "Warning: Write of " << len * 2 << " digits requested, but "
 		<< datLen << " digits supplied: packet ignored" << endl;
       pkt->packStr ("E01");
       rsp->putPkt (pkt);
       return;
     }
 
-  // Write the bytes to memory (no check the address is OK here)
-  for (int  off = 0; off < len; off++)
+  if (!Utils::hex2Bin (mMemBuf.data (), symDat, len))
     {
-      uint8_t  nyb1 = Utils::char2Hex (symDat[off * 2]);
-      uint8_t  nyb2 = Utils::char2Hex (symDat[off * 2 + 1]);
-      uint8_t  val = static_cast<unsigned int> ((nyb1 << 4) | nyb2);
-
-      if (1 != cpu->write (addr + off, &val, 1))
-	cerr << "Warning: Failed to write character" << endl;
+      cerr << "Warning: Invalid hex digits in RSP write memory: packet ignored"
+	   << endl;
+      pkt->packStr ("E01");
+      rsp->putPkt (pkt);
+      return;
     }
 
+  mHistory->memWrite (addr, mMemBuf.data (), len);
+
+  // Write the bytes to memory (no check the address is OK here)
+  if (len != cpu->write (addr, mMemBuf.data (), len))
+    cerr << "Warning: Failed to write memory" << endl;
+
   pkt->packStr ("OK");
   rsp->putPkt (pkt);
 
@@ -812,9 +1137,10 @@ void
 GdbServerImpl::rspReadReg ()
 {
   unsigned int  regNum;
+  RspParser  p (pkt);
 
   // Break out the fields from the data
-  if (1 != sscanf (pkt->data, "p%x", &regNum))
+  if (!(p.lit ('p') && p.hex (regNum) && p.atEnd ()))
     {
       cerr << "Warning: Failed to recognize RSP read register command: "
 		<< pkt->data << endl;
@@ -856,14 +1182,14 @@ GdbServerImpl::rspWriteReg ()
 {
   std::size_t regByteSize = sizeof (uint_reg_t);
   unsigned int regNum;
-  const int valstr_len = 2 * sizeof (uint_reg_t);
-  char valstr[valstr_len + 1];	// Allow for EOS
-
-  // Break out the fields from the data
-  std::ostringstream fmt_stream;
-  fmt_stream << "P%x=%" << valstr_len << "s";
-  string fmt = fmt_stream.str ();
-  if (2 != sscanf (pkt->data, fmt.c_str (), &regNum, valstr))
+  uint8_t  bytes[sizeof (uint_reg_t)];
+  RspParser  p (pkt);
+
+  // Break out the fields from the data. The value is in target (little
+  // endian) order.
+  if (!(p.lit ('P') && p.hex (regNum) && p.lit ('=')
+	&& (p.remaining () == 2 * regByteSize)
+	&& Utils::hex2Bin (bytes, p.pos (), regByteSize)))
     {
       cerr << "Warning: Failed to recognize RSP write register command "
 	   << pkt->data << endl;
@@ -871,15 +1197,17 @@ GdbServerImpl::rspWriteReg ()
       rsp->putPkt (pkt);
       return;
     }
-  valstr[valstr_len] = '\0';
 
-  uint_reg_t val
-    = Utils::hex2Val (valstr, regByteSize, true /* little endian */);
+  uint_reg_t  val = 0;
+
+  for (std::size_t i = regByteSize; i > 0; i--)
+    val = (val << 8) | bytes[i - 1];
 
   if (regByteSize != cpu->writeRegister (regNum, val))
     cerr << "Warning: Size != " << regByteSize << " when writing reg " << regNum
 	 << "." << endl;
 
+  mHistory->stateChanged ();
   pkt->packStr ("OK");
   rsp->putPkt (pkt);
 
@@ -900,8 +1228,7 @@ GdbServerImpl::rspQuery ()
       // Return the current thread ID (unsigned hex). A null response
       // indicates to use the previously selected thread. We use the constant
       // DUMMY_TID to represent our single thread of control.
-      sprintf (pkt->data, "QC%x", DUMMY_TID);
-      pkt->setLen (strlen (pkt->data));
+      RspFormatter (pkt).str ("QC").hex (DUMMY_TID).finish ();
       rsp->putPkt (pkt);
     }
   else if (0 == strncmp ("qCRC", pkt->data, strlen ("qCRC")))
@@ -915,8 +1242,7 @@ GdbServerImpl::rspQuery ()
     {
       // Return info about active threads. We return just the constant
       // DUMMY_TID to represent our single thread of control.
-      sprintf (pkt->data, "m%x", DUMMY_TID);
-      pkt->setLen (strlen (pkt->data));
+      RspFormatter (pkt).str ("m").hex (DUMMY_TID).finish ();
       rsp->putPkt (pkt);
     }
   else if (0 == strcmp ("qsThreadInfo", pkt->data))
@@ -944,9 +1270,10 @@ GdbServerImpl::rspQuery ()
       // supplied specific feature queries, but in the future these may be
       // supported as well. Note that the packet size allows for 'G' + all the
       // registers sent to us, or a reply to 'g' with all the registers and an
-      // EOS so the buffer is a well formed string.
-      sprintf (pkt->data, "PacketSize=%x", pkt->getBufSize());
-      pkt->setLen (strlen (pkt->data));
+      // EOS so the buffer is a well formed string. Reverse execution is
+      // always offered, but only works once history is being recorded.
+      RspFormatter (pkt).str ("PacketSize=").hex (pkt->getBufSize ())
+	.str (";ReverseStep+;ReverseContinue+").finish ();
       rsp->putPkt (pkt);
     }
   else if (0 == strncmp ("qSymbol:", pkt->data, strlen ("qSymbol:")))
@@ -961,10 +1288,12 @@ GdbServerImpl::rspQuery ()
 			 strlen ("qThreadExtraInfo,")))
     {
       // Report that we are runnable, but the text must be hex ASCI
-      // digits. For now do this by steam, reusing the original packet
-      sprintf (pkt->data, "%02x%02x%02x%02x%02x%02x%02x%02x%02x",
-	       'R', 'u', 'n', 'n', 'a', 'b', 'l', 'e', 0);
-      pkt->setLen (strlen (pkt->data));
+      // digits, including the EOS.
+      static const char  runnable[] = "Runnable";
+
+      Utils::bin2Hex (pkt->data, reinterpret_cast<const uint8_t *> (runnable),
+		      sizeof (runnable));
+      pkt->setLen (2 * sizeof (runnable));
       rsp->putPkt (pkt);
     }
   else
@@ -978,399 +1307,824 @@ GdbServerImpl::rspQuery ()
 
 //! Handle a RSP qRcmd request
 
-//! The actual command follows the "qRcmd," in ASCII encoded to hex
+//! The actual command follows the "qRcmd," in ASCII encoded to hex. It is
+//! decoded into a buffer kept for the purpose, then looked up first in the
+//! server's commands and then in the target's. An empty command is taken as
+//! "help".
 
 void
 GdbServerImpl::rspCommand ()
 {
-  char *cmd = new char[pkt->getBufSize ()];
-  int   timeout;
+  char *cmd = mCmdBuf.data ();
+  int   cmdLen = (pkt->getLen () - strlen ("qRcmd,")) / 2;
+
+  if ((cmdLen < 0)
+      || !Utils::hex2Bin (reinterpret_cast<uint8_t *> (cmd),
+			  &(pkt->data[strlen ("qRcmd,")]), cmdLen))
+    {
+      cerr << "Warning: Invalid hex digits in RSP qRcmd: packet ignored"
+	   << endl;
+      pkt->packStr ("E01");
+      rsp->putPkt (pkt);
+      return;
+    }
 
-  Utils::hex2Ascii (cmd, &(pkt->data[strlen ("qRcmd,")]));
+  cmd[cmdLen] = '\0';
 
   if (traceFlags->traceRsp())
     {
       cout << "RSP trace: qRcmd," << cmd << endl;
     }
 
-  if (0 == strncmp ("help", cmd, strlen (cmd)))
-    {
-      static const char *mess [] = {
-	"The following generic monitor commands are supported:\n",
-	"  help\n",
-	"    Produce this message\n",
-	"  reset [cold | warm]\n",
-	"    Reset the simulator (default warm)\n",
-	"  exit\n",
-	"    Exit the GDB server\n",
-	"  timeout <interval>\n",
-	"    Maximum time in seconds taken by continue packet\n",
-	"  cyclecount\n",
-	"    Report cycles executed since last report and since reset\n",
-	"  instrcount\n",
-	"    Report instructions executed since last report and since reset\n",
-	"  set debug <level>\n",
-	"    Set debug messaging in target to <level>\n",
-	"  show debug\n",
-	"    Show current level of debug messaging in target\n",
-	"  set remote-debug <0|1>\n",
-	"    Disable/enable tracing of Remote Serial Protocol (RSP)\n",
-	"  show remote-debug\n",
-	"    Show whether RSP tracing is enabled\n",
-	"  echo <message>\n",
-	"    Echo <message> on stdout of the gdbserver\n",
-	nullptr };
-
-      for (int i = 0; nullptr != mess[i]; i++)
-	{
-	  pkt->packRcmdStr (mess[i], true);
-	  rsp->putPkt (pkt);
-	}
+  CommandArgs  args ((0 == cmdLen) ? "help" : cmd);
+  CommandRegistry::Result  res;
 
-      // Now get any help from the target
+  mCmdOut.reset ();
+  res = mCommands.run (args, mCmdOut);
 
-      stringstream  ss;
-      if (cpu->command (string ("help"), ss))
-	{
-	  string line;
+  if (CommandRegistry::Result::UNKNOWN == res)
+    res = mTargetCommands.run (args, mCmdOut);
 
-	  pkt->packRcmdStr ("The following target specific monitor commands are supported:\n",
-			     true);
-	  rsp->putPkt (pkt);
-	  while (getline (ss, line, '\n'))
-	    {
-	      line.append ("\n");
-	      pkt->packRcmdStr (line.c_str (), true);
-	      rsp->putPkt (pkt);
-	    }
-	}
-      else
-	{
-	  // No target specific help
+  // A command which ends the server, or which has handed the client to
+  // another process, sends no reply.
 
-	  pkt->packRcmdStr ("There are no target specific monitor commands",
-			     true);
-	  rsp->putPkt (pkt);
-	}
+  if (mExitServer)
+    return;
 
-      // Not silent, so acknowledge OK
+  rspCommandReply (CommandRegistry::Result::OK == res);
 
-      pkt->packStr ("OK");
+}	// rspCommand ()
+
+
+//! Send the output from a monitor command
+
+//! Each line goes in its own packet, split if it does not fit in one. The
+//! command is then acknowledged, or its failure reported.
+
+//! @param[in] ok  TRUE if the command succeeded, FALSE otherwise.
+
+void
+GdbServerImpl::rspCommandReply (bool  ok)
+{
+  const char *p = mCmdOut.data ();
+  const char *end = p + mCmdOut.size ();
+  std::size_t  maxLen = (pkt->getBufSize () - 2) / 2;	// 'O', hex and EOS
+
+  while (p < end)
+    {
+      const char *nl = static_cast<const char *> (memchr (p, '\n', end - p));
+      std::size_t  n = (nullptr == nl) ? end - p : nl + 1 - p;
+
+      if (n > maxLen)
+	n = maxLen;
+
+      pkt->packRcmdStr (p, n, true);
       rsp->putPkt (pkt);
+      p += n;
     }
-  else if ((0 == strcmp (cmd, "reset")) || (0 == strcmp (cmd, "reset warm")))
+
+  pkt->packStr (ok ? "OK" : "E01");
+  rsp->putPkt (pkt);
+
+}	// rspCommandReply ()
+
+
+//! Add the server's own monitor commands
+
+//! They are described by help in the order added here.
+
+void
+GdbServerImpl::registerCommands ()
+{
+  mCommands.add ("help",
+		 "  help\n"
+		 "    Produce this message\n",
+		 std::bind (&GdbServerImpl::cmdHelp, this, _1, _2));
+  mCommands.add ("reset",
+		 "  reset [cold | warm]\n"
+		 "    Reset the simulator (default warm)\n",
+		 std::bind (&GdbServerImpl::cmdReset, this, _1, _2));
+  mCommands.add ("exit",
+		 "  exit\n"
+		 "    Exit the GDB server\n",
+		 std::bind (&GdbServerImpl::cmdExit, this, _1, _2));
+  mCommands.add ("timeout",
+		 "  timeout <interval>\n"
+		 "    Maximum time in seconds taken by continue packet\n"
+		 "  timeout cycles|instrs <n>\n"
+		 "    Maximum simulated cycles or instructions run by each "
+		 "continue packet\n"
+		 "    (0 for no limit), stopping with SIGXCPU. RI5CY may "
+		 "overshoot by the\n"
+		 "    few cycles it takes to halt\n",
+		 std::bind (&GdbServerImpl::cmdTimeout, this, _1, _2));
+  mCommands.add ("runfor",
+		 "  runfor <n> [cycles|instrs]\n"
+		 "    Stop the next continue with SIGXCPU after <n> simulated "
+		 "cycles or\n"
+		 "    instructions (default instrs). RI5CY may overshoot by "
+		 "the few cycles\n"
+		 "    it takes to halt\n",
+		 std::bind (&GdbServerImpl::cmdRunFor, this, _1, _2));
+  mCommands.add ("timestamp", nullptr,
+		 std::bind (&GdbServerImpl::cmdTimestamp, this, _1, _2));
+  mCommands.add ("checkpoint",
+		 "  checkpoint save|restore|delete <name>\n"
+		 "    Save, restore or delete a checkpoint of the whole "
+		 "simulation\n"
+		 "  checkpoint list\n"
+		 "    List the saved checkpoints\n"
+		 "  checkpoint write|read <file>\n"
+		 "    Save or restore the core state using a checkpoint file\n",
+		 std::bind (&GdbServerImpl::cmdCheckpoint, this, _1, _2));
+  mCommands.add ("reverse",
+		 "  reverse [on | off]\n"
+		 "    Record history for reverse execution, or report the "
+		 "history\n"
+		 "  reverse interval <n>\n"
+		 "    Take a snapshot of the history every <n> instructions\n"
+		 "  reverse snapshots <n>\n"
+		 "    Keep at most <n> snapshots of the history\n",
+		 std::bind (&GdbServerImpl::cmdReverse, this, _1, _2));
+  mCommands.add ("pool",
+		 "  pool\n"
+		 "    Report time to first packet, reset latency and pool "
+		 "statistics\n",
+		 std::bind (&GdbServerImpl::cmdPool, this, _1, _2));
+  mCommands.add ("cyclecount",
+		 "  cyclecount\n"
+		 "    Report cycles executed since last report and since reset\n",
+		 std::bind (&GdbServerImpl::cmdCycleCount, this, _1, _2));
+  mCommands.add ("instrcount",
+		 "  instrcount\n"
+		 "    Report instructions executed since last report and since "
+		 "reset\n",
+		 std::bind (&GdbServerImpl::cmdInstrCount, this, _1, _2));
+  mCommands.add ("stats",
+		 "  stats\n"
+		 "    Report instructions per cycle, stall cycles and simulation "
+		 "speed\n",
+		 std::bind (&GdbServerImpl::cmdStats, this, _1, _2));
+  mCommands.add ("set",
+		 "  set debug <level>\n"
+		 "    Set debug messaging in target to <level>\n"
+		 "  set remote-debug <0|1>\n"
+		 "    Disable/enable tracing of Remote Serial Protocol (RSP)\n",
+		 std::bind (&GdbServerImpl::cmdSet, this, _1, _2));
+  mCommands.add ("show",
+		 "  show debug\n"
+		 "    Show current level of debug messaging in target\n"
+		 "  show remote-debug\n"
+		 "    Show whether RSP tracing is enabled\n",
+		 std::bind (&GdbServerImpl::cmdShow, this, _1, _2));
+  mCommands.add ("echo",
+		 "  echo <message>\n"
+		 "    Echo <message> on stdout of the gdbserver\n",
+		 std::bind (&GdbServerImpl::cmdEcho, this, _1, _2));
+
+}	// registerCommands ()
+
+
+//! Handle the help monitor command
+
+//! Describe the server's commands, then the target's.
+
+//! @param[in]  args    The command
+//! @param[out] stream  Where to write the output
+//! @return  TRUE, since the command always succeeds.
+
+bool
+GdbServerImpl::cmdHelp (const CommandArgs & args __attribute__ ((unused)),
+			std::ostream & stream)
+{
+  stream << "The following generic monitor commands are supported:" << endl;
+  mCommands.help (stream);
+
+  if (mTargetCommands.empty ())
+    stream << "There are no target specific monitor commands" << endl;
+  else
     {
-      // Warm reset the CPU.  Failure to reset causes us to blow up.
+      stream << "The following target specific monitor commands are "
+	     << "supported:" << endl;
+      mTargetCommands.help (stream);
+    }
+
+  return true;
+
+}	// cmdHelp ()
+
+
+//! Handle the reset monitor command
+
+//! A warm reset is done by the target. Failure to reset causes us to blow
+//! up.
+
+//! @param[in]  args    The command
+//! @param[out] stream  Where to write the output
+//! @return  TRUE if the command succeeded, FALSE otherwise.
 
+bool
+GdbServerImpl::cmdReset (const CommandArgs & args,
+			 std::ostream & stream __attribute__ ((unused)))
+{
+  if ((1 == args.size ()) || ((2 == args.size ()) && args.is (1, "warm")))
+    {
       if (ITarget::ResumeRes::SUCCESS != cpu->reset (ITarget::ResetType::WARM))
 	{
 	  cerr << "*** ABORT *** Failed to reset: Terminating." << endl;
 	  exit (EXIT_FAILURE);
 	}
 
-      pkt->packStr ("OK");
-      rsp->putPkt (pkt);
+      mHistory->clear ();
+      return true;
+    }
+
+  if ((2 == args.size ()) && args.is (1, "cold"))
+    {
+      rspColdReset ();
+      return true;
     }
-  else if (0 == strcmp (cmd, "reset cold"))
+
+  return false;
+
+}	// cmdReset ()
+
+
+//! Handle the exit monitor command
+
+//! No reply is sent, since the server is about to go.
+
+//! @param[in]  args    The command
+//! @param[out] stream  Where to write the output
+//! @return  TRUE if the command succeeded, FALSE otherwise.
+
+bool
+GdbServerImpl::cmdExit (const CommandArgs & args,
+			std::ostream & stream __attribute__ ((unused)))
+{
+  if (1 != args.size ())
+    return false;
+
+  mExitServer = true;
+  return true;
+
+}	// cmdExit ()
+
+
+//! Handle the timeout monitor command
+
+//! "timeout <interval>" limits each continue in host seconds, which depends
+//! on how busy the host is. "timeout cycles <n>" and "timeout instrs <n>"
+//! limit it in simulated time, so always stop in the same place. A limit in
+//! instructions needs a target which counts them.
+
+//! @param[in]  args    The command
+//! @param[out] stream  Where to write the output
+//! @return  TRUE if the command succeeded, FALSE otherwise.
+
+bool
+GdbServerImpl::cmdTimeout (const CommandArgs & args,
+			   std::ostream & stream)
+{
+  uint64_t  timeout;
+
+  if (3 == args.size ())
     {
-      // Cold reset the CPU.  Failure to reset causes us to blow up.
+      if (!args.num (2, timeout))
+	return false;
 
-      if (ITarget::ResumeRes::SUCCESS != cpu->reset (ITarget::ResetType::COLD))
+      if (args.is (1, "cycles"))
+	mCycleBudget = timeout;
+      else if (args.is (1, "instrs"))
 	{
-	  cerr << "*** ABORT *** Failed to cold reset: Terminating." << endl;
-	  exit (EXIT_FAILURE);
+	  if ((0 != timeout) && !cpu->countsInstrs ())
+	    {
+	      stream << "The target does not count instructions" << endl;
+	      return false;
+	    }
+
+	  mInstrBudget = timeout;
 	}
+      else
+	return false;
 
-      pkt->packStr ("OK");
-      rsp->putPkt (pkt);
+      return true;
     }
-  else if (0 == strcmp (cmd, "exit"))
+
+  if ((2 != args.size ()) || !args.num (1, timeout))
+    return false;
+
+  mTimeout = std::chrono::duration <double> (static_cast <double> (timeout));
+  return true;
+
+}	// cmdTimeout ()
+
+
+//! Handle the runfor monitor command
+
+//! The limit applies to the next continue only. A limit in instructions
+//! needs a target which counts them.
+
+//! @param[in]  args    The command
+//! @param[out] stream  Where to write the output
+//! @return  TRUE if the command succeeded, FALSE otherwise.
+
+bool
+GdbServerImpl::cmdRunFor (const CommandArgs & args,
+			  std::ostream & stream)
+{
+  uint64_t  n;
+
+  if ((args.size () < 2) || (args.size () > 3) || !args.num (1, n)
+      || (0 == n))
     {
-      mExitServer = true;
+      stream << "Usage: runfor <n> [cycles|instrs], with <n> positive"
+	     << endl;
+      return false;
     }
-  else if (1 == sscanf (cmd, "timeout %d", &timeout))
+
+  if ((2 == args.size ()) || args.is (2, "instrs"))
     {
-      mTimeout
-        = std::chrono::duration <double> (static_cast <double> (timeout));
-      pkt->packStr ("OK");
-      rsp->putPkt (pkt);
+      if (!cpu->countsInstrs ())
+	{
+	  stream << "The target does not count instructions" << endl;
+	  return false;
+	}
+
+      mRunForInstrs = n;
     }
-  else if (0 == strcmp (cmd, "timestamp"))
+  else if (args.is (2, "cycles"))
+    mRunForCycles = n;
+  else
     {
-      // @todo Do this using std::put_time, which is not in pre 5.0 GCC. Not
-      // thread safe.
+      stream << "Unknown unit: " << args.str (2) << endl;
+      return false;
+    }
 
-      std::ostringstream  oss;
-      time_t now_c = system_clock::to_time_t (system_clock::now ());
-      struct tm * timeinfo = localtime (&(now_c));
-      char buff[20];
+  return true;
 
-      strftime (buff, 20, "%F %T", timeinfo);
-      oss << buff << endl;
-      pkt->packHexstr (oss.str ().c_str ());
-      rsp->putPkt (pkt);
+}	// cmdRunFor ()
 
-      // Not silent, so acknowledge OK
 
-      pkt->packStr ("OK");
-      rsp->putPkt (pkt);
-    }
-  else if (0 == strcmp (cmd, "cyclecount"))
-    {
-      std::ostringstream  oss;
-      oss << cpu->getCycleCount () << endl;
-      pkt->packHexstr (oss.str ().c_str ());
-      rsp->putPkt (pkt);
+//! Handle the timestamp monitor command
 
-      // Not silent, so acknowledge OK
+//! @todo Do this using std::put_time, which is not in pre 5.0 GCC.
 
-      pkt->packStr ("OK");
-      rsp->putPkt (pkt);
-    }
-  else if (0 == strcmp (cmd, "instrcount"))
-    {
-      std::ostringstream  oss;
-      oss << cpu->getInstrCount () << endl;
-      pkt->packHexstr (oss.str ().c_str ());
-      rsp->putPkt (pkt);
+//! Sessions under --multi may ask at the same time, so the time is broken
+//! down with localtime_r rather than into localtime's static buffer.
 
-      // Not silent, so acknowledge OK
+//! @param[in]  args    The command
+//! @param[out] stream  Where to write the output
+//! @return  TRUE, since the command always succeeds.
 
-      pkt->packStr ("OK");
-      rsp->putPkt (pkt);
-    }
-    else if (0 == strncmp (cmd, "echo", 4))
-      {
-	const char *tmp = cmd + 4;
-	while (*tmp != '\0' && isspace (*tmp))
-	  ++tmp;
-	cerr << std::flush;
-	cout << tmp << std::endl << std::flush;
-	pkt->packStr ("OK");
-	rsp->putPkt (pkt);
-      }
-    // Insert any new generic commands here.
-    // Don't forget to document them.
-
-    else if (0 == strncmp (cmd, "set ", strlen ("set ")))
-      {
-	int i;
-
-	for (i =  strlen ("set ") ; isspace (cmd[i]) ; i++)
-	  ;
-
-	rspSetCommand (cmd + i);
-      }
-    else if (0 == strncmp (cmd, "show ", strlen ("show ")))
-      {
-	int i;
-
-	for (i =  strlen ("show ") ; isspace (cmd[i]) ; i++)
-	  ;
-
-	rspShowCommand (cmd + i);
-      }
-    else
-      {
-	// Fallback is to pass the command to the target.
-
-	ostringstream  oss;
-
-	if (cpu->command (string (cmd), oss))
-	  {
-	    pkt->packRcmdStr (oss.str ().c_str (), true);
-	    rsp->putPkt (pkt);
-
-	    // Not silent, so acknowledge OK
-
-	    pkt->packStr ("OK");
-	    rsp->putPkt (pkt);
-	  }
-	else
-	  {
-	    // Command failed
-
-	    pkt->packStr ("E01");
-	    rsp->putPkt (pkt);
-	  }
-      }
-
-  delete [] cmd;
+bool
+GdbServerImpl::cmdTimestamp (const CommandArgs & args __attribute__ ((unused)),
+			     std::ostream & stream)
+{
+  time_t now_c = system_clock::to_time_t (system_clock::now ());
+  struct tm  timeinfo;
+  char buff[20];
 
-}	// rspCommand ()
+  localtime_r (&now_c, &timeinfo);
+  strftime (buff, sizeof (buff), "%F %T", &timeinfo);
+  stream << buff << endl;
+  return true;
+
+}	// cmdTimestamp ()
+
+
+//! Handle the pool monitor command
 
+//! @param[in]  args    The command
+//! @param[out] stream  Where to write the output
+//! @return  TRUE, since the command always succeeds.
 
-//! Handle a RSP qRcmd request for set
+bool
+GdbServerImpl::cmdPool (const CommandArgs & args __attribute__ ((unused)),
+			std::ostream & stream)
+{
+  stream << std::fixed << std::setprecision (6)
+	 << "Time to first packet: " << mFirstPacketLatency.count () << " s"
+	 << endl
+	 << "Last cold reset:      " << mResetLatency.count () << " s"
+	 << endl;
+
+  if (nullptr != mPool)
+    mPool->report (stream);
+  else
+    stream << "No target pool" << endl;
 
-//! The main rspCommand function has decoded the argument string and
-//! stripped off "set" and any spaces separating it from the rest.
+  return true;
 
-//! Any unrecognized command is passed to the target to process.
+}	// cmdPool ()
 
-//! @param[in] cmd  The RSP set command string (excluding "set ")
 
-void
-GdbServerImpl::rspSetCommand (const char* cmd)
+//! Handle the cyclecount monitor command
+
+//! @param[in]  args    The command
+//! @param[out] stream  Where to write the output
+//! @return  TRUE, since the command always succeeds.
+
+bool
+GdbServerImpl::cmdCycleCount (const CommandArgs & args __attribute__ ((unused)),
+			      std::ostream & stream)
 {
-  vector<string> tokens;
-  Utils::split (cmd, " ", tokens);
-  int numTok = tokens.size ();
+  stream << cpu->getCycleCount () << endl;
+  return true;
+
+}	// cmdCycleCount ()
 
-  // Look for any options we can handle.
 
-  if ((numTok == 3) && (string ("debug") == tokens[0]))
+//! Handle the instrcount monitor command
+
+//! @param[in]  args    The command
+//! @param[out] stream  Where to write the output
+//! @return  TRUE, since the command always succeeds.
+
+bool
+GdbServerImpl::cmdInstrCount (const CommandArgs & args __attribute__ ((unused)),
+			      std::ostream & stream)
+{
+  stream << cpu->getInstrCount () << endl;
+  return true;
+
+}	// cmdInstrCount ()
+
+
+//! Handle the echo monitor command
+
+//! The rest of the command is written to our stdout.
+
+//! @param[in]  args    The command
+//! @param[out] stream  Where to write the output
+//! @return  TRUE, since the command always succeeds.
+
+bool
+GdbServerImpl::cmdEcho (const CommandArgs & args,
+			std::ostream & stream __attribute__ ((unused)))
+{
+  cerr << std::flush;
+  cout << args.rest (1) << std::endl << std::flush;
+  return true;
+
+}	// cmdEcho ()
+
+
+//! Handle the checkpoint monitor command
+
+//! Checkpoints fork the whole process, so are not available to a threaded
+//! server (multiple sessions or a target pool), nor without a client socket.
+//! Nor can they be saved or restored while the target has threads of its
+//! own, such as a trace writer, since the forked process would not have
+//! them. If a restore succeeds, this process exits and the restored process
+//! replies to GDB.
+
+//! Checkpoint files are written and read by the target, so are available in
+//! any session.
+
+//! @param[in]  args    The command
+//! @param[out] stream  Where to write the output
+//! @return  TRUE if the command succeeded, FALSE otherwise.
+
+bool
+GdbServerImpl::cmdCheckpoint (const CommandArgs & args,
+			      std::ostream & stream)
+{
+  if ((3 == args.size ()) && args.is (1, "write"))
+    return cpu->saveCheckpoint (args.str (2));
+
+  if ((3 == args.size ()) && args.is (1, "read"))
     {
-      // monitor set debug <flag> [1|0|on|off|true|false]
+      mHistory->clear ();
+      return cpu->restoreCheckpoint (args.str (2));
+    }
 
-      const char * flagName = tokens[1].c_str ();
+  if ((GdbServer::KillBehaviour::END_SESSION == killBehaviour)
+      || (nullptr != mPool) || (rsp->getClientFd () < 0))
+    {
+      stream << "Checkpoints need a single session, no pool and a socket "
+	     << "connection" << endl;
+      return false;
+    }
 
-      // Valid flag?
+  if ((2 == args.size ()) && args.is (1, "list"))
+    {
+      mCheckpoints->list (stream);
+      return true;
+    }
 
-      if (!traceFlags->isFlag (flagName))
- 	{
-	  // Not a valid flag
+  if (3 != args.size ())
+    return false;
 
- 	  pkt->packStr ("E01");
- 	  rsp->putPkt (pkt);
- 	  return;
- 	}
+  const string  name = args.str (2);
 
-      // Valid value?
+  if ((args.is (1, "save") || args.is (1, "restore")) && cpu->threaded ())
+    {
+      stream << "Checkpoints cannot be saved or restored while the target "
+	     << "has threads running" << endl;
+      return false;
+    }
 
-      bool flagVal;
+  if (args.is (1, "save"))
+    {
+      int  newClientFd;
 
-      if ((0 == strcasecmp (tokens[2].c_str (), "0"))
-	  || (0 == strcasecmp (tokens[2].c_str (), "off"))
-	  || (0 == strcasecmp (tokens[2].c_str (), "false")))
-	flagVal = false;
-      else if ((0 == strcasecmp (tokens[2].c_str (), "1"))
-	  || (0 == strcasecmp (tokens[2].c_str (), "on"))
-	  || (0 == strcasecmp (tokens[2].c_str (), "true")))
-	flagVal = true;
-      else
+      switch (mCheckpoints->save (name, rsp->getClientFd (), newClientFd))
 	{
-	  // Not a valid level
+	case ForkCheckpoints::SaveRes::RESTORED:
+	  // We are a new process, answering the restore request.
+	  rsp->setClientFd (newClientFd);
+	  sessionStart (system_clock::now ());
+	  return true;
 
- 	  pkt->packStr ("E02");
- 	  rsp->putPkt (pkt);
- 	  return;
- 	}
+	case ForkCheckpoints::SaveRes::SAVED:
+	  return true;
 
-      traceFlags->flag (flagName, flagVal);
-      pkt->packStr ("OK");
-      rsp->putPkt (pkt);
-      return;
+	case ForkCheckpoints::SaveRes::FAILED:
+	  return false;
+	}
+
+      return false;
+    }
+  else if (args.is (1, "restore"))
+    {
+      if (mCheckpoints->restore (name, rsp->getClientFd ()))
+	{
+	  // The checkpoint has the client now. Leave quietly.
+	  mExitServer = true;
+	  return true;
+	}
+
+      return false;
     }
+  else if (args.is (1, "delete"))
+    return mCheckpoints->remove (name);
   else
+    return false;
+
+}	// cmdCheckpoint ()
+
+
+//! Handle the reverse monitor command
+
+//! With no arguments, report the history.
+
+//! Recording needs a target which can take snapshots, so turning it on
+//! fails if the first snapshot cannot be taken.
+
+//! @param[in]  args    The command
+//! @param[out] stream  Where to write the output
+//! @return  TRUE if the command succeeded, FALSE otherwise.
+
+bool
+GdbServerImpl::cmdReverse (const CommandArgs & args,
+			   std::ostream & stream)
+{
+  if (1 == args.size ())
     {
-      // Not handled here, try the target
+      mHistory->report (stream);
+      return true;
+    }
 
-      ostringstream  oss;
-      string fullCmd = string ("set ") + string (cmd);
+  if ((2 == args.size ()) && args.is (1, "on"))
+    return mHistory->enable ();
 
-      if (cpu->command (string (fullCmd), oss))
-	{
-	  pkt->packRcmdStr (oss.str ().c_str (), true);
-	  rsp->putPkt (pkt);
+  if ((2 == args.size ()) && args.is (1, "off"))
+    {
+      mHistory->disable ();
+      return true;
+    }
 
-	  // Not silent, so acknowledge OK
+  uint64_t  n;
 
-	  pkt->packStr ("OK");
-	  rsp->putPkt (pkt);
+  if ((3 == args.size ()) && args.num (2, n) && (n > 0))
+    {
+      if (args.is (1, "interval"))
+	{
+	  mHistory->interval (n);
+	  return true;
 	}
-      else
+      else if (args.is (1, "snapshots"))
 	{
-	  // Command failed
-
-	  pkt->packStr ("E04");
-	  rsp->putPkt (pkt);
+	  mHistory->maxSnapshots (n);
+	  return true;
 	}
     }
-}	// RspSetCommand ()
 
+  return false;
 
-//! Handle a RSP qRcmd request for show
+}	// cmdReverse ()
 
-//! The main rspCommand function has decoded the argument string and
-//! stripped off "show" and any spaces separating it from the rest.
 
-//! Any unrecognized command is passed to the target to process.
+//! Cold reset the CPU
 
-//! @param[in] cmd  The RSP command string (excluding "show ")
+//! With a target pool, a cold reset swaps in a freshly built target, which is
+//! usually much quicker than resetting this one. Failure to reset causes us
+//! to blow up.
 
 void
-GdbServerImpl::rspShowCommand (const char* cmd)
+GdbServerImpl::rspColdReset ()
 {
-  vector<string> tokens;
-  Utils::split (cmd, " ", tokens);
-  int numTok = tokens.size ();
+  time_point <system_clock, duration <double> >  start = system_clock::now ();
 
-  if ((numTok == 1) && (string ("debug") == tokens[0]))
+  if (nullptr != mPool)
     {
-      // monitor show debug
-
-      ostringstream  oss;
+      ServerTarget * newCpu = static_cast<ServerTarget *> (mPool->take ());
 
-      for (auto it = traceFlags->begin (); it != traceFlags->end (); it++)
-	oss << *it << ": " << (traceFlags->flag (*it) ? "ON" : "OFF") << endl;
+      if (nullptr == newCpu)
+	{
+	  cerr << "*** ABORT *** Failed to get target from pool: Terminating."
+	       << endl;
+	  exit (EXIT_FAILURE);
+	}
 
-      pkt->packRcmdStr (oss.str ().c_str (), true);
-      rsp->putPkt (pkt);
-      pkt->packStr ("OK");
-      rsp->putPkt (pkt);
+      mPool->retire (cpu);
+      cpu = newCpu;
+      cpu->gdbServer (mServer);
+      mHistory->target (cpu);
+      mTargetCommands.clear ();
+      cpu->registerCommands (mTargetCommands);
     }
-  else if ((numTok == 2) && (string ("debug") == tokens[0]))
+  else if (ITarget::ResumeRes::SUCCESS
+	   != cpu->reset (ITarget::ResetType::COLD))
     {
-      // monitor show debug <flag>
+      cerr << "*** ABORT *** Failed to cold reset: Terminating." << endl;
+      exit (EXIT_FAILURE);
+    }
+  else
+    mHistory->clear ();
 
-      ostringstream  oss;
-      const char * flagName = tokens[1].c_str ();
+  mResetLatency = system_clock::now () - start;
+  mRunTime = duration <double>::zero ();
+  mRunCycles = 0;
 
-      // Valid flag?
+}	// rspColdReset ()
 
-      if (!traceFlags->isFlag (flagName))
-	{
-	  // Not a valid flag
 
-	  pkt->packStr ("E01");
-	  rsp->putPkt (pkt);
-	  return;
-	}
+//! Handle the stats monitor command
 
-      oss << flagName << ": " << (traceFlags->flag (flagName) ? "ON" : "OFF")
-	  << endl;
+//! Report the counts since cold reset. The cores retire at most one
+//! instruction a cycle, so every cycle without one is a stall. Targets which
+//! do not count instructions only report cycles. The simulated speed only
+//! counts the host time spent running the target, not the time spent waiting
+//! for GDB.
 
-      pkt->packRcmdStr (oss.str ().c_str (), true);
-      rsp->putPkt (pkt);
-      pkt->packStr ("OK");
-      rsp->putPkt (pkt);
-    }
+//! A target may add statistics of its own by registering a "stats" command
+//! without help, which this command hides and runs after its own report.
+
+//! @param[in]  args    The command
+//! @param[out] stream  Where to write the output
+//! @return  TRUE, since the command always succeeds.
+
+bool
+GdbServerImpl::cmdStats (const CommandArgs & args,
+			 std::ostream & stream)
+{
+  uint64_t  cycles = cpu->getCycleCount ();
+  uint64_t  instrs = cpu->getInstrCount ();
+  uint64_t  stalls = (cycles > instrs) ? cycles - instrs : 0;
+
+  stream << "Cycles:          " << cycles << endl;
+
+  if (cpu->countsInstrs ())
+    stream << "Instructions:    " << instrs << endl
+	   << std::fixed << std::setprecision (3)
+	   << "IPC:             "
+	   << ((0 == cycles) ? 0.0 : static_cast<double> (instrs) / cycles)
+	   << endl
+	   << "Stall cycles:    " << stalls << endl;
   else
+    stream << "Instructions:    not counted" << endl;
+
+  stream << std::fixed << std::setprecision (6)
+	 << "Host run time:   " << mRunTime.count () << " s" << endl
+	 << std::setprecision (1)
+	 << "Simulated speed: "
+	 << ((mRunTime.count () > 0.0)
+	     ? static_cast<double> (mRunCycles) / mRunTime.count () / 1000.0
+	     : 0.0)
+	 << " kHz" << endl;
+
+  mTargetCommands.run (args, stream);
+  return true;
+
+}	// cmdStats ()
+
+
+//! Note the start of a run of the target, for the statistics
+
+void
+GdbServerImpl::startRun ()
+{
+  mRunStart = system_clock::now ();
+  mRunStartCycles = cpu->getCycleCount ();
+
+}	// startRun ()
+
+
+//! Note the end of a run of the target, for the statistics
+
+//! Checkpoints and reverse execution can move the cycle count backwards, in
+//! which case only the time is counted.
+
+void
+GdbServerImpl::endRun ()
+{
+  uint64_t  cycles = cpu->getCycleCount ();
+
+  mRunTime += system_clock::now () - mRunStart;
+
+  if (cycles > mRunStartCycles)
+    mRunCycles += cycles - mRunStartCycles;
+
+}	// endRun ()
+
+
+//! Handle the set monitor command
+
+//! @param[in]  args    The command
+//! @param[out] stream  Where to write the output
+//! @return  TRUE if the command succeeded, FALSE otherwise.
+
+bool
+GdbServerImpl::cmdSet (const CommandArgs & args,
+		       std::ostream & stream __attribute__ ((unused)))
+{
+  if ((4 == args.size ()) && args.is (1, "debug"))
     {
-      // Not handled here, try the target
+      // monitor set debug <flag> [1|0|on|off|true|false]
 
-      ostringstream  oss;
-      string fullCmd = string ("show ") + string (cmd);
+      const string  flagName = args.str (2);
+      const string  val = args.str (3);
 
-      if (cpu->command (string (fullCmd), oss))
-	{
-	  pkt->packRcmdStr (oss.str ().c_str (), true);
-	  rsp->putPkt (pkt);
+      // Valid flag?
 
-	  // Not silent, so acknowledge OK
+      if (!traceFlags->isFlag (flagName.c_str ()))
+	return false;
 
-	  pkt->packStr ("OK");
-	  rsp->putPkt (pkt);
-	}
+      // Valid value?
+
+      bool flagVal;
+
+      if ((0 == strcasecmp (val.c_str (), "0"))
+	  || (0 == strcasecmp (val.c_str (), "off"))
+	  || (0 == strcasecmp (val.c_str (), "false")))
+	flagVal = false;
+      else if ((0 == strcasecmp (val.c_str (), "1"))
+	  || (0 == strcasecmp (val.c_str (), "on"))
+	  || (0 == strcasecmp (val.c_str (), "true")))
+	flagVal = true;
       else
-	{
-	  // Command failed
+	return false;
 
-	  pkt->packStr ("E04");
-	  rsp->putPkt (pkt);
-	}
+      traceFlags->flag (flagName.c_str (), flagVal);
+      return true;
     }
-}	// rspShowCommand ()
+
+  return false;
+
+}	// cmdSet ()
+
+
+//! Handle the show monitor command
+
+//! @param[in]  args    The command
+//! @param[out] stream  Where to write the output
+//! @return  TRUE if the command succeeded, FALSE otherwise.
+
+bool
+GdbServerImpl::cmdShow (const CommandArgs & args,
+			std::ostream & stream)
+{
+  if ((2 == args.size ()) && args.is (1, "debug"))
+    {
+      // monitor show debug
+
+      for (auto it = traceFlags->begin (); it != traceFlags->end (); it++)
+	stream << *it << ": " << (traceFlags->flag (*it) ? "ON" : "OFF")
+	       << endl;
+
+      return true;
+    }
+  else if ((3 == args.size ()) && args.is (1, "debug"))
+    {
+      // monitor show debug <flag>
+
+      const string  flagName = args.str (2);
+
+      // Valid flag?
+
+      if (!traceFlags->isFlag (flagName.c_str ()))
+	return false;
+
+      stream << flagName << ": "
+	     << (traceFlags->flag (flagName.c_str ()) ? "ON" : "OFF") << endl;
+      return true;
+    }
+
+  return false;
+
+}	// cmdShow ()
 
 
 //! Handle a RSP set request.
@@ -1416,8 +2170,10 @@ GdbServerImpl::rspWriteMemBin ()
 {
   uint32_t  addr;			// Where to write the memory
   std::size_t len;			// Number of bytes to write
+  RspParser  p (pkt);
 
-  if (2 != sscanf (pkt->data, "X%x,%lx:", &addr, &len))
+  if (!(p.lit ('X') && p.hex (addr) && p.lit (',') && p.hex (len)
+	&& p.lit (':')))
     {
       cerr << "Warning: Failed to recognize RSP write memory command: %s"
 	   << pkt->data << endl;
@@ -1426,12 +2182,10 @@ GdbServerImpl::rspWriteMemBin ()
       return;
     }
 
-  // Find the start of the data and "unescape" it.
-  uint8_t *bindat = (uint8_t *)(memchr (pkt->data, ':',
-					pkt->getBufSize ())) + 1;
-  int   off       = (char *)bindat - pkt->data;
-  std::size_t newLen
-    = Utils::rspUnescape ((char *)bindat, pkt->getLen () - off);
+  // The data follows the colon. "Unescape" it in place.
+  std::size_t off = p.pos () - pkt->data;
+  uint8_t *bindat = (uint8_t *) (pkt->data + off);
+  std::size_t newLen = Utils::rspUnescape ((char *)bindat, p.remaining ());
 
   // Sanity check
   if (newLen != len)
@@ -1445,6 +2199,8 @@ GdbServerImpl::rspWriteMemBin ()
     }
 
   // Write the bytes to memory.
+  mHistory->memWrite (addr, bindat, len);
+
   if (len != cpu->write (addr, bindat, len))
     cerr << "Warning: Failed to write " << len << " bytes to 0x" << hex
 	 << addr << dec << endl;
@@ -1457,8 +2213,9 @@ GdbServerImpl::rspWriteMemBin ()
 
 //! Handle a RSP remove breakpoint or matchpoint request
 
-//! This checks that the matchpoint was actually set earlier. For software
-//! (memory) breakpoints, the breakpoint is cleared from memory.
+//! The breakpoint is removed from the target which holds it. The code which
+//! follows, clearing breakpoints the server put into memory itself, is not
+//! used.
 
 //! @todo This doesn't work with icache/immu yet
 
@@ -1471,14 +2228,13 @@ GdbServerImpl::rspRemoveMatchpoint ()
   std::size_t len;			// Matchpoint length
   uint8_t  *instrVec;			// Instruction as byte vector
 
-  pkt->packStr ("");
-  rsp->putPkt (pkt);
-  return;
-
   // Break out the instruction
-  string ui32Fmt = SCNx32;
-  string fmt = "z%1d,%" + ui32Fmt + ",%1d";
-  if (3 != sscanf (pkt->data, fmt.c_str(), (int *)&type, &addr, &len))
+  RspParser  p (pkt);
+  int  t;
+
+  if (!(p.lit ('z') && p.dec (t) && (t >= BP_MEMORY) && (t <= WP_ACCESS)
+	&& p.lit (',') && p.hex (addr) && p.lit (',') && p.hex (len)
+	&& p.atEnd ()))
     {
       cerr << "Warning: RSP matchpoint deletion request not "
 	   << "recognized: ignored" << endl;
@@ -1487,6 +2243,22 @@ GdbServerImpl::rspRemoveMatchpoint ()
       return;
     }
 
+  type = static_cast<MpType> (t);
+
+  // Only breakpoints the target holds itself are removed here. GDB removes
+  // its memory breakpoints by writing memory.
+  if (((BP_MEMORY == type) || (BP_HARDWARE == type))
+      && cpu->removeMatchpoint (addr, static_cast<ITarget::MatchType> (type)))
+    {
+      mHistory->breakRemoved (addr);
+      pkt->packStr ("OK");
+    }
+  else
+    pkt->packStr ("");
+
+  rsp->putPkt (pkt);
+  return;
+
   // Sanity check len
   if (len > sizeof (instr))
     {
@@ -1640,7 +2412,11 @@ GdbServerImpl::rspRemoveMatchpoint ()
 
 //! Handle a RSP insert breakpoint or matchpoint request
 
-//! @todo For now only memory breakpoints are handled
+//! Breakpoints are passed to targets which can hold them, such as the ISS,
+//! which then need not execute EBREAK from memory. The code which follows,
+//! putting breakpoints into memory from the server, is not used.
+
+//! @todo Watchpoints
 
 void
 GdbServerImpl::rspInsertMatchpoint ()
@@ -1651,14 +2427,13 @@ GdbServerImpl::rspInsertMatchpoint ()
   std::size_t len;			// Matchpoint length
   uint8_t  *instrVec;			// Instruction as byte vector
 
-  pkt->packStr ("");
-  rsp->putPkt (pkt);
-  return;
-
   // Break out the instruction
-  string ui32Fmt = SCNx32;
-  string fmt = "Z%1d,%" + ui32Fmt + ",%1d";
-  if (3 != sscanf (pkt->data, fmt.c_str(), (int *)&type, &addr, &len))
+  RspParser  p (pkt);
+  int  t;
+
+  if (!(p.lit ('Z') && p.dec (t) && (t >= BP_MEMORY) && (t <= WP_ACCESS)
+	&& p.lit (',') && p.hex (addr) && p.lit (',') && p.hex (len)
+	&& p.atEnd ()))
     {
       cerr << "Warning: RSP matchpoint insertion request not "
 	   << "recognized: ignored" << endl;
@@ -1667,6 +2442,23 @@ GdbServerImpl::rspInsertMatchpoint ()
       return;
     }
 
+  type = static_cast<MpType> (t);
+
+  // Breakpoints go to the target, if it can hold them itself. Otherwise the
+  // empty reply tells GDB to write EBREAK into memory instead. Watchpoints
+  // are not supported.
+  if (((BP_MEMORY == type) || (BP_HARDWARE == type))
+      && cpu->insertMatchpoint (addr, static_cast<ITarget::MatchType> (type)))
+    {
+      mHistory->breakInserted (addr);
+      pkt->packStr ("OK");
+    }
+  else
+    pkt->packStr ("");
+
+  rsp->putPkt (pkt);
+  return;
+
   // Sanity check len
   if (len > sizeof (instr))
     {
@@ -1804,6 +2596,7 @@ operator<< (std::ostream & s,
     case GdbServerImpl::TargetSignal::NONE:    name = "SIGNONE";    break;
     case GdbServerImpl::TargetSignal::INT:     name = "SIGINT";     break;
     case GdbServerImpl::TargetSignal::TRAP:    name = "SIGTRAP";    break;
+    case GdbServerImpl::TargetSignal::ABRT:    name = "SIGABRT";    break;
     case GdbServerImpl::TargetSignal::XCPU:    name = "SIGXCPU";    break;
     case GdbServerImpl::TargetSignal::UNKNOWN: name = "SIGUNKNOWN"; break;
     default:                                   name = "unknown";    break;
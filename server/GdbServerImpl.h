@@ -28,19 +28,25 @@
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
 #include <string>
+#include <vector>
 
-// General interface to targets
+// General interface to targets, or the one target of a single target server
 
-#include "ITarget.h"
+#include "ServerTarget.h"
 
 // Class headers
 
+#include "CommandOutput.h"
+#include "CommandRegistry.h"
+#include "ForkCheckpoints.h"
 #include "GdbServer.h"
 #include "MpHash.h"
+#include "ReverseHistory.h"
 #include "RspConnection.h"
 #include "RspPacket.h"
 #include "TraceFlags.h"
 #include "RegisterSizes.h"
+#include "TargetPool.h"
 
 
 //! Module implementing a GDB RSP server.
@@ -54,12 +60,18 @@ public:
 
   // Constructor and destructor
 
-  GdbServerImpl (AbstractConnection * _conn,
+  GdbServerImpl (GdbServer * _server,
+		 AbstractConnection * _conn,
 		 ITarget * _cpu,
 		 TraceFlags * _traceFlags,
-		 GdbServer::KillBehaviour _killBehaviour);
+		 GdbServer::KillBehaviour _killBehaviour,
+		 TargetPool * _pool);
   ~GdbServerImpl ();
 
+  // When the client connected
+
+  void sessionStart (std::chrono::system_clock::time_point  start);
+
   // Main loop to listen for and service RSP requests.
 
   int  rspServer ();
@@ -69,6 +81,10 @@ public:
   bool command (const std::string  cmd,
 		std::ostream & stream);
 
+  // Time stamp of the server running on this thread
+
+  static double timeStamp ();
+
 
 private:
 
@@ -78,6 +94,7 @@ private:
     NONE    =   0,
     INT     =   2,
     TRAP    =   5,
+    ABRT    =   6,
     XCPU    =  24,
     UNKNOWN = 143
   };
@@ -98,12 +115,12 @@ private:
 
   static const int RISCV_NUM_REG_BYTES = RISCV_NUM_REGS * sizeof (uint_reg_t);
 
-  //! Minimum packet size for RSP. Must be large enough for any initial
-  //! dialogue. Should at least allow all the registers ASCII encloded + end of
-  //! string marker.
+  //! Packet size for RSP. Must be large enough for any initial dialogue.
+  //! Should at least allow all the registers ASCII encloded + end of string
+  //! marker. Large enough that loading a program takes few packets.
 
-  static const int RSP_PKT_SIZE = (RISCV_NUM_REG_BYTES * 2 + 1) < 256
-				    ? 256 : RISCV_NUM_REG_BYTES * 2 + 1;
+  static const int RSP_PKT_SIZE = (RISCV_NUM_REG_BYTES * 2 + 1) < 16384
+				    ? 16384 : RISCV_NUM_REG_BYTES * 2 + 1;
 
   //! Constant for a thread id
 
@@ -118,8 +135,20 @@ private:
 
   static const int RUN_SAMPLE_PERIOD = 10000;
 
-  //! Our associated simulated CPU
-  ITarget * cpu;
+  //! The server running on the current thread, if any. Needed by
+  //! Verilator's context free $time support.
+  static thread_local GdbServerImpl * sThreadServer;
+
+  //! The public server wrapping us, which targets know about
+  GdbServer * mServer;
+
+  //! Our associated simulated CPU. In a single target server, its own type,
+  //! so calls to it are direct.
+  ServerTarget * cpu;
+
+  //! Pool of ready built targets for cold reset, or nullptr. If set, we own
+  //! cpu.
+  TargetPool * mPool;
 
   //! Our trace flags
   TraceFlags *traceFlags;
@@ -134,9 +163,28 @@ private:
   //! Hash table for matchpoints
   MpHash *mpHash;
 
+  //! Checkpoints of this process
+  ForkCheckpoints *mCheckpoints;
+
+  //! Execution history, for reverse execution
+  ReverseHistory *mHistory;
+
   //! Timeout for continue.
   std::chrono::duration<double> mTimeout;
 
+  //! Cycles and instructions each continue may run for, zero for no limit.
+  uint64_t  mCycleBudget;
+  uint64_t  mInstrBudget;
+
+  //! Cycles and instructions the next continue may run for, zero for no
+  //! limit.  These apply once, together with any budget above.
+  uint64_t  mRunForCycles;
+  uint64_t  mRunForInstrs;
+
+  //! Cycle and instruction counts at which the current continue stops.
+  uint64_t  mCycleLimit;
+  uint64_t  mInstrLimit;
+
   //! The length of time to run before breaking out of the model to
   //! check for an interrupt from GDB.
   static const std::chrono::duration <double> interruptTimeout;
@@ -148,6 +196,30 @@ private:
 
   bool mExitServer;
 
+  //! When the current client connected
+  std::chrono::system_clock::time_point  mSessionStart;
+
+  //! True until the first packet of the current session arrives
+  bool mAwaitingFirstPacket;
+
+  //! Time from connection to the first packet of the last session
+  std::chrono::duration<double>  mFirstPacketLatency;
+
+  //! Time taken by the last cold reset
+  std::chrono::duration<double>  mResetLatency;
+
+  //! Host time spent running the target since cold reset
+  std::chrono::duration<double>  mRunTime;
+
+  //! Cycles run by the target in mRunTime
+  uint64_t  mRunCycles;
+
+  //! When the current run started
+  std::chrono::system_clock::time_point  mRunStart;
+
+  //! Cycle count when the current run started
+  uint64_t  mRunStartCycles;
+
   //! What to do when we get a syscall reply.
   enum SyscallContinuationType
     {
@@ -156,6 +228,24 @@ private:
      SYSCALL_THEN_FINISH_CONTINUE
     } mSyscallContinuation;
 
+  //! The server's own monitor commands
+  CommandRegistry  mCommands;
+
+  //! The target's monitor commands, registered again if the target changes
+  CommandRegistry  mTargetCommands;
+
+  //! Where a monitor command is decoded, kept to avoid allocating it each
+  //! time
+  std::vector<char>  mCmdBuf;
+
+  //! The bytes of a memory read or write, kept to avoid allocating them
+  //! each time. Two hex digits per byte means no request can need more than
+  //! half a packet.
+  std::vector<uint8_t>  mMemBuf;
+
+  //! The output of a monitor command
+  CommandOutput  mCmdOut;
+
   // Main RSP request handler
   void  rspClientRequest ();
 
@@ -172,8 +262,8 @@ private:
   void  rspWriteReg ();
   void  rspQuery ();
   void  rspCommand ();
-  void  rspSetCommand (const char* cmd);
-  void  rspShowCommand (const char* cmd);
+  void  rspCommandReply (bool  ok);
+  void  rspColdReset ();
   void  rspSet ();
   void  rspRestart ();
   void  rspVpkt ();
@@ -181,7 +271,46 @@ private:
   void  rspRemoveMatchpoint ();
   void  rspInsertMatchpoint ();
   void  rspContinue ();
+  void  armLimits ();
   void  rspSingleStep ();
+  void  rspReverseStep ();
+  void  rspReverseContinue ();
+  void  rspReportReverse (ReverseHistory::ReverseRes  res);
+  void  startRun ();
+  void  endRun ();
+
+  // Monitor commands
+  void  registerCommands ();
+  bool  cmdHelp (const CommandArgs & args,
+		 std::ostream & stream);
+  bool  cmdReset (const CommandArgs & args,
+		  std::ostream & stream);
+  bool  cmdExit (const CommandArgs & args,
+		 std::ostream & stream);
+  bool  cmdTimeout (const CommandArgs & args,
+		    std::ostream & stream);
+  bool  cmdTimestamp (const CommandArgs & args,
+		      std::ostream & stream);
+  bool  cmdRunFor (const CommandArgs & args,
+		   std::ostream & stream);
+  bool  cmdCheckpoint (const CommandArgs & args,
+		       std::ostream & stream);
+  bool  cmdReverse (const CommandArgs & args,
+		    std::ostream & stream);
+  bool  cmdPool (const CommandArgs & args,
+		 std::ostream & stream);
+  bool  cmdCycleCount (const CommandArgs & args,
+		       std::ostream & stream);
+  bool  cmdInstrCount (const CommandArgs & args,
+		       std::ostream & stream);
+  bool  cmdStats (const CommandArgs & args,
+		  std::ostream & stream);
+  bool  cmdSet (const CommandArgs & args,
+		std::ostream & stream);
+  bool  cmdShow (const CommandArgs & args,
+		 std::ostream & stream);
+  bool  cmdEcho (const CommandArgs & args,
+		 std::ostream & stream);
 
 };	// GdbServerImpl ()
 
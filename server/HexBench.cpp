@@ -0,0 +1,243 @@
+// Micro-benchmark for bulk hex conversion: main program
+
+// Copyright (C) 2017  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// ----------------------------------------------------------------------------
+
+// Compares Utils::bin2Hex and Utils::hex2Bin with loops over the per-nibble
+// helpers Utils::hex2Char and Utils::char2Hex, which is how the server
+// converted memory and registers before. Both must agree before anything is
+// timed: on random data of every length up to 199 bytes, with hex digits in
+// mixed case, and on which inputs are rejected when each char value in turn
+// replaces each digit. Timings are GB/s of binary data on one thread.
+
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "Utils.h"
+
+using std::cout;
+using std::endl;
+using std::fixed;
+using std::setprecision;
+using std::setw;
+using std::vector;
+
+
+//! Encode as hex one nibble at a time
+
+//! @param[out] dest  Where to put the hex digits, which are null terminated
+//! @param[in]  src   The binary data
+//! @param[in]  len   The number of bytes of binary data
+
+static void
+refBin2Hex (char          *dest,
+	    const uint8_t *src,
+	    std::size_t    len)
+{
+  for (std::size_t  i = 0; i < len; i++)
+    {
+      dest[i * 2]     = Utils::hex2Char (src[i] >> 4);
+      dest[i * 2 + 1] = Utils::hex2Char (src[i] & 0xf);
+    }
+
+  dest[len * 2] = '\0';
+
+}	// refBin2Hex ()
+
+
+//! Decode hex one nibble at a time
+
+//! @param[out] dest  Where to put the binary data
+//! @param[in]  src   The hex digits
+//! @param[in]  len   The number of bytes of binary data
+//! @return  TRUE if all the digits were valid
+
+static bool
+refHex2Bin (uint8_t     *dest,
+	    const char  *src,
+	    std::size_t  len)
+{
+  for (std::size_t  i = 0; i < len; i++)
+    {
+      uint8_t  hi = Utils::char2Hex (src[i * 2]);
+      uint8_t  lo = Utils::char2Hex (src[i * 2 + 1]);
+
+      if ((hi > 0xf) || (lo > 0xf))
+	return  false;
+
+      dest[i] = (hi << 4) | lo;
+    }
+
+  return  true;
+
+}	// refHex2Bin ()
+
+
+//! Check the bulk routines against the per-nibble ones
+
+//! @param[in] rng  The random number generator to use
+//! @return  TRUE if they agree
+
+static bool
+checkBulk (std::mt19937 & rng)
+{
+  for (std::size_t  len = 0; len < 200; len++)
+    {
+      vector<uint8_t>  bin (len);
+      vector<uint8_t>  out (len);
+      vector<uint8_t>  refOut (len);
+      vector<char>     hex (len * 2 + 1);
+      vector<char>     refHex (len * 2 + 1);
+
+      for (uint8_t & b : bin)
+	b = static_cast<uint8_t> (rng ());
+
+      Utils::bin2Hex (hex.data (), bin.data (), len);
+      refBin2Hex (refHex.data (), bin.data (), len);
+
+      if (0 != memcmp (hex.data (), refHex.data (), len * 2 + 1))
+	{
+	  cout << "ERROR: bin2Hex differs for " << len << " bytes" << endl;
+	  return  false;
+	}
+
+      for (std::size_t  i = 0; i < len * 2; i++)
+	if (rng () & 1)
+	  hex[i] = toupper (hex[i]);
+
+      if (!Utils::hex2Bin (out.data (), hex.data (), len)
+	  || (0 != memcmp (out.data (), bin.data (), len)))
+	{
+	  cout << "ERROR: hex2Bin differs for " << len << " bytes" << endl;
+	  return  false;
+	}
+
+      for (std::size_t  pos = 0; pos < len * 2; pos++)
+	{
+	  char  digit = hex[pos];
+
+	  for (int  c = 0; c < 256; c++)
+	    {
+	      hex[pos] = static_cast<char> (c);
+
+	      if (Utils::hex2Bin (out.data (), hex.data (), len)
+		  != refHex2Bin (refOut.data (), hex.data (), len))
+		{
+		  cout << "ERROR: hex2Bin validates char " << c << " at "
+		       << pos << " of " << len << " bytes differently" << endl;
+		  return  false;
+		}
+	    }
+
+	  hex[pos] = digit;
+	}
+    }
+
+  return  true;
+
+}	// checkBulk ()
+
+
+//! Time a conversion
+
+//! Enough repetitions are made to convert about 400MB.
+
+//! @param[in] len  The number of bytes of binary data each conversion
+//! @param[in] fn   The conversion
+//! @return  The rate in GB/s of binary data
+
+template <typename F>
+static double
+gbPerSec (std::size_t  len,
+	  F            fn)
+{
+  std::size_t  reps = 400000000 / (len + 16);
+  auto  start = std::chrono::steady_clock::now ();
+
+  for (std::size_t  i = 0; i < reps; i++)
+    {
+      fn ();
+      asm volatile ("" ::: "memory");	// Keep each conversion
+    }
+
+  std::chrono::duration <double>  secs =
+    std::chrono::steady_clock::now () - start;
+
+  return  static_cast<double> (len * reps) / secs.count () / 1e9;
+
+}	// gbPerSec ()
+
+
+//! Main program
+
+//! Usage: hex-bench
+
+//! @return  EXIT_SUCCESS if the bulk routines agree with the per-nibble
+//!          ones.
+
+int
+main ()
+{
+  std::mt19937  rng (7);
+
+  if (!checkBulk (rng))
+    return  EXIT_FAILURE;
+
+  cout << setw (8) << "bytes" << setw (10) << "enc ref" << setw (10)
+       << "enc bulk" << setw (10) << "dec ref" << setw (10) << "dec bulk"
+       << endl << fixed << setprecision (2);
+
+  for (std::size_t  len : {4, 16, 64, 256, 4096, 8192, 65536})
+    {
+      vector<uint8_t>  bin (len);
+      vector<uint8_t>  out (len);
+      vector<char>     hex (len * 2 + 1);
+
+      for (uint8_t & b : bin)
+	b = static_cast<uint8_t> (rng ());
+
+      Utils::bin2Hex (hex.data (), bin.data (), len);
+
+      cout << setw (8) << len
+	   << setw (10) << gbPerSec (len, [&] {
+	       refBin2Hex (hex.data (), bin.data (), len); })
+	   << setw (10) << gbPerSec (len, [&] {
+	       Utils::bin2Hex (hex.data (), bin.data (), len); })
+	   << setw (10) << gbPerSec (len, [&] {
+	       refHex2Bin (out.data (), hex.data (), len); })
+	   << setw (10) << gbPerSec (len, [&] {
+	       Utils::hex2Bin (out.data (), hex.data (), len); })
+	   << endl;
+    }
+
+  return  EXIT_SUCCESS;
+
+}	// main ()
+
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// End:
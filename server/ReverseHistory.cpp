@@ -0,0 +1,589 @@
+// Execution history for reverse debugging: implementation
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// ----------------------------------------------------------------------------
+
+#include <cstring>
+
+#include "ReverseHistory.h"
+
+using std::cerr;
+using std::endl;
+using std::map;
+using std::vector;
+
+
+//! EBREAK, as GDB writes it (little endian)
+
+static const uint8_t  EBREAK_INSN[] = { 0x73, 0x00, 0x10, 0x00 };
+
+//! C.EBREAK, as GDB writes it (little endian)
+
+static const uint8_t  C_EBREAK_INSN[] = { 0x02, 0x90 };
+
+
+//! Constructor
+
+//! Recording is off until enabled.
+
+//! @param[in] cpu  The target whose history we record
+
+ReverseHistory::ReverseHistory (ITarget * cpu) :
+  mCpu (cpu),
+  mEnabled (false),
+  mDirty (false),
+  mInterval (DEFAULT_INTERVAL),
+  mMaxSnapshots (DEFAULT_MAX_SNAPSHOTS),
+  mPos (0)
+{
+}	// ReverseHistory ()
+
+
+//! Destructor
+
+ReverseHistory::~ReverseHistory ()
+{
+}	// ~ReverseHistory ()
+
+
+//! Start recording
+
+//! The history starts at the current state of the target.
+
+//! @return  TRUE if the target can be recorded, FALSE otherwise
+
+bool
+ReverseHistory::enable ()
+{
+  if (mEnabled)
+    return  true;
+
+  mEnabled = true;
+  mPos = 0;
+  mSnapshots.clear ();
+  mPatches.clear ();
+  return  takeSnapshot ();
+
+}	// enable ()
+
+
+//! Stop recording and forget the history
+
+void
+ReverseHistory::disable ()
+{
+  mEnabled = false;
+  mDirty = false;
+  mPos = 0;
+  mSnapshots.clear ();
+  mPatches.clear ();
+
+}	// disable ()
+
+
+//! Are we recording?
+
+//! @return  TRUE if we are recording, FALSE otherwise
+
+bool
+ReverseHistory::isEnabled () const
+{
+  return  mEnabled;
+
+}	// isEnabled ()
+
+
+//! Set the number of instructions between snapshots
+
+//! Fewer instructions make reverse execution quicker, at the cost of more
+//! memory for the same length of history. Existing snapshots are kept.
+
+//! @param[in] numInstrs  Instructions between snapshots. Must be non-zero.
+
+void
+ReverseHistory::interval (uint64_t  numInstrs)
+{
+  mInterval = numInstrs;
+
+}	// interval ()
+
+
+//! Set the most snapshots to keep
+
+//! @param[in] numSnapshots  Most snapshots to keep. Must be non-zero.
+
+void
+ReverseHistory::maxSnapshots (std::size_t  numSnapshots)
+{
+  mMaxSnapshots = numSnapshots;
+
+  while (mSnapshots.size () > mMaxSnapshots)
+    mSnapshots.erase (mSnapshots.begin ());
+
+}	// maxSnapshots ()
+
+
+//! Describe the history
+
+//! @param[in] s  Stream to write the description to
+
+void
+ReverseHistory::report (std::ostream & s) const
+{
+  std::size_t  bytes = 0;
+
+  for (auto & snap : mSnapshots)
+    bytes += snap.second.size ();
+
+  s << "Reverse execution:   " << (mEnabled ? "on" : "off") << endl
+    << "Snapshot interval:   " << mInterval << " instructions" << endl
+    << "Most snapshots:      " << mMaxSnapshots << endl;
+
+  if (! mEnabled)
+    return;
+
+  s << "Current instruction: " << mPos << endl
+    << "Snapshots:           " << mSnapshots.size () << " (" << bytes
+    << " bytes)" << endl;
+
+  if (! mSnapshots.empty ())
+    s << "History starts at:   " << mSnapshots.begin ()->first << endl;
+
+}	// report ()
+
+
+//! Record a different target
+
+//! Used when the target is swapped for a new one. The history of the old
+//! target is no use.
+
+//! @param[in] cpu  The new target
+
+void
+ReverseHistory::target (ITarget * cpu)
+{
+  mCpu = cpu;
+  clear ();
+
+}	// target ()
+
+
+//! Forget the history
+
+//! Used when the target is reset or its state replaced wholesale. If we are
+//! recording, the history starts again from the new state.
+
+void
+ReverseHistory::clear ()
+{
+  mPos = 0;
+  mSnapshots.clear ();
+  mPatches.clear ();
+  mDirty = mEnabled;
+
+}	// clear ()
+
+
+//! The target has been changed other than by execution
+
+//! For example by GDB writing a register. The history up to now remains
+//! valid, but a new snapshot is needed before executing any further.
+
+void
+ReverseHistory::stateChanged ()
+{
+  if (mEnabled)
+    mDirty = true;
+
+}	// stateChanged ()
+
+
+//! GDB is about to write memory
+
+//! Must be called before the memory is written. A write of exactly a
+//! breakpoint instruction is GDB inserting a breakpoint, and a write to a
+//! breakpoint address of the same size is GDB removing it. Anything else
+//! changes the state of the target.
+
+//! @param[in] addr  Address to be written
+//! @param[in] buf   The bytes to be written
+//! @param[in] len   Number of bytes to be written
+
+void
+ReverseHistory::memWrite (uint32_t         addr,
+			  const uint8_t *  buf,
+			  std::size_t      len)
+{
+  if (! mEnabled)
+    return;
+
+  auto  it = mPatches.find (addr);
+
+  if (isBreakInstr (buf, len))
+    {
+      if ((it == mPatches.end ()) || (it->second.orig.size () != len))
+	{
+	  Patch &  p = mPatches[addr];
+
+	  p.orig.resize (len);
+	  mCpu->read (addr, p.orig.data (), len);
+	  p.insn.assign (buf, buf + len);
+	}
+
+      return;
+    }
+
+  if ((it != mPatches.end ()) && (it->second.orig.size () == len))
+    {
+      if (0 != memcmp (it->second.orig.data (), buf, len))
+	mDirty = true;
+
+      mPatches.erase (it);
+      return;
+    }
+
+  mDirty = true;
+
+}	// memWrite ()
+
+
+//! GDB has inserted a breakpoint the target holds itself
+
+//! These are noted whether or not we are recording, since GDB may insert
+//! them before recording starts.
+
+//! @param[in] addr  Address of the breakpoint
+
+void
+ReverseHistory::breakInserted (uint32_t  addr)
+{
+  mBreaks.insert (addr);
+
+}	// breakInserted ()
+
+
+//! GDB has removed a breakpoint the target holds itself
+
+//! @param[in] addr  Address of the breakpoint
+
+void
+ReverseHistory::breakRemoved (uint32_t  addr)
+{
+  mBreaks.erase (addr);
+
+}	// breakRemoved ()
+
+
+//! Is the target at one of the breakpoints it holds itself?
+
+//! Stepping always executes the instruction at the PC, so continuing one
+//! step at a time must look for these breakpoints after each step.
+
+//! @return  TRUE if the PC is at such a breakpoint, FALSE otherwise
+
+bool
+ReverseHistory::atBreak () const
+{
+  if (mBreaks.empty ())
+    return  false;
+
+  uint_reg_t  pc;
+
+  mCpu->readRegister (PC_REGNUM, pc);
+  return  0 != mBreaks.count (static_cast<uint32_t> (pc));
+
+}	// atBreak ()
+
+
+//! Execute one instruction
+
+//! If we are recording, take a snapshot first if GDB has changed the target,
+//! and afterwards if it is time to. Any history after a change is no longer
+//! valid and is discarded.
+
+//! @return  The result of stepping the target
+
+ITarget::ResumeRes
+ReverseHistory::step ()
+{
+  if (mEnabled && mDirty)
+    {
+      mSnapshots.erase (mSnapshots.lower_bound (mPos), mSnapshots.end ());
+      takeSnapshot ();
+    }
+
+  ITarget::ResumeRes  res = mCpu->resume (ITarget::ResumeType::STEP);
+
+  if (mEnabled
+      && ((ITarget::ResumeRes::STEPPED == res)
+	  || (ITarget::ResumeRes::SYSCALL == res)))
+    {
+      mPos++;
+
+      // Replaying a part of the history we already have takes the same
+      // snapshots again, so there is no need to.
+      if ((0 == mPos % mInterval) && (0 == mSnapshots.count (mPos)))
+	takeSnapshot ();
+    }
+
+  return  res;
+
+}	// step ()
+
+
+//! Go back one instruction
+
+//! @return  How we stopped
+
+ReverseHistory::ReverseRes
+ReverseHistory::stepBack ()
+{
+  if (! mEnabled || mSnapshots.empty ()
+      || (mPos <= mSnapshots.begin ()->first))
+    return  ReverseRes::BEGIN;
+
+  return  replayTo (mPos - 1) ? ReverseRes::STOPPED : ReverseRes::FAILED;
+
+}	// stepBack ()
+
+
+//! Go back to the last breakpoint
+
+//! Search back through the history a snapshot at a time, replaying each
+//! part to find the last time the program counter was at a breakpoint. The
+//! breakpoints are the ones GDB has inserted now, not those at the time.
+
+//! @param[in] interrupted  Called between each part of the history, to see
+//!                         if we should give up
+//! @return  How we stopped
+
+ReverseHistory::ReverseRes
+ReverseHistory::continueBack (std::function<bool ()> interrupted)
+{
+  if (! mEnabled || mSnapshots.empty ()
+      || (mPos <= mSnapshots.begin ()->first))
+    return  ReverseRes::BEGIN;
+
+  uint64_t  end = mPos;
+  auto  it = mSnapshots.upper_bound (end - 1);
+
+  --it;
+
+  for (;;)
+    {
+      if (interrupted ())
+	{
+	  applyPatches ();
+	  return  ReverseRes::INTERRUPTED;
+	}
+
+      if (! restoreSnapshot (it))
+	return  ReverseRes::FAILED;
+
+      bool  found = false;
+      uint64_t  foundPos = 0;
+
+      while (mPos < end)
+	{
+	  uint_reg_t  pc;
+
+	  mCpu->readRegister (PC_REGNUM, pc);
+
+	  if ((0 != mPatches.count (static_cast<uint32_t> (pc)))
+	      || (0 != mBreaks.count (static_cast<uint32_t> (pc))))
+	    {
+	      found = true;
+	      foundPos = mPos;
+	    }
+
+	  ITarget::ResumeRes  res = mCpu->resume (ITarget::ResumeType::STEP);
+
+	  if ((ITarget::ResumeRes::STEPPED != res)
+	      && (ITarget::ResumeRes::SYSCALL != res))
+	    {
+	      cerr << "Warning: Replay diverged from history at instruction "
+		   << mPos << ": reverse execution disabled" << endl;
+	      applyPatches ();
+	      disable ();
+	      return  ReverseRes::FAILED;
+	    }
+
+	  mPos++;
+	}
+
+      if (found)
+	return  replayTo (foundPos) ? ReverseRes::STOPPED : ReverseRes::FAILED;
+
+      if (it == mSnapshots.begin ())
+	break;
+
+      end = it->first;
+      --it;
+    }
+
+  // No breakpoint, so go back as far as we can.
+  return  replayTo (mSnapshots.begin ()->first)
+    ? ReverseRes::BEGIN : ReverseRes::FAILED;
+
+}	// continueBack ()
+
+
+//! Take a snapshot at the current position
+
+//! Snapshots hold the program's memory, not GDB's breakpoints. If the target
+//! cannot take a snapshot, recording stops.
+
+//! @return  TRUE if the snapshot was taken, FALSE otherwise
+
+bool
+ReverseHistory::takeSnapshot ()
+{
+  removePatches ();
+  bool  ok = mCpu->saveSnapshot (mSnapshots[mPos]);
+  applyPatches ();
+
+  if (! ok)
+    {
+      cerr << "Warning: Cannot take snapshot: reverse execution disabled"
+	   << endl;
+      disable ();
+      return  false;
+    }
+
+  while (mSnapshots.size () > mMaxSnapshots)
+    mSnapshots.erase (mSnapshots.begin ());
+
+  mDirty = false;
+  return  true;
+
+}	// takeSnapshot ()
+
+
+//! Restore a snapshot
+
+//! The breakpoints are not put back, since we are usually about to replay.
+
+//! @param[in] it  The snapshot to restore
+//! @return  TRUE if the snapshot was restored, FALSE otherwise
+
+bool
+ReverseHistory::restoreSnapshot (map<uint64_t, vector<uint8_t> >::iterator  it)
+{
+  if (! mCpu->restoreSnapshot (it->second))
+    {
+      cerr << "Warning: Cannot restore snapshot: reverse execution disabled"
+	   << endl;
+      disable ();
+      return  false;
+    }
+
+  mPos = it->first;
+  mDirty = false;
+  return  true;
+
+}	// restoreSnapshot ()
+
+
+//! Go to a position in the history
+
+//! Restore the nearest snapshot at or before the position and replay from
+//! there, then put back GDB's breakpoints.
+
+//! @param[in] pos  Where to go
+//! @return  TRUE if we got there, FALSE otherwise
+
+bool
+ReverseHistory::replayTo (uint64_t  pos)
+{
+  auto  it = mSnapshots.upper_bound (pos);
+
+  if (it == mSnapshots.begin ())
+    return  false;
+
+  if (! restoreSnapshot (--it))
+    return  false;
+
+  while (mPos < pos)
+    {
+      ITarget::ResumeRes  res = mCpu->resume (ITarget::ResumeType::STEP);
+
+      if ((ITarget::ResumeRes::STEPPED != res)
+	  && (ITarget::ResumeRes::SYSCALL != res))
+	{
+	  cerr << "Warning: Replay diverged from history at instruction "
+	       << mPos << ": reverse execution disabled" << endl;
+	  applyPatches ();
+	  disable ();
+	  return  false;
+	}
+
+      mPos++;
+    }
+
+  applyPatches ();
+  return  true;
+
+}	// replayTo ()
+
+
+//! Take GDB's breakpoints out of memory
+
+void
+ReverseHistory::removePatches ()
+{
+  for (auto & p : mPatches)
+    mCpu->write (p.first, p.second.orig.data (), p.second.orig.size ());
+
+}	// removePatches ()
+
+
+//! Put GDB's breakpoints into memory
+
+void
+ReverseHistory::applyPatches ()
+{
+  for (auto & p : mPatches)
+    mCpu->write (p.first, p.second.insn.data (), p.second.insn.size ());
+
+}	// applyPatches ()
+
+
+//! Is this a breakpoint instruction, as GDB would write it?
+
+//! @param[in] buf  The bytes to be written
+//! @param[in] len  Number of bytes to be written
+//! @return  TRUE if the bytes are a breakpoint instruction, FALSE otherwise
+
+bool
+ReverseHistory::isBreakInstr (const uint8_t *  buf,
+			      std::size_t      len) const
+{
+  if (sizeof (EBREAK_INSN) == len)
+    return  0 == memcmp (buf, EBREAK_INSN, len);
+  else if (sizeof (C_EBREAK_INSN) == len)
+    return  0 == memcmp (buf, C_EBREAK_INSN, len);
+  else
+    return  false;
+
+}	// isBreakInstr ()
+
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// End:
@@ -0,0 +1,179 @@
+// Execution history for reverse debugging: declaration
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef REVERSE_HISTORY_H
+#define REVERSE_HISTORY_H
+
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "ITarget.h"
+
+
+//! Execution history of a target, for reverse execution.
+
+//! While recording, the target is run one instruction at a time, and every
+//! so many instructions a snapshot of its complete state is taken. Going
+//! backwards means restoring the nearest earlier snapshot and replaying
+//! forward, which the target does deterministically.
+
+//! GDB inserts breakpoints by writing EBREAK into memory, unless the target
+//! holds them itself through Z packets. Those writes are not part of the
+//! program's history, so they are tracked as patches, which are kept out of
+//! snapshots and replays. Breakpoints the target holds are not in memory,
+//! but are noted so reverse continue can stop at them. Any other change GDB
+//! makes to the target starts a new snapshot, discarding any history after
+//! it.
+
+class ReverseHistory
+{
+public:
+
+  //! The result of reverse execution
+
+  enum class ReverseRes
+    {
+      //! Stopped at the previous instruction or breakpoint
+      STOPPED,
+
+      //! Stopped at the start of the history
+      BEGIN,
+
+      //! Stopped early, because the client interrupted
+      INTERRUPTED,
+
+      //! The history could not be replayed, and has been abandoned
+      FAILED
+    };
+
+  // Constructor and destructor
+
+  ReverseHistory (ITarget * cpu);
+  ~ReverseHistory ();
+
+  // Control recording
+
+  bool  enable ();
+  void  disable ();
+  bool  isEnabled () const;
+  void  interval (uint64_t  numInstrs);
+  void  maxSnapshots (std::size_t  numSnapshots);
+  void  report (std::ostream & s) const;
+
+  // Tell us about changes to the target
+
+  void  target (ITarget * cpu);
+  void  clear ();
+  void  stateChanged ();
+  void  memWrite (uint32_t         addr,
+		  const uint8_t *  buf,
+		  std::size_t      len);
+  void  breakInserted (uint32_t  addr);
+  void  breakRemoved (uint32_t  addr);
+  bool  atBreak () const;
+
+  // Execution
+
+  ITarget::ResumeRes  step ();
+  ReverseRes  stepBack ();
+  ReverseRes  continueBack (std::function<bool ()> interrupted);
+
+private:
+
+  //! Default number of instructions between snapshots
+
+  static const uint64_t  DEFAULT_INTERVAL = 10000;
+
+  //! Default most snapshots to keep
+
+  static const std::size_t  DEFAULT_MAX_SNAPSHOTS = 100;
+
+  //! GDB register number of the program counter
+
+  static const int  PC_REGNUM = 32;
+
+  //! A breakpoint GDB has written into memory
+
+  struct Patch
+  {
+    std::vector<uint8_t>  orig;		//!< What was there before
+    std::vector<uint8_t>  insn;		//!< The breakpoint instruction
+  };
+
+  //! The target being recorded
+
+  ITarget * mCpu;
+
+  //! Are we recording?
+
+  bool  mEnabled;
+
+  //! Has the target changed other than by execution since the last
+  //! snapshot?
+
+  bool  mDirty;
+
+  //! Instructions between snapshots
+
+  uint64_t  mInterval;
+
+  //! Most snapshots to keep. The oldest are dropped first.
+
+  std::size_t  mMaxSnapshots;
+
+  //! Instructions executed since recording started
+
+  uint64_t  mPos;
+
+  //! Snapshots of the target, by position
+
+  std::map<uint64_t, std::vector<uint8_t> >  mSnapshots;
+
+  //! Breakpoints GDB has written into memory, by address
+
+  std::map<uint32_t, Patch>  mPatches;
+
+  //! Breakpoints the target holds itself, inserted with Z packets
+
+  std::set<uint32_t>  mBreaks;
+
+  // Helper functions
+
+  bool  takeSnapshot ();
+  bool  restoreSnapshot (std::map<uint64_t,
+				  std::vector<uint8_t> >::iterator  it);
+  bool  replayTo (uint64_t  pos);
+  void  removePatches ();
+  void  applyPatches ();
+  bool  isBreakInstr (const uint8_t *  buf,
+		      std::size_t      len) const;
+
+};	// ReverseHistory ()
+
+#endif	// REVERSE_HISTORY_H
+
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// End:
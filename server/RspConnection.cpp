@@ -64,6 +64,25 @@ RspConnection::RspConnection (int         _portNum,
 }	// RspConnection ()
 
 
+//! Constructor when adopting an already accepted client
+
+//! Used when some other party (for example the multi-session server) owns
+//! the listening socket. Once this client closes, there is nothing to
+//! reconnect to, so ::rspConnect () will fail.
+
+//! @param[in] _traceFlags  flags controlling tracing
+//! @param[in] _clientFd    file descriptor of the connected client
+RspConnection::RspConnection (TraceFlags *_traceFlags,
+			      int         _clientFd) :
+  AbstractConnection (_traceFlags),
+  portNum (-1),
+  clientFd (_clientFd)
+{
+  setClientOptions (clientFd);
+
+}	// RspConnection ()
+
+
 //! Destructor
 
 //! Close the connection if it is still open
@@ -98,6 +117,10 @@ RspConnection::~RspConnection ()
 bool
 RspConnection::rspConnect ()
 {
+  // An adopted client cannot be replaced.
+  if (portNum < 0)
+    return  false;
+
   // Open a socket on which we'll listen for clients
   int  tmpFd = socket (PF_INET, SOCK_STREAM, IPPROTO_TCP);
   if (tmpFd < 0)
@@ -144,20 +167,10 @@ RspConnection::rspConnect ()
       return  true;			// OK to retry
     }
 
-  // Enable TCP keep alive process
-  optval = 1;
-  setsockopt (clientFd, SOL_SOCKET, SO_KEEPALIVE, (char *)&optval,
-	      sizeof (optval));
-
-  // Don't delay small packets, for better interactive response (disable
-  // Nagel's algorithm)
-  optval = 1;
-  setsockopt (clientFd, IPPROTO_TCP, TCP_NODELAY, (char *)&optval,
-	      sizeof (optval));
+  setClientOptions (clientFd);
 
   // Socket is no longer needed
   close (tmpFd);			// No longer need this
-  signal (SIGPIPE, SIG_IGN);		// So we don't exit if client dies
 
   if (! traceFlags->traceSilent ())
     cout << "Remote debugging from host " << inet_ntoa (sockAddr.sin_addr)
@@ -168,6 +181,31 @@ RspConnection::rspConnect ()
 }	// rspConnect ()
 
 
+//! Set up a newly accepted client socket
+
+//! Enables keep alive and disables Nagle's algorithm. Also makes sure we
+//! don't die if the client goes away while we are writing to it.
+
+//! @param[in] fd  The client file descriptor
+void
+RspConnection::setClientOptions (int  fd)
+{
+  // Enable TCP keep alive process
+  int  optval = 1;
+  setsockopt (fd, SOL_SOCKET, SO_KEEPALIVE, (char *)&optval,
+	      sizeof (optval));
+
+  // Don't delay small packets, for better interactive response (disable
+  // Nagel's algorithm)
+  optval = 1;
+  setsockopt (fd, IPPROTO_TCP, TCP_NODELAY, (char *)&optval,
+	      sizeof (optval));
+
+  signal (SIGPIPE, SIG_IGN);		// So we don't exit if client dies
+
+}	// setClientOptions ()
+
+
 //! Close a client connection if it is open
 void
 RspConnection::rspClose ()
@@ -193,64 +231,98 @@ RspConnection::isConnected ()
 
 }	// isConnected ()
 
-//! Put a single character out on the RSP connection
+//! Get the client socket
+
+//! @return  The client file descriptor, or -1 if not connected
+int
+RspConnection::getClientFd ()
+{
+  return  clientFd;
+
+}	// getClientFd ()
+
+
+//! Replace the client socket
+
+//! Used when a checkpoint takes over a client from another process. Any
+//! existing client socket is not closed, since it may be the same client.
+
+//! @param[in] fd  The new client file descriptor
+void
+RspConnection::setClientFd (int  fd)
+{
+  clientFd = fd;
+
+}	// setClientFd ()
+
+
+//! Put a buffer of characters out on the RSP connection
 
 //! Utility routine. This should only be called if the client is open, but we
 //! check for safety.
 
-//! @param[in] c         The character to put out
+//! @param[in] buf  The characters to put out
+//! @param[in] len  The number of characters
 
-//! @return  TRUE if char sent OK, FALSE if not (communications failure)
+//! @return  TRUE if the chars were sent OK, FALSE if not (communications
+//!          failure)
 
 bool
-RspConnection::putRspCharRaw (char  c)
+RspConnection::putRspBytesRaw (const char  *buf,
+			       std::size_t  len)
 {
   if (-1 == clientFd)
     {
-      cerr << "Warning: Attempt to write '" << c
-		<< "' to unopened RSP client: Ignored" << endl;
+      cerr << "Warning: Attempt to write to unopened RSP client: Ignored"
+	   << endl;
       return  false;
     }
 
-  // Write until successful (we retry after interrupts) or catastrophic
-  // failure.
-  while (true)
+  // Write until all written (we retry after interrupts and partial writes)
+  // or catastrophic failure.
+  while (len > 0)
     {
-      switch (write (clientFd, &c, sizeof (c)))
+      ssize_t  n = write (clientFd, buf, len);
+
+      if (-1 == n)
 	{
-	case -1:
 	  // Error: only allow interrupts or would block
 	  if ((EAGAIN != errno) && (EINTR != errno))
 	    {
 	      cerr << "Warning: Failed to write to RSP client: "
-			<< "Closing client connection: "
-			<<  strerror (errno) << endl;
+		   << "Closing client connection: "
+		   <<  strerror (errno) << endl;
 	      return  false;
 	    }
-
-	  break;
-
-	case 0:
-	  break;		// Nothing written! Try again
-
-	default:
-	  return  true;		// Success, we can return
+	}
+      else
+	{
+	  buf += n;
+	  len -= n;
 	}
     }
-}	// putRspCharRaw ()
 
+  return  true;
 
-//! Get a single character from the RSP connection
+}	// putRspBytesRaw ()
+
+
+//! Get a buffer of characters from the RSP connection
 
 //! Utility routine. This should only be called if the client is open, but we
-//! check for safety.
+//! check for safety. As many characters as are available are returned, up
+//! to the size of the buffer.
 
-//! @param[in] blocking  True if the read should block.
-//! @return  The character received or -1 on failure, or if the read would
-//!          block, and blocking is true.
+//! @param[out] buf       Where to put the characters
+//! @param[in]  size      The size of the buffer
+//! @param[in]  blocking  True if the read should block.
+//! @return  The number of characters received or -1 on failure, or if the
+//!          read would block, and blocking is false.
 
 int
-RspConnection::getRspCharRaw (bool blocking)
+RspConnection::getRspBytesRaw (char        *buf,
+			       std::size_t  size,
+			       bool         blocking)
 {
   if (-1 == clientFd)
     {
@@ -264,9 +336,9 @@ RspConnection::getRspCharRaw (bool blocking)
 
   for (;;)
     {
-      unsigned char  c;
+      ssize_t  n = recv (clientFd, buf, size, (blocking ? 0 : MSG_DONTWAIT));
 
-      switch (recv (clientFd, &c, sizeof (c), (blocking ? 0 : MSG_DONTWAIT)))
+      switch (n)
   	{
   	case -1:
 	  if (!blocking
@@ -288,10 +360,10 @@ RspConnection::getRspCharRaw (bool blocking)
   	  return  -1;
 
   	default:
-  	  return  c & 0xff;	// Success, we can return (no sign extend!)
+  	  return  n;		// Success, we can return
   	}
     }
-}	// getRspCharRaw ()
+}	// getRspBytesRaw ()
 
 
 // Local Variables:
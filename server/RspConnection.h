@@ -39,6 +39,8 @@ public:
 
   RspConnection (int         _portNum,
 		 TraceFlags *_traceFlags);
+  RspConnection (TraceFlags *_traceFlags,
+		 int         _clientFd);
   ~RspConnection ();
 
   // Public interface: manage client connections
@@ -47,9 +49,19 @@ public:
   void  rspClose ();
   bool  isConnected ();
 
+  // Access to the client socket
+
+  int   getClientFd ();
+  void  setClientFd (int  fd);
+
+  // Socket setup shared with other listeners
+
+  static void  setClientOptions (int  fd);
+
 private:
 
-  //! The port number to listen on
+  //! The port number to listen on, or -1 if we were handed an already
+  //! connected client and so cannot accept another.
 
   int  portNum;
 
@@ -57,10 +69,13 @@ private:
 
   int  clientFd;
 
-  // Implementation specific routines to handle individual chars.
+  // Implementation specific routines to handle buffers of chars.
 
-  virtual bool  putRspCharRaw (char  c);
-  virtual int   getRspCharRaw (bool blocking);
+  virtual bool  putRspBytesRaw (const char  *buf,
+				std::size_t  len);
+  virtual int   getRspBytesRaw (char        *buf,
+				std::size_t  size,
+				bool         blocking);
 
 };	// RspConnection ()
 
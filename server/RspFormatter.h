@@ -0,0 +1,134 @@
+// Format the fields of an RSP reply
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef RSP_FORMATTER_H
+#define RSP_FORMATTER_H
+
+#include <cstdint>
+
+#include "RspPacket.h"
+
+
+//! Build an RSP reply in a packet, field by field.
+
+//! This replaces sprintf for replies such as "Fread,<fd>,<buf>,<count>".
+//! The calls chain, for example:
+
+//!   RspFormatter (pkt).str ("QC").hex (tid).finish ();
+
+//! Characters that would not fit in the packet buffer are dropped.
+
+class RspFormatter
+{
+public:
+
+  //! Constructor
+
+  //! The reply replaces anything in the packet.
+
+  //! @param[in] pkt  The packet for the reply
+
+  explicit RspFormatter (RspPacket *pkt)
+    : mPkt (pkt),
+      mPos (pkt->data),
+      mEnd (pkt->data + pkt->getBufSize () - 1)	// Allow for EOS
+  {
+  }
+
+  //! Append a null terminated string
+
+  //! @param[in] s  The string
+  //! @return  This formatter.
+
+  RspFormatter & str (const char *s)
+  {
+    while (('\0' != *s) && (mPos < mEnd))
+      *mPos++ = *s++;
+
+    return *this;
+  }
+
+  //! Append a character
+
+  //! @param[in] c  The character
+  //! @return  This formatter.
+
+  RspFormatter & chr (char  c)
+  {
+    if (mPos < mEnd)
+      *mPos++ = c;
+
+    return *this;
+  }
+
+  //! Append an unsigned number as hex, with no leading zeros
+
+  //! @param[in] val  The number
+  //! @return  This formatter.
+
+  RspFormatter & hex (uint64_t  val)
+  {
+    static const char  digits[] = "0123456789abcdef";
+    char  buf[16];
+    int   n = 0;
+
+    do
+      {
+	buf[n++] = digits[val & 0xf];
+	val >>= 4;
+      }
+    while (val != 0);
+
+    while ((n > 0) && (mPos < mEnd))
+      *mPos++ = buf[--n];
+
+    return *this;
+  }
+
+  //! Finish the reply, setting the packet length
+
+  //! The data is also null terminated, for the benefit of any logging.
+
+  void finish ()
+  {
+    *mPos = '\0';
+    mPkt->setLen (mPos - mPkt->data);
+  }
+
+
+private:
+
+  //! The packet for the reply
+  RspPacket *mPkt;
+
+  //! Where the next character goes
+  char *mPos;
+
+  //! The last character that can be used
+  char *mEnd;
+};
+
+
+#endif	// RSP_FORMATTER_H
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// show-trailing-whitespace: t
+// End:
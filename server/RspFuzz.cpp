@@ -0,0 +1,466 @@
+// Fuzz harness for the GDB RSP server: main program
+
+// Copyright (C) 2017  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// ----------------------------------------------------------------------------
+
+// Each input is a GDB session, one packet body per line. The harness frames
+// each line as a packet with a valid checksum, followed by the client's ack,
+// and serves the session with the ISS as the target. Monitor commands which
+// could run unbounded, fork, or write files are dropped, and every session
+// starts by limiting how many instructions a continue may run.
+
+// Built with libFuzzer (-DRSP_FUZZ_LIBFUZZER -fsanitize=fuzzer), only
+// LLVMFuzzerTestOneInput is used. Otherwise this file supplies a main
+// program which replays the files given, or mutates a built in session for
+// -runs=<n> iterations.
+
+#include "config.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "AbstractConnection.h"
+#include "GdbServer.h"
+#include "Iss.h"
+#include "TraceFlags.h"
+#include "Utils.h"
+
+#if defined (SINGLE_TARGET_RI5CY) || defined (SINGLE_TARGET_PICORV32) \
+  || defined (SINGLE_TARGET_GDBSIM)
+#error "The RSP fuzz harness serves the ISS, so needs a multi-target server"
+#endif
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+
+//! A connection whose client is a buffer of characters
+
+//! What the server puts out is discarded. When the buffer is used up, the
+//! client has disconnected.
+
+class FuzzConnection : public AbstractConnection
+{
+public:
+
+  // Constructor and destructor
+
+  FuzzConnection (TraceFlags *_traceFlags,
+		  const string & _input) :
+    AbstractConnection (_traceFlags),
+    mInput (_input),
+    mPos (0),
+    mIsConnected (true)
+  {
+  }
+
+  ~FuzzConnection () {}
+
+  // Public interface: manage client connections
+
+  virtual bool  rspConnect () { return false; }
+  virtual void  rspClose () { mIsConnected = false; }
+  virtual bool  isConnected () { return mIsConnected; }
+
+private:
+
+  //! The client's side of the session
+  string  mInput;
+
+  //! Offset of the next character the client sends
+  std::size_t  mPos;
+
+  //! Whether the client is still there
+  bool  mIsConnected;
+
+  // Implementation specific routines to handle buffers of chars.
+
+  virtual bool
+  putRspBytesRaw (const char  *buf __attribute__ ((unused)),
+		  std::size_t  len __attribute__ ((unused)))
+  {
+    return  mIsConnected;
+  }
+
+  virtual int
+  getRspBytesRaw (char        *buf,
+		  std::size_t  size,
+		  bool         blocking __attribute__ ((unused)))
+  {
+    std::size_t  n = mInput.size () - mPos;
+
+    if (0 == n)
+      return  -1;
+
+    if (n > size)
+      n = size;
+
+    memcpy (buf, mInput.data () + mPos, n);
+    mPos += n;
+    return  static_cast<int> (n);
+  }
+};	// FuzzConnection ()
+
+
+//! Monitor commands the harness must not run
+
+//! timeout and runfor could lift the instruction limit, checkpoint forks or
+//! writes files, and profile and coverage write files when dumped.
+
+static const char *blockedCmds[] =
+  { "timeout", "runfor", "checkpoint", "profile", "coverage" };
+
+//! The session the standalone harness mutates when given no files
+
+static const char *seedSession =
+  "qSupported:multiprocess+;swbreak+;hwbreak+\n"
+  "!\n"
+  "Hg0\n"
+  "qTStatus\n"
+  "?\n"
+  "qC\n"
+  "qAttached\n"
+  "g\n"
+  "p20\n"
+  "P5=78563412\n"
+  "M0,10:9302100093021000b70100806f00c0ff\n"
+  "X10,4:\x13\x01\x02\x03\n"
+  "m0,14\n"
+  "qCRC:0,10\n"
+  "Z0,8,4\n"
+  "c\n"
+  "z0,8,4\n"
+  "s\n"
+  "vCont;s:1\n"
+  "vCont;c\n"
+  "qRcmd,7265766572736520";
+
+
+//! Add a packet to a session, followed by the client's ack
+
+//! @param[out] session  The session
+//! @param[in]  body     The body of the packet
+
+static void
+addPacket (string & session,
+	   const string & body)
+{
+  unsigned char  checksum = 0;
+
+  for (char c : body)
+    checksum += static_cast<unsigned char> (c);
+
+  session += '$';
+  session += body;
+  session += '#';
+  session += Utils::hex2Char (checksum >> 4);
+  session += Utils::hex2Char (checksum & 0xf);
+  session += '+';
+
+}	// addPacket ()
+
+
+//! Is a packet body a monitor command the harness must not run?
+
+//! @param[in] body  The body of the packet
+//! @return  TRUE if the body is a blocked monitor command
+
+static bool
+isBlockedCmd (const string & body)
+{
+  static const string  prefix ("qRcmd,");
+
+  if (0 != body.compare (0, prefix.size (), prefix))
+    return  false;
+
+  // Decode as much of the command as there are valid hex digits for.
+  string  cmd;
+
+  for (std::size_t  i = prefix.size (); i + 1 < body.size (); i += 2)
+    {
+      uint8_t  hi = Utils::char2Hex (body[i]);
+      uint8_t  lo = Utils::char2Hex (body[i + 1]);
+
+      if ((hi > 0xf) || (lo > 0xf))
+	break;
+
+      cmd += static_cast<char> ((hi << 4) | lo);
+    }
+
+  vector<string>  words;
+  Utils::split (cmd, " ", words);
+
+  for (const string & word : words)
+    if (word == "dump")
+      return  true;
+
+  if (words.empty ())
+    return  false;
+
+  for (const char *blocked : blockedCmds)
+    if (words[0] == blocked)
+      return  true;
+
+  return  false;
+
+}	// isBlockedCmd ()
+
+
+//! Serve one session
+
+//! @param[in] data  The session, one packet body per line
+//! @param[in] size  The number of chars in the session
+
+static void
+runSession (const uint8_t *data,
+	    std::size_t    size)
+{
+  static const string  limitCmd ("timeout instrs 100000");
+
+  // Start by limiting how long a continue may run.
+  string  session;
+  string  body ("qRcmd,");
+
+  for (char c : limitCmd)
+    {
+      body += Utils::hex2Char (static_cast<uint8_t> (c) >> 4);
+      body += Utils::hex2Char (static_cast<uint8_t> (c) & 0xf);
+    }
+
+  addPacket (session, body);
+
+  // Then frame each line.
+  std::istringstream  lines (string (reinterpret_cast<const char *> (data),
+				     size));
+
+  while (std::getline (lines, body))
+    if (!isBlockedCmd (body))
+      addPacket (session, body);
+
+  TraceFlags *traceFlags = new TraceFlags ();
+  ITarget *cpu = new Iss (traceFlags);
+  AbstractConnection *conn = new FuzzConnection (traceFlags, session);
+  GdbServer *gdbServer =
+    new GdbServer (conn, cpu, traceFlags,
+		   GdbServer::KillBehaviour::END_SESSION);
+  cpu->gdbServer (gdbServer);
+
+  gdbServer->rspServer ();
+
+  delete  gdbServer;
+  delete  conn;
+  delete  cpu;
+  delete  traceFlags;
+
+}	// runSession ()
+
+
+//! The entry point for libFuzzer
+
+//! The server's warnings and monitor command output are not wanted.
+
+//! @param[in] data  The session, one packet body per line
+//! @param[in] size  The number of chars in the session
+//! @return  Zero, as libFuzzer requires.
+
+extern "C" int
+LLVMFuzzerTestOneInput (const uint8_t *data,
+			std::size_t    size)
+{
+  static bool  silenced = false;
+
+  if (!silenced)
+    {
+      cout.rdbuf (nullptr);
+      cerr.rdbuf (nullptr);
+      silenced = true;
+    }
+
+  runSession (data, size);
+  return  0;
+
+}	// LLVMFuzzerTestOneInput ()
+
+
+//! Function to handle $time calls in the Verilog
+
+//! There may be one model per thread, so ask the server running on this
+//! thread.
+
+double
+sc_time_stamp ()
+{
+  return GdbServer::timeStamp ();
+}
+
+
+#if !defined (RSP_FUZZ_LIBFUZZER)
+
+//! Mutate a session
+
+//! Each mutation flips, inserts or deletes a char, or duplicates or deletes
+//! a line.
+
+//! @param[in,out] s    The session to mutate
+//! @param[in]     rng  The random number generator to use
+
+static void
+mutate (string & s,
+	std::mt19937 & rng)
+{
+  int  numMutations = 1 + rng () % 4;
+
+  for (int  i = 0; i < numMutations; i++)
+    {
+      std::size_t  pos = s.empty () ? 0 : rng () % s.size ();
+      int          kind = rng () % 5;
+
+      switch (kind)
+	{
+	case 0:
+	  if (!s.empty ())
+	    s[pos] ^= static_cast<char> (1 << (rng () % 8));
+	  break;
+
+	case 1:
+	  s.insert (pos, 1, static_cast<char> (rng ()));
+	  break;
+
+	case 2:
+	  if (!s.empty ())
+	    s.erase (pos, 1);
+	  break;
+
+	case 3:
+	case 4:
+	  {
+	    // Find the line holding pos
+	    std::size_t  start = s.rfind ('\n', pos);
+	    std::size_t  end = s.find ('\n', pos);
+
+	    start = (string::npos == start) ? 0 : start + 1;
+	    end = (string::npos == end) ? s.size () : end;
+
+	    if (3 == kind)
+	      s.insert (start, s.substr (start, end - start) + '\n');
+	    else
+	      s.erase (start, end - start);
+	  }
+	  break;
+	}
+    }
+}	// mutate ()
+
+
+//! Main program when not built with libFuzzer
+
+//! Usage: rsp-fuzz [-runs=<n>] [-seed=<n>] [<file> ...]
+
+//! Each file is replayed as a session. With no files, -runs=<n> mutated
+//! copies of the built in session are served (default 1000). Any crash is a
+//! bug, and the session which caused it is in rsp-fuzz-crash.
+
+//! @param[in] argc  Number of arguments
+//! @param[in] argv  The arguments
+//! @return  EXIT_SUCCESS, unless the arguments are bad.
+
+int
+main (int   argc,
+      char *argv[])
+{
+  unsigned long int  runs = 1000;
+  unsigned long int  seed = 1;
+  vector<string>     files;
+
+  for (int  i = 1; i < argc; i++)
+    {
+      if (0 == strncmp (argv[i], "-runs=", strlen ("-runs=")))
+	runs = strtoul (argv[i] + strlen ("-runs="), nullptr, 0);
+      else if (0 == strncmp (argv[i], "-seed=", strlen ("-seed=")))
+	seed = strtoul (argv[i] + strlen ("-seed="), nullptr, 0);
+      else if ('-' == argv[i][0])
+	{
+	  cerr << "Usage: rsp-fuzz [-runs=<n>] [-seed=<n>] [<file> ...]"
+	       << endl;
+	  return  EXIT_FAILURE;
+	}
+      else
+	files.push_back (argv[i]);
+    }
+
+  std::streambuf *coutBuf = cout.rdbuf ();
+
+  if (!files.empty ())
+    {
+      for (const string & file : files)
+	{
+	  std::ifstream  is (file, std::ios::binary);
+	  std::ostringstream  session;
+
+	  session << is.rdbuf ();
+	  string  s = session.str ();
+	  LLVMFuzzerTestOneInput (reinterpret_cast<const uint8_t *> (s.data ()),
+				  s.size ());
+	}
+
+      cout.rdbuf (coutBuf);
+      cout << "Replayed " << files.size () << " sessions" << endl;
+      return  EXIT_SUCCESS;
+    }
+
+  std::mt19937  rng (seed);
+
+  for (unsigned long int  run = 0; run < runs; run++)
+    {
+      string  s (seedSession);
+
+      mutate (s, rng);
+
+      // Keep the session, so it is there if we crash.
+      std::ofstream  os ("rsp-fuzz-crash", std::ios::binary);
+      os << s;
+      os.close ();
+
+      LLVMFuzzerTestOneInput (reinterpret_cast<const uint8_t *> (s.data ()),
+			      s.size ());
+    }
+
+  remove ("rsp-fuzz-crash");
+  cout.rdbuf (coutBuf);
+  cout << "Served " << runs << " mutated sessions" << endl;
+  return  EXIT_SUCCESS;
+
+}	// main ()
+
+#endif	// !RSP_FUZZ_LIBFUZZER
+
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// End:
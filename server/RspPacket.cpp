@@ -108,18 +108,9 @@ RspPacket::packHexstr (const char *str)
       slen = bufSize / 2 - 1;
     }
 
-  // Construct the string the hard way
   data[0] = 'O';
-  for (std::size_t i = 0; i < slen; i++)
-    {
-      int nybble_hi = str[i] >> 4;
-      int nybble_lo = str[i] & 0x0f;
-
-      data[i * 2 + 1] = nybble_hi + (nybble_hi > 9 ? 'a' - 10 : '0');
-      data[i * 2 + 2] = nybble_lo + (nybble_lo > 9 ? 'a' - 10 : '0');
-    }
+  Utils::bin2Hex (&(data[1]), reinterpret_cast<const uint8_t *> (str), slen);
   len       = slen * 2 + 1;
-  data[len] = 0;
 
 }	// packStr ()
 
@@ -138,18 +129,35 @@ void
 RspPacket::packRcmdStr (const char *str,
 			const bool toStdoutP)
 {
-  std::size_t slen = strlen (str);
+  packRcmdStr (str, strlen (str), toStdoutP);
+
+}	// packRcmdStr ()
 
+
+//! Pack some characters as a hex encoded string into a packet for qRcmd.
+
+//! As above, but the characters need not be null terminated.
+
+//! @param  str        The characters to copy into the data packet
+//! @param  slen       The number of characters
+//! @param  toStdoutP  TRUE if the client should send to stdout, FALSE if the
+//!                    result should silently go into a buffer.
+
+void
+RspPacket::packRcmdStr (const char *str,
+			std::size_t slen,
+			const bool toStdoutP)
+{
   // Construct the packet to send, so long as string is not too big, otherwise
   // truncate. Add EOS at the end for convenient debug printout
   if (slen >= (bufSize / 2 - 1))
     {
-      cerr << "Warning: String \"" << str
-		<< "\" too large for RSP packet: truncated\n" << endl;
+      cerr << "Warning: String \"";
+      cerr.write (str, slen);
+      cerr << "\" too large for RSP packet: truncated\n" << endl;
       slen = bufSize / 2 - 1;
     }
 
-  // Construct the string the hard way
   int offset;
   if (toStdoutP)
     {
@@ -161,18 +169,9 @@ RspPacket::packRcmdStr (const char *str,
       offset = 0;
     }
 
-  for (unsigned int i = 0; i < slen; i++)
-    {
-      uint8_t nybble_hi = str[i] >> 4;
-      uint8_t nybble_lo = str[i] & 0x0f;
-
-      data[i * 2 + offset + 0] =
-	  static_cast<char> (nybble_hi + (nybble_hi > 9 ? 'a' - 10 : '0'));
-      data[i * 2 + offset + 1] =
-	  static_cast<char> (nybble_lo + (nybble_lo > 9 ? 'a' - 10 : '0'));
-    }
+  Utils::bin2Hex (&(data[offset]), reinterpret_cast<const uint8_t *> (str),
+		  slen);
   len       = slen * 2 + offset;
-  data[len] = 0;
 
 }	// packRcmdStr ()
 
@@ -44,6 +44,9 @@ public:
   void  packStr (const char * str);	// For fixed packets
   void  packRcmdStr (const char * str,	// For qRcmd replies
 		     const bool   toStdoutP);
+  void  packRcmdStr (const char * str,
+		     std::size_t  slen,
+		     const bool   toStdoutP);
 
   // Pack a hex encoded string into a packet
   void  packHexstr (const char *str);
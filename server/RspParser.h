@@ -0,0 +1,223 @@
+// Parse the fields of an RSP request
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef RSP_PARSER_H
+#define RSP_PARSER_H
+
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+
+#include "RspPacket.h"
+
+
+//! A cursor over the fields of an RSP request.
+
+//! This replaces sscanf for breaking out requests such as "m<addr>,<len>".
+//! It reads the packet buffer in place, so nothing is copied or allocated,
+//! it does not depend on the locale and it never reads past the end of the
+//! packet. Each function consumes a field and returns TRUE, or returns FALSE
+//! if the field is not there. Unlike sscanf, no white space or "0x" prefix
+//! is skipped and a number too large for its variable is an error.
+
+class RspParser
+{
+public:
+
+  //! Constructor for a packet
+
+  //! @param[in] pkt  The packet, which need not be null terminated
+
+  explicit RspParser (RspPacket *pkt)
+    : mPos (pkt->data),
+      mEnd (pkt->data + pkt->getLen ())
+  {
+  }
+
+  //! Constructor for any characters
+
+  //! @param[in] buf  The characters
+  //! @param[in] len  The number of characters
+
+  RspParser (const char *buf,
+	     std::size_t  len)
+    : mPos (buf),
+      mEnd (buf + len)
+  {
+  }
+
+  //! Consume a character
+
+  //! @param[in] c  The character expected
+  //! @return  TRUE if it was next, FALSE otherwise.
+
+  bool lit (char  c)
+  {
+    if ((mPos == mEnd) || (*mPos != c))
+      return false;
+
+    mPos++;
+    return true;
+  }
+
+  //! Consume a string
+
+  //! @param[in] s  The null terminated string expected
+  //! @return  TRUE if it was next, FALSE otherwise.
+
+  bool lit (const char *s)
+  {
+    std::size_t  n = strlen (s);
+
+    if ((remaining () < n) || (0 != memcmp (mPos, s, n)))
+      return false;
+
+    mPos += n;
+    return true;
+  }
+
+  //! Consume an unsigned hex number
+
+  //! @param[out] val  The value, only set if there is one
+  //! @return  TRUE if there was at least one hex digit and the value fitted,
+  //!          FALSE otherwise.
+
+  template <typename T>
+  bool hex (T &val)
+  {
+    const T  limit = std::numeric_limits<T>::max () >> 4;
+    const char *p = mPos;
+    T  res = 0;
+
+    for (; p < mEnd; p++)
+      {
+	int  d = digit (*p);
+
+	if (d < 0)
+	  break;
+
+	if (res > limit)
+	  return false;
+
+	res = (res << 4) | static_cast<T> (d);
+      }
+
+    if (p == mPos)
+      return false;
+
+    mPos = p;
+    val = res;
+    return true;
+  }
+
+  //! Consume a signed decimal number
+
+  //! @param[out] val  The value, only set if there is one
+  //! @return  TRUE if there was at least one digit and the value fitted,
+  //!          FALSE otherwise.
+
+  bool dec (int &val)
+  {
+    const char *p = mPos;
+    bool  neg = (p < mEnd) && ('-' == *p);
+    unsigned int  limit = neg ? static_cast<unsigned int> (INT_MAX) + 1
+                              : INT_MAX;
+    unsigned int  res = 0;
+
+    if (neg)
+      p++;
+
+    const char *start = p;
+
+    for (; (p < mEnd) && (*p >= '0') && (*p <= '9'); p++)
+      {
+	unsigned int  d = *p - '0';
+
+	if (res > (limit - d) / 10)
+	  return false;
+
+	res = res * 10 + d;
+      }
+
+    if (p == start)
+      return false;
+
+    mPos = p;
+    val = neg ? static_cast<int> (0 - res) : static_cast<int> (res);
+    return true;
+  }
+
+  //! Have all the characters been consumed?
+
+  bool atEnd () const
+  {
+    return mPos == mEnd;
+  }
+
+  //! The next character to be consumed
+
+  const char *pos () const
+  {
+    return mPos;
+  }
+
+  //! The number of characters left
+
+  std::size_t remaining () const
+  {
+    return mEnd - mPos;
+  }
+
+
+private:
+
+  //! The next character
+  const char *mPos;
+
+  //! One past the last character
+  const char *mEnd;
+
+  //! The value of a hex digit
+
+  //! @param[in] c  The character
+  //! @return  The value, or -1 if it is not a hex digit.
+
+  static int digit (char  c)
+  {
+    if ((c >= '0') && (c <= '9'))
+      return c - '0';
+
+    c |= 0x20;			// Lower case
+
+    if ((c >= 'a') && (c <= 'f'))
+      return c - 'a' + 10;
+
+    return -1;
+  }
+};
+
+
+#endif	// RSP_PARSER_H
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// show-trailing-whitespace: t
+// End:
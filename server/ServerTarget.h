@@ -0,0 +1,68 @@
+// The type of target the server calls: declaration
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SERVER_TARGET_H
+#define SERVER_TARGET_H
+
+#include "config.h"
+
+// Normally the server may be given any target, so calls it through the
+// ITarget interface. A server configured --with-single-target is only ever
+// given that one target. Since each target class is final, calls through a
+// pointer to it are direct calls rather than virtual calls. Configure then
+// also optimizes at link time, so that the target's calls to its
+// implementation class, in another file, can be inlined too.
+
+#if defined (SINGLE_TARGET_RI5CY)
+
+#include "Ri5cy.h"
+
+//! The type of target the server calls
+typedef Ri5cy  ServerTarget;
+
+#elif defined (SINGLE_TARGET_PICORV32)
+
+#include "Picorv32.h"
+
+//! The type of target the server calls
+typedef Picorv32  ServerTarget;
+
+#elif defined (SINGLE_TARGET_GDBSIM)
+
+#include "GdbSim.h"
+
+//! The type of target the server calls
+typedef GdbSim  ServerTarget;
+
+#else
+
+#include "ITarget.h"
+
+//! The type of target the server calls
+typedef ITarget  ServerTarget;
+
+#endif
+
+#endif	// SERVER_TARGET_H
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// show-trailing-whitespace: t
+// End:
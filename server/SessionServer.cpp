@@ -0,0 +1,294 @@
+// Multi-session GDB server: implementation
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// ----------------------------------------------------------------------------
+
+#include <iostream>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "SessionServer.h"
+#include "GdbServer.h"
+#include "ITarget.h"
+#include "RspConnection.h"
+#include "TargetPool.h"
+#include "TraceFlags.h"
+
+using std::cerr;
+using std::cout;
+using std::chrono::system_clock;
+using std::endl;
+using std::flush;
+using std::lock_guard;
+using std::mutex;
+using std::thread;
+using std::unique_lock;
+
+
+//! Constructor
+
+//! Nothing happens until ::run () is called.
+
+//! @param[in] _portNum       The port to listen on
+//! @param[in] _coreName      The core to create for each session
+//! @param[in] _traceFlags    Initial trace flags for each session
+//! @param[in] _createTarget  Function to create a target
+//! @param[in] _numWorkers    Maximum number of concurrent sessions
+//! @param[in] _pool          Pool of ready built targets, or nullptr
+
+SessionServer::SessionServer (int           _portNum,
+			      const char *  _coreName,
+			      TraceFlags *  _traceFlags,
+			      TargetFactory _createTarget,
+			      unsigned int  _numWorkers,
+			      TargetPool *  _pool) :
+  mPortNum (_portNum),
+  mCoreName (_coreName),
+  mTraceFlags (_traceFlags),
+  mCreateTarget (_createTarget),
+  mNumWorkers (_numWorkers),
+  mPool (_pool),
+  mShutdown (false)
+{
+}	// SessionServer ()
+
+
+//! Destructor
+
+//! Let any running sessions finish.
+
+SessionServer::~SessionServer ()
+{
+  stopWorkers ();
+
+}	// ~SessionServer ()
+
+
+//! Accept clients and hand them to the workers
+
+//! Only returns on a fatal error with the listening socket.
+
+//! @return  The exit code for the program
+
+int
+SessionServer::run ()
+{
+  int  listenFd = listenSocket ();
+
+  if (listenFd < 0)
+    return  EXIT_FAILURE;
+
+  for (unsigned int  i = 0; i < mNumWorkers; i++)
+    mWorkers.push_back (thread (&SessionServer::worker, this));
+
+  if (! mTraceFlags->traceSilent ())
+    cout << "Listening for RSP on port " << mPortNum << " (" << mNumWorkers
+	 << " sessions)" << endl << flush;
+
+  while (true)
+    {
+      struct sockaddr_in  sockAddr;
+      socklen_t  len = sizeof (sockAddr);
+      int  clientFd = accept (listenFd, (struct sockaddr *) &sockAddr, &len);
+
+      if (-1 == clientFd)
+	{
+	  // Transient failures just lose that client
+	  if ((EINTR == errno) || (ECONNABORTED == errno) || (EPROTO == errno))
+	    continue;
+
+	  cerr << "ERROR: Failed to accept RSP client: " << strerror (errno)
+	       << endl;
+	  break;
+	}
+
+      if (mTraceFlags->traceConn ())
+	cout << "RSP session from host " << inet_ntoa (sockAddr.sin_addr)
+	     << endl;
+
+      {
+	lock_guard<mutex>  lock (mPendingMutex);
+	mPending.push_back ({ clientFd, system_clock::now () });
+      }
+
+      mPendingCond.notify_one ();
+    }
+
+  close (listenFd);
+  stopWorkers ();
+  return  EXIT_FAILURE;
+
+}	// run ()
+
+
+//! Open the listening socket
+
+//! Unlike RspConnection, we keep this open and allow a backlog, since many
+//! clients are expected.
+
+//! @return  The socket file descriptor, or -1 on failure
+
+int
+SessionServer::listenSocket ()
+{
+  int  fd = socket (PF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+  if (fd < 0)
+    {
+      cerr << "ERROR: Cannot open RSP socket" << endl;
+      return  -1;
+    }
+
+  // Allow rapid reuse of the port on this socket
+  int  optval = 1;
+  setsockopt (fd, SOL_SOCKET, SO_REUSEADDR, (char *)&optval,
+	      sizeof (optval));
+
+  struct sockaddr_in  sockAddr;
+  sockAddr.sin_family      = PF_INET;
+  sockAddr.sin_port        = htons (mPortNum);
+  sockAddr.sin_addr.s_addr = INADDR_ANY;
+
+  if (bind (fd, (struct sockaddr *) &sockAddr, sizeof (sockAddr)))
+    {
+      cerr << "ERROR: Cannot bind to RSP socket" << endl;
+      close (fd);
+      return  -1;
+    }
+
+  if (listen (fd, SOMAXCONN))
+    {
+      cerr << "ERROR: Cannot listen on RSP socket" << endl;
+      close (fd);
+      return  -1;
+    }
+
+  return  fd;
+
+}	// listenSocket ()
+
+
+//! Worker thread body
+
+//! Serve queued clients one at a time until told to shut down.
+
+void
+SessionServer::worker ()
+{
+  while (true)
+    {
+      PendingClient  client;
+
+      {
+	unique_lock<mutex>  lock (mPendingMutex);
+
+	mPendingCond.wait (lock, [this] {
+	    return  mShutdown || !mPending.empty ();
+	  });
+
+	if (mPending.empty ())
+	  return;			// Shutting down
+
+	client = mPending.front ();
+	mPending.pop_front ();
+      }
+
+      serveSession (client);
+    }
+}	// worker ()
+
+
+//! Run one complete GDB session
+
+//! Everything the session touches is created here and freed at the end, so
+//! sessions cannot interfere. The trace flags are copied, so that "monitor
+//! set debug" only affects the session which issued it. Targets from a pool
+//! are built with the original trace flags.
+
+//! @param[in] client  The accepted client
+
+void
+SessionServer::serveSession (const PendingClient & client)
+{
+  TraceFlags * traceFlags = new TraceFlags (*mTraceFlags);
+  ITarget * cpu = (nullptr == mPool) ? mCreateTarget (mCoreName, traceFlags)
+				     : mPool->take ();
+
+  if (nullptr == cpu)
+    {
+      cerr << "ERROR: Unable to create core for session: closing connection"
+	   << endl;
+      close (client.fd);
+      delete  traceFlags;
+      return;
+    }
+
+  AbstractConnection * conn = new RspConnection (traceFlags, client.fd);
+  GdbServer * gdbServer =
+    new GdbServer (conn, cpu, traceFlags,
+		   GdbServer::KillBehaviour::END_SESSION, mPool);
+  cpu->gdbServer (gdbServer);
+  gdbServer->sessionStart (client.accepted);
+
+  (void) gdbServer->rspServer ();
+
+  // The target may still refer to the flags, so they go last. With a pool,
+  // the server owns the target.
+  delete  conn;
+  delete  gdbServer;
+
+  if (nullptr == mPool)
+    delete  cpu;
+
+  delete  traceFlags;
+
+}	// serveSession ()
+
+
+//! Tell the workers to finish and wait for them
+
+//! Clients still queued are served first.
+
+void
+SessionServer::stopWorkers ()
+{
+  {
+    lock_guard<mutex>  lock (mPendingMutex);
+    mShutdown = true;
+  }
+
+  mPendingCond.notify_all ();
+
+  for (auto & w : mWorkers)
+    w.join ();
+
+  mWorkers.clear ();
+
+}	// stopWorkers ()
+
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// End:
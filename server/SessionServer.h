@@ -0,0 +1,141 @@
+// Multi-session GDB server: declaration
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SESSION_SERVER_H
+#define SESSION_SERVER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Classes needed for the declaration
+
+class ITarget;
+class TargetPool;
+class TraceFlags;
+
+
+//! Serve many independent GDB sessions from one process.
+
+//! A single listening socket accepts clients, which are queued and picked up
+//! by a fixed pool of worker threads. Each session gets its own target,
+//! trace flags, connection and GdbServer, so sessions share nothing but the
+//! process. A session ends when its client disconnects or kills the target.
+
+//! If all workers are busy, new clients wait in the queue until one frees.
+
+//! If a target pool is given, sessions take their targets from it rather
+//! than building them.
+
+class SessionServer
+{
+public:
+
+  //! Function used to create a target for each session
+
+  typedef ITarget * (*TargetFactory) (const char * name,
+				      TraceFlags * traceFlags);
+
+  // Constructor and destructor
+
+  SessionServer (int           _portNum,
+		 const char *  _coreName,
+		 TraceFlags *  _traceFlags,
+		 TargetFactory _createTarget,
+		 unsigned int  _numWorkers,
+		 TargetPool *  _pool = nullptr);
+  ~SessionServer ();
+
+  // Main loop, accepting clients
+
+  int  run ();
+
+private:
+
+  //! The port number to listen on
+
+  int  mPortNum;
+
+  //! The core each session should use
+
+  const char * mCoreName;
+
+  //! Trace flags used as the starting point for every session
+
+  TraceFlags * mTraceFlags;
+
+  //! How we make targets
+
+  TargetFactory  mCreateTarget;
+
+  //! How many sessions may run at once
+
+  unsigned int  mNumWorkers;
+
+  //! Pool of ready built targets, or nullptr
+
+  TargetPool * mPool;
+
+  //! A client waiting for a worker
+
+  struct PendingClient
+  {
+    int  fd;
+    std::chrono::system_clock::time_point  accepted;
+  };
+
+  //! The worker threads
+
+  std::vector<std::thread>  mWorkers;
+
+  //! Accepted clients waiting for a worker
+
+  std::deque<PendingClient>  mPending;
+
+  //! Guard for mPending
+
+  std::mutex  mPendingMutex;
+
+  //! Signalled when a client is added to mPending
+
+  std::condition_variable  mPendingCond;
+
+  //! Set when the workers should finish once the queue is empty
+
+  bool  mShutdown;
+
+  // Helper functions
+
+  int   listenSocket ();
+  void  worker ();
+  void  serveSession (const PendingClient & client);
+  void  stopWorkers ();
+
+};	// SessionServer ()
+
+#endif	// SESSION_SERVER_H
+
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// End:
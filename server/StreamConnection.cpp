@@ -113,25 +113,26 @@ StreamConnection::isConnected ()
   return mIsConnected;
 }	// isConnected ()
 
-//! Put a single character out on the RSP connection
+//! Put a buffer of characters out on the RSP connection
 
-//! Utility routine. This should only be called if the client is open, but we
-//! check for safety.
+//! @param[in] buf  The characters to put out
+//! @param[in] len  The number of characters
 
-//! @param[in] c         The character to put out
-
-//! @return  TRUE if char sent OK, FALSE if not (communications failure)
+//! @return  TRUE if the chars were sent OK, FALSE if not (communications
+//!          failure)
 
 bool
-StreamConnection::putRspCharRaw (char  c)
+StreamConnection::putRspBytesRaw (const char  *buf,
+				  std::size_t  len)
 {
-  // Write until successful (we retry after interrupts) or catastrophic
-  // failure.
-  while (true)
+  // Write until all written (we retry after interrupts and partial writes)
+  // or catastrophic failure.
+  while (len > 0)
     {
-      switch (write (STDOUT_FILENO, &c, sizeof (c)))
+      ssize_t  n = write (STDOUT_FILENO, buf, len);
+
+      if (-1 == n)
 	{
-	case -1:
 	  // Error: only allow interrupts or would block
 	  if ((EAGAIN != errno) && (EINTR != errno))
 	    {
@@ -140,37 +141,40 @@ StreamConnection::putRspCharRaw (char  c)
 			<<  strerror (errno) << endl;
 	      return  false;
 	    }
-
-	  break;
-
-	case 0:
-	  break;		// Nothing written! Try again
-
-	default:
-	  return  true;		// Success, we can return
+	}
+      else
+	{
+	  buf += n;
+	  len -= n;
 	}
     }
-}	// putRspCharRaw ()
+
+  return  true;
+
+}	// putRspBytesRaw ()
 
 
-//! Get a single character from the RSP connection
+//! Get a buffer of characters from the RSP connection
 
-//! Utility routine. This should only be called if the client is open, but we
-//! check for safety.
+//! As many characters as are available are returned, up to the size of the
+//! buffer.
 
-//! @param[in] blocking  True if the read should block.
-//! @return  The character received or -1 on failure, or if the read would
-//!          block, and blocking is true.
+//! @param[out] buf       Where to put the characters
+//! @param[in]  size      The size of the buffer
+//! @param[in]  blocking  True if the read should block.
+//! @return  The number of characters received or -1 on failure, or if the
+//!          read would block, and blocking is false.
 
 int
-StreamConnection::getRspCharRaw (bool blocking)
+StreamConnection::getRspBytesRaw (char        *buf,
+				  std::size_t  size,
+				  bool         blocking)
 {
   // Blocking read until successful (we retry after interrupts) or
   // catastrophic failure.
 
   for (;;)
     {
-      unsigned char  c;
       int res;
       struct timeval timeout;
       fd_set readfds;
@@ -200,24 +204,21 @@ StreamConnection::getRspCharRaw (bool blocking)
   	  break;
 
   	case 0:
-          // Timeout, only happens in the blocking case.
+          // Timeout, only happens in the non-blocking case.
   	  return  -1;
 
   	default:
 	  {
 	    ssize_t count;
 
-	    if ((count = read (STDIN_FILENO, &c, sizeof (c))) == -1)
-	      return -1;
-
-	    if (count == 0)
+	    if ((count = read (STDIN_FILENO, buf, size)) <= 0)
 	      return -1;
 
-	    return  c & 0xff;	// Success, we can return (no sign extend!)
+	    return  count;	// Success, we can return
 	  }
   	}
     }
-}	// getRspCharRaw ()
+}	// getRspBytesRaw ()
 
 
 // Local Variables:
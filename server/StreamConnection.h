@@ -45,10 +45,13 @@ public:
 
 private:
 
-  // Implementation specific routines to handle individual chars.
+  // Implementation specific routines to handle buffers of chars.
 
-  virtual bool  putRspCharRaw (char  c);
-  virtual int   getRspCharRaw (bool blocking);
+  virtual bool  putRspBytesRaw (const char  *buf,
+				std::size_t  len);
+  virtual int   getRspBytesRaw (char        *buf,
+				std::size_t  size,
+				bool         blocking);
 
   // Track whether we are connected or not.
   bool mIsConnected;
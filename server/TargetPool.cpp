@@ -0,0 +1,248 @@
+// Pool of pre-built targets: implementation
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// ----------------------------------------------------------------------------
+
+#include <iomanip>
+
+#include "TargetPool.h"
+#include "ITarget.h"
+#include "TraceFlags.h"
+
+using std::cerr;
+using std::chrono::duration;
+using std::chrono::system_clock;
+using std::chrono::time_point;
+using std::endl;
+using std::fixed;
+using std::lock_guard;
+using std::mutex;
+using std::setprecision;
+using std::thread;
+using std::unique_lock;
+using std::vector;
+
+
+//! Constructor
+
+//! Start the background thread, which immediately begins filling the pool.
+
+//! @param[in] _coreName      The core to build
+//! @param[in] _traceFlags    Trace flags for every target
+//! @param[in] _createTarget  Function to create a target
+//! @param[in] _size          Number of targets to keep ready
+
+TargetPool::TargetPool (const char *  _coreName,
+			TraceFlags *  _traceFlags,
+			TargetFactory _createTarget,
+			unsigned int  _size) :
+  mCoreName (_coreName),
+  mTraceFlags (_traceFlags),
+  mCreateTarget (_createTarget),
+  mSize (_size),
+  mShutdown (false),
+  mFailed (false),
+  mTakes (0),
+  mHits (0),
+  mBuilds (0),
+  mBuildTime (duration<double>::zero ()),
+  mWaitTime (duration<double>::zero ()),
+  mMaxWait (duration<double>::zero ())
+{
+  mRefiller = thread (&TargetPool::refill, this);
+
+}	// TargetPool ()
+
+
+//! Destructor
+
+//! Stop the background thread and delete every target we still hold.
+
+TargetPool::~TargetPool ()
+{
+  {
+    lock_guard<mutex>  lock (mMutex);
+    mShutdown = true;
+  }
+
+  mWork.notify_one ();
+  mRefiller.join ();
+
+  for (auto cpu : mReady)
+    delete  cpu;
+
+  for (auto cpu : mRetired)
+    delete  cpu;
+
+}	// ~TargetPool ()
+
+
+//! Take a target from the pool
+
+//! If none is ready, build one now rather than wait for the background
+//! thread, which may be busy building for someone else.
+
+//! @return  A freshly built target, owned by the caller, or nullptr if the
+//!          target could not be built.
+
+ITarget *
+TargetPool::take ()
+{
+  time_point<system_clock, duration<double> >  start = system_clock::now ();
+  ITarget * cpu = nullptr;
+
+  {
+    lock_guard<mutex>  lock (mMutex);
+
+    if (! mReady.empty ())
+      {
+	cpu = mReady.front ();
+	mReady.pop_front ();
+	mHits++;
+      }
+
+    mTakes++;
+  }
+
+  mWork.notify_one ();
+
+  if (nullptr == cpu)
+    cpu = mCreateTarget (mCoreName, mTraceFlags);
+
+  duration<double>  wait = system_clock::now () - start;
+
+  {
+    lock_guard<mutex>  lock (mMutex);
+
+    mWaitTime += wait;
+
+    if (wait > mMaxWait)
+      mMaxWait = wait;
+  }
+
+  return  cpu;
+
+}	// take ()
+
+
+//! Give a finished target back to the pool
+
+//! It will be deleted on the background thread.
+
+//! @param[in] cpu  The target, which the caller must no longer use.
+
+void
+TargetPool::retire (ITarget * cpu)
+{
+  {
+    lock_guard<mutex>  lock (mMutex);
+    mRetired.push_back (cpu);
+  }
+
+  mWork.notify_one ();
+
+}	// retire ()
+
+
+//! Report pool statistics
+
+//! @param[in] s  The stream to write to
+
+void
+TargetPool::report (std::ostream & s)
+{
+  lock_guard<mutex>  lock (mMutex);
+
+  s << "Pool size:           " << mSize << endl
+    << "Targets ready:       " << mReady.size () << endl
+    << "Targets taken:       " << mTakes << " (" << mHits << " ready, "
+    << (mTakes - mHits) << " built on demand)" << endl
+    << fixed << setprecision (6);
+
+  if (mBuilds > 0)
+    s << "Mean build time:     " << (mBuildTime.count () / mBuilds) << " s"
+      << endl;
+
+  if (mTakes > 0)
+    s << "Mean take time:      " << (mWaitTime.count () / mTakes) << " s"
+      << endl
+      << "Max take time:       " << mMaxWait.count () << " s" << endl;
+
+}	// report ()
+
+
+//! Background thread body
+
+//! Delete retired targets and build new ones until the pool is full, then
+//! sleep until something changes.
+
+void
+TargetPool::refill ()
+{
+  while (true)
+    {
+      vector<ITarget *>  retired;
+      bool  wantBuild;
+
+      {
+	unique_lock<mutex>  lock (mMutex);
+
+	mWork.wait (lock, [this] {
+	    return  mShutdown || !mRetired.empty ()
+	      || (!mFailed && (mReady.size () < mSize));
+	  });
+
+	if (mShutdown)
+	  return;
+
+	retired.swap (mRetired);
+	wantBuild = !mFailed && (mReady.size () < mSize);
+      }
+
+      for (auto cpu : retired)
+	delete  cpu;
+
+      if (! wantBuild)
+	continue;
+
+      time_point<system_clock, duration<double> >  start =
+	system_clock::now ();
+      ITarget * cpu = mCreateTarget (mCoreName, mTraceFlags);
+      duration<double>  buildTime = system_clock::now () - start;
+
+      lock_guard<mutex>  lock (mMutex);
+
+      if (nullptr == cpu)
+	{
+	  cerr << "Warning: Unable to build target for pool: "
+	       << "pool disabled" << endl;
+	  mFailed = true;
+	  continue;
+	}
+
+      mReady.push_back (cpu);
+      mBuilds++;
+      mBuildTime += buildTime;
+    }
+}	// refill ()
+
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// End:
@@ -0,0 +1,160 @@
+// Pool of pre-built targets: declaration
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TARGET_POOL_H
+#define TARGET_POOL_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Classes needed for the declaration
+
+class ITarget;
+class TraceFlags;
+
+
+//! A pool of targets built and reset ahead of time.
+
+//! Building a target (for example constructing a Verilator model and taking
+//! it through reset) can take a significant time. A background thread keeps
+//! a number of freshly built targets ready, so that a new session or a cold
+//! reset can take one immediately. Finished targets are handed back with
+//! ::retire () and deleted on the background thread too.
+
+//! If the pool is empty when a target is wanted, one is built synchronously
+//! by the caller, and counted as a miss.
+
+//! All targets are built with the same trace flags, which must outlive the
+//! pool.
+
+class TargetPool
+{
+public:
+
+  //! Function used to create a target
+
+  typedef ITarget * (*TargetFactory) (const char * name,
+				      TraceFlags * traceFlags);
+
+  // Constructor and destructor
+
+  TargetPool (const char *  _coreName,
+	      TraceFlags *  _traceFlags,
+	      TargetFactory _createTarget,
+	      unsigned int  _size);
+  ~TargetPool ();
+
+  // Get and give back targets
+
+  ITarget * take ();
+  void  retire (ITarget * cpu);
+
+  // Statistics
+
+  void  report (std::ostream & s);
+
+private:
+
+  //! The core to build
+
+  const char * mCoreName;
+
+  //! Trace flags for every target we build
+
+  TraceFlags * mTraceFlags;
+
+  //! How we make targets
+
+  TargetFactory  mCreateTarget;
+
+  //! How many targets to keep ready
+
+  unsigned int  mSize;
+
+  //! Targets ready for use
+
+  std::deque<ITarget *>  mReady;
+
+  //! Targets waiting to be deleted
+
+  std::vector<ITarget *>  mRetired;
+
+  //! Guard for everything shared with the background thread
+
+  std::mutex  mMutex;
+
+  //! Signalled when the background thread may have something to do
+
+  std::condition_variable  mWork;
+
+  //! Set when the background thread should finish
+
+  bool  mShutdown;
+
+  //! Set if the factory ever fails, after which we stop building
+
+  bool  mFailed;
+
+  //! The background thread
+
+  std::thread  mRefiller;
+
+  //! Number of targets taken
+
+  uint64_t  mTakes;
+
+  //! Number of targets taken which were ready
+
+  uint64_t  mHits;
+
+  //! Number of targets built in the background
+
+  uint64_t  mBuilds;
+
+  //! Total time spent building targets in the background
+
+  std::chrono::duration<double>  mBuildTime;
+
+  //! Total time callers spent waiting in ::take ()
+
+  std::chrono::duration<double>  mWaitTime;
+
+  //! Longest time any caller spent waiting in ::take ()
+
+  std::chrono::duration<double>  mMaxWait;
+
+  // Background thread body
+
+  void  refill ();
+
+};	// TargetPool ()
+
+#endif	// TARGET_POOL_H
+
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// End:
@@ -20,8 +20,13 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 // ----------------------------------------------------------------------------
 
+#include <cstring>
 #include <iostream>
 
+#if defined (__SSE2__)
+#include <immintrin.h>
+#endif
+
 #include "Utils.h"
 
 using std::cout;
@@ -216,11 +221,231 @@ Utils::hex2Ascii (char *dest,
 }	// hex2ascii ()
 
 
+//! Convert a buffer of bytes to pairs of hex digits
+
+//! This is the bulk version of hex2Char, for memory and register contents.
+//! The destination is null terminated for convenience, so must have room
+//! for (len * 2 + 1) chars.
+
+//! Where the compiler targets AVX2 or SSE2, 32 or 16 bytes are converted at
+//! a time. Each nibble has '0' added, and another 39 if it is above 9, to
+//! reach 'a'. The high and low nibbles are then interleaved. Any tail is
+//! converted one byte at a time.
+
+//! @param[out] dest  Buffer for the hex digit pairs (null terminated)
+//! @param[in]  src   The bytes to convert
+//! @param[in]  len   The number of bytes to convert
+void
+Utils::bin2Hex (char          *dest,
+		const uint8_t *src,
+		std::size_t    len)
+{
+  std::size_t  i = 0;
+
+#if defined (__AVX2__)
+  {
+    const __m256i  mask = _mm256_set1_epi8 (0x0f);
+    const __m256i  nine = _mm256_set1_epi8 (9);
+    const __m256i  zero = _mm256_set1_epi8 ('0');
+    const __m256i  gap  = _mm256_set1_epi8 ('a' - '0' - 10);
+
+    for (; i + 32 <= len; i += 32)
+      {
+	__m256i  v  = _mm256_loadu_si256 ((const __m256i *) (src + i));
+	__m256i  hi = _mm256_and_si256 (_mm256_srli_epi16 (v, 4), mask);
+	__m256i  lo = _mm256_and_si256 (v, mask);
+
+	hi = _mm256_add_epi8 (_mm256_add_epi8 (hi, zero),
+			      _mm256_and_si256 (_mm256_cmpgt_epi8 (hi, nine),
+						gap));
+	lo = _mm256_add_epi8 (_mm256_add_epi8 (lo, zero),
+			      _mm256_and_si256 (_mm256_cmpgt_epi8 (lo, nine),
+						gap));
+
+	// Unpacking works within each 128-bit lane, so swap the middle
+	// quarters back into order.
+
+	__m256i  a = _mm256_unpacklo_epi8 (hi, lo);
+	__m256i  b = _mm256_unpackhi_epi8 (hi, lo);
+
+	_mm256_storeu_si256 ((__m256i *) (dest + i * 2),
+			     _mm256_permute2x128_si256 (a, b, 0x20));
+	_mm256_storeu_si256 ((__m256i *) (dest + i * 2 + 32),
+			     _mm256_permute2x128_si256 (a, b, 0x31));
+      }
+  }
+#endif
+
+#if defined (__SSE2__)
+  {
+    const __m128i  mask = _mm_set1_epi8 (0x0f);
+    const __m128i  nine = _mm_set1_epi8 (9);
+    const __m128i  zero = _mm_set1_epi8 ('0');
+    const __m128i  gap  = _mm_set1_epi8 ('a' - '0' - 10);
+
+    for (; i + 16 <= len; i += 16)
+      {
+	__m128i  v  = _mm_loadu_si128 ((const __m128i *) (src + i));
+	__m128i  hi = _mm_and_si128 (_mm_srli_epi16 (v, 4), mask);
+	__m128i  lo = _mm_and_si128 (v, mask);
+
+	hi = _mm_add_epi8 (_mm_add_epi8 (hi, zero),
+			   _mm_and_si128 (_mm_cmpgt_epi8 (hi, nine), gap));
+	lo = _mm_add_epi8 (_mm_add_epi8 (lo, zero),
+			   _mm_and_si128 (_mm_cmpgt_epi8 (lo, nine), gap));
+
+	_mm_storeu_si128 ((__m128i *) (dest + i * 2),
+			  _mm_unpacklo_epi8 (hi, lo));
+	_mm_storeu_si128 ((__m128i *) (dest + i * 2 + 16),
+			  _mm_unpackhi_epi8 (hi, lo));
+      }
+  }
+#endif
+
+  for (; i < len; i++)
+    {
+      dest[i * 2]     = hex2Char (src[i] >> 4);
+      dest[i * 2 + 1] = hex2Char (src[i] & 0xf);
+    }
+
+  dest[len * 2] = '\0';
+
+}	// bin2Hex ()
+
+
+//! Convert pairs of hex digits to a buffer of bytes
+
+//! This is the bulk version of char2Hex, for memory and register contents.
+//! Every digit is checked as it is converted, so there is no need for a
+//! separate pass to validate the packet.
+
+//! Where the compiler targets AVX2 or SSE2, 32 or 16 bytes are converted at
+//! a time. A char is a digit if subtracting '0' leaves at most 9, and a
+//! letter if lower casing it and subtracting 'a' leaves at most 5. Adjacent
+//! nibbles are then combined in 16-bit lanes and packed down to bytes. Any
+//! tail is converted one byte at a time.
+
+//! @param[out] dest  Buffer for the bytes
+//! @param[in]  src   The hex digit pairs, (len * 2) chars
+//! @param[in]  len   The number of bytes to convert
+//! @return  TRUE if all the chars were hex digits, FALSE otherwise, in which
+//!          case the contents of dest are undefined.
+bool
+Utils::hex2Bin (uint8_t     *dest,
+		const char  *src,
+		std::size_t  len)
+{
+  std::size_t  i = 0;
+
+#if defined (__AVX2__)
+  {
+    const __m256i  zero   = _mm256_set1_epi8 ('0');
+    const __m256i  nine   = _mm256_set1_epi8 (9);
+    const __m256i  lower  = _mm256_set1_epi8 (0x20);
+    const __m256i  a      = _mm256_set1_epi8 ('a');
+    const __m256i  five   = _mm256_set1_epi8 (5);
+    const __m256i  ten    = _mm256_set1_epi8 (10);
+    const __m256i  nibble = _mm256_set1_epi16 (0x00f0);
+
+    for (; i + 32 <= len; i += 32)
+      {
+	__m256i  res[2];
+
+	for (int  half = 0; half < 2; half++)
+	  {
+	    __m256i  c = _mm256_loadu_si256 ((const __m256i *)
+					     (src + i * 2 + half * 32));
+	    __m256i  d = _mm256_sub_epi8 (c, zero);
+	    __m256i  l = _mm256_sub_epi8 (_mm256_or_si256 (c, lower), a);
+	    __m256i  isD = _mm256_cmpeq_epi8 (_mm256_min_epu8 (d, nine), d);
+	    __m256i  isL = _mm256_cmpeq_epi8 (_mm256_min_epu8 (l, five), l);
+
+	    if (-1 != _mm256_movemask_epi8 (_mm256_or_si256 (isD, isL)))
+	      return  false;
+
+	    __m256i  v = _mm256_or_si256 (_mm256_and_si256 (isD, d),
+					  _mm256_and_si256
+					  (isL, _mm256_add_epi8 (l, ten)));
+
+	    res[half] = _mm256_or_si256
+	      (_mm256_and_si256 (_mm256_slli_epi16 (v, 4), nibble),
+	       _mm256_srli_epi16 (v, 8));
+	  }
+
+	// Packing works within each 128-bit lane, so put the quarters back
+	// into order.
+
+	_mm256_storeu_si256 ((__m256i *) (dest + i),
+			     _mm256_permute4x64_epi64
+			     (_mm256_packus_epi16 (res[0], res[1]), 0xd8));
+      }
+  }
+#endif
+
+#if defined (__SSE2__)
+  {
+    const __m128i  zero   = _mm_set1_epi8 ('0');
+    const __m128i  nine   = _mm_set1_epi8 (9);
+    const __m128i  lower  = _mm_set1_epi8 (0x20);
+    const __m128i  a      = _mm_set1_epi8 ('a');
+    const __m128i  five   = _mm_set1_epi8 (5);
+    const __m128i  ten    = _mm_set1_epi8 (10);
+    const __m128i  nibble = _mm_set1_epi16 (0x00f0);
+
+    for (; i + 16 <= len; i += 16)
+      {
+	__m128i  res[2];
+
+	for (int  half = 0; half < 2; half++)
+	  {
+	    __m128i  c = _mm_loadu_si128 ((const __m128i *)
+					  (src + i * 2 + half * 16));
+	    __m128i  d = _mm_sub_epi8 (c, zero);
+	    __m128i  l = _mm_sub_epi8 (_mm_or_si128 (c, lower), a);
+	    __m128i  isD = _mm_cmpeq_epi8 (_mm_min_epu8 (d, nine), d);
+	    __m128i  isL = _mm_cmpeq_epi8 (_mm_min_epu8 (l, five), l);
+
+	    if (0xffff != _mm_movemask_epi8 (_mm_or_si128 (isD, isL)))
+	      return  false;
+
+	    __m128i  v = _mm_or_si128 (_mm_and_si128 (isD, d),
+				       _mm_and_si128 (isL,
+						      _mm_add_epi8 (l, ten)));
+
+	    res[half] = _mm_or_si128
+	      (_mm_and_si128 (_mm_slli_epi16 (v, 4), nibble),
+	       _mm_srli_epi16 (v, 8));
+	  }
+
+	_mm_storeu_si128 ((__m128i *) (dest + i),
+			  _mm_packus_epi16 (res[0], res[1]));
+      }
+  }
+#endif
+
+  for (; i < len; i++)
+    {
+      uint8_t  hi = char2Hex (src[i * 2]);
+      uint8_t  lo = char2Hex (src[i * 2 + 1]);
+
+      if ((hi > 0xf) || (lo > 0xf))
+	return  false;
+
+      dest[i] = (hi << 4) | lo;
+    }
+
+  return  true;
+
+}	// hex2Bin ()
+
+
 //! "Unescape" RSP binary data
 
 //! '#', '$' and '}' are escaped by preceding them by '}' and oring with 0x20.
 
-//! This function reverses that, modifying the data in place.
+//! This function reverses that, modifying the data in place. Escapes are
+//! found with memchr, which the C library vectorizes, and the data between
+//! them moved down a block at a time.
 
 //! @param[in] buf  The array of bytes to convert
 //! @para[in]  len   The number of bytes to be converted
@@ -230,29 +455,35 @@ int
 Utils::rspUnescape (char *buf,
 		    int   len)
 {
-  int  fromOffset = 0;		// Offset to source char
-  int  toOffset   = 0;		// Offset to dest char
+  char *end  = buf + len;
+  char *from = static_cast<char *> (memchr (buf, '}', len));
+  char *to   = from;
 
-  while (fromOffset < len)
+  if (nullptr == from)
+    return  len;			// Nothing escaped
+
+  while (from < end)
     {
-      // Is it escaped
-      if ( '}' == buf[fromOffset])
-	{
-	  fromOffset++;
-	  buf[toOffset] = buf[fromOffset] ^ 0x20;
-	}
-      else
-	{
-	  buf[toOffset] = buf[fromOffset];
-	}
+      // from is at an escape, so unescape the char after it
+      from++;
+
+      if (from < end)
+	*to++ = *from++ ^ 0x20;
+
+      // Then move down everything up to the next escape
+      char *next = static_cast<char *> (memchr (from, '}', end - from));
+
+      if (nullptr == next)
+	next = end;
 
-      fromOffset++;
-      toOffset++;
+      memmove (to, from, next - from);
+      to  += next - from;
+      from = next;
     }
 
-  return  toOffset;
+  return  to - buf;
 
-}	// rspUnescape () */
+}	// rspUnescape ()
 
 
 //! Split a string into delimited tokens
@@ -23,6 +23,7 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -48,6 +49,12 @@ public:
 				char *src);
   static void        hex2Ascii (char *dest,
 				char *src);
+  static void        bin2Hex (char          *dest,
+			      const uint8_t *src,
+			      std::size_t    len);
+  static bool        hex2Bin (uint8_t     *dest,
+			      const char  *src,
+			      std::size_t  len);
   static int         rspUnescape (char *buf,
 				  int   len);
   static std::vector<std::string> & split (const std::string & s,
@@ -30,7 +30,10 @@
 
 // RISC-V headers in general and for each target
 
+#include "Cosim.h"
+#include "Hybrid.h"
 #include "ITarget.h"
+#include "Iss.h"
 
 #ifdef BUILD_GDBSIM_MODEL
 #include "GdbSim.h"
@@ -44,6 +47,10 @@
 #include "Ri5cy.h"
 #endif /* BUILD_RI5CY_MODEL */
 
+#ifdef HAVE_THREADED_MODELS
+#include "verilated.h"
+#endif /* HAVE_THREADED_MODELS */
+
 
 // Class headers
 
@@ -51,7 +58,9 @@
 #include "TraceFlags.h"
 
 #include "RspConnection.h"
+#include "SessionServer.h"
 #include "StreamConnection.h"
+#include "TargetPool.h"
 
 using std::atoi;
 using std::cerr;
@@ -59,11 +68,8 @@ using std::cout;
 using std::endl;
 using std::ostream;
 using std::strcmp;
-
-
-//! The RISC-V model
-
-static ITarget *globalCpu = nullptr;
+using std::strncmp;
+using std::strtoull;
 
 static const std::string gdbserver_name =
 #ifdef BUILD_64_BIT
@@ -73,6 +79,44 @@ static const std::string gdbserver_name =
 #endif
     ;
 
+//! Checkpoint file every new core is restored from, if any
+
+static const char *restoreFile = nullptr;
+
+//! Whether every new core is checked against the ISS as it runs
+
+static bool lockstep = false;
+
+//! Whether every new core fast forwards on the ISS first
+
+static bool fastForward = false;
+
+//! When a fast forwarding core switches from the ISS to the RTL model
+
+static Hybrid::SwitchWhen switchWhen = Hybrid::SwitchWhen::MANUAL;
+
+//! The PC or instruction count at which a fast forwarding core switches
+
+static uint64_t switchVal = 0;
+
+//! Threads for each Verilator model to evaluate with, or 0 for Verilator's
+//! default
+
+static int modelThreads = 0;
+
+//! The only core a server configured --with-single-target can use, or
+//! nullptr if it can use any core
+
+#if defined (SINGLE_TARGET_RI5CY)
+static const char *singleTarget = "RI5CY";
+#elif defined (SINGLE_TARGET_PICORV32)
+static const char *singleTarget = "PicoRV32";
+#elif defined (SINGLE_TARGET_GDBSIM)
+static const char *singleTarget = "GDBSIM";
+#else
+static const char *singleTarget = nullptr;
+#endif
+
 //! Convenience function to output the usage to a specified stream.
 
 //! @param[in] s  Output stream to use.
@@ -84,16 +128,66 @@ usage (ostream & s)
     << "                         [ --trace | -t <traceflag> ]" << endl
     << "                         [ --silent | -q ]" << endl
     << "                         [ --stdin | -s ]" << endl
+    << "                         [ --multi | -m <workers> ]" << endl
+    << "                         [ --pool | -p <size> ]" << endl
+    << "                         [ --restore | -r <file> ]" << endl
+    << "                         [ --fast-forward | -f <when> ]" << endl
+    << "                         [ --lockstep | -l ]" << endl
+    << "                         [ --model-threads | -T <threads> ]" << endl
     << "                         [ --help | -h ]" << endl
     << "                         [ --version | -v ]" << endl
     << "                         <rsp-port>" << endl
     << endl
+    << "The core may be ISS, the built in instruction set simulator, or any"
+    << endl
+    << "of GDBSIM, PicoRV32 and RI5CY configured into this build." << endl;
+
+  if (nullptr != singleTarget)
+    s << "This build is bound to " << singleTarget << ", which is the only"
+      << endl
+      << "core it can use, without --fast-forward or --lockstep." << endl;
+
+  s << endl
+    << "With --multi, up to <workers> GDB clients are served at once, each"
+    << endl
+    << "with its own core. A session ends when its client disconnects."
+    << endl
+    << endl
+    << "With --pool, up to <size> cores are built in the background ready for"
+    << endl
+    << "new sessions and cold resets." << endl
+    << endl
+    << "PicoRV32 and RI5CY can only be served by more than one worker, or"
+    << endl
+    << "pooled, if verilated with --threads. GDBSIM never can be, since the"
+    << endl
+    << "GDB simulator keeps its state in globals." << endl
+    << endl
+    << "With --restore, every core is restored from the checkpoint <file>"
+    << endl
+    << "written by \"monitor checkpoint write\"." << endl
+    << endl
+    << "With --fast-forward, the program runs on the ISS and then switches to"
+    << endl
+    << "the core. <when> is pc=<address>, count=<instructions> or manual, in"
+    << endl
+    << "which case only \"monitor switch-to rtl\" switches." << endl
+    << endl
+    << "With --lockstep, every instruction the core runs is checked against"
+    << endl
+    << "the ISS, stopping with SIGABRT if they differ." << endl
+    << endl
+    << "With --model-threads, models verilated with --threads evaluate with"
+    << endl
+    << "<threads> threads, shared by all the cores in the server." << endl
+    << endl
     << "The trace option may appear multiple times. Trace flags are:" << endl
     << "  rsp     Trace RSP packets" << endl
     << "  conn    Trace RSP connection handling" << endl
     << "  break   Trace breakpoint handling" << endl
-    << "  vcd     Generate a Verilog Change Dump" << endl
-    << "  silent  Minimize informative messages (synonym for -q)" << endl;
+    << "  vcd     Dump a waveform (VCD, or FST for FST models)" << endl
+    << "  silent  Minimize informative messages (synonym for -q)" << endl
+    << "  disas   Write a binary trace of the instructions executed" << endl;
 
 }	// usage ()
 
@@ -125,6 +219,8 @@ createCpu (const char *name, TraceFlags *traceFlags)
   // The RISC-V model
   if (0)
     /* Nothing.  */;
+  else if (0 == strcasecmp ("ISS", name))
+    cpu = new Iss (traceFlags);
 #ifdef BUILD_GDBSIM_MODEL
   else if (0 == strcasecmp ("GDBSIM", name))
     cpu = new GdbSim (traceFlags);
@@ -143,10 +239,101 @@ createCpu (const char *name, TraceFlags *traceFlags)
       return  nullptr;
     }
 
+  if (lockstep)
+    cpu = new Cosim (traceFlags, cpu);
+
+  if (fastForward)
+    cpu = new Hybrid (traceFlags, cpu, switchWhen, switchVal);
+
   return cpu;
 }	// createCpu
 
 
+//! Can cores of this type be built and run on several threads at once?
+
+//! The Verilator runtime has state shared by every model in the process,
+//! which is only made thread safe for models verilated with --threads. The
+//! GDB simulator keeps its state in globals, so there can only ever be one
+//! of those.
+
+//! @param[in] name  C string containing cpu model name.
+//! @return  TRUE if several threads may each have such a core.
+
+static bool
+threadSafeCore (const char *name)
+{
+  if (0 == strcasecmp ("GDBSIM", name))
+    return  false;
+
+#ifdef HAVE_THREADED_MODELS
+  return  true;
+#else
+  return  (0 != strcasecmp ("PicoRV32", name))
+    && (0 != strcasecmp ("RI5CY", name));
+#endif /* HAVE_THREADED_MODELS */
+}	// threadSafeCore
+
+
+//! Parse the argument to --fast-forward
+
+//! @param[in] arg  The argument: pc=<addr>, count=<n> or manual
+//! @return  TRUE if the argument was valid, FALSE otherwise.
+
+static bool
+parseFastForward (const char *arg)
+{
+  const char *val;
+
+  if (0 == strcmp ("manual", arg))
+    {
+      switchWhen = Hybrid::SwitchWhen::MANUAL;
+      return  true;
+    }
+  else if (0 == strncmp ("pc=", arg, 3))
+    {
+      switchWhen = Hybrid::SwitchWhen::PC;
+      val = arg + 3;
+    }
+  else if (0 == strncmp ("count=", arg, 6))
+    {
+      switchWhen = Hybrid::SwitchWhen::COUNT;
+      val = arg + 6;
+    }
+  else
+    return  false;
+
+  char *end;
+
+  switchVal = strtoull (val, &end, 0);
+  return  (*val != '\0') && (*end == '\0');
+
+}	// parseFastForward
+
+
+//! Create a new ITarget instance, restored from the checkpoint file if one
+//! was given.
+
+//! @param[in] name  C string containing cpu model name.
+//! @param[in] traceFlags  Pointer to TraceFlags used to create model.
+//! @return  Pointer to new ITarget instance, or nullptr.
+
+static ITarget *
+createRestoredCpu (const char *name, TraceFlags *traceFlags)
+{
+  ITarget *cpu = createCpu (name, traceFlags);
+
+  if ((cpu != nullptr) && (restoreFile != nullptr)
+      && !cpu->restoreCheckpoint (restoreFile))
+    {
+      cerr << "ERROR: Unable to restore checkpoint " << restoreFile << endl;
+      delete  cpu;
+      return  nullptr;
+    }
+
+  return cpu;
+}	// createRestoredCpu
+
+
 
 //! Main function
 
@@ -166,6 +353,9 @@ main (int   argc,
   char         *coreName = nullptr;
   bool          from_stdin = false;
   int           port = -1;
+  int           numWorkers = 0;
+  int           poolSize = 0;
+  TargetPool *  pool = nullptr;
   TraceFlags *  traceFlags = new TraceFlags ();
   int           nextArg;
 
@@ -178,11 +368,17 @@ main (int   argc,
       {"silent", no_argument,       nullptr,  'q' },
       {"trace",  required_argument, nullptr,  't' },
       {"stdin",  no_argument,       nullptr,  's' },
+      {"multi",  required_argument, nullptr,  'm' },
+      {"pool",   required_argument, nullptr,  'p' },
+      {"restore", required_argument, nullptr, 'r' },
+      {"fast-forward", required_argument, nullptr, 'f' },
+      {"lockstep", no_argument,     nullptr,  'l' },
+      {"model-threads", required_argument, nullptr, 'T' },
       {"version", no_argument,      nullptr,  'v' },
       {0,       0,                 0,  0 }
     };
 
-    if ((c = getopt_long (argc, argv, "c:hqt:sv", longOptions, &longOptind)) == -1)
+    if ((c = getopt_long (argc, argv, "c:hqt:sm:p:r:f:lT:v", longOptions, &longOptind)) == -1)
       break;
 
     switch (c) {
@@ -215,6 +411,61 @@ main (int   argc,
       from_stdin = true;
       break;
 
+    case 'm':
+      numWorkers = atoi (optarg);
+
+      if (numWorkers <= 0)
+	{
+	  cerr << "ERROR: Bad number of workers " << optarg << endl;
+	  usage (cerr);
+	  return EXIT_FAILURE;
+	}
+
+      break;
+
+    case 'p':
+      poolSize = atoi (optarg);
+
+      if (poolSize <= 0)
+	{
+	  cerr << "ERROR: Bad pool size " << optarg << endl;
+	  usage (cerr);
+	  return EXIT_FAILURE;
+	}
+
+      break;
+
+    case 'r':
+      restoreFile = optarg;
+      break;
+
+    case 'f':
+      if (!parseFastForward (optarg))
+	{
+	  cerr << "ERROR: Bad fast forward point " << optarg << endl;
+	  usage (cerr);
+	  return EXIT_FAILURE;
+	}
+
+      fastForward = true;
+      break;
+
+    case 'l':
+      lockstep = true;
+      break;
+
+    case 'T':
+      modelThreads = atoi (optarg);
+
+      if (modelThreads <= 0)
+	{
+	  cerr << "ERROR: Bad number of model threads " << optarg << endl;
+	  usage (cerr);
+	  return EXIT_FAILURE;
+	}
+
+      break;
+
     case '?':
     case ':':
       usage (cerr);
@@ -241,10 +492,96 @@ main (int   argc,
       return  EXIT_FAILURE;
     }
 
+  if (fastForward && (0 == strcasecmp ("ISS", coreName)))
+    {
+      cerr << "ERROR: Cannot fast forward the ISS to itself" << endl;
+      return  EXIT_FAILURE;
+    }
+
+  if (lockstep && (0 == strcasecmp ("ISS", coreName)))
+    {
+      cerr << "ERROR: Cannot check the ISS against itself" << endl;
+      return  EXIT_FAILURE;
+    }
+
+  // The server calls a single target directly, so cannot be given any other
+  // core, nor one wrapped for fast forwarding or lockstep.
+  if (nullptr != singleTarget)
+    {
+      if (0 != strcasecmp (singleTarget, coreName))
+	{
+	  cerr << "ERROR: This server is bound to " << singleTarget
+	       << ": cannot use " << coreName << endl;
+	  return  EXIT_FAILURE;
+	}
+
+      if (fastForward || lockstep)
+	{
+	  cerr << "ERROR: This server is bound to " << singleTarget
+	       << ": cannot fast forward or run in lockstep" << endl;
+	  return  EXIT_FAILURE;
+	}
+    }
+
+  // The thread count must be set before any model is built.
+  if (modelThreads > 0)
+    {
+#ifdef HAVE_THREADED_MODELS
+      Verilated::threads (modelThreads);
+#else
+      cerr << "ERROR: --model-threads needs models verilated with --threads"
+	   << endl;
+      return  EXIT_FAILURE;
+#endif /* HAVE_THREADED_MODELS */
+    }
+
+  // Several sessions, or a pool building on its own thread, each have a core
+  // on a different thread.
+  if (((numWorkers > 1) || (poolSize > 0)) && !threadSafeCore (coreName))
+    {
+      cerr << "ERROR: " << coreName << " cores cannot be used on several "
+	   << "threads" << endl
+	   << "(see --help): --multi must be 1 and --pool cannot be used"
+	   << endl;
+      return  EXIT_FAILURE;
+    }
+
+  // Start building cores straight away, while we wait for a client.
+  if (poolSize > 0)
+    pool = new TargetPool (coreName, traceFlags, createRestoredCpu,
+			   poolSize);
+
+  // Multiple sessions each create their own cpu model.
+  if (numWorkers > 0)
+    {
+      if (from_stdin)
+	{
+	  cerr << "ERROR: --multi cannot be used with --stdin" << endl;
+	  delete  pool;
+	  return  EXIT_FAILURE;
+	}
+
+      port = atoi (argv[nextArg]);
+      SessionServer *sessionServer =
+	new SessionServer (port, coreName, traceFlags, createRestoredCpu,
+			   numWorkers, pool);
+      int ret = sessionServer->run ();
+
+      delete  sessionServer;
+      delete  pool;
+      delete  traceFlags;
+      free (coreName);
+      return  ret;
+    }
+
   // Create the cpu model.
-  globalCpu = createCpu (coreName, traceFlags);
-  if (globalCpu == nullptr)
-    return  EXIT_FAILURE;
+  ITarget *cpu = (pool == nullptr)
+    ? createRestoredCpu (coreName, traceFlags) : pool->take ();
+  if (cpu == nullptr)
+    {
+      delete  pool;
+      return  EXIT_FAILURE;
+    }
 
   AbstractConnection *conn;
   GdbServer::KillBehaviour killBehaviour;
@@ -262,19 +599,24 @@ main (int   argc,
 
   // The RSP server, connecting it to its CPU.
 
-  GdbServer *gdbServer = new GdbServer (conn, globalCpu, traceFlags,
-                                        killBehaviour);
-  globalCpu->gdbServer (gdbServer);
+  GdbServer *gdbServer = new GdbServer (conn, cpu, traceFlags,
+                                        killBehaviour, pool);
+  cpu->gdbServer (gdbServer);
 
   // Run the GDB server.
 
   int ret = gdbServer->rspServer ();
 
-  // Free memory
+  // Free memory.  With a pool, the server owns the cpu.
 
   delete  conn;
   delete  gdbServer;
-  delete  globalCpu;
+
+  if (pool == nullptr)
+    delete  cpu;
+  else
+    delete  pool;
+
   delete  traceFlags;
   free (coreName);
 
@@ -285,14 +627,13 @@ main (int   argc,
 
 //! Function to handle $time calls in the Verilog
 
+//! There may be one model per thread, so ask the server running on this
+//! thread.
+
 double
 sc_time_stamp ()
 {
-  // If we are called before cpu has been constructed, return 0.0
-  if (globalCpu != nullptr)
-    return globalCpu->timeStamp ();
-  else
-    return 0.0;
+  return GdbServer::timeStamp ();
 }
 
 
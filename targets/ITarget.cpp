@@ -26,6 +26,11 @@
 #include "ITarget.h"
 
 
+// Static constants, which need storage when passed by reference
+
+const uint64_t  ITarget::NO_LIMIT;
+
+
 //! Output operator for ResumeType enumeration
 
 //! @param[in] s  The stream to output to.
@@ -72,6 +77,8 @@ operator<< (std::ostream & s,
     case ITarget::ResumeRes::TIMEOUT:     name = "timeout";     break;
     case ITarget::ResumeRes::SYSCALL:     name = "syscall";     break;
     case ITarget::ResumeRes::STEPPED:     name = "stepped";     break;
+    case ITarget::ResumeRes::DIVERGED:    name = "diverged";    break;
+    case ITarget::ResumeRes::LIMIT:       name = "limit";       break;
     default:                              name = "unknown";     break;
     }
 
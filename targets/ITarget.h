@@ -26,11 +26,13 @@
 #include <cstddef>
 #include <cstdint>
 #include <iostream>
+#include <vector>
 
 #include "RegisterSizes.h"
 
 // Classes to which we refer.
 
+class CommandRegistry;
 class TraceFlags;
 class GdbServer;
 
@@ -66,8 +68,21 @@ class ITarget
     TIMEOUT     = 4,		//!< Execution hit time limit.
     SYSCALL     = 5,		//!< Target needs some host I/O.
     STEPPED     = 6,		//!< Single step was completed.
+    DIVERGED    = 7,		//!< Differs from a reference model.
+    LIMIT       = 8,		//!< Execution hit a cycle or instruction limit.
   };
 
+  //! Type of limit on continuing
+
+  enum class LimitType {
+    CYCLES,			//!< Limit on the cycle count
+    INSTRS			//!< Limit on the instruction count
+  };
+
+  //! No limit on continuing
+
+  static const uint64_t  NO_LIMIT = UINT64_MAX;
+
   //! Type of reset
   enum class ResetType {
     COLD,			//!< Equivalent to complete class recreation
@@ -99,6 +114,18 @@ class ITarget
   virtual uint64_t  getCycleCount () const = 0;
   virtual uint64_t  getInstrCount () const = 0;
 
+  // Does the target count instructions?  If not, getInstrCount () is always
+  // zero, so an instruction limit would never be reached.
+
+  virtual bool  countsInstrs () const = 0;
+
+  // Stop continuing once the cycle or instruction count, as returned above,
+  // reaches a limit.  The limit is checked in the run loop as simulated
+  // time passes, so where execution stops does not depend on the host.
+
+  virtual void  setLimit (LimitType  type,
+			  uint64_t  count) = 0;
+
   // Read contents of a target register.
 
   virtual std::size_t  readRegister (const int  reg,
@@ -129,10 +156,33 @@ class ITarget
   virtual bool  removeMatchpoint (const uint32_t  addr,
 				  const MatchType  matchType) = 0;
 
-  // Generic pass through of command
+  // Add the target's monitor commands to a registry
+
+  virtual void  registerCommands (CommandRegistry & reg) = 0;
+
+  // Save and restore the complete target state using a checkpoint file.
+  // Return value indicates whether the operation was successful.
+
+  virtual bool  saveCheckpoint (const std::string & filename) = 0;
+  virtual bool  restoreCheckpoint (const std::string & filename) = 0;
+
+  // Save and restore the complete target state in memory, for snapshots
+  // taken while running. Return value indicates whether the operation was
+  // successful.
+
+  virtual bool  saveSnapshot (std::vector<uint8_t> & state) = 0;
+  virtual bool  restoreSnapshot (const std::vector<uint8_t> & state) = 0;
+
+  // Does the target have threads of its own running?  A forked copy of the
+  // process would not have them, so could not carry on.
+
+  virtual bool  threaded () const = 0;
+
+  // Record the PC of each instruction retired while continuing, in order,
+  // or stop recording if pcs is nullptr.  Return value indicates whether the
+  // target can, without single stepping.
 
-  virtual bool command (const std::string  cmd,
-			std::ostream & stream) = 0;
+  virtual bool  traceRetired (std::vector<uint32_t> * pcs) = 0;
 
   // Tell the target about the server using it
 
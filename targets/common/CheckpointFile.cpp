@@ -0,0 +1,379 @@
+// Checkpoint files for Verilated targets: implementation
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// ----------------------------------------------------------------------------
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "CheckpointFile.h"
+
+using std::cerr;
+using std::endl;
+using std::string;
+
+
+//! Magic number identifying a checkpoint file
+
+static const char  CHECKPOINT_MAGIC[8] = { 'R', 'V', 'G', 'S',
+					   'C', 'K', 'P', 'T' };
+
+//! Current checkpoint file format version
+
+static const uint32_t  CHECKPOINT_VERSION = 1;
+
+//! Space reserved for the header: one page
+
+static const uint32_t  CHECKPOINT_HEADER_SIZE = 4096;
+
+
+//! Constructor
+
+CheckpointWriter::CheckpointWriter () :
+  mFd (-1),
+  mFailed (false)
+{
+  memset (&mHeader, 0, sizeof (mHeader));
+
+}	// CheckpointWriter ()
+
+
+//! Destructor
+
+//! Make sure the file is complete.
+
+CheckpointWriter::~CheckpointWriter ()
+{
+  close ();
+
+}	// ~CheckpointWriter ()
+
+
+//! Open a checkpoint file for writing
+
+//! Any existing file is replaced.
+
+//! @param[in] filename  The file to write
+//! @param[in] core      Name of the core being saved
+//! @param[in] cycleCnt  Cycle count of the core
+//! @param[in] instrCnt  Instruction count of the core
+//! @param[in] cpuTime   Verilator time of the core
+//! @return  TRUE if the file was opened, FALSE otherwise
+
+bool
+CheckpointWriter::open (const string & filename,
+			const string & core,
+			uint64_t       cycleCnt,
+			uint64_t       instrCnt,
+			uint64_t       cpuTime)
+{
+  if (isOpen ())
+    return  false;
+
+  mFd = ::open (filename.c_str (), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+		0666);
+
+  if (mFd < 0)
+    {
+      cerr << "Warning: Cannot open checkpoint file " << filename << ": "
+	   << strerror (errno) << endl;
+      return  false;
+    }
+
+  // The header page is left as a hole until we know the size of the model
+  // state.
+  if (lseek (mFd, CHECKPOINT_HEADER_SIZE, SEEK_SET) < 0)
+    {
+      cerr << "Warning: Cannot write checkpoint file " << filename << ": "
+	   << strerror (errno) << endl;
+      ::close (mFd);
+      mFd = -1;
+      return  false;
+    }
+
+  memcpy (mHeader.magic, CHECKPOINT_MAGIC, sizeof (mHeader.magic));
+  mHeader.version = CHECKPOINT_VERSION;
+  mHeader.headerSize = CHECKPOINT_HEADER_SIZE;
+  strncpy (mHeader.core, core.c_str (), sizeof (mHeader.core) - 1);
+  mHeader.cycleCnt = cycleCnt;
+  mHeader.instrCnt = instrCnt;
+  mHeader.cpuTime = cpuTime;
+  mHeader.modelSize = 0;
+
+  mFailed = false;
+  m_isOpen = true;
+  m_filename = filename;
+  m_cp = m_bufp;
+  header ();
+  return  true;
+
+}	// open ()
+
+
+//! Finish the checkpoint file
+
+//! Write out what is left in the buffer, then the header.
+
+void
+CheckpointWriter::close ()
+{
+  if (! isOpen ())
+    return;
+
+  flush ();
+  m_isOpen = false;
+
+  if (! mFailed
+      && (pwrite (mFd, &mHeader, sizeof (mHeader), 0)
+	  != static_cast<ssize_t> (sizeof (mHeader))))
+    {
+      cerr << "Warning: Cannot write checkpoint header to " << m_filename
+	   << ": " << strerror (errno) << endl;
+      mFailed = true;
+    }
+
+  if (::close (mFd) < 0)
+    {
+      cerr << "Warning: Cannot close checkpoint file " << m_filename << ": "
+	   << strerror (errno) << endl;
+      mFailed = true;
+    }
+
+  mFd = -1;
+
+}	// close ()
+
+
+//! Write out the Verilator buffer
+
+void
+CheckpointWriter::flush ()
+{
+  if (! isOpen ())
+    return;
+
+  const uint8_t * p = m_bufp;
+
+  while (! mFailed && (p < m_cp))
+    {
+      ssize_t  n = ::write (mFd, p, m_cp - p);
+
+      if (n < 0)
+	{
+	  if (EINTR == errno)
+	    continue;
+
+	  cerr << "Warning: Cannot write checkpoint file " << m_filename << ": "
+	       << strerror (errno) << endl;
+	  mFailed = true;
+	  break;
+	}
+
+      p += n;
+      mHeader.modelSize += n;
+    }
+
+  m_cp = m_bufp;
+
+}	// flush ()
+
+
+//! Was the checkpoint written successfully?
+
+//! Only meaningful once the file is closed.
+
+//! @return  TRUE if the whole file was written, FALSE otherwise
+
+bool
+CheckpointWriter::ok () const
+{
+  return  ! mFailed;
+
+}	// ok ()
+
+
+//! Constructor
+
+CheckpointReader::CheckpointReader () :
+  mMap (nullptr),
+  mMapSize (0)
+{
+  memset (&mHeader, 0, sizeof (mHeader));
+
+}	// CheckpointReader ()
+
+
+//! Destructor
+
+CheckpointReader::~CheckpointReader ()
+{
+  close ();
+
+}	// ~CheckpointReader ()
+
+
+//! Open a checkpoint file for reading
+
+//! The file is checked for the right format, the right core and its full
+//! length before anything is read from it.
+
+//! @param[in] filename  The file to read
+//! @param[in] core      Name of the core being restored
+//! @return  TRUE if the file is ready to be read, FALSE otherwise
+
+bool
+CheckpointReader::open (const string & filename,
+			const string & core)
+{
+  if (isOpen ())
+    return  false;
+
+  int  fd = ::open (filename.c_str (), O_RDONLY | O_CLOEXEC);
+
+  if (fd < 0)
+    {
+      cerr << "Warning: Cannot open checkpoint file " << filename << ": "
+	   << strerror (errno) << endl;
+      return  false;
+    }
+
+  struct stat  st;
+
+  if (fstat (fd, &st) < 0)
+    {
+      cerr << "Warning: Cannot read checkpoint file " << filename << ": "
+	   << strerror (errno) << endl;
+      ::close (fd);
+      return  false;
+    }
+
+  if (st.st_size < static_cast<off_t> (CHECKPOINT_HEADER_SIZE))
+    {
+      cerr << "Warning: " << filename << " is not a checkpoint file" << endl;
+      ::close (fd);
+      return  false;
+    }
+
+  mMapSize = st.st_size;
+  void * map = mmap (nullptr, mMapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close (fd);
+
+  if (MAP_FAILED == map)
+    {
+      cerr << "Warning: Cannot map checkpoint file " << filename << ": "
+	   << strerror (errno) << endl;
+      mMapSize = 0;
+      return  false;
+    }
+
+  mMap = static_cast<uint8_t *> (map);
+  madvise (mMap, mMapSize, MADV_SEQUENTIAL);
+  memcpy (&mHeader, mMap, sizeof (mHeader));
+  mHeader.core[sizeof (mHeader.core) - 1] = '\0';
+
+  const char * err = nullptr;
+
+  if (0 != memcmp (mHeader.magic, CHECKPOINT_MAGIC, sizeof (mHeader.magic)))
+    err = "not a checkpoint file";
+  else if (CHECKPOINT_VERSION != mHeader.version)
+    err = "unsupported checkpoint version";
+  else if (core != mHeader.core)
+    err = "checkpoint is for a different core";
+  else if ((mHeader.headerSize < sizeof (mHeader))
+	   || (mHeader.headerSize > mMapSize)
+	   || (mHeader.modelSize != mMapSize - mHeader.headerSize))
+    err = "checkpoint is truncated";
+
+  if (nullptr != err)
+    {
+      cerr << "Warning: " << filename << ": " << err << endl;
+      munmap (mMap, mMapSize);
+      mMap = nullptr;
+      mMapSize = 0;
+      return  false;
+    }
+
+  // Verilator reads straight from the mapping
+  openRange (mMap + mHeader.headerSize, mMap + mMapSize, filename);
+  return  true;
+
+}	// open ()
+
+
+//! Finish with the checkpoint file
+
+void
+CheckpointReader::close ()
+{
+  if (! isOpen ())
+    return;
+
+  StateReader::close ();
+  munmap (mMap, mMapSize);
+  mMap = nullptr;
+  mMapSize = 0;
+
+}	// close ()
+
+
+//! Cycle count when the checkpoint was saved
+
+//! @return  The cycle count
+
+uint64_t
+CheckpointReader::cycleCnt () const
+{
+  return  mHeader.cycleCnt;
+
+}	// cycleCnt ()
+
+
+//! Instruction count when the checkpoint was saved
+
+//! @return  The instruction count
+
+uint64_t
+CheckpointReader::instrCnt () const
+{
+  return  mHeader.instrCnt;
+
+}	// instrCnt ()
+
+
+//! Verilator time when the checkpoint was saved
+
+//! @return  The time
+
+uint64_t
+CheckpointReader::cpuTime () const
+{
+  return  mHeader.cpuTime;
+
+}	// cpuTime ()
+
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// End:
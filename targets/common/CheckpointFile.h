@@ -0,0 +1,149 @@
+// Checkpoint files for Verilated targets: declaration
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef CHECKPOINT_FILE_H
+#define CHECKPOINT_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "StateBuffer.h"
+#include "verilated_save.h"
+
+
+//! The fixed header at the start of every checkpoint file.
+
+//! The header occupies the whole of the first page of the file, so that the
+//! model state which follows is page aligned when the file is mapped. It is
+//! written last, so an incomplete file is never mistaken for a checkpoint.
+
+struct CheckpointHeader
+{
+  char      magic[8];		//!< Always "RVGSCKPT"
+  uint32_t  version;		//!< Format version
+  uint32_t  headerSize;		//!< Offset of the model state in the file
+  char      core[32];		//!< Name of the core, NUL terminated
+  uint64_t  cycleCnt;		//!< Cycle count when saved
+  uint64_t  instrCnt;		//!< Instruction count when saved
+  uint64_t  cpuTime;		//!< Verilator time when saved
+  uint64_t  modelSize;		//!< Bytes of model state after the header
+};
+
+
+//! Write a checkpoint file.
+
+//! The Verilator model is serialized straight into this, using the
+//! operator<< Verilator generates for models built with --savable. Target
+//! specific state may follow. The target's counters go in the header.
+
+class CheckpointWriter : public VerilatedSerialize
+{
+public:
+
+  // Constructor and destructor
+
+  CheckpointWriter ();
+  virtual ~CheckpointWriter ();
+
+  // Open and close the file
+
+  bool  open (const std::string & filename,
+	      const std::string & core,
+	      uint64_t            cycleCnt,
+	      uint64_t            instrCnt,
+	      uint64_t            cpuTime);
+  virtual void  close ();
+
+  // Write out the buffer
+
+  virtual void  flush ();
+
+  // Did everything get written?
+
+  bool  ok () const;
+
+private:
+
+  //! The file being written
+
+  int  mFd;
+
+  //! Set once any write fails
+
+  bool  mFailed;
+
+  //! The header, completed when the file is closed
+
+  CheckpointHeader  mHeader;
+
+};	// CheckpointWriter ()
+
+
+//! Read a checkpoint file.
+
+//! The file is mapped into memory, and the model reads its state directly
+//! from the mapping, so restoring is little more than a memory copy. Only
+//! the last few bytes go through the Verilator buffer.
+
+class CheckpointReader : public StateReader
+{
+public:
+
+  // Constructor and destructor
+
+  CheckpointReader ();
+  virtual ~CheckpointReader ();
+
+  // Open and close the file
+
+  bool  open (const std::string & filename,
+	      const std::string & core);
+  virtual void  close ();
+
+  // The counters when the checkpoint was saved
+
+  uint64_t  cycleCnt () const;
+  uint64_t  instrCnt () const;
+  uint64_t  cpuTime () const;
+
+private:
+
+  //! The mapped file
+
+  uint8_t * mMap;
+
+  //! Size of the mapping
+
+  std::size_t  mMapSize;
+
+  //! The header of the file
+
+  CheckpointHeader  mHeader;
+
+};	// CheckpointReader ()
+
+
+#endif	// CHECKPOINT_FILE_H
+
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// End:
@@ -0,0 +1,395 @@
+// Registry of monitor commands: definition
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+#include "CommandRegistry.h"
+
+using std::string;
+
+
+// Static constants, which need storage when passed by reference
+
+const std::size_t  CommandArgs::MAX_WORDS;
+const uint16_t  CommandRegistry::EMPTY;
+const uint32_t  CommandRegistry::SEEDS_PER_SIZE;
+
+
+//! Constructor.
+
+//! Split the command into words. The command must stay unchanged while the
+//! words are in use.
+
+//! @param[in] cmd  The null terminated command
+
+CommandArgs::CommandArgs (const char *cmd) :
+  mCmd (cmd),
+  mNumWords (0)
+{
+  const char *p = cmd;
+
+  while (true)
+    {
+      while (isspace (static_cast<unsigned char> (*p)))
+	p++;
+
+      if ('\0' == *p)
+	break;
+
+      const char *start = p;
+
+      while (('\0' != *p) && !isspace (static_cast<unsigned char> (*p)))
+	p++;
+
+      if (mNumWords < MAX_WORDS)
+	{
+	  mWord[mNumWords] = start;
+	  mLen[mNumWords] = p - start;
+	}
+
+      mNumWords++;
+    }
+}	// CommandArgs::CommandArgs ()
+
+
+//! Is a word a particular string?
+
+//! @param[in] i  The word
+//! @param[in] s  The string
+//! @return  TRUE if there is such a word and it matches, FALSE otherwise.
+
+bool
+CommandArgs::is (std::size_t  i,
+		 const char *s) const
+{
+  return (i < mNumWords) && (i < MAX_WORDS) && (strlen (s) == mLen[i])
+    && (0 == memcmp (mWord[i], s, mLen[i]));
+
+}	// CommandArgs::is ()
+
+
+//! A copy of a word
+
+//! For arguments such as file names, which are needed as a string.
+
+//! @param[in] i  The word
+//! @return  The word, or an empty string if there is no such word.
+
+string
+CommandArgs::str (std::size_t  i) const
+{
+  if ((i >= mNumWords) || (i >= MAX_WORDS))
+    return string ();
+
+  return string (mWord[i], mLen[i]);
+
+}	// CommandArgs::str ()
+
+
+//! A word as a number
+
+//! As for strtoull with base 0, so decimal, hex with "0x" or octal with a
+//! leading "0".
+
+//! @param[in]  i    The word
+//! @param[out] val  The value, only set if the whole word is a number
+//! @return  TRUE if the whole word is a number, FALSE otherwise.
+
+bool
+CommandArgs::num (std::size_t  i,
+		  uint64_t &val) const
+{
+  if ((i >= mNumWords) || (i >= MAX_WORDS))
+    return false;
+
+  // The word ends at white space or the end of the command, so strtoull
+  // stops there too.
+
+  char *end;
+  uint64_t  res = strtoull (mWord[i], &end, 0);
+
+  if (end != mWord[i] + mLen[i])
+    return false;
+
+  val = res;
+  return true;
+
+}	// CommandArgs::num ()
+
+
+//! A word as a 32-bit number
+
+//! @param[in]  i    The word
+//! @param[out] val  The value, only set if the whole word is a number which
+//!                  fits
+//! @return  TRUE if the whole word is a number which fits, FALSE otherwise.
+
+bool
+CommandArgs::num (std::size_t  i,
+		  uint32_t &val) const
+{
+  uint64_t  res;
+
+  if (!num (i, res) || (res > UINT32_MAX))
+    return false;
+
+  val = static_cast<uint32_t> (res);
+  return true;
+
+}	// CommandArgs::num ()
+
+
+//! The length of a word
+
+//! @param[in] i  The word
+//! @return  The length, or 0 if there is no such word.
+
+std::size_t
+CommandArgs::length (std::size_t  i) const
+{
+  if ((i >= mNumWords) || (i >= MAX_WORDS))
+    return 0;
+
+  return mLen[i];
+
+}	// CommandArgs::length ()
+
+
+//! The command from a word to the end
+
+//! For commands such as "echo", which take the rest of the line as it was
+//! typed.
+
+//! @param[in] i  The first word
+//! @return  The rest of the command, or an empty string if there is no such
+//!          word.
+
+const char *
+CommandArgs::rest (std::size_t  i) const
+{
+  if ((i >= mNumWords) || (i >= MAX_WORDS))
+    return "";
+
+  return mWord[i];
+
+}	// CommandArgs::rest ()
+
+
+//! Constructor.
+
+CommandRegistry::CommandRegistry () :
+  mSeed (0)
+{
+}	// CommandRegistry::CommandRegistry ()
+
+
+//! Add a command
+
+//! A command with the same name as one already added replaces it.
+
+//! @param[in] name     The name, which must outlive the registry
+//! @param[in] help     Help text, one or more lines each ending in newline,
+//!                     which must outlive the registry. May be nullptr if
+//!                     the command is not to be described.
+//! @param[in] handler  What to call to run the command
+
+void
+CommandRegistry::add (const char *name,
+		      const char *help,
+		      Handler     handler)
+{
+  std::size_t  len = strlen (name);
+
+  for (auto it = mCommands.begin (); it != mCommands.end (); it++)
+    if ((it->len == len) && (0 == memcmp (it->name, name, len)))
+      {
+	it->help = help;
+	it->handler = handler;
+	return;
+      }
+
+  mCommands.push_back ({ name, len, help, handler });
+  rebuild ();
+
+}	// CommandRegistry::add ()
+
+
+//! Remove all the commands
+
+void
+CommandRegistry::clear ()
+{
+  mCommands.clear ();
+  mSlots.clear ();
+
+}	// CommandRegistry::clear ()
+
+
+//! Run a command
+
+//! @param[in]  args    The command
+//! @param[out] stream  Where the command writes any output
+//! @return  Whether the command succeeded, failed or was not found.
+
+CommandRegistry::Result
+CommandRegistry::run (const CommandArgs & args,
+		      std::ostream & stream) const
+{
+  if (0 == args.size ())
+    return Result::UNKNOWN;
+
+  const Command *c = find (args.rest (0), args.length (0));
+
+  if (nullptr == c)
+    return Result::UNKNOWN;
+
+  return c->handler (args, stream) ? Result::OK : Result::FAILED;
+
+}	// CommandRegistry::run ()
+
+
+//! Describe all the commands, in the order added
+
+//! @param[out] stream  Where to write the help
+
+void
+CommandRegistry::help (std::ostream & stream) const
+{
+  for (auto it = mCommands.begin (); it != mCommands.end (); it++)
+    if (nullptr != it->help)
+      stream << it->help;
+
+}	// CommandRegistry::help ()
+
+
+//! Hash a name
+
+//! FNV-1a, starting from the seed.
+
+//! @param[in] s     The name
+//! @param[in] len   The length of the name
+//! @param[in] seed  The seed
+//! @return  The hash
+
+uint32_t
+CommandRegistry::hash (const char *s,
+		       std::size_t  len,
+		       uint32_t  seed)
+{
+  uint32_t  h = 2166136261u ^ seed;
+
+  for (std::size_t  i = 0; i < len; i++)
+    {
+      h ^= static_cast<uint8_t> (s[i]);
+      h *= 16777619u;
+    }
+
+  return h;
+
+}	// CommandRegistry::hash ()
+
+
+//! Find a command
+
+//! Normally the command is in the slot it hashes to, but the table is
+//! searched on from there, in case no seed could be found to give every
+//! command its own slot.
+
+//! @param[in] name  The name
+//! @param[in] len   The length of the name
+//! @return  The command, or nullptr if there is no such command.
+
+const CommandRegistry::Command *
+CommandRegistry::find (const char *name,
+		       std::size_t  len) const
+{
+  if (mSlots.empty ())
+    return nullptr;
+
+  std::size_t  mask = mSlots.size () - 1;
+
+  for (std::size_t  s = hash (name, len, mSeed) & mask;
+       EMPTY != mSlots[s];
+       s = (s + 1) & mask)
+    {
+      const Command & c = mCommands[mSlots[s]];
+
+      if ((c.len == len) && (0 == memcmp (c.name, name, len)))
+	return &c;
+    }
+
+  return nullptr;
+
+}	// CommandRegistry::find ()
+
+
+//! Rebuild the hash table
+
+//! The table is at least twice the number of commands. Seeds are tried until
+//! every command hashes to its own slot. If none does, the table is doubled
+//! and the search goes on. There are few commands and they are only added
+//! when a server or target is set up, so this is cheap enough.
+
+void
+CommandRegistry::rebuild ()
+{
+  static const std::size_t  MAX_SLOTS = 1 << 12;
+  std::size_t  size = 8;
+
+  while (size < 2 * mCommands.size ())
+    size *= 2;
+
+  for (; ; size *= 2)
+    for (uint32_t  seed = 0; seed < SEEDS_PER_SIZE; seed++)
+      {
+	bool  perfect = true;
+
+	mSlots.assign (size, EMPTY);
+	mSeed = seed;
+
+	for (std::size_t  i = 0; i < mCommands.size (); i++)
+	  {
+	    std::size_t  s = hash (mCommands[i].name, mCommands[i].len, seed)
+	      & (size - 1);
+
+	    while (EMPTY != mSlots[s])
+	      {
+		perfect = false;
+		s = (s + 1) & (size - 1);
+	      }
+
+	    mSlots[s] = static_cast<uint16_t> (i);
+	  }
+
+	// Give up looking at the largest size, since find () copes with
+	// commands which share a slot.
+
+	if (perfect || (size >= MAX_SLOTS))
+	  return;
+      }
+}	// CommandRegistry::rebuild ()
+
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// show-trailing-whitespace: t
+// End:
@@ -0,0 +1,206 @@
+// Registry of monitor commands: declaration
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef COMMAND_REGISTRY_H
+#define COMMAND_REGISTRY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+//! The words of a monitor command.
+
+//! The command is split at white space without copying it: each word is a
+//! pointer into the command and a length. Word 0 is the command name, so
+//! for "profile start 100", size () is 3 and word 1 is "start".
+
+class CommandArgs
+{
+public:
+
+  //! Most words recorded. Later words are counted, but cannot be read.
+
+  static const std::size_t  MAX_WORDS = 16;
+
+  // Constructor
+
+  CommandArgs (const char *cmd);
+
+  // Accessors
+
+  //! The number of words
+
+  std::size_t  size () const
+  {
+    return mNumWords;
+  }
+
+  //! The whole command
+
+  const char * cmd () const
+  {
+    return mCmd;
+  }
+
+  bool  is (std::size_t  i,
+	    const char *s) const;
+  std::string  str (std::size_t  i) const;
+  bool  num (std::size_t  i,
+	     uint64_t &val) const;
+  bool  num (std::size_t  i,
+	     uint32_t &val) const;
+  std::size_t  length (std::size_t  i) const;
+  const char * rest (std::size_t  i) const;
+
+
+private:
+
+  //! The whole command, null terminated
+  const char *mCmd;
+
+  //! The number of words
+  std::size_t  mNumWords;
+
+  //! The start of each word
+  const char *mWord[MAX_WORDS];
+
+  //! The length of each word
+  std::size_t  mLen[MAX_WORDS];
+
+};	// class CommandArgs
+
+
+//! A registry of monitor commands.
+
+//! The server and each target add the commands they handle, each with a
+//! handler and its help text. A command is found by its name, the first word
+//! typed, using a hash table which is rebuilt as commands are added, with
+//! the seed chosen so that no two names share a slot. Looking a command up
+//! is then a hash and a compare, with no allocation.
+
+class CommandRegistry
+{
+public:
+
+  //! A command handler. It writes any output to the stream and returns TRUE
+  //! if the command succeeded, FALSE otherwise.
+
+  typedef std::function<bool (const CommandArgs & args,
+			      std::ostream & stream)>  Handler;
+
+  //! A registered command
+
+  struct Command
+  {
+    const char  *name;			//!< Name, the first word
+    std::size_t  len;			//!< Length of the name
+    const char  *help;			//!< Help text, or nullptr
+    Handler      handler;		//!< What to call
+  };
+
+  //! The result of running a command
+
+  enum class Result
+  {
+    OK,					//!< The command succeeded
+    FAILED,				//!< The command failed
+    UNKNOWN				//!< There is no such command
+  };
+
+  // Constructor
+
+  CommandRegistry ();
+
+  // Registration
+
+  void  add (const char *name,
+	     const char *help,
+	     Handler     handler);
+  void  clear ();
+
+  // Using the commands
+
+  Result  run (const CommandArgs & args,
+	       std::ostream & stream) const;
+  void  help (std::ostream & stream) const;
+
+  //! Are there no commands?
+
+  bool  empty () const
+  {
+    return mCommands.empty ();
+  }
+
+  //! The first command, in the order added
+
+  std::vector<Command>::const_iterator  begin () const
+  {
+    return mCommands.begin ();
+  }
+
+  //! One past the last command
+
+  std::vector<Command>::const_iterator  end () const
+  {
+    return mCommands.end ();
+  }
+
+
+private:
+
+  //! Marks an unused slot in the hash table
+
+  static const uint16_t  EMPTY = UINT16_MAX;
+
+  //! Seeds tried for each table size, before doubling it
+
+  static const uint32_t  SEEDS_PER_SIZE = 32;
+
+  //! The commands, in the order added, so help is in that order
+  std::vector<Command>  mCommands;
+
+  //! The hash table: an index into mCommands, or EMPTY
+  std::vector<uint16_t>  mSlots;
+
+  //! The seed of the hash
+  uint32_t  mSeed;
+
+  // Helper functions
+
+  static uint32_t  hash (const char *s,
+			 std::size_t  len,
+			 uint32_t  seed);
+  const Command * find (const char *name,
+			std::size_t  len) const;
+  void  rebuild ();
+
+};	// class CommandRegistry
+
+
+#endif	// COMMAND_REGISTRY_H
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// show-trailing-whitespace: t
+// End:
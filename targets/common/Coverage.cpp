@@ -0,0 +1,202 @@
+// Executed instruction coverage for targets: definition
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#include "Coverage.h"
+
+using std::dec;
+using std::endl;
+using std::hex;
+using std::ios;
+using std::ofstream;
+using std::string;
+using std::vector;
+
+
+//! Constructor.
+
+//! Coverage starts stopped, with an empty bitmap.
+
+Coverage::Coverage () :
+  mLowPc (DEFAULT_LOW_PC),
+  mHighPc (DEFAULT_LOW_PC),
+  mSlots (0),
+  mGeneration (1)
+{
+}	// Coverage::Coverage ()
+
+
+//! Handle a coverage command
+
+//! The commands are:
+//! - "coverage" reports how much has been covered
+//! - "coverage start [<low> <high>]" clears the bitmap and starts recording
+//! - "coverage stop" stops recording, keeping the bitmap
+//! - "coverage reset" clears the bitmap
+//! - "coverage dump <file>" writes out the bitmap
+
+//! @param[in]  args    The monitor command
+//! @param[out] stream  Where to write any response
+//! @return  TRUE if the command succeeded, FALSE otherwise.
+
+bool
+Coverage::command (const CommandArgs & args,
+		   std::ostream & stream)
+{
+  if (args.size () == 1)
+    {
+      stream << "Coverage is " << (0 == mSlots ? "stopped" : "running")
+	     << ", " << countHits () << " instructions executed between 0x"
+	     << hex << mLowPc << " and 0x" << mHighPc << dec << endl;
+      return true;
+    }
+
+  if (args.is (1, "start") && ((args.size () == 2)
+				 || (args.size () == 4)))
+    {
+      uint32_t  lowPc = DEFAULT_LOW_PC;
+      uint32_t  highPc = DEFAULT_HIGH_PC;
+
+      if ((args.size () == 4)
+	  && (!args.num (2, lowPc) || !args.num (3, highPc)
+	      || (highPc <= lowPc)))
+	{
+	  stream << "Address range must be <low> <high>, with low < high"
+		 << endl;
+	  return false;
+	}
+
+      mLowPc = lowPc;
+      mHighPc = highPc;
+      mSlots = ((highPc - lowPc - 1) >> 1) + 1;
+      mBits.assign ((mSlots + 7) / 8, 0);
+      mGeneration++;
+      return true;
+    }
+
+  if (args.is (1, "stop") && (args.size () == 2))
+    {
+      mSlots = 0;
+      return true;
+    }
+
+  if (args.is (1, "reset") && (args.size () == 2))
+    {
+      mBits.assign (mBits.size (), 0);
+      mGeneration++;
+      return true;
+    }
+
+  if (args.is (1, "dump") && (args.size () == 3))
+    return writeBitmap (args.str (2), stream);
+
+  stream << "Unrecognized coverage command: " << args.cmd () << endl;
+  return false;
+
+}	// Coverage::command ()
+
+
+//! Help for the coverage commands
+
+const char Coverage::HELP[] =
+  "  coverage\n"
+  "    Report how many instructions have been covered\n"
+  "  coverage start [<low> <high>]\n"
+  "    Record the instructions executed between <low> and <high>\n"
+  "  coverage stop\n"
+  "    Stop recording coverage\n"
+  "  coverage reset\n"
+  "    Forget the coverage recorded so far\n"
+  "  coverage dump <file>\n"
+  "    Write the coverage bitmap, for rvcoverage.py\n";
+
+
+//! Count the bits set in the bitmap
+
+//! @return  The number of instruction addresses executed
+
+uint64_t
+Coverage::countHits () const
+{
+  uint64_t  total = 0;
+
+  for (auto it = mBits.begin (); it != mBits.end (); it++)
+    total += __builtin_popcount (*it);
+
+  return total;
+
+}	// Coverage::countHits ()
+
+
+//! Write the bitmap to a file
+
+//! The file starts with a 24 byte header, all little endian: the magic
+//! "RVCOVER\0", the version, the lowest and highest (exclusive) PC and the
+//! bytes of address for each bit. Then comes the bitmap, with the lowest
+//! address in bit 0 of the first byte.
+
+//! @param[in]  filename  The file to write
+//! @param[out] stream    Where to report any problems
+//! @return  TRUE if the file was written, FALSE otherwise.
+
+bool
+Coverage::writeBitmap (const string & filename,
+		       std::ostream & stream) const
+{
+  ofstream  ofs (filename, ios::out | ios::binary | ios::trunc);
+
+  if (! ofs)
+    {
+      stream << "Unable to open " << filename << ": " << strerror (errno)
+	     << endl;
+      return false;
+    }
+
+  const uint32_t  fields[4] = { COVERAGE_VERSION, mLowPc, mHighPc, 2 };
+  char  header[24];
+
+  memcpy (header, "RVCOVER", 8);
+
+  for (int  i = 0; i < 4; i++)
+    for (int  b = 0; b < 4; b++)
+      header[8 + i * 4 + b] = static_cast<char> (fields[i] >> (b * 8));
+
+  ofs.write (header, sizeof (header));
+  ofs.write (reinterpret_cast<const char *> (mBits.data ()), mBits.size ());
+
+  if (! ofs)
+    {
+      stream << "Unable to write " << filename << endl;
+      return false;
+    }
+
+  return true;
+
+}	// Coverage::writeBitmap ()
+
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// show-trailing-whitespace: t
+// End:
@@ -0,0 +1,142 @@
+// Executed instruction coverage for targets: declaration
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef COVERAGE_H
+#define COVERAGE_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "CommandRegistry.h"
+
+
+//! A bitmap of the instruction addresses executed.
+
+//! There is a bit for every 2 bytes of a range of addresses, normally the
+//! text segment. A target calls hit () with the address of each instruction
+//! it retires, which sets one bit. While coverage is stopped, the range is
+//! empty, so hit () is just a subtract and a compare.
+
+//! Targets which run blocks of instructions can instead cover each block
+//! once, until generation () changes, which it does whenever the bitmap is
+//! cleared.
+
+//! The bitmap is controlled by the "coverage" monitor commands, which the
+//! target registers to call command (). It is written out with a small
+//! header, for the rvcoverage.py script to turn into lcov or gcov JSON.
+
+class Coverage
+{
+public:
+
+  // Constructor
+
+  Coverage ();
+
+  // Called from the target's run loop
+
+  //! Is coverage running?
+
+  //! @return  TRUE if there is a range being covered, FALSE otherwise.
+
+  inline bool  active () const
+  {
+    return 0 != mSlots;
+  }
+
+  //! Record an instruction retired
+
+  //! @param[in] pc  Address of the instruction
+
+  inline void  hit (uint32_t  pc)
+  {
+    uint32_t  slot = (pc - mLowPc) >> 1;
+
+    if (slot < mSlots)
+      mBits[slot >> 3] |= static_cast<uint8_t> (1 << (slot & 7));
+  }
+
+  //! Count of the times the bitmap has been cleared or restarted
+
+  //! @return  The generation
+
+  inline uint64_t  generation () const
+  {
+    return mGeneration;
+  }
+
+  // Monitor commands
+
+  static const char  HELP[];
+  bool  command (const CommandArgs & args,
+		 std::ostream & stream);
+
+
+private:
+
+  //! Lowest PC covered, unless set by "coverage start"
+
+  static const uint32_t  DEFAULT_LOW_PC = 0x00000000;
+
+  //! Highest PC covered (exclusive), unless set by "coverage start"
+
+  static const uint32_t  DEFAULT_HIGH_PC = 0x00100000;
+
+  //! Version of the file format
+
+  static const uint32_t  COVERAGE_VERSION = 1;
+
+  //! Lowest PC covered
+
+  uint32_t  mLowPc;
+
+  //! Highest PC covered (exclusive)
+
+  uint32_t  mHighPc;
+
+  //! Number of 2 byte slots covered, or 0 when stopped
+
+  uint32_t  mSlots;
+
+  //! The bitmap
+
+  std::vector<uint8_t>  mBits;
+
+  //! Incremented each time the bitmap is cleared or restarted
+
+  uint64_t  mGeneration;
+
+  // Helper functions
+
+  uint64_t  countHits () const;
+  bool  writeBitmap (const std::string & filename,
+		     std::ostream & stream) const;
+
+};	// class Coverage
+
+
+#endif	// COVERAGE_H
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// show-trailing-whitespace: t
+// End:
@@ -0,0 +1,381 @@
+// Memory access trace for targets: definition
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+
+#include "MemTrace.h"
+
+using std::dec;
+using std::endl;
+using std::hex;
+using std::make_pair;
+using std::memory_order_acquire;
+using std::memory_order_relaxed;
+using std::memory_order_release;
+using std::setw;
+using std::string;
+using std::thread;
+using std::vector;
+
+
+//! Constructor.
+
+//! The trace starts stopped, tracing all addresses.
+
+MemTrace::MemTrace () :
+  mFile (nullptr),
+  mRing (RING_SIZE),
+  mHead (0),
+  mTail (0),
+  mStop (false),
+  mLastCycle (0),
+  mLastAddr (0)
+{
+}	// MemTrace::MemTrace ()
+
+
+//! Destructor.
+
+//! Write out anything still in the ring.
+
+MemTrace::~MemTrace ()
+{
+  stop ();
+
+}	// MemTrace::~MemTrace ()
+
+
+//! Handle a memory trace command
+
+//! The commands are:
+//! - "memtrace" reports whether the trace is running
+//! - "memtrace start <file>" starts tracing to a file
+//! - "memtrace stop" stops tracing and closes the file
+//! - "memtrace range <low> <high>" adds an address range to trace
+//! - "memtrace range clear" goes back to tracing all addresses
+//! - "memtrace pages" reports the accesses to each 4KB page
+
+//! @param[in]  args    The monitor command
+//! @param[out] stream  Where to write any response
+//! @return  TRUE if the command succeeded, FALSE otherwise.
+
+bool
+MemTrace::command (const CommandArgs & args,
+		   std::ostream & stream)
+{
+  if (args.size () == 1)
+    {
+      if (active ())
+	stream << "Memory trace is running to " << mFilename << ", "
+	       << mHead.load (memory_order_relaxed) << " accesses" << endl;
+      else
+	stream << "Memory trace is stopped" << endl;
+
+      if (mRanges.empty ())
+	stream << "Tracing all addresses" << endl;
+
+      for (auto it = mRanges.begin (); it != mRanges.end (); it++)
+	stream << "Tracing 0x" << hex << it->first << " to 0x" << it->second
+	       << dec << endl;
+
+      return true;
+    }
+
+  if (args.is (1, "start") && (args.size () == 3))
+    {
+      if (active ())
+	{
+	  stream << "Memory trace is already running" << endl;
+	  return false;
+	}
+
+      return start (args.str (2), stream);
+    }
+
+  if (args.is (1, "stop") && (args.size () == 2))
+    {
+      stop ();
+      return true;
+    }
+
+  if (args.is (1, "range") && (args.size () == 3)
+      && (args.is (2, "clear")))
+    {
+      mRanges.clear ();
+      return true;
+    }
+
+  if (args.is (1, "range") && (args.size () == 4))
+    {
+      uint32_t  low;
+      uint32_t  high;
+
+      if (!args.num (2, low) || !args.num (3, high) || (high <= low))
+	{
+	  stream << "Address range must be <low> <high>, with low < high"
+		 << endl;
+	  return false;
+	}
+
+      mRanges.push_back (make_pair (low, high));
+      return true;
+    }
+
+  if (args.is (1, "pages") && (args.size () == 2))
+    {
+      summary (stream);
+      return true;
+    }
+
+  stream << "Unrecognized memtrace command: " << args.cmd () << endl;
+  return false;
+
+}	// MemTrace::command ()
+
+
+//! Help for the memory trace commands
+
+const char MemTrace::HELP[] =
+  "  memtrace\n"
+  "    Report whether loads and stores are being traced\n"
+  "  memtrace start <file>\n"
+  "    Trace loads and stores to <file>\n"
+  "  memtrace stop\n"
+  "    Stop tracing loads and stores\n"
+  "  memtrace range <low> <high>\n"
+  "    Only trace addresses between <low> and <high>\n"
+  "  memtrace range clear\n"
+  "    Trace all addresses\n"
+  "  memtrace pages\n"
+  "    Report the loads and stores to each 4KB page\n";
+
+
+//! Wait for the writer thread to make space in the ring
+
+//! @param[in] head  Accesses put in the ring so far
+
+void
+MemTrace::waitForSpace (uint64_t  head)
+{
+  while (head - mTail.load (memory_order_acquire) == RING_SIZE)
+    std::this_thread::yield ();
+
+}	// MemTrace::waitForSpace ()
+
+
+//! Start tracing
+
+//! Open the file, write the header and start the writer thread.
+
+//! @param[in]  filename  The file to write
+//! @param[out] stream    Where to report any problems
+//! @return  TRUE if the trace started, FALSE otherwise.
+
+bool
+MemTrace::start (const string & filename,
+		 std::ostream & stream)
+{
+  FILE * f = fopen (filename.c_str (), "wb");
+
+  if (nullptr == f)
+    {
+      stream << "Unable to open " << filename << ": " << strerror (errno)
+	     << endl;
+      return false;
+    }
+
+  uint8_t  header[16];
+
+  memset (header, 0, sizeof (header));
+  memcpy (header, "RVMTRACE", 8);
+  header[8] = static_cast<uint8_t> (MEMTRACE_VERSION);
+  header[9] = static_cast<uint8_t> (MEMTRACE_VERSION >> 8);
+  fwrite (header, 1, sizeof (header), f);
+
+  mFilename = filename;
+  mPages.clear ();
+  mLastCycle = 0;
+  mLastAddr = 0;
+  mHead.store (0, memory_order_relaxed);
+  mTail.store (0, memory_order_relaxed);
+  mStop.store (false, memory_order_relaxed);
+  mWriter = thread (&MemTrace::writer, this);
+  mFile = f;
+  return true;
+
+}	// MemTrace::start ()
+
+
+//! Stop tracing
+
+//! Tell the writer thread to empty the ring, wait for it and close the file.
+
+void
+MemTrace::stop ()
+{
+  if (!active ())
+    return;
+
+  mStop.store (true, memory_order_release);
+  mWriter.join ();
+  fclose (mFile);
+  mFile = nullptr;
+
+}	// MemTrace::stop ()
+
+
+//! The writer thread
+
+//! Take accesses out of the ring, encode them into a block and count them
+//! against their page. A full block is written to the file. When the ring
+//! is empty the thread sleeps briefly, unless it has been told to stop, in
+//! which case it writes what is left and finishes.
+
+void
+MemTrace::writer ()
+{
+  vector<uint8_t>  buf (BLOCK_SIZE);
+  uint8_t * p = buf.data ();
+  uint8_t * limit = p + BLOCK_SIZE - MAX_RECORD;
+  uint64_t  tail = mTail.load (memory_order_relaxed);
+
+  while (true)
+    {
+      // Check for stopping first, so nothing put in the ring before the
+      // stop is missed.
+
+      bool  stopping = mStop.load (memory_order_acquire);
+      uint64_t  head = mHead.load (memory_order_acquire);
+
+      if (tail == head)
+	{
+	  if (stopping)
+	    break;
+
+	  std::this_thread::sleep_for (std::chrono::microseconds (100));
+	  continue;
+	}
+
+      for (; tail != head; tail++)
+	{
+	  const Access & a = mRing[tail & (RING_SIZE - 1)];
+
+	  if (p > limit)
+	    {
+	      fwrite (buf.data (), 1, p - buf.data (), mFile);
+	      p = buf.data ();
+	    }
+
+	  p = encode (p, a);
+
+	  PageCount & pc = mPages[a.addr >> PAGE_SHIFT];
+
+	  if (a.flags & FLAG_WRITE)
+	    pc.writes++;
+	  else
+	    pc.reads++;
+	}
+
+      mTail.store (tail, memory_order_release);
+    }
+
+  fwrite (buf.data (), 1, p - buf.data (), mFile);
+
+}	// MemTrace::writer ()
+
+
+//! Encode an access as a record
+
+//! @param[in] p  Where the record goes
+//! @param[in] a  The access
+//! @return  Where the next record goes
+
+uint8_t *
+MemTrace::encode (uint8_t * p,
+		  const Access & a)
+{
+  int32_t  delta = static_cast<int32_t> (a.addr - mLastAddr);
+  uint64_t  vals[2] = { a.cycle - mLastCycle,
+			(static_cast<uint32_t> (delta) << 1)
+			^ static_cast<uint32_t> (delta >> 31) };
+
+  *p++ = a.flags;
+
+  for (int  i = 0; i < 2; i++)
+    {
+      uint64_t  val = vals[i];
+
+      while (val >= 0x80)
+	{
+	  *p++ = static_cast<uint8_t> (val) | 0x80;
+	  val >>= 7;
+	}
+
+      *p++ = static_cast<uint8_t> (val);
+    }
+
+  mLastCycle = a.cycle;
+  mLastAddr = a.addr;
+  return p;
+
+}	// MemTrace::encode ()
+
+
+//! Report the accesses to each page
+
+//! The page counts belong to the writer thread, so if the trace is running,
+//! wait for it to empty the ring first. It then has nothing more to count
+//! until the target makes another access.
+
+//! @param[out] stream  Where to write the report
+
+void
+MemTrace::summary (std::ostream & stream) const
+{
+  if (active ())
+    while (mTail.load (memory_order_acquire)
+	   != mHead.load (memory_order_relaxed))
+      std::this_thread::yield ();
+
+  if (mPages.empty ())
+    {
+      stream << "No loads or stores traced" << endl;
+      return;
+    }
+
+  stream << "Page              Loads     Stores" << endl;
+
+  for (auto it = mPages.begin (); it != mPages.end (); it++)
+    stream << "0x" << hex << std::setfill ('0') << setw (8)
+	   << (it->first << PAGE_SHIFT) << std::setfill (' ') << dec
+	   << setw (11) << it->second.reads << setw (11)
+	   << it->second.writes << endl;
+
+}	// MemTrace::summary ()
+
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// show-trailing-whitespace: t
+// End:
@@ -0,0 +1,242 @@
+// Memory access trace for targets: declaration
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MEM_TRACE_H
+#define MEM_TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "CommandRegistry.h"
+
+
+//! A trace of the loads and stores seen on a target's data memory port.
+
+//! The target calls access () for each transfer the memory accepts. If the
+//! address falls in one of the ranges being traced, or there are no ranges,
+//! the access goes into a ring buffer. A background thread takes accesses
+//! out of the ring, encodes them into the file and counts them for each 4KB
+//! page. The ring has a single producer and a single consumer, so it needs
+//! no lock, just the two atomic indices. The target only waits if the ring
+//! is full.
+
+//! The file starts with a 16 byte header: the magic "RVMTRACE", a 16-bit
+//! version and 6 reserved bytes. Then there is a record for each access,
+//! which starts with a byte of flags:
+//! - bit 0 (WRITE) if it is a store
+//! - bits 1-2 log2 of the bytes accessed
+
+//! Then come the cycles since the last access as an LEB128, and the
+//! difference of the address from that of the last access, zigzag encoded
+//! as an LEB128. targets/common/rvmemtrace.py decodes the file.
+
+//! The trace is controlled by the "memtrace" monitor commands, which the
+//! target registers to call command ().
+
+class MemTrace
+{
+public:
+
+  // Constructor and destructor
+
+  MemTrace ();
+  ~MemTrace ();
+
+  // Called from the target's run loop
+
+  //! Is the trace running?
+
+  //! @return  TRUE if accesses should be passed to access (), FALSE
+  //!          otherwise.
+
+  inline bool  active () const
+  {
+    return nullptr != mFile;
+  }
+
+  //! Record an access, if it is in a range being traced
+
+  //! @param[in] cycle  The cycle of the access
+  //! @param[in] addr   The lowest address accessed
+  //! @param[in] size   Bytes accessed: 1, 2 or 4
+  //! @param[in] write  TRUE for a store, FALSE for a load
+
+  inline void  access (uint64_t  cycle,
+		       uint32_t  addr,
+		       unsigned int  size,
+		       bool      write)
+  {
+    if (!wanted (addr))
+      return;
+
+    uint64_t  head = mHead.load (std::memory_order_relaxed);
+
+    if (head - mTail.load (std::memory_order_acquire) == RING_SIZE)
+      waitForSpace (head);
+
+    Access & a = mRing[head & (RING_SIZE - 1)];
+
+    a.cycle = cycle;
+    a.addr = addr;
+    a.flags = (write ? FLAG_WRITE : 0) | ((size >> 1) << SIZE_SHIFT);
+    mHead.store (head + 1, std::memory_order_release);
+  }
+
+  // Monitor commands
+
+  static const char  HELP[];
+  bool  command (const CommandArgs & args,
+		 std::ostream & stream);
+
+
+private:
+
+  //! An access waiting in the ring
+
+  struct Access
+  {
+    uint64_t  cycle;			//!< Cycle of the access
+    uint32_t  addr;			//!< Lowest address accessed
+    uint8_t   flags;			//!< As written to the file
+  };
+
+  //! Loads and stores to one page
+
+  struct PageCount
+  {
+    uint64_t  reads;			//!< Loads
+    uint64_t  writes;			//!< Stores
+  };
+
+  //! Accesses in the ring, which must be a power of 2
+
+  static const uint64_t  RING_SIZE = 64 * 1024;
+
+  //! Bytes encoded before writing them to the file
+
+  static const std::size_t  BLOCK_SIZE = 64 * 1024;
+
+  //! Largest record: flags, cycles and address
+
+  static const std::size_t  MAX_RECORD = 1 + 10 + 5;
+
+  //! Log2 of the page size for the summary
+
+  static const unsigned int  PAGE_SHIFT = 12;
+
+  //! Version of the file format
+
+  static const uint16_t  MEMTRACE_VERSION = 1;
+
+  // Record flags
+
+  static const uint8_t  FLAG_WRITE = 0x01;	//!< A store
+  static const unsigned int  SIZE_SHIFT = 1;	//!< Position of log2 size
+
+  //! The trace file, or nullptr if the trace is not running
+
+  FILE * mFile;
+
+  //! Name of the trace file
+
+  std::string  mFilename;
+
+  //! Address ranges traced, each low to high (exclusive)
+
+  std::vector<std::pair<uint32_t, uint32_t> >  mRanges;
+
+  //! The ring of accesses
+
+  std::vector<Access>  mRing;
+
+  //! Accesses put in the ring, only written by the target
+
+  std::atomic<uint64_t>  mHead;
+
+  //! Accesses taken out of the ring, only written by the writer thread
+
+  std::atomic<uint64_t>  mTail;
+
+  //! Set when the writer thread should empty the ring and finish
+
+  std::atomic<bool>  mStop;
+
+  //! The writer thread
+
+  std::thread  mWriter;
+
+  // Only used by the writer thread, until it is joined
+
+  //! Accesses for each page, by page number
+
+  std::map<uint32_t, PageCount>  mPages;
+
+  //! Cycle of the last access written
+
+  uint64_t  mLastCycle;
+
+  //! Address of the last access written
+
+  uint32_t  mLastAddr;
+
+  // Helper functions
+
+  //! Is an address in one of the ranges?
+
+  //! @param[in] addr  The address
+  //! @return  TRUE if it is, or if there are no ranges, FALSE otherwise.
+
+  inline bool  wanted (uint32_t  addr) const
+  {
+    if (mRanges.empty ())
+      return true;
+
+    for (auto it = mRanges.begin (); it != mRanges.end (); it++)
+      if ((addr >= it->first) && (addr < it->second))
+	return true;
+
+    return false;
+  }
+
+  void  waitForSpace (uint64_t  head);
+  bool  start (const std::string & filename,
+	       std::ostream & stream);
+  void  stop ();
+  void  writer ();
+  uint8_t * encode (uint8_t * p,
+		    const Access & a);
+  void  summary (std::ostream & stream) const;
+
+};	// class MemTrace
+
+
+#endif	// MEM_TRACE_H
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// show-trailing-whitespace: t
+// End:
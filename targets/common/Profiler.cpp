@@ -0,0 +1,315 @@
+// PC sampling profiler for targets: definition
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+
+#include "Profiler.h"
+
+using std::dec;
+using std::endl;
+using std::hex;
+using std::ios;
+using std::ofstream;
+using std::setfill;
+using std::setw;
+using std::string;
+using std::vector;
+
+
+//! Constructor.
+
+//! The profiler starts stopped, with an empty histogram.
+
+//! @param[in] tickHz  Clock ticks per simulated second
+
+Profiler::Profiler (double  tickHz) :
+  mTickHz (tickHz),
+  mPeriod (STOPPED),
+  mCountdown (STOPPED),
+  mLastPeriod (DEFAULT_PERIOD),
+  mLowPc (DEFAULT_LOW_PC),
+  mHighPc (DEFAULT_LOW_PC),
+  mOutside (0)
+{
+}	// Profiler::Profiler ()
+
+
+//! Handle a profiler command
+
+//! The commands are:
+//! - "profile" reports what has been sampled
+//! - "profile start [<period> [<low> <high>]]" clears the histogram and
+//!   starts sampling
+//! - "profile stop" stops sampling, keeping the histogram
+//! - "profile dump <file> [gmon | folded]" writes out the histogram
+
+//! @param[in]  args    The monitor command
+//! @param[out] stream  Where to write any response
+//! @return  TRUE if the command succeeded, FALSE otherwise.
+
+bool
+Profiler::command (const CommandArgs & args,
+		   std::ostream & stream)
+{
+  if (args.size () == 1)
+    {
+      stream << "Profiling is " << (STOPPED == mPeriod ? "stopped" : "running")
+	     << ", sampling every " << mLastPeriod << " cycles" << endl
+	     << totalSamples () << " samples between 0x" << hex << mLowPc
+	     << " and 0x" << mHighPc << dec << ", " << mOutside
+	     << " samples outside" << endl;
+      return true;
+    }
+
+  if (args.is (1, "start") && (args.size () <= 5)
+      && (args.size () != 4))
+    {
+      uint64_t  period = DEFAULT_PERIOD;
+      uint32_t  lowPc = DEFAULT_LOW_PC;
+      uint32_t  highPc = DEFAULT_HIGH_PC;
+
+      if ((args.size () >= 3) && (!args.num (2, period) || (0 == period)))
+	{
+	  stream << "Sample period must be a positive number" << endl;
+	  return false;
+	}
+
+      if ((args.size () == 5)
+	  && (!args.num (3, lowPc) || !args.num (4, highPc)
+	      || (highPc <= lowPc)))
+	{
+	  stream << "Address range must be <low> <high>, with low < high"
+		 << endl;
+	  return false;
+	}
+
+      start (period, lowPc, highPc);
+      return true;
+    }
+
+  if (args.is (1, "stop") && (args.size () == 2))
+    {
+      mPeriod = STOPPED;
+      mCountdown = STOPPED;
+      return true;
+    }
+
+  if (args.is (1, "dump") && (args.size () == 3))
+    return writeGmon (args.str (2), stream);
+
+  if (args.is (1, "dump") && (args.size () == 4))
+    {
+      if (args.is (3, "gmon"))
+	return writeGmon (args.str (2), stream);
+      else if (args.is (3, "folded"))
+	return writeFolded (args.str (2), stream);
+    }
+
+  stream << "Unrecognized profile command: " << args.cmd () << endl;
+  return false;
+
+}	// Profiler::command ()
+
+
+//! Help for the profiler commands
+
+const char Profiler::HELP[] =
+  "  profile\n"
+  "    Report what the profiler has sampled\n"
+  "  profile start [<period> [<low> <high>]]\n"
+  "    Sample the PC between <low> and <high> every <period> cycles\n"
+  "  profile stop\n"
+  "    Stop sampling the PC\n"
+  "  profile dump <file> [gmon | folded]\n"
+  "    Write the samples as gmon.out or folded stacks\n";
+
+
+//! Clear the histogram and start sampling
+
+//! @param[in] period  Ticks between samples
+//! @param[in] lowPc   Lowest PC profiled
+//! @param[in] highPc  Highest PC profiled (exclusive)
+
+void
+Profiler::start (uint64_t  period,
+		 uint32_t  lowPc,
+		 uint32_t  highPc)
+{
+  std::size_t  buckets = ((highPc - lowPc - 1) >> BUCKET_BITS) + 1;
+
+  mLowPc = lowPc;
+  mHighPc = highPc;
+  mHist.assign (buckets, 0);
+  mOutside = 0;
+  mLastPeriod = period;
+  mPeriod = period;
+  mCountdown = period;
+
+}	// Profiler::start ()
+
+
+//! Count the samples in the histogram
+
+//! @return  The number of samples in the range profiled
+
+uint64_t
+Profiler::totalSamples () const
+{
+  uint64_t  total = 0;
+
+  for (auto it = mHist.begin (); it != mHist.end (); it++)
+    total += *it;
+
+  return total;
+
+}	// Profiler::totalSamples ()
+
+
+//! Write the histogram as a gprof gmon.out file
+
+//! The file has the gmon header, then a single histogram record. Addresses
+//! are the size of a register, to match the target's gprof. Counts are only
+//! 16 bits in the file, so larger ones are clipped, with a warning.
+
+//! @param[in]  filename  The file to write
+//! @param[out] stream    Where to report any problems
+//! @return  TRUE if the file was written, FALSE otherwise.
+
+bool
+Profiler::writeGmon (const string & filename,
+		     std::ostream & stream) const
+{
+  ofstream  ofs (filename, ios::out | ios::binary | ios::trunc);
+
+  if (! ofs)
+    {
+      stream << "Unable to open " << filename << ": " << strerror (errno)
+	     << endl;
+      return false;
+    }
+
+  // Header: cookie, version, and 12 spare bytes
+
+  char  spare[12];
+  uint32_t  version = GMON_VERSION;
+
+  memset (spare, 0, sizeof (spare));
+  ofs.write ("gmon", 4);
+  ofs.write (reinterpret_cast<const char *> (&version), sizeof (version));
+  ofs.write (spare, sizeof (spare));
+
+  // Histogram record
+
+  uint_reg_t  lowPc = mLowPc;
+  uint_reg_t  highPc = mLowPc
+    + (static_cast<uint_reg_t> (mHist.size ()) << BUCKET_BITS);
+  uint32_t  histSize = static_cast<uint32_t> (mHist.size ());
+  double  rate = mTickHz / static_cast<double> (mLastPeriod);
+  uint32_t  profRate = rate < 1.0 ? 1 : static_cast<uint32_t> (rate);
+  char  dimen[15];
+
+  memset (dimen, 0, sizeof (dimen));
+  strncpy (dimen, "seconds", sizeof (dimen));
+
+  ofs.put (static_cast<char> (GMON_TAG_TIME_HIST));
+  ofs.write (reinterpret_cast<const char *> (&lowPc), sizeof (lowPc));
+  ofs.write (reinterpret_cast<const char *> (&highPc), sizeof (highPc));
+  ofs.write (reinterpret_cast<const char *> (&histSize), sizeof (histSize));
+  ofs.write (reinterpret_cast<const char *> (&profRate), sizeof (profRate));
+  ofs.write (dimen, sizeof (dimen));
+  ofs.put ('s');
+
+  vector<uint16_t>  counts (mHist.size ());
+  bool  clipped = false;
+
+  for (std::size_t  i = 0; i < mHist.size (); i++)
+    if (mHist[i] > UINT16_MAX)
+      {
+	counts[i] = UINT16_MAX;
+	clipped = true;
+      }
+    else
+      counts[i] = static_cast<uint16_t> (mHist[i]);
+
+  ofs.write (reinterpret_cast<const char *> (counts.data ()),
+	     counts.size () * sizeof (uint16_t));
+
+  if (! ofs)
+    {
+      stream << "Unable to write " << filename << endl;
+      return false;
+    }
+
+  if (clipped)
+    stream << "Warning: Some counts are too large for gmon.out: use a longer "
+	   << "sample period" << endl;
+
+  return true;
+
+}	// Profiler::writeGmon ()
+
+
+//! Write the histogram as folded stacks
+
+//! There is no call stack, so each line is a single frame, the address of a
+//! bucket, followed by its count. Flame graph tools take this as it is, and
+//! the addresses can be replaced by function names from the symbol table.
+
+//! @param[in]  filename  The file to write
+//! @param[out] stream    Where to report any problems
+//! @return  TRUE if the file was written, FALSE otherwise.
+
+bool
+Profiler::writeFolded (const string & filename,
+		       std::ostream & stream) const
+{
+  ofstream  ofs (filename, ios::out | ios::trunc);
+
+  if (! ofs)
+    {
+      stream << "Unable to open " << filename << ": " << strerror (errno)
+	     << endl;
+      return false;
+    }
+
+  for (std::size_t  i = 0; i < mHist.size (); i++)
+    if (0 != mHist[i])
+      ofs << "0x" << hex << setw (8) << setfill ('0')
+	  << (mLowPc + (i << BUCKET_BITS)) << dec << " " << mHist[i] << endl;
+
+  if (! ofs)
+    {
+      stream << "Unable to write " << filename << endl;
+      return false;
+    }
+
+  return true;
+
+}	// Profiler::writeFolded ()
+
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// show-trailing-whitespace: t
+// End:
@@ -0,0 +1,193 @@
+// PC sampling profiler for targets: declaration
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "CommandRegistry.h"
+#include "RegisterSizes.h"
+
+
+//! A histogram of the PC, sampled every so many clock ticks.
+
+//! A target calls tick () from its clock loop, and when that returns TRUE,
+//! passes the current PC to sample (). While the profiler is stopped, tick
+//! () never returns TRUE, so the cost is a compare and a subtract.
+
+//! The histogram is a flat array with a count for every 2 bytes of a range
+//! of addresses, normally the text segment. It can be written out as a
+//! gprof gmon.out file, or as folded stacks for flame graph tools.
+
+//! The profiler is controlled by the "profile" monitor commands, which the
+//! target registers to call command ().
+
+class Profiler
+{
+public:
+
+  // Constructor
+
+  Profiler (double  tickHz);
+
+  // Called from the target's clock loop
+
+  //! Is the profiler sampling?
+
+  //! @return  TRUE if tick () can return TRUE, FALSE otherwise.
+
+  inline bool  running () const
+  {
+    return STOPPED != mPeriod;
+  }
+
+  //! Count clock ticks towards the next sample
+
+  //! @param[in] n  Number of ticks since the last call
+  //! @return  TRUE if a sample is due, FALSE otherwise.
+
+  inline bool  tick (uint64_t  n = 1)
+  {
+    if (mCountdown > n)
+      {
+	mCountdown -= n;
+	return false;
+      }
+
+    mCountdown = mPeriod;
+    return true;
+  }
+
+  //! Ticks until the next sample is due
+
+  //! For a target which can skip ticks, so it skips no more than this.
+
+  //! @return  The number of ticks, which is the maximum if stopped.
+
+  inline uint64_t  untilSample () const
+  {
+    return mCountdown;
+  }
+
+  //! Record a sample
+
+  //! @param[in] pc  The PC when the sample was due
+
+  inline void  sample (uint32_t  pc)
+  {
+    uint32_t  off = pc - mLowPc;
+
+    if (off < mHighPc - mLowPc)
+      mHist[off >> BUCKET_BITS]++;
+    else
+      mOutside++;
+  }
+
+  // Monitor commands
+
+  static const char  HELP[];
+  bool  command (const CommandArgs & args,
+		 std::ostream & stream);
+
+
+private:
+
+  //! Bits of address within a histogram bucket
+
+  static const unsigned int  BUCKET_BITS = 1;
+
+  //! Ticks between samples, unless set by "profile start"
+
+  static const uint64_t  DEFAULT_PERIOD = 10000;
+
+  //! Lowest PC profiled, unless set by "profile start"
+
+  static const uint32_t  DEFAULT_LOW_PC = 0x00000000;
+
+  //! Highest PC profiled (exclusive), unless set by "profile start"
+
+  static const uint32_t  DEFAULT_HIGH_PC = 0x00100000;
+
+  //! Value of mCountdown and mPeriod when stopped
+
+  static const uint64_t  STOPPED = std::numeric_limits<uint64_t>::max ();
+
+  // gmon.out values, from gprof's gmon_out.h
+
+  static const uint32_t  GMON_VERSION = 1;	//!< File version
+  static const uint8_t  GMON_TAG_TIME_HIST = 0;	//!< Histogram record tag
+
+  //! Clock ticks per simulated second, for the sample rate
+
+  double  mTickHz;
+
+  //! Ticks between samples, or STOPPED
+
+  uint64_t  mPeriod;
+
+  //! Ticks until the next sample, or STOPPED
+
+  uint64_t  mCountdown;
+
+  //! Ticks between samples when last started
+
+  uint64_t  mLastPeriod;
+
+  //! Lowest PC profiled
+
+  uint32_t  mLowPc;
+
+  //! Highest PC profiled (exclusive)
+
+  uint32_t  mHighPc;
+
+  //! Samples in each bucket
+
+  std::vector<uint32_t>  mHist;
+
+  //! Samples outside the range profiled
+
+  uint64_t  mOutside;
+
+  // Helper functions
+
+  void  start (uint64_t  period,
+	       uint32_t  lowPc,
+	       uint32_t  highPc);
+  uint64_t  totalSamples () const;
+  bool  writeGmon (const std::string & filename,
+		   std::ostream & stream) const;
+  bool  writeFolded (const std::string & filename,
+		     std::ostream & stream) const;
+
+};	// class Profiler
+
+
+#endif	// PROFILER_H
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// show-trailing-whitespace: t
+// End:
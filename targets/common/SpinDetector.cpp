@@ -0,0 +1,657 @@
+// Spin loop detector: definition
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <iomanip>
+
+#include "SpinDetector.h"
+
+using std::dec;
+using std::endl;
+using std::hex;
+using std::setfill;
+using std::setw;
+
+
+//! What the loop analysis needs to know about an instruction
+
+struct Insn
+{
+  //! What the instruction does to control flow and state
+
+  enum Kind
+  {
+    PLAIN,			//!< Only writes rd, from rs1, rs2 and memory
+    BRANCH,			//!< Conditional branch
+    JUMP,			//!< Jump without a link
+    OTHER			//!< Anything else, which stops a skip
+  };
+
+  Kind          kind;		//!< What it does
+  unsigned int  size;		//!< Length in bytes
+  unsigned int  rd;		//!< Register written, or 0
+  unsigned int  rs1;		//!< First register read, or 0
+  unsigned int  rs2;		//!< Second register read, or 0
+  bool          update;		//!< Is it "addi rd, rd, imm"?
+  int64_t       imm;		//!< Immediate of an update
+  unsigned int  cond;		//!< BRANCH funct3
+};
+
+
+//! Decode an instruction
+
+//! Only as far as the loop analysis needs. Stores, atomics, floating point,
+//! system instructions and jumps which link are all OTHER. So are those
+//! compressed instructions which differ between RV32 and RV64.
+
+//! @param[in] p  The instruction, little endian
+//! @return  What the analysis needs to know.
+
+static Insn
+decode (const uint8_t *p)
+{
+  Insn  in = { Insn::OTHER, 2, 0, 0, 0, false, 0, 0 };
+  uint32_t  h = p[0] | (p[1] << 8);
+
+  if (3 == (h & 3))
+    {
+      uint32_t  w = h | (p[2] << 16) | (static_cast<uint32_t> (p[3]) << 24);
+      unsigned int  rd = (w >> 7) & 0x1f;
+      unsigned int  f3 = (w >> 12) & 7;
+      unsigned int  rs1 = (w >> 15) & 0x1f;
+      unsigned int  rs2 = (w >> 20) & 0x1f;
+
+      in.size = 4;
+
+      switch (w & 0x7f)
+	{
+	case 0x13:			// OP-IMM
+	  in = { Insn::PLAIN, 4, rd, rs1, 0, false, 0, 0 };
+
+	  if ((0 == f3) && (rd == rs1))
+	    {
+	      in.update = true;
+	      in.imm = static_cast<int32_t> (w) >> 20;
+	    }
+
+	  break;
+
+	case 0x03:			// LOAD
+	case 0x1b:			// OP-IMM-32
+	  in = { Insn::PLAIN, 4, rd, rs1, 0, false, 0, 0 };
+	  break;
+
+	case 0x33:			// OP
+	case 0x3b:			// OP-32
+	  in = { Insn::PLAIN, 4, rd, rs1, rs2, false, 0, 0 };
+	  break;
+
+	case 0x17:			// AUIPC
+	case 0x37:			// LUI
+	  in = { Insn::PLAIN, 4, rd, 0, 0, false, 0, 0 };
+	  break;
+
+	case 0x0f:			// MISC-MEM
+	  in.kind = Insn::PLAIN;
+	  break;
+
+	case 0x63:			// BRANCH
+	  if ((2 != f3) && (3 != f3))
+	    in = { Insn::BRANCH, 4, 0, rs1, rs2, false, 0, f3 };
+
+	  break;
+
+	case 0x6f:			// JAL
+	  if (0 == rd)
+	    in.kind = Insn::JUMP;
+
+	  break;
+	}
+
+      return in;
+    }
+
+  unsigned int  f3 = h >> 13;
+  unsigned int  rd = (h >> 7) & 0x1f;
+  unsigned int  rs2 = (h >> 2) & 0x1f;
+  unsigned int  rdp = 8 + ((h >> 7) & 7);	// rd' and rs1'
+  unsigned int  rs2p = 8 + ((h >> 2) & 7);	// rs2' and rd'
+
+  switch (((h & 3) << 3) | f3)
+    {
+    case 000:				// C.ADDI4SPN
+      if (0 != h)
+	in = { Insn::PLAIN, 2, rs2p, 2, 0, false, 0, 0 };
+
+      break;
+
+    case 002:				// C.LW
+      in = { Insn::PLAIN, 2, rs2p, rdp, 0, false, 0, 0 };
+      break;
+
+    case 010:				// C.ADDI
+      in = { Insn::PLAIN, 2, rd, rd, 0, 0 != rd, 0, 0 };
+      in.imm = static_cast<int64_t> ((((h >> 7) & 0x20) | rs2) ^ 0x20) - 0x20;
+      break;
+
+    case 012:				// C.LI
+      in = { Insn::PLAIN, 2, rd, 0, 0, false, 0, 0 };
+      break;
+
+    case 013:				// C.ADDI16SP and C.LUI
+      in = { Insn::PLAIN, 2, rd, (2 == rd) ? 2U : 0U, 0, false, 0, 0 };
+      break;
+
+    case 014:				// Arithmetic on rd'
+      if (3 == ((h >> 10) & 3))
+	in = { Insn::PLAIN, 2, rdp, rdp, rs2p, false, 0, 0 };
+      else
+	in = { Insn::PLAIN, 2, rdp, rdp, 0, false, 0, 0 };
+
+      break;
+
+    case 015:				// C.J
+      in.kind = Insn::JUMP;
+      break;
+
+    case 016:				// C.BEQZ
+    case 017:				// C.BNEZ
+      in = { Insn::BRANCH, 2, 0, rdp, 0, false, 0, f3 - 6 };
+      break;
+
+    case 020:				// C.SLLI
+      in = { Insn::PLAIN, 2, rd, rd, 0, false, 0, 0 };
+      break;
+
+    case 022:				// C.LWSP
+      in = { Insn::PLAIN, 2, rd, 2, 0, false, 0, 0 };
+      break;
+
+    case 024:				// C.MV and C.ADD, but not jumps
+      if (0 != rs2)
+	in = { Insn::PLAIN, 2, rd, ((h >> 12) & 1) ? rd : 0, rs2, false, 0,
+	       0 };
+
+      break;
+    }
+
+  return in;
+
+}	// decode ()
+
+
+//! Constructor.
+
+//! Detection starts on, with nothing found.
+
+//! @param[in] xlen  Width of the core's registers, 32 or 64
+
+SpinDetector::SpinDetector (unsigned int  xlen) :
+  mMask ((64 == xlen) ? std::numeric_limits<uint64_t>::max ()
+	 : (UINT64_C (1) << xlen) - 1),
+  mEnabled (true),
+  mLastPc (0),
+  mHead (0),
+  mEdge (0),
+  mHeadInstrs (0),
+  mHeadCycles (0),
+  mIterInstrs (0),
+  mIterCycles (0),
+  mIters (0),
+  mState (State::TIMING),
+  mRegs ()
+{
+}	// SpinDetector::SpinDetector ()
+
+
+//! Examine a loop
+
+//! Called at the head of the loop each time watch () returns TRUE. The first
+//! call saves the registers and finds nothing. The second compares them
+//! with the first, and the loop is then left alone until skipped () is
+//! called or its timing changes.
+
+//! @param[in] regs  The registers, x0 to x31
+//! @param[in] code  MAX_CODE bytes of code from the head of the loop
+//! @return  What was found. Nothing can be skipped unless the kind is SPIN
+//!          or COUNTDOWN.
+
+SpinDetector::Verdict
+SpinDetector::examine (const uint64_t regs[NUM_REGS],
+		       const uint8_t code[MAX_CODE])
+{
+  if (State::TIMING == mState)
+    {
+      std::copy (regs, regs + NUM_REGS, mRegs);
+      mState = State::EXAMINING;
+      return { Kind::NONE, 0, 0, 0, mIterInstrs, mIterCycles };
+    }
+
+  mState = State::DONE;
+  Verdict  v = analyse (regs, code);
+
+  if (Kind::NONE != v.kind)
+    {
+      Found & f = mFound[mHead];
+
+      f.kind = v.kind;
+      f.times++;
+    }
+
+  return v;
+
+}	// SpinDetector::examine ()
+
+
+//! Note iterations skipped
+
+//! The loop is timed again from here, so a countdown which could not be
+//! skipped to its end in one go is found again.
+
+//! @param[in] iters  Number of iterations the target moved on
+
+void
+SpinDetector::skipped (uint64_t  iters)
+{
+  Found & f = mFound[mHead];
+
+  f.iters += iters;
+  f.instrs += iters * mIterInstrs;
+
+  mHeadInstrs += iters * mIterInstrs;
+  mHeadCycles += iters * mIterCycles;
+  mIters = 0;
+  mState = State::TIMING;
+
+}	// SpinDetector::skipped ()
+
+
+//! The most iterations which keep a count within a limit
+
+//! @param[in] iters    Iterations wanted
+//! @param[in] count    Count now
+//! @param[in] limit    Count at which to stop, with the maximum meaning no
+//!                     limit, as for ITarget::NO_LIMIT
+//! @param[in] perIter  Count for each iteration
+//! @return  The iterations which can be skipped.
+
+uint64_t
+SpinDetector::within (uint64_t  iters,
+		      uint64_t  count,
+		      uint64_t  limit,
+		      uint64_t  perIter)
+{
+  if ((0 == iters) || (std::numeric_limits<uint64_t>::max () == limit))
+    return iters;
+
+  if (count >= limit)
+    return 0;
+
+  return std::min (iters, (limit - count) / perIter);
+
+}	// SpinDetector::within ()
+
+
+//! Report the loops found
+
+//! For the "stats" monitor command.
+
+//! @param[out] stream  Where to write the report
+
+void
+SpinDetector::report (std::ostream & stream) const
+{
+  stream << "Spin loops:      " << mFound.size () << endl;
+
+  for (auto it = mFound.begin (); it != mFound.end (); it++)
+    stream << "  0x" << hex << setw (8) << setfill ('0') << it->first
+	   << dec << setfill (' ') << ": "
+	   << ((Kind::SPIN == it->second.kind) ? "spin" : "countdown")
+	   << ", found " << it->second.times << ", skipped "
+	   << it->second.iters << " iterations (" << it->second.instrs
+	   << " instructions)" << endl;
+
+}	// SpinDetector::report ()
+
+
+//! Handle a spin loop command
+
+//! The commands are:
+//! - "spin" reports whether detection is on and the loops found
+//! - "spin on" and "spin off" start and stop detection
+//! - "spin clear" forgets the loops found
+
+//! @param[in]  args    The monitor command
+//! @param[out] stream  Where to write any response
+//! @return  TRUE if the command succeeded, FALSE otherwise.
+
+bool
+SpinDetector::command (const CommandArgs & args,
+		       std::ostream & stream)
+{
+  if (args.size () == 1)
+    {
+      stream << "Spin loop detection is " << (mEnabled ? "on" : "off")
+	     << endl;
+      report (stream);
+      return true;
+    }
+
+  if (args.size () == 2)
+    {
+      if (args.is (1, "on") || args.is (1, "off"))
+	{
+	  mEnabled = args.is (1, "on");
+	  mHead = 0;
+	  mEdge = 0;
+	  mState = State::TIMING;
+	  return true;
+	}
+
+      if (args.is (1, "clear"))
+	{
+	  mFound.clear ();
+	  return true;
+	}
+    }
+
+  stream << "Unrecognized spin command: " << args.cmd () << endl;
+  return false;
+
+}	// SpinDetector::command ()
+
+
+//! Help for the spin loop commands
+
+const char SpinDetector::HELP[] =
+  "  spin\n"
+  "    Report the spin loops found\n"
+  "  spin on|off\n"
+  "    Enable/disable skipping spin loops\n"
+  "  spin clear\n"
+  "    Forget the spin loops found\n";
+
+
+//! Handle a jump back
+
+//! Starts timing a new loop, or counts another iteration of the one being
+//! timed.
+
+//! @param[in] pc      The head of the loop
+//! @param[in] last    The PC jumped from
+//! @param[in] instrs  Instructions executed so far
+//! @param[in] cycles  Cycles taken so far
+//! @return  TRUE if the loop should be examined, FALSE otherwise.
+
+bool
+SpinDetector::backEdge (uint32_t  pc,
+			uint32_t  last,
+			uint64_t  instrs,
+			uint64_t  cycles)
+{
+  if (!mEnabled)
+    return false;
+
+  if ((pc != mHead) || (last != mEdge))
+    {
+      mHead = pc;
+      mEdge = last;
+      mHeadInstrs = instrs;
+      mHeadCycles = cycles;
+      mIterInstrs = 0;
+      mIterCycles = 0;
+      mIters = 0;
+      mState = State::TIMING;
+      return false;
+    }
+
+  uint64_t  di = instrs - mHeadInstrs;
+  uint64_t  dc = cycles - mHeadCycles;
+
+  mHeadInstrs = instrs;
+  mHeadCycles = cycles;
+
+  // A change in timing means the loop was left, or took a different path,
+  // so anything found no longer holds.
+
+  if ((di != mIterInstrs) || (dc != mIterCycles))
+    {
+      mIterInstrs = di;
+      mIterCycles = dc;
+      mIters = 1;
+      mState = State::TIMING;
+      return false;
+    }
+
+  if (mIters < MIN_ITERS)
+    {
+      mIters++;
+      return false;
+    }
+
+  return State::DONE != mState;
+
+}	// SpinDetector::backEdge ()
+
+
+//! Work out what can be skipped
+
+//! The loop must be straight line code from the head, ending in a branch
+//! or jump back at the edge, with as many instructions as each iteration
+//! took.
+
+//! @param[in] regs  The registers, one iteration after mRegs
+//! @param[in] code  MAX_CODE bytes of code from the head of the loop
+//! @return  What was found.
+
+SpinDetector::Verdict
+SpinDetector::analyse (const uint64_t regs[NUM_REGS],
+		       const uint8_t code[MAX_CODE]) const
+{
+  Verdict  v = { Kind::NONE, 0, 0, 0, mIterInstrs, mIterCycles };
+  unsigned int  numChanged = 0;
+  unsigned int  reg = 0;
+
+  for (unsigned int  r = 1; r < NUM_REGS; r++)
+    if (0 != ((regs[r] ^ mRegs[r]) & mMask))
+      {
+	numChanged++;
+	reg = r;
+      }
+
+  if (numChanged > 1)
+    return v;
+
+  // Walk the body. Only an update may write the counter, and nothing but
+  // an update or the branch may read it.
+
+  uint64_t  sum = 0;
+  uint64_t  numInsns = 0;
+  uint32_t  off = 0;
+  Insn  in;
+
+  while (true)
+    {
+      if (off > mEdge - mHead)
+	return v;			// Not on an instruction boundary
+
+      in = decode (code + off);
+      numInsns++;
+
+      if (off == mEdge - mHead)
+	break;
+
+      if (Insn::PLAIN != in.kind)
+	return v;
+
+      if ((0 != reg) && in.update && (in.rd == reg))
+	sum += static_cast<uint64_t> (in.imm);
+      else if ((0 != reg)
+	       && ((in.rd == reg) || (in.rs1 == reg) || (in.rs2 == reg)))
+	return v;
+
+      off += in.size;
+    }
+
+  if ((numInsns != mIterInstrs)
+      || ((Insn::BRANCH != in.kind) && (Insn::JUMP != in.kind)))
+    return v;
+
+  if (0 == reg)
+    {
+      v.kind = Kind::SPIN;
+      v.iters = FOREVER;
+      return v;
+    }
+
+  uint64_t  delta = (regs[reg] - mRegs[reg]) & mMask;
+
+  if ((sum & mMask) != delta)
+    return v;
+
+  v.kind = Kind::COUNTDOWN;
+  v.reg = reg;
+  v.delta = delta;
+
+  if ((Insn::JUMP == in.kind) || ((in.rs1 != reg) && (in.rs2 != reg)))
+    v.iters = FOREVER;			// The branch does not depend on it
+  else if (in.rs1 == in.rs2)
+    v.iters = ((0 == in.cond) || (5 == in.cond) || (7 == in.cond))
+      ? FOREVER : 0;			// BEQ, BGE and BGEU with itself
+  else if (in.rs1 == reg)
+    v.iters = countdown (in.cond, true, regs[reg], delta, regs[in.rs2]);
+  else
+    v.iters = countdown (in.cond, false, regs[reg], delta, regs[in.rs1]);
+
+  return v;
+
+}	// SpinDetector::analyse ()
+
+
+//! Iterations of a countdown which can be skipped
+
+//! Iteration i leaves the counter at x0 + i * delta for the branch. The
+//! loop ends at the first iteration whose branch is not taken, which is
+//! worked out directly for BEQ and BNE. For the others, the counter is only
+//! followed as far as it goes without wrapping, over which the branch
+//! condition can change at most once, so the change is found by bisection.
+
+//! @param[in] cond          Branch funct3
+//! @param[in] counterFirst  Is the counter rs1 of the branch?
+//! @param[in] x0            The counter now
+//! @param[in] delta         Its change each iteration, which is not zero
+//! @param[in] other         The other operand of the branch
+//! @return  Iterations which can be skipped, leaving at least the last to
+//!          run, or FOREVER.
+
+uint64_t
+SpinDetector::countdown (unsigned int  cond,
+			 bool  counterFirst,
+			 uint64_t  x0,
+			 uint64_t  delta,
+			 uint64_t  other) const
+{
+  const uint64_t  sign = (mMask >> 1) + 1;
+  const uint64_t  c = other & mMask;
+
+  auto taken = [=] (uint64_t  i) -> bool
+    {
+      uint64_t  x = (x0 + i * delta) & mMask;
+      uint64_t  a = counterFirst ? x : c;
+      uint64_t  b = counterFirst ? c : x;
+
+      switch (cond)
+	{
+	case 0: return a == b;
+	case 1: return a != b;
+	case 4: return (a ^ sign) < (b ^ sign);
+	case 5: return (a ^ sign) >= (b ^ sign);
+	case 6: return a < b;
+	default: return a >= b;
+	}
+    };
+
+  if (!taken (1))
+    return 0;
+
+  if (0 == cond)
+    return 1;				// Only once, since delta is not zero
+
+  if (1 == cond)
+    {
+      // Solve i * delta == c - x0, modulo 2^(XLEN - t), where 2^t is the
+      // largest power of 2 dividing delta.
+
+      uint64_t  d = (c - x0) & mMask;
+      unsigned int  t = __builtin_ctzll (delta);
+
+      if (0 != (d & ((UINT64_C (1) << t) - 1)))
+	return FOREVER;
+
+      uint64_t  odd = delta >> t;
+      uint64_t  inv = odd;		// Right to 3 bits
+
+      for (int  n = 0; n < 5; n++)
+	inv *= 2 - odd * inv;		// Newton: doubles the bits right
+
+      uint64_t  mod = mMask >> t;
+      uint64_t  i = ((d >> t) * inv) & mod;
+
+      if (0 == i)
+	return (std::numeric_limits<uint64_t>::max () == mod) ? FOREVER : mod;
+
+      return i - 1;
+    }
+
+  // How far the counter goes without wrapping, as unsigned or signed
+
+  uint64_t  u0 = ((4 == cond) || (5 == cond)) ? (x0 ^ sign) & mMask : x0;
+  uint64_t  m = (0 != (delta & sign))
+    ? u0 / ((0 - delta) & mMask)
+    : (mMask - u0) / delta;
+
+  if (0 == m)
+    return 0;
+
+  if (taken (m))
+    return m;
+
+  uint64_t  lo = 1;			// Taken
+  uint64_t  hi = m;			// Not taken
+
+  while (hi - lo > 1)
+    {
+      uint64_t  mid = lo + (hi - lo) / 2;
+
+      if (taken (mid))
+	lo = mid;
+      else
+	hi = mid;
+    }
+
+  return lo;
+
+}	// SpinDetector::countdown ()
+
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// show-trailing-whitespace: t
+// End:
@@ -0,0 +1,247 @@
+// Spin loop detector: declaration
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SPIN_DETECTOR_H
+#define SPIN_DETECTOR_H
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <ostream>
+
+#include "CommandRegistry.h"
+
+
+//! Finds small loops whose iterations can be skipped.
+
+//! A target calls watch () with the PC of each instruction it is about to
+//! execute. A jump back of no more than MAX_SPAN bytes marks a candidate
+//! loop, from the head jumped to, to the edge jumped from. Each time round,
+//! the instructions and cycles taken are compared with the last time, and
+//! once they have been the same for MIN_ITERS iterations, watch () returns
+//! TRUE at the head of the loop.
+
+//! The target then passes the registers and the code of the loop to
+//! examine (), twice, on successive iterations. A loop can be skipped if its
+//! body is straight line code ending in the branch back, with no stores or
+//! system instructions, and either:
+//! - no register changes, so the loop spins until something outside changes
+//!   memory, which nothing does; or
+//! - one register changes, only by "addi" to itself, and nothing else reads
+//!   it except the branch, so the number of iterations left can be worked
+//!   out from the branch condition.
+
+//! The target moves its counters on by as many iterations as it can, sets
+//! the counter register to match and calls skipped (). Loops found are
+//! listed by report (), for the "stats" command, and detection is
+//! controlled by the "spin" monitor commands, which the target registers to
+//! call command ().
+
+class SpinDetector
+{
+public:
+
+  //! Registers examined: x0 to x31
+
+  static const unsigned int  NUM_REGS = 32;
+
+  //! Longest jump back treated as a loop, in bytes
+
+  static const uint32_t  MAX_SPAN = 64;
+
+  //! Bytes of code examine () needs
+
+  static const uint32_t  MAX_CODE = MAX_SPAN + 4;
+
+  //! Iterations which never end
+
+  static const uint64_t  FOREVER = std::numeric_limits<uint64_t>::max ();
+
+  //! What sort of loop was found
+
+  enum class Kind
+  {
+    NONE,				//!< Nothing that can be skipped
+    SPIN,				//!< Nothing changes
+    COUNTDOWN				//!< One register counts
+  };
+
+  //! What examine () found
+
+  struct Verdict
+  {
+    Kind          kind;			//!< Sort of loop
+    uint64_t      iters;		//!< Iterations which can be skipped
+    unsigned int  reg;			//!< Counter register (COUNTDOWN)
+    uint64_t      delta;		//!< Change in the counter each time
+    uint64_t      instrs;		//!< Instructions each time round
+    uint64_t      cycles;		//!< Cycles each time round
+  };
+
+  // Constructor
+
+  SpinDetector (unsigned int  xlen);
+
+  // Called from the target's run loop
+
+  //! Note the PC of the next instruction
+
+  //! @param[in] pc      The PC
+  //! @param[in] instrs  Instructions executed so far
+  //! @param[in] cycles  Cycles taken so far, in any unit the target likes
+  //! @return  TRUE if the loop should be examined, FALSE otherwise.
+
+  inline bool  watch (uint32_t  pc,
+		      uint64_t  instrs,
+		      uint64_t  cycles)
+  {
+    uint32_t  last = mLastPc;
+
+    mLastPc = pc;
+
+    if (last - pc <= MAX_SPAN)
+      return backEdge (pc, last, instrs, cycles);
+
+    return false;
+  }
+
+  //! The address of the loop being examined
+
+  uint32_t  head () const
+  {
+    return mHead;
+  }
+
+  Verdict  examine (const uint64_t regs[NUM_REGS],
+		    const uint8_t code[MAX_CODE]);
+  void  skipped (uint64_t  iters);
+
+  // Limiting a skip
+
+  static uint64_t  within (uint64_t  iters,
+			   uint64_t  count,
+			   uint64_t  limit,
+			   uint64_t  perIter);
+
+  // Reporting
+
+  void  report (std::ostream & stream) const;
+
+  // Monitor commands
+
+  static const char  HELP[];
+  bool  command (const CommandArgs & args,
+		 std::ostream & stream);
+
+
+private:
+
+  //! Iterations timed the same before a loop is examined
+
+  static const unsigned int  MIN_ITERS = 4;
+
+  //! Where we are with the current loop
+
+  enum class State
+  {
+    TIMING,				//!< Counting iterations
+    EXAMINING,				//!< First registers saved
+    DONE				//!< Examined
+  };
+
+  //! What has been found at a loop head
+
+  struct Found
+  {
+    Kind      kind;			//!< Sort of loop last found
+    uint64_t  times;			//!< Times found
+    uint64_t  iters;			//!< Iterations skipped
+    uint64_t  instrs;			//!< Instructions skipped
+  };
+
+  //! Register mask for the width of the core
+
+  uint64_t  mMask;
+
+  //! Looking for loops?
+
+  bool  mEnabled;
+
+  //! The PC last watched
+
+  uint32_t  mLastPc;
+
+  //! The first instruction of the loop
+
+  uint32_t  mHead;
+
+  //! The branch back to the head
+
+  uint32_t  mEdge;
+
+  //! Counts when last at the head
+
+  uint64_t  mHeadInstrs;
+  uint64_t  mHeadCycles;
+
+  //! Counts for each time round
+
+  uint64_t  mIterInstrs;
+  uint64_t  mIterCycles;
+
+  //! Iterations timed the same
+
+  unsigned int  mIters;
+
+  //! Where we are with this loop
+
+  State  mState;
+
+  //! Registers when examining started
+
+  uint64_t  mRegs[NUM_REGS];
+
+  //! Loops found, by head
+
+  std::map<uint32_t, Found>  mFound;
+
+  // Helper functions
+
+  bool  backEdge (uint32_t  pc,
+		  uint32_t  last,
+		  uint64_t  instrs,
+		  uint64_t  cycles);
+  Verdict  analyse (const uint64_t regs[NUM_REGS],
+		    const uint8_t code[MAX_CODE]) const;
+  uint64_t  countdown (unsigned int  cond,
+		       bool  counterFirst,
+		       uint64_t  x0,
+		       uint64_t  delta,
+		       uint64_t  other) const;
+
+};	// class SpinDetector
+
+
+#endif	// SPIN_DETECTOR_H
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// show-trailing-whitespace: t
+// End:
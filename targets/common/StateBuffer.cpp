@@ -0,0 +1,201 @@
+// In memory state of Verilated targets: implementation
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+// ----------------------------------------------------------------------------
+
+#include <cstring>
+
+#include "StateBuffer.h"
+
+using std::string;
+using std::vector;
+
+
+//! Constructor
+
+StateWriter::StateWriter () :
+  mState (nullptr)
+{
+}	// StateWriter ()
+
+
+//! Destructor
+
+//! Make sure the state is complete.
+
+StateWriter::~StateWriter ()
+{
+  close ();
+
+}	// ~StateWriter ()
+
+
+//! Start saving state
+
+//! @param[out] state  Where to put the state. Anything already there is
+//!                    discarded, but its storage is reused.
+
+void
+StateWriter::open (vector<uint8_t> & state)
+{
+  close ();
+
+  mState = &state;
+  mState->clear ();
+  m_isOpen = true;
+  m_filename = "snapshot";
+  m_cp = m_bufp;
+  header ();
+
+}	// open ()
+
+
+//! Finish saving state
+
+void
+StateWriter::close ()
+{
+  if (! isOpen ())
+    return;
+
+  flush ();
+  m_isOpen = false;
+  mState = nullptr;
+
+}	// close ()
+
+
+//! Write out the Verilator buffer
+
+void
+StateWriter::flush ()
+{
+  if (! isOpen ())
+    return;
+
+  mState->insert (mState->end (), m_bufp, m_cp);
+  m_cp = m_bufp;
+
+}	// flush ()
+
+
+//! Constructor
+
+StateReader::StateReader () :
+  mOverrun (false)
+{
+}	// StateReader ()
+
+
+//! Destructor
+
+StateReader::~StateReader ()
+{
+  close ();
+
+}	// ~StateReader ()
+
+
+//! Start restoring state
+
+//! @param[in] state  State previously saved by a StateWriter. It must not
+//!                   change until the reader is closed.
+
+void
+StateReader::open (const vector<uint8_t> & state)
+{
+  openRange (state.data (), state.data () + state.size (), "snapshot");
+
+}	// open ()
+
+
+//! Finish restoring state
+
+void
+StateReader::close ()
+{
+  m_isOpen = false;
+
+}	// close ()
+
+
+//! Was all the model state read, and no more?
+
+//! @return  TRUE if everything saved has been read, FALSE otherwise
+
+bool
+StateReader::complete () const
+{
+  return  isOpen () && ! mOverrun && (m_cp == m_endp);
+
+}	// complete ()
+
+
+//! Start reading state from a range of memory
+
+//! Verilator reads straight from the range, until it gets near the end. The
+//! range is never written.
+
+//! @param[in] start  Start of the state
+//! @param[in] end    End of the state
+//! @param[in] name   Name to use in any Verilator messages
+
+void
+StateReader::openRange (const uint8_t * start,
+			const uint8_t * end,
+			const string &  name)
+{
+  mOverrun = false;
+  m_isOpen = true;
+  m_filename = name;
+  m_cp = const_cast<uint8_t *> (start);
+  m_endp = const_cast<uint8_t *> (end);
+  header ();
+
+}	// openRange ()
+
+
+//! Verilator wants more data
+
+//! Verilator only asks when it is within a buffer insert of the end. Since
+//! all the state is in memory, there is no more to come. Copy what is left
+//! into the Verilator buffer, which is big enough that reading beyond the end
+//! (corrupt state) cannot touch memory it does not own.
+
+void
+StateReader::fill ()
+{
+  if (m_cp > m_endp)
+    {
+      mOverrun = true;
+      m_cp = m_endp;
+    }
+
+  std::size_t  rem = m_endp - m_cp;
+
+  memmove (m_bufp, m_cp, rem);
+  m_cp = m_bufp;
+  m_endp = m_bufp + rem;
+
+}	// fill ()
+
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// End:
@@ -0,0 +1,113 @@
+// In memory state of Verilated targets: declaration
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef STATE_BUFFER_H
+#define STATE_BUFFER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "verilated_save.h"
+
+
+//! Save the state of a Verilator model into memory.
+
+//! The state is appended to a vector owned by the caller, which is cleared
+//! when the writer is opened. This is used for snapshots, which are taken
+//! too often to go through the file system.
+
+class StateWriter : public VerilatedSerialize
+{
+public:
+
+  // Constructor and destructor
+
+  StateWriter ();
+  virtual ~StateWriter ();
+
+  // Open and close the buffer
+
+  void  open (std::vector<uint8_t> & state);
+  virtual void  close ();
+
+  // Write out the Verilator buffer
+
+  virtual void  flush ();
+
+private:
+
+  //! Where the state goes
+
+  std::vector<uint8_t> * mState;
+
+};	// StateWriter ()
+
+
+//! Restore the state of a Verilator model from memory.
+
+//! The model reads its state directly from the memory holding it. Only the
+//! last few bytes go through the Verilator buffer.
+
+class StateReader : public VerilatedDeserialize
+{
+public:
+
+  // Constructor and destructor
+
+  StateReader ();
+  virtual ~StateReader ();
+
+  // Open and close the buffer
+
+  void  open (const std::vector<uint8_t> & state);
+  virtual void  close ();
+
+  // Was exactly all the state read?
+
+  bool  complete () const;
+
+protected:
+
+  // Start reading from a range of memory
+
+  void  openRange (const uint8_t *     start,
+		   const uint8_t *     end,
+		   const std::string & name);
+
+  // Verilator wants more data
+
+  virtual void  fill ();
+
+private:
+
+  //! Set if more was read than was saved
+
+  bool  mOverrun;
+
+};	// StateReader ()
+
+
+#endif	// STATE_BUFFER_H
+
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// End:
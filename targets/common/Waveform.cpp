@@ -0,0 +1,403 @@
+// Triggered waveform dumping for Verilated targets: definition
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstdlib>
+#include <vector>
+
+#include "Waveform.h"
+
+using std::dec;
+using std::endl;
+using std::hex;
+using std::string;
+using std::to_string;
+using std::vector;
+
+
+//! Suffix of the waveform files
+
+#ifdef HAVE_FST_MODELS
+static const char * const  WAVE_SUFFIX = ".fst";
+#else
+static const char * const  WAVE_SUFFIX = ".vcd";
+#endif
+
+
+//! Constructor.
+
+//! Turn on Verilator tracing and create the trace file. Nothing is dumped, and
+//! no file opened, until start () is called or a trigger is set.
+
+//! @param[in] basename  Name of the waveform file, without suffix
+
+Waveform::Waveform (const string & basename) :
+  mBasename (basename),
+  mMode (Mode::OFF),
+  mFrom (0),
+  mTo (NEVER),
+  mLength (0),
+  mTriggerPc (0),
+  mRingFiles (0)
+{
+  Verilated::traceEverOn (true);
+  mTfp = new TraceFile;
+  mRingFrom[0] = 0;
+  mRingFrom[1] = 0;
+
+}	// Waveform::Waveform ()
+
+
+//! Destructor.
+
+//! Close any open file.
+
+Waveform::~Waveform ()
+{
+  if (! mFilename.empty ())
+    mTfp->close ();
+
+  delete mTfp;
+
+}	// Waveform::~Waveform ()
+
+
+//! Dump everything from now on, into the main file
+
+//! If the ring was in use, its files are left as they are, and the main file
+//! is truncated.
+
+void
+Waveform::start ()
+{
+  if (mFilename != fileName ())
+    openFile (fileName ());
+
+  mMode = Mode::ALL;
+  mRingFiles = 0;
+
+}	// Waveform::start ()
+
+
+//! Write out anything buffered, so the file can be viewed
+
+void
+Waveform::flush ()
+{
+  if (! mFilename.empty ())
+    mTfp->flush ();
+
+}	// Waveform::flush ()
+
+
+//! The first cycle from now which may be dumped
+
+//! For a target which can skip cycles, so it never skips one which should
+//! be dumped. A PC trigger is not counted, since the PC does not change
+//! while cycles are skipped.
+
+//! @param[in] cycle  The cycle count now
+//! @return  The first cycle which may be dumped, or NEVER if none will be.
+
+uint64_t
+Waveform::nextWanted (uint64_t  cycle) const
+{
+  switch (mMode)
+    {
+    case Mode::ALL:
+    case Mode::RING:
+
+      return cycle;
+
+    case Mode::CYCLES:
+
+      if (cycle < mFrom)
+	return mFrom;
+      else if (cycle < mTo)
+	return cycle;
+      else
+	return NEVER;
+
+    default:
+
+      return NEVER;
+    }
+}	// Waveform::nextWanted ()
+
+
+//! Handle a waveform command
+
+//! The commands are:
+//! - "vcd" reports the trigger and the files written
+//! - "vcd start" dumps everything from now on
+//! - "vcd stop" stops dumping
+//! - "vcd cycles <from> <to>" dumps cycles <from> up to <to>
+//! - "vcd pc <addr> [<cycles>]" dumps <cycles> cycles (or everything) from
+//!   when the PC reaches <addr>
+//! - "vcd ring <cycles>" keeps at least the last <cycles> cycles
+
+//! Apart from the ring, all dump to the main file, which is only truncated
+//! when first opened or after using the ring.
+
+//! @param[in]  args    The monitor command
+//! @param[out] stream  Where to write any response
+//! @return  TRUE if the command succeeded, FALSE otherwise.
+
+bool
+Waveform::command (const CommandArgs & args,
+		   std::ostream & stream)
+{
+  uint64_t  vals[2] = { 0, 0 };
+
+  for (std::size_t  i = 2; i < args.size (); i++)
+    {
+      uint64_t  val;
+
+      if (!args.num (i, val))
+	{
+	  stream << "Invalid number: " << args.str (i) << endl;
+	  return false;
+	}
+
+      if (i < 4)
+	vals[i - 2] = val;
+    }
+
+  if (args.size () == 1)
+    {
+      switch (mMode)
+	{
+	case Mode::OFF:
+	  stream << "Waveform dumping is stopped" << endl;
+	  break;
+
+	case Mode::ALL:
+	  stream << "Waveform dumping is running" << endl;
+	  break;
+
+	case Mode::CYCLES:
+	  stream << "Waveform dumps from cycle " << mFrom;
+
+	  if (NEVER != mTo)
+	    stream << " up to cycle " << mTo;
+
+	  stream << endl;
+	  break;
+
+	case Mode::PC:
+	  stream << "Waveform waits for PC 0x" << hex << mTriggerPc << dec
+		 << ", then dumps ";
+
+	  if (0 == mLength)
+	    stream << "until stopped" << endl;
+	  else
+	    stream << mLength << " cycles" << endl;
+
+	  break;
+
+	case Mode::RING:
+	  stream << "Waveform keeps the last " << mLength << " cycles" << endl;
+	  break;
+	}
+
+      if (mRingFiles > 0)
+	for (uint64_t  n = (mRingFiles < 2) ? 0 : mRingFiles - 2;
+	     n < mRingFiles;
+	     n++)
+	  stream << ringFileName (n) << " holds from cycle "
+		 << mRingFrom[n % 2] << endl;
+      else if (! mFilename.empty ())
+	stream << "Writing " << mFilename << endl;
+
+      return true;
+    }
+
+  if (args.is (1, "start") && (args.size () == 2))
+    {
+      start ();
+      return true;
+    }
+
+  if (args.is (1, "stop") && (args.size () == 2))
+    {
+      mMode = Mode::OFF;
+      flush ();
+      return true;
+    }
+
+  if (args.is (1, "cycles") && (args.size () == 4))
+    {
+      if (vals[1] <= vals[0])
+	{
+	  stream << "Cycle range must be <from> <to>, with from < to" << endl;
+	  return false;
+	}
+
+      start ();
+      mMode = Mode::CYCLES;
+      mFrom = vals[0];
+      mTo = vals[1];
+      return true;
+    }
+
+  if (args.is (1, "pc") && (args.size () >= 3) && (args.size () <= 4))
+    {
+      start ();
+      mMode = Mode::PC;
+      mTriggerPc = static_cast<uint32_t> (vals[0]);
+      mLength = (args.size () == 4) ? vals[1] : 0;
+      return true;
+    }
+
+  if (args.is (1, "ring") && (args.size () == 3))
+    {
+      if (0 == vals[0])
+	{
+	  stream << "Ring must hold a positive number of cycles" << endl;
+	  return false;
+	}
+
+      mMode = Mode::RING;
+      mLength = vals[0];
+      mTo = 0;
+      mRingFiles = 0;
+      return true;
+    }
+
+  stream << "Unrecognized vcd command: " << args.cmd () << endl;
+  return false;
+
+}	// Waveform::command ()
+
+
+//! Help for the waveform commands
+
+const char Waveform::HELP[] =
+  "  vcd\n"
+  "    Report what the waveform is dumping\n"
+  "  vcd start\n"
+  "    Dump the waveform from now on\n"
+  "  vcd stop\n"
+  "    Stop dumping the waveform\n"
+  "  vcd cycles <from> <to>\n"
+  "    Dump the waveform from cycle <from> up to cycle <to>\n"
+  "  vcd pc <addr> [<cycles>]\n"
+  "    Dump the waveform once the PC reaches <addr>\n"
+  "  vcd ring <cycles>\n"
+  "    Keep the waveform of the last <cycles> cycles\n";
+
+
+//! Decide whether to dump a cycle, for the triggers other than ALL and OFF
+
+//! A PC trigger becomes a window starting at the current cycle. A window
+//! which has ended stops dumping. A ring switches files every mLength
+//! cycles.
+
+//! @param[in] cycle  The cycle count
+//! @param[in] pc     The current PC
+//! @return  TRUE if the cycle should be dumped, FALSE otherwise.
+
+bool
+Waveform::trigger (uint64_t  cycle,
+		   uint32_t  pc)
+{
+  if (Mode::RING == mMode)
+    {
+      if (cycle >= mTo)
+	{
+	  mRingFrom[mRingFiles % 2] = cycle;
+	  openFile (ringFileName (mRingFiles));
+	  mRingFiles++;
+	  mTo = cycle + mLength;
+	}
+
+      return true;
+    }
+
+  if (Mode::PC == mMode)
+    {
+      if (pc != mTriggerPc)
+	return false;
+
+      mMode = Mode::CYCLES;
+      mFrom = cycle;
+      mTo = (0 == mLength) ? NEVER : cycle + mLength;
+    }
+
+  if (cycle < mFrom)
+    return false;
+  else if (cycle < mTo)
+    return true;
+
+  mMode = Mode::OFF;
+  flush ();
+  return false;
+
+}	// Waveform::trigger ()
+
+
+//! Open a waveform file, closing any already open
+
+//! Each time a file is opened, Verilator starts it with the value of every
+//! signal.
+
+//! @param[in] filename  The file to open
+
+void
+Waveform::openFile (const string & filename)
+{
+  if (! mFilename.empty ())
+    mTfp->close ();
+
+  mTfp->open (filename.c_str ());
+  mFilename = filename;
+
+}	// Waveform::openFile ()
+
+
+//! The name of the main waveform file
+
+//! @return  The file name
+
+string
+Waveform::fileName () const
+{
+  return mBasename + WAVE_SUFFIX;
+
+}	// Waveform::fileName ()
+
+
+//! The name of a ring file
+
+//! @param[in] n  Which ring file, counting from 0. Only the bottom bit
+//!               matters.
+//! @return  The file name
+
+string
+Waveform::ringFileName (uint64_t  n) const
+{
+  return mBasename + "-" + to_string (n % 2) + WAVE_SUFFIX;
+
+}	// Waveform::ringFileName ()
+
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// show-trailing-whitespace: t
+// End:
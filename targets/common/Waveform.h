@@ -0,0 +1,190 @@
+// Triggered waveform dumping for Verilated targets: declaration
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef WAVEFORM_H
+#define WAVEFORM_H
+
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <string>
+
+#include "CommandRegistry.h"
+
+#ifdef HAVE_FST_MODELS
+#include "verilated_fst_c.h"
+#else
+#include "verilated_vcd_c.h"
+#endif
+
+
+//! A waveform file, dumped only for the cycles chosen by a trigger.
+
+//! The target passes traceFile () to its model's trace () function, then for
+//! each cycle asks wanted () whether to dump it. The trigger may be:
+//! - everything, until stopped
+//! - nothing
+//! - a range of cycles
+//! - a number of cycles from when the PC first reaches an address
+//! - a ring of the last N cycles, kept in two files used in turn, each
+//!   holding N cycles, so together they always hold at least the last N.
+
+//! The trigger is set by the "vcd" monitor commands, which the target
+//! registers to call command (). The file is VCD, unless the models were
+//! verilated with --trace-fst, in which case it is FST. The target calls
+//! flush () when it stops, so the file can be viewed while GDB is still
+//! connected.
+
+class Waveform
+{
+public:
+
+  //! The Verilator trace file matching the models
+
+#ifdef HAVE_FST_MODELS
+  typedef VerilatedFstC  TraceFile;
+#else
+  typedef VerilatedVcdC  TraceFile;
+#endif
+
+  // Constructor and destructor
+
+  Waveform (const std::string & basename);
+  ~Waveform ();
+
+  //! The trace file, for the model's trace () function
+
+  //! @return  The trace file
+
+  inline TraceFile * traceFile ()
+  {
+    return mTfp;
+  }
+
+  // Called from the target's clock loop
+
+  //! Should this cycle be dumped?
+
+  //! @param[in] cycle  The cycle count
+  //! @param[in] pc     The current PC, for a PC trigger
+  //! @return  TRUE if the cycle should be dumped, FALSE otherwise.
+
+  inline bool  wanted (uint64_t  cycle,
+		       uint32_t  pc)
+  {
+    return (Mode::ALL == mMode)
+      || ((Mode::OFF != mMode) && trigger (cycle, pc));
+  }
+
+  uint64_t  nextWanted (uint64_t  cycle) const;
+
+  //! Dump the model's signals
+
+  //! @param[in] time  The simulation time
+
+  inline void  dump (vluint64_t  time)
+  {
+    mTfp->dump (time);
+  }
+
+  void  start ();
+  void  flush ();
+
+  // Monitor commands
+
+  static const char  HELP[];
+  bool  command (const CommandArgs & args,
+		 std::ostream & stream);
+
+
+private:
+
+  //! What the trigger is
+
+  enum class Mode
+  {
+    OFF,			//!< Dump nothing
+    ALL,			//!< Dump everything
+    CYCLES,			//!< Dump from mFrom up to mTo
+    PC,				//!< Wait for mTriggerPc, then dump mLength
+    RING			//!< Dump into alternate files every mLength
+  };
+
+  //! Value of mTo for a window which never ends
+
+  static const uint64_t  NEVER = std::numeric_limits<uint64_t>::max ();
+
+  //! The Verilator trace file
+
+  TraceFile * mTfp;
+
+  //! File name without suffix
+
+  std::string  mBasename;
+
+  //! The file open, or empty if none is
+
+  std::string  mFilename;
+
+  //! The trigger
+
+  Mode  mMode;
+
+  //! First cycle of the window, or of the current ring file
+
+  uint64_t  mFrom;
+
+  //! Cycle after the window, or at which to switch ring files
+
+  uint64_t  mTo;
+
+  //! Cycles to dump after a PC trigger (0 for ever), or in each ring file
+
+  uint64_t  mLength;
+
+  //! The PC which starts a PC trigger
+
+  uint32_t  mTriggerPc;
+
+  //! Number of ring files started
+
+  uint64_t  mRingFiles;
+
+  //! First cycle in each ring file
+
+  uint64_t  mRingFrom[2];
+
+  // Helper functions
+
+  bool  trigger (uint64_t  cycle,
+		 uint32_t  pc);
+  void  openFile (const std::string & filename);
+  std::string  fileName () const;
+  std::string  ringFileName (uint64_t  n) const;
+
+};	// class Waveform
+
+
+#endif	// WAVEFORM_H
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// show-trailing-whitespace: t
+// End:
@@ -0,0 +1,200 @@
+#!/usr/bin/env python3
+# Convert a coverage bitmap to lcov or gcov JSON
+
+# Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+# This file is part of the RISC-V GDB server
+
+# This program is free software: you can redistribute it and/or modify it
+# under the terms of the GNU General Public License as published by the Free
+# Software Foundation, either version 3 of the License, or (at your option)
+# any later version.
+
+# This program is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+# more details.
+
+# You should have received a copy of the GNU General Public License along
+# with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+"""Convert a bitmap written by "monitor coverage dump" to line coverage.
+
+The bitmap records which instruction addresses were executed (see
+targets/common/Coverage.h). The DWARF line table of the program, decoded by
+readelf, maps each address range to a source line. A line is executed if any
+instruction in any of its ranges was. The result is an lcov tracefile, or
+gcov's JSON intermediate format.
+"""
+
+import argparse
+import collections
+import json
+import os
+import struct
+import subprocess
+import sys
+
+MAGIC = b'RVCOVER\0'
+VERSION = 1
+
+
+def read_bitmap(filename):
+    """Read a coverage bitmap, returning (low PC, high PC, granule, bits)."""
+    try:
+        with open(filename, 'rb') as f:
+            data = f.read()
+    except OSError as e:
+        sys.exit('%s: %s' % (filename, e.strerror))
+
+    if len(data) < 24 or data[:8] != MAGIC:
+        sys.exit('%s: not a coverage bitmap' % filename)
+
+    version, low, high, granule = struct.unpack_from('<4I', data, 8)
+
+    if version != VERSION:
+        sys.exit('%s: unsupported version %d' % (filename, version))
+
+    return low, high, granule, data[24:]
+
+
+def line_table(readelf, elf):
+    """Decode the line table, returning a list of (start, end, file, line)."""
+    try:
+        out = subprocess.run([readelf, '--debug-dump=decodedline', '--wide',
+                              elf], check=True, stdout=subprocess.PIPE,
+                             universal_newlines=True).stdout
+    except (OSError, subprocess.CalledProcessError) as e:
+        sys.exit('%s: unable to read line table: %s' % (elf, e))
+
+    ranges = []
+    cu_dir = ''
+    prev = None
+
+    for text in out.splitlines():
+        if text.startswith('CU: '):
+            cu_dir = os.path.dirname(text[4:].rstrip(':'))
+            prev = None
+            continue
+
+        fields = text.split()
+
+        if len(fields) < 3:
+            continue
+
+        try:
+            addr = int(fields[2], 0)
+        except ValueError:
+            continue
+
+        if prev is not None and addr > prev[0]:
+            ranges.append((prev[0], addr, prev[1], prev[2]))
+
+        if fields[1] == '-':
+            # End of a sequence
+
+            prev = None
+        else:
+            name = fields[0]
+
+            if not os.path.isabs(name) and cu_dir:
+                name = os.path.join(cu_dir, name)
+
+            prev = (addr, os.path.normpath(name), int(fields[1]))
+
+    return ranges
+
+
+def executed(bits, low, high, granule, start, end):
+    """Was any instruction from start up to end executed?"""
+    start = max(start, low)
+    end = min(end, high)
+
+    for slot in range((start - low) // granule, (end - low + granule - 1)
+                      // granule):
+        if bits[slot >> 3] & (1 << (slot & 7)):
+            return True
+
+    return False
+
+
+def coverage(bitmap, ranges):
+    """Map each file to a dictionary from line to whether it was executed."""
+    low, high, granule, bits = bitmap
+    files = collections.defaultdict(dict)
+
+    for start, end, name, line in ranges:
+        if end <= low or start >= high:
+            continue
+
+        hit = executed(bits, low, high, granule, start, end)
+        files[name][line] = files[name].get(line, False) or hit
+
+    return files
+
+
+def write_lcov(files, out):
+    """Write coverage as an lcov tracefile."""
+    out.write('TN:\n')
+
+    for name in sorted(files):
+        lines = files[name]
+        out.write('SF:%s\n' % name)
+
+        for line in sorted(lines):
+            out.write('DA:%d,%d\n' % (line, 1 if lines[line] else 0))
+
+        out.write('LF:%d\n' % len(lines))
+        out.write('LH:%d\n' % sum(1 for hit in lines.values() if hit))
+        out.write('end_of_record\n')
+
+
+def write_gcov_json(files, elf, out):
+    """Write coverage in gcov's JSON intermediate format."""
+    doc = {
+        'format_version': '1',
+        'gcc_version': '',
+        'current_working_directory': os.getcwd(),
+        'data_file': elf,
+        'files': [{
+            'file': name,
+            'functions': [],
+            'lines': [{
+                'line_number': line,
+                'count': 1 if files[name][line] else 0,
+                'unexecuted_block': not files[name][line],
+                'branches': [],
+                'function_name': '',
+            } for line in sorted(files[name])],
+        } for name in sorted(files)],
+    }
+    json.dump(doc, out, indent=1)
+    out.write('\n')
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('bitmap', help='file written by "monitor coverage dump"')
+    parser.add_argument('elf', help='the program, with debug information')
+    parser.add_argument('--format', choices=['lcov', 'gcov-json'],
+                        default='lcov', help='output format (default lcov)')
+    parser.add_argument('--readelf', default='readelf',
+                        help='readelf to decode the line table')
+    parser.add_argument('-o', '--output', help='output file (default stdout)')
+    args = parser.parse_args()
+
+    files = coverage(read_bitmap(args.bitmap),
+                     line_table(args.readelf, args.elf))
+    out = open(args.output, 'w') if args.output else sys.stdout
+
+    if args.format == 'lcov':
+        write_lcov(files, out)
+    else:
+        write_gcov_json(files, args.elf, out)
+
+    if args.output:
+        out.close()
+
+
+if __name__ == '__main__':
+    main()
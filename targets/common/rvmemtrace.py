@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+# Decode a binary memory access trace
+
+# Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+# This file is part of the RISC-V GDB server
+
+# This program is free software: you can redistribute it and/or modify it
+# under the terms of the GNU General Public License as published by the Free
+# Software Foundation, either version 3 of the License, or (at your option)
+# any later version.
+
+# This program is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+# more details.
+
+# You should have received a copy of the GNU General Public License along
+# with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+"""Decode a trace written by "monitor memtrace" (see targets/common/MemTrace.h).
+
+Each load or store is printed with its cycle, direction, address and size,
+one to a line, which suits cache simulators that read text traces.  With
+--summary, only the number of loads and stores is shown.
+"""
+
+import argparse
+import mmap
+import struct
+import sys
+
+MAGIC = b'RVMTRACE'
+VERSION = 1
+
+FLAG_WRITE = 0x01
+SIZE_SHIFT = 1
+
+
+def uleb(buf, pos):
+    """Read an unsigned LEB128, returning (value, new position)."""
+    val = 0
+    shift = 0
+
+    while True:
+        byte = buf[pos]
+        pos += 1
+        val |= (byte & 0x7f) << shift
+        shift += 7
+
+        if byte < 0x80:
+            return val, pos
+
+
+def records(buf):
+    """Generate (cycle, write, address, size) for each record."""
+    pos = 16
+    cycle = 0
+    addr = 0
+
+    while pos < len(buf):
+        flags = buf[pos]
+        delta, pos = uleb(buf, pos + 1)
+        cycle += delta
+        delta, pos = uleb(buf, pos)
+        addr = (addr + ((delta >> 1) ^ -(delta & 1))) & 0xffffffff
+        yield cycle, bool(flags & FLAG_WRITE), addr, 1 << (
+            (flags >> SIZE_SHIFT) & 3)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('trace', help='trace file')
+    parser.add_argument('--summary', action='store_true',
+                        help='only count the loads and stores')
+    parser.add_argument('--limit', type=int, default=0,
+                        help='stop after this many accesses')
+    args = parser.parse_args()
+
+    with open(args.trace, 'rb') as f:
+        if f.read(8) != MAGIC:
+            sys.exit('%s: not a memory trace' % args.trace)
+
+        version, = struct.unpack('<H', f.read(2))
+
+        if version != VERSION:
+            sys.exit('%s: unsupported version %d' % (args.trace, version))
+
+        buf = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+
+    counts = [0, 0]
+
+    for n, (cycle, write, addr, size) in enumerate(records(buf)):
+        if args.limit and n >= args.limit:
+            break
+
+        counts[write] += 1
+
+        if not args.summary:
+            print('%d %s 0x%08x %d' % (cycle, 'W' if write else 'R', addr,
+                                       size))
+
+    if args.summary:
+        print('%d loads, %d stores' % (counts[0], counts[1]))
+
+
+if __name__ == '__main__':
+    main()
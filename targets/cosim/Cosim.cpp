@@ -0,0 +1,1028 @@
+// GDB RSP server lockstep co-simulation target: definition
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include "CommandRegistry.h"
+#include "Cosim.h"
+#include "GdbServer.h"
+#include "Iss.h"
+#include "TraceFlags.h"
+
+using std::chrono::duration;
+using std::chrono::system_clock;
+using std::chrono::time_point;
+using std::cerr;
+using std::dec;
+using std::endl;
+using std::hex;
+using std::ostringstream;
+using std::setfill;
+using std::setw;
+using std::vector;
+
+
+//! Constructor.
+
+//! The reference model starts from the state of the RTL model. Asking the
+//! RTL model to stop recording what it retires tells us whether it can.
+
+//! @param[in] flags  The trace flags
+//! @param[in] rtl    The RTL model to check. We take ownership.
+
+Cosim::Cosim (const TraceFlags * flags,
+	      ITarget *          rtl) :
+  ITarget (flags),
+  mRtl (rtl),
+  mCycleLimit (NO_LIMIT),
+  mInstrLimit (NO_LIMIT),
+  mFreeRun (rtl->traceRetired (nullptr)),
+  mInterval (mFreeRun ? DEFAULT_BATCH : DEFAULT_INTERVAL),
+  mSinceCheck (0),
+  mChecked (0),
+  mDivergences (0)
+{
+  mRef = new Iss (flags);
+  mRef->logStores (&mStores);
+  resync ();
+
+}	// Cosim::Cosim ()
+
+
+//! Destructor
+
+//! Free both models
+
+Cosim::~Cosim ()
+{
+  delete mRef;
+  delete mRtl;
+
+}	// Cosim::~Cosim ()
+
+
+//! Resume execution
+
+//! @param[in] step  Type of resumption required
+//! @return The type of termination encountered.
+
+ITarget::ResumeRes
+Cosim::resume (ResumeType  step)
+{
+  return resume (step, duration <double>::zero ());
+
+}	// Cosim::resume ()
+
+
+//! Resume execution
+
+//! A step steps both models. Continuing runs the RTL model freely in
+//! batches if it can record what it retires, and otherwise steps both models
+//! an instruction at a time, checking limits between instructions, so a
+//! cycle limit stops at the first instruction boundary at or after it.
+//! Everything outstanding is compared before we stop, so GDB never sees
+//! state which has not been checked.
+
+//! @param[in] step     Type of resumption required
+//! @param[in] timeout  Timeout requested
+//! @return The type of termination encountered, ResumeRes::DIVERGED if the
+//!         models differ.
+
+ITarget::ResumeRes
+Cosim::resume (ResumeType  step,
+	       duration <double>  timeout)
+{
+  switch (step)
+    {
+    case ResumeType::STEP:
+
+      {
+	ResumeRes  res = stepBoth ();
+
+	if ((ResumeRes::DIVERGED != res) && ! check ())
+	  return ResumeRes::DIVERGED;
+
+	return res;
+      }
+
+    case ResumeType::CONTINUE:
+
+      if (mFreeRun)
+	return runBatches (timeout);
+
+      {
+	bool haveTimeout = duration <double>::zero () != timeout;
+	time_point <system_clock, duration <double> > timeout_end =
+	  system_clock::now () + timeout;
+
+	for (uint64_t  count = 1; ; count++)
+	  {
+	    if ((mRtl->getCycleCount () >= mCycleLimit)
+		|| (mRtl->getInstrCount () >= mInstrLimit))
+	      return check () ? ResumeRes::LIMIT : ResumeRes::DIVERGED;
+
+	    ResumeRes  res = stepBoth ();
+
+	    if (ResumeRes::DIVERGED == res)
+	      return res;
+
+	    if (ResumeRes::STEPPED != res)
+	      return check () ? res : ResumeRes::DIVERGED;
+
+	    if (haveTimeout && (0 == count % RUN_SAMPLE_INSNS)
+		&& (timeout_end < system_clock::now ()))
+	      return check () ? ResumeRes::TIMEOUT : ResumeRes::DIVERGED;
+	  }
+      }
+
+    default:
+
+      return mRtl->resume (step, timeout);
+    }
+}	// Cosim::resume ()
+
+
+//! Terminate
+
+//! @return  Whatever the RTL model returns
+
+ITarget::ResumeRes
+Cosim::terminate ()
+{
+  return mRtl->terminate ();
+
+}	// Cosim::terminate ()
+
+
+//! Reset execution
+
+//! Both models are reset, then the reference model takes the registers of
+//! the RTL model, since the two may reset to different PCs.
+
+//! @param[in] type  The type of reset
+//! @return  Result of resetting the RTL model
+
+ITarget::ResumeRes
+Cosim::reset (ITarget::ResetType  type)
+{
+  ResumeRes  res = mRtl->reset (type);
+
+  mRef->reset (type);
+
+  if (ITarget::ResetType::COLD == type)
+    {
+      mChecked = 0;
+      mDivergences = 0;
+      mReport.clear ();
+    }
+
+  resync ();
+  return res;
+
+}	// Cosim::reset ()
+
+
+//! Get count of cycles since startup or reset
+
+//! @return  Cycle count of the RTL model
+
+uint64_t
+Cosim::getCycleCount (void) const
+{
+  return mRtl->getCycleCount ();
+
+}	// Cosim::getCycleCount ()
+
+
+//! Get count of instructions since startup or reset
+
+//! @return  Instruction count of the RTL model
+
+uint64_t
+Cosim::getInstrCount (void) const
+{
+  return mRtl->getInstrCount ();
+
+}	// Cosim::getInstrCount ()
+
+
+//! Does the target count instructions?
+
+//! @return  Whether the RTL model counts instructions
+
+bool
+Cosim::countsInstrs () const
+{
+  return  mRtl->countsInstrs ();
+
+}	// Cosim::countsInstrs ()
+
+
+//! Set a limit on continuing
+
+//! The limit is on the counts of the RTL model, which are the ones we
+//! report. The RTL model is only ever stepped or run to the end of a batch,
+//! so we check it ourselves.
+
+//! @param[in] type   Whether the limit is on cycles or instructions
+//! @param[in] count  The count at which to stop, or NO_LIMIT
+
+void
+Cosim::setLimit (LimitType  type,
+		 uint64_t  count)
+{
+  if (LimitType::CYCLES == type)
+    mCycleLimit = count;
+  else
+    mInstrLimit = count;
+
+}	// Cosim::setLimit ()
+
+
+//! Read a register
+
+//! @param[in] reg     Register to read
+//! @param[out] value  Where to put the result of the read
+//! @return  Number of bytes read into the register
+
+std::size_t
+Cosim::readRegister (const int  reg,
+		     uint_reg_t & value) const
+{
+  return mRtl->readRegister (reg, value);
+
+}	// Cosim::readRegister ()
+
+
+//! Write a register
+
+//! Both models are written, so they stay in step.
+
+//! @param[in] reg    Register to write
+//! @param[in] value  Value to write
+//! @return  Number of bytes written into the RTL register
+
+std::size_t
+Cosim::writeRegister (const int  reg,
+		      const uint_reg_t  value)
+{
+  mRef->writeRegister (reg, value);
+
+  if ((0 <= reg) && (reg < NUM_REGS))
+    mRef->readRegister (reg, mRefRegs[reg]);
+
+  return mRtl->writeRegister (reg, value);
+
+}	// Cosim::writeRegister ()
+
+
+//! Read from memory
+
+//! @param[in]  addr    Address to read
+//! @param[out] buffer  Where to put the result of the read
+//! @param[in]  size    Number of bytes to read
+//! @return  Number of bytes read
+
+std::size_t
+Cosim::read (const uint32_t addr,
+	     uint8_t * buffer,
+	     const std::size_t  size) const
+{
+  return mRtl->read (addr, buffer, size);
+
+}	// Cosim::read ()
+
+
+//! Write to memory
+
+//! Both models are written, so they stay in step.
+
+//! @param[in]  addr    Address to write
+//! @param[in]  buffer  Data to write
+//! @param[in]  size    Number of bytes to write
+//! @return  Number of bytes written to the RTL model
+
+std::size_t
+Cosim::write (const uint32_t  addr,
+	      const uint8_t * buffer,
+	      const std::size_t size)
+{
+  mRef->write (addr, buffer, size);
+  return mRtl->write (addr, buffer, size);
+
+}	// Cosim::write ()
+
+
+//! Insert a matchpoint
+
+//! Only the RTL model needs it. The reference model is only ever stepped.
+
+//! @param[in] addr       Address at which to set the matchpoint
+//! @param[in] matchType  Type of matchpoint (breakpoint or watchpoint)
+//! @return  TRUE if the matchpoint was set, FALSE otherwise.
+
+bool
+Cosim::insertMatchpoint (const uint32_t  addr,
+			 const MatchType  matchType)
+{
+  return mRtl->insertMatchpoint (addr, matchType);
+
+}	// Cosim::insertMatchpoint ()
+
+
+//! Remove a matchpoint
+
+//! @param[in] addr       Address from which to clear the matchpoint
+//! @param[in] matchType  Type of matchpoint (breakpoint or watchpoint)
+//! @return  TRUE if the matchpoint was removed, FALSE otherwise.
+
+bool
+Cosim::removeMatchpoint (const uint32_t  addr,
+			 const MatchType  matchType)
+{
+  return mRtl->removeMatchpoint (addr, matchType);
+
+}	// Cosim::removeMatchpoint ()
+
+
+//! Add the target's monitor commands to a registry
+
+//! "cosim" reports what checking has found, and "cosim interval <n>" sets
+//! how often the general registers are compared. The commands of the RTL
+//! model follow.
+
+//! @param[in] reg  The registry
+
+void
+Cosim::registerCommands (CommandRegistry & reg)
+{
+  reg.add ("cosim",
+	   "  cosim\n"
+	   "    Report what checking against the ISS has found\n"
+	   "  cosim interval <n>\n"
+	   "    Compare the general registers every <n> instructions\n",
+	   [this] (const CommandArgs & args, std::ostream & stream)
+	   {
+	     if (1 == args.size ())
+	       {
+		 stream << "Checked " << mChecked
+			<< " instructions against the ISS, " << mDivergences
+			<< " divergences found" << endl
+			<< (mFreeRun ? "Core runs freely, registers compared every "
+			    : "Core is stepped, registers compared every ")
+			<< mInterval << " instructions" << endl;
+
+		 if (! mReport.empty ())
+		   stream << "Last divergence:" << endl << mReport;
+
+		 return true;
+	       }
+
+	     uint32_t  n;
+
+	     if ((3 != args.size ()) || !args.is (1, "interval"))
+	       {
+		 stream << "Unrecognized cosim command: " << args.cmd ()
+			<< endl;
+		 return false;
+	       }
+
+	     if (!args.num (2, n) || (0 == n))
+	       {
+		 stream << "Interval must be a positive number" << endl;
+		 return false;
+	       }
+
+	     mInterval = n;
+	     return true;
+	   });
+
+  mRtl->registerCommands (reg);
+
+}	// Cosim::registerCommands ()
+
+
+//! Save a checkpoint file
+
+//! The reference model is saved alongside, with ".ref" appended to the
+//! name.
+
+//! @param[in] filename  The file to write
+//! @return  TRUE if the checkpoint was saved, FALSE otherwise.
+
+bool
+Cosim::saveCheckpoint (const std::string & filename)
+{
+  return mRtl->saveCheckpoint (filename)
+    && mRef->saveCheckpoint (filename + ".ref");
+
+}	// Cosim::saveCheckpoint ()
+
+
+//! Restore a checkpoint file
+
+//! Without a saved reference model, the reference model takes what state
+//! it can from the RTL model.
+
+//! @param[in] filename  The file to read
+//! @return  TRUE if the checkpoint was restored, FALSE otherwise.
+
+bool
+Cosim::restoreCheckpoint (const std::string & filename)
+{
+  if (! mRtl->restoreCheckpoint (filename))
+    return false;
+
+  if (mRef->restoreCheckpoint (filename + ".ref"))
+    restart ();
+  else
+    {
+      cerr << "Warning: No reference model in " << filename << ".ref: "
+	   << "checking may find false divergences" << endl;
+      resync ();
+    }
+
+  return true;
+
+}	// Cosim::restoreCheckpoint ()
+
+
+//! Save a snapshot
+
+//! The RTL snapshot is followed by the reference snapshot, then the size of
+//! the RTL snapshot in 8 bytes, least significant first.
+
+//! @param[out] state  The saved state
+//! @return  TRUE if the snapshot was taken, FALSE otherwise.
+
+bool
+Cosim::saveSnapshot (std::vector<uint8_t> & state)
+{
+  vector<uint8_t>  ref;
+
+  if (! mRtl->saveSnapshot (state) || ! mRef->saveSnapshot (ref))
+    return false;
+
+  uint64_t  rtlSize = state.size ();
+
+  state.insert (state.end (), ref.begin (), ref.end ());
+
+  for (int  i = 0; i < 8; i++)
+    state.push_back (static_cast<uint8_t> (rtlSize >> (i * 8)));
+
+  return true;
+
+}	// Cosim::saveSnapshot ()
+
+
+//! Restore a snapshot
+
+//! @param[in] state  State previously saved by saveSnapshot
+//! @return  TRUE if the snapshot was restored, FALSE otherwise.
+
+bool
+Cosim::restoreSnapshot (const std::vector<uint8_t> & state)
+{
+  if (state.size () < 8)
+    return false;
+
+  uint64_t  rtlSize = 0;
+  std::size_t  refEnd = state.size () - 8;
+
+  for (int  i = 0; i < 8; i++)
+    rtlSize |= static_cast<uint64_t> (state[refEnd + i]) << (i * 8);
+
+  if (rtlSize > refEnd)
+    return false;
+
+  vector<uint8_t>  rtl (state.begin (), state.begin () + rtlSize);
+  vector<uint8_t>  ref (state.begin () + rtlSize, state.begin () + refEnd);
+
+  if (! mRtl->restoreSnapshot (rtl) || ! mRef->restoreSnapshot (ref))
+    return false;
+
+  restart ();
+  return true;
+
+}	// Cosim::restoreSnapshot ()
+
+
+//! Does either model have threads of its own running?
+
+//! @return  TRUE if either model has threads of its own running, FALSE
+//!          otherwise.
+
+bool
+Cosim::threaded () const
+{
+  return  mRtl->threaded () || mRef->threaded ();
+
+}	// Cosim::threaded ()
+
+
+//! Record the PC of each instruction retired while continuing
+
+//! Nothing checks a co-simulation against another.
+
+//! @param[in] pcs  Where to record the PCs, or nullptr
+//! @return  FALSE, since we do not record them.
+
+bool
+Cosim::traceRetired (std::vector<uint32_t> * pcs __attribute__ ((unused)))
+{
+  return  false;
+
+}	// Cosim::traceRetired ()
+
+
+//! Identify the server to both models
+
+//! @param[in] server  The server to use
+
+void
+Cosim::gdbServer (GdbServer * server)
+{
+  mRef->gdbServer (server);
+  mRtl->gdbServer (server);
+
+}	// Cosim::gdbServer ()
+
+
+//! Return a timestamp.
+
+//! @return  The current simulation time of the RTL model in seconds.
+
+double
+Cosim::timeStamp ()
+{
+  return mRtl->timeStamp ();
+
+}	// Cosim::timeStamp ()
+
+
+//! Run the RTL model freely, a batch of instructions at a time
+
+//! Each batch ends at an instruction limit, so holds at most mInterval
+//! instructions. The reference model then follows the instructions the RTL
+//! model retired, and everything outstanding is compared. The RTL model
+//! only records what it retires while we are running it.
+
+//! @param[in] timeout  Timeout requested, or zero for none
+//! @return  How the RTL model stopped, or ResumeRes::DIVERGED if the models
+//!          differ.
+
+ITarget::ResumeRes
+Cosim::runBatches (duration <double>  timeout)
+{
+  bool haveTimeout = duration <double>::zero () != timeout;
+  time_point <system_clock, duration <double> > timeout_end =
+    system_clock::now () + timeout;
+  ResumeRes  res = ResumeRes::LIMIT;
+
+  mRtl->traceRetired (&mRetired);
+  mRtl->setLimit (LimitType::CYCLES, mCycleLimit);
+
+  while (ResumeRes::LIMIT == res)
+    {
+      uint64_t  instrs = mRtl->getInstrCount ();
+      duration <double>  left = timeout_end - system_clock::now ();
+
+      if ((mRtl->getCycleCount () >= mCycleLimit) || (instrs >= mInstrLimit))
+	break;
+
+      if (haveTimeout && (left <= duration <double>::zero ()))
+	{
+	  res = ResumeRes::TIMEOUT;
+	  break;
+	}
+
+      mRtl->setLimit (LimitType::INSTRS,
+		      std::min (mInstrLimit, instrs + mInterval));
+      mRetired.clear ();
+      res = followRetired (mRtl->resume (ResumeType::CONTINUE,
+					 haveTimeout ? left
+					 : duration <double>::zero ()));
+
+      if ((ResumeRes::DIVERGED != res) && ! check ())
+	res = ResumeRes::DIVERGED;
+    }
+
+  mRtl->traceRetired (nullptr);
+  return res;
+
+}	// Cosim::runBatches ()
+
+
+//! Step the reference model through the instructions the RTL model retired
+
+//! The PC of each instruction is compared. Only the last may stop the
+//! reference model, and then only for the reason the RTL model stopped. A
+//! breakpoint or syscall may stop the RTL model before the instruction
+//! leaves its decode stage, so is not among those retired, in which case
+//! the reference model steps once more to reach it.
+
+//! @param[in] rtlRes  How the RTL model stopped
+//! @return  rtlRes, or ResumeRes::DIVERGED if the models differ.
+
+ITarget::ResumeRes
+Cosim::followRetired (ResumeRes  rtlRes)
+{
+  ResumeRes  refRes = ResumeRes::STEPPED;
+  uint_reg_t  pc = mRefRegs[REG_PC];
+  uint64_t  instr = mRef->getInstrCount ();
+
+  for (std::size_t  i = 0; i < mRetired.size (); i++)
+    {
+      pc = mRefRegs[REG_PC];
+      instr = mRef->getInstrCount ();
+
+      if (mRetired[i] != pc)
+	{
+	  ostringstream  oss;
+
+	  oss << "  Instruction " << instr << ": PC RTL 0x" << hex
+	      << mRetired[i] << ", ISS 0x" << pc << dec << endl;
+	  diverged (oss.str ());
+	  return ResumeRes::DIVERGED;
+	}
+
+      refRes = stepRef ();
+
+      if ((ResumeRes::STEPPED != refRes) && (i + 1 < mRetired.size ()))
+	{
+	  ostringstream  oss;
+
+	  oss << "  Instruction " << instr << " at PC 0x" << hex << pc << dec
+	      << ": RTL ran on, ISS " << refRes << endl;
+	  diverged (oss.str ());
+	  return ResumeRes::DIVERGED;
+	}
+    }
+
+  if (((ResumeRes::INTERRUPTED == rtlRes) || (ResumeRes::SYSCALL == rtlRes))
+      && (ResumeRes::STEPPED == refRes))
+    {
+      pc = mRefRegs[REG_PC];
+      instr = mRef->getInstrCount ();
+      refRes = stepRef ();
+    }
+
+  ResumeRes  expected =
+    ((ResumeRes::LIMIT == rtlRes) || (ResumeRes::TIMEOUT == rtlRes))
+    ? ResumeRes::STEPPED : rtlRes;
+
+  if (refRes != expected)
+    {
+      ostringstream  oss;
+
+      oss << "  Instruction " << instr << " at PC 0x" << hex << pc << dec
+	  << ": RTL " << rtlRes << ", ISS " << refRes << endl;
+      diverged (oss.str ());
+      return ResumeRes::DIVERGED;
+    }
+
+  uint_reg_t  rtlPc;
+
+  mRtl->readRegister (REG_PC, rtlPc);
+
+  if (rtlPc != mRefRegs[REG_PC])
+    {
+      ostringstream  oss;
+
+      oss << "  Instruction " << instr << " at PC 0x" << hex << pc
+	  << ": next PC RTL 0x" << rtlPc << ", ISS 0x" << mRefRegs[REG_PC]
+	  << dec << endl;
+      diverged (oss.str ());
+      return ResumeRes::DIVERGED;
+    }
+
+  return rtlRes;
+
+}	// Cosim::followRetired ()
+
+
+//! Step both models one instruction
+
+//! The PC is compared every instruction, and everything else once a batch
+//! is full.
+
+//! @return  How the RTL model stopped, or ResumeRes::DIVERGED if the models
+//!          differ.
+
+ITarget::ResumeRes
+Cosim::stepBoth ()
+{
+  uint_reg_t  pc = mRefRegs[REG_PC];
+  uint64_t  instr = mRef->getInstrCount ();
+  ResumeRes  rtlRes = mRtl->resume (ResumeType::STEP);
+
+  // A breakpoint stops the RTL model without executing anything.
+
+  if ((ResumeRes::STEPPED != rtlRes) && (ResumeRes::SYSCALL != rtlRes))
+    return rtlRes;
+
+  ResumeRes  refRes = stepRef ();
+
+  if (refRes != rtlRes)
+    {
+      ostringstream  oss;
+
+      oss << "  Instruction " << instr << " at PC 0x" << hex << pc << dec
+	  << ": RTL " << rtlRes << ", ISS " << refRes << endl;
+      diverged (oss.str ());
+      return ResumeRes::DIVERGED;
+    }
+
+  uint_reg_t  rtlPc;
+
+  mRtl->readRegister (REG_PC, rtlPc);
+
+  if (rtlPc != mRefRegs[REG_PC])
+    {
+      ostringstream  oss;
+
+      oss << "  Instruction " << instr << " at PC 0x" << hex << pc
+	  << ": next PC RTL 0x" << rtlPc << ", ISS 0x" << mRefRegs[REG_PC]
+	  << dec << endl;
+      diverged (oss.str ());
+      return ResumeRes::DIVERGED;
+    }
+
+  if ((++mSinceCheck >= mInterval) || (mStores.size () >= STORE_BATCH))
+    if (! check ())
+      return ResumeRes::DIVERGED;
+
+  return rtlRes;
+
+}	// Cosim::stepBoth ()
+
+
+//! Step the reference model one instruction
+
+//! Each register change and store is noted with the instruction that made
+//! it, for the report.
+
+//! @return  How the reference model stopped
+
+ITarget::ResumeRes
+Cosim::stepRef ()
+{
+  uint_reg_t  pc = mRefRegs[REG_PC];
+  uint64_t  instr = mRef->getInstrCount ();
+  ResumeRes  refRes = mRef->resume (ResumeType::STEP);
+  uint_reg_t  prev[NUM_REGS];
+
+  mStoreInstrs.resize (mStores.size (), instr);
+  mStorePcs.resize (mStores.size (), pc);
+  memcpy (prev, mRefRegs, sizeof (mRefRegs));
+  readRefRegs ();
+
+  for (int  reg = 1; reg < REG_PC; reg++)
+    if (prev[reg] != mRefRegs[reg])
+      {
+	mWriterInstr[reg] = instr;
+	mWriterPc[reg] = pc;
+      }
+
+  mChecked++;
+  return refRes;
+
+}	// Cosim::stepRef ()
+
+
+//! Compare the general registers
+
+//! The whole register file is compared at once, and only searched if it
+//! differs.
+
+//! @return  TRUE if the registers match, FALSE otherwise.
+
+bool
+Cosim::checkRegs ()
+{
+  mRtlRegs[0] = 0;
+
+  for (int  reg = 1; reg < REG_PC; reg++)
+    mRtl->readRegister (reg, mRtlRegs[reg]);
+
+  if (0 == memcmp (mRtlRegs, mRefRegs, REG_PC * sizeof (uint_reg_t)))
+    return true;
+
+  ostringstream  oss;
+
+  for (int  reg = 1; reg < REG_PC; reg++)
+    if (mRtlRegs[reg] != mRefRegs[reg])
+      {
+	oss << "  x" << reg << ": RTL 0x" << hex << mRtlRegs[reg] << ", ISS 0x"
+	    << mRefRegs[reg] << dec;
+
+	if (NO_WRITER == mWriterInstr[reg])
+	  oss << ", unchanged on the ISS" << endl;
+	else
+	  oss << ", last changed by instruction " << mWriterInstr[reg]
+	      << " at PC 0x" << hex << mWriterPc[reg] << dec << endl;
+      }
+
+  diverged (oss.str ());
+  return false;
+
+}	// Cosim::checkRegs ()
+
+
+//! Compare the memory written by stores
+
+//! The bytes stored are gathered from each model, and compared as a whole.
+//! Only if they differ do we look for the store responsible.
+
+//! @return  TRUE if the memory matches, FALSE otherwise.
+
+bool
+Cosim::checkStores ()
+{
+  if (mStores.empty ())
+    return true;
+
+  mRtlBytes.clear ();
+  mRefBytes.clear ();
+
+  for (auto it = mStores.begin (); it != mStores.end (); it++)
+    {
+      std::size_t  off = mRefBytes.size ();
+
+      mRtlBytes.resize (off + it->second);
+      mRefBytes.resize (off + it->second);
+      mRtl->read (it->first, mRtlBytes.data () + off, it->second);
+      mRef->read (it->first, mRefBytes.data () + off, it->second);
+    }
+
+  if (0 == memcmp (mRtlBytes.data (), mRefBytes.data (), mRefBytes.size ()))
+    {
+      mStores.clear ();
+      mStoreInstrs.clear ();
+      mStorePcs.clear ();
+      return true;
+    }
+
+  ostringstream  oss;
+  std::size_t  off = 0;
+
+  for (std::size_t  i = 0; i < mStores.size (); i++)
+    {
+      std::size_t  size = mStores[i].second;
+
+      if (0 != memcmp (mRtlBytes.data () + off, mRefBytes.data () + off, size))
+	{
+	  oss << "  Store of " << size << " bytes to 0x" << hex
+	      << mStores[i].first << " by instruction " << dec
+	      << mStoreInstrs[i] << " at PC 0x" << hex << mStorePcs[i]
+	      << ":" << endl << "    RTL";
+
+	  for (std::size_t  b = 0; b < size; b++)
+	    oss << " " << setw (2) << setfill ('0')
+		<< static_cast<unsigned int> (mRtlBytes[off + b]);
+
+	  oss << endl << "    ISS";
+
+	  for (std::size_t  b = 0; b < size; b++)
+	    oss << " " << setw (2) << setfill ('0')
+		<< static_cast<unsigned int> (mRefBytes[off + b]);
+
+	  oss << dec << endl;
+	  break;
+	}
+
+      off += size;
+    }
+
+  diverged (oss.str ());
+  return false;
+
+}	// Cosim::checkStores ()
+
+
+//! Compare everything outstanding
+
+//! @return  TRUE if the models match, FALSE otherwise.
+
+bool
+Cosim::check ()
+{
+  mSinceCheck = 0;
+  return checkRegs () && checkStores ();
+
+}	// Cosim::check ()
+
+
+//! Record and report a divergence
+
+//! The reference model then takes the state of the RTL model, so checking
+//! can carry on from there.
+
+//! @param[in] report  What differs, a line per difference
+
+void
+Cosim::diverged (const std::string & report)
+{
+  ostringstream  oss;
+
+  oss << "RTL diverged from the ISS after " << mRef->getInstrCount ()
+      << " instructions:" << endl << report;
+
+  mReport = oss.str ();
+  mDivergences++;
+  cerr << "Warning: " << mReport;
+  resync ();
+
+}	// Cosim::diverged ()
+
+
+//! Read the registers of the reference model
+
+void
+Cosim::readRefRegs ()
+{
+  for (int  reg = 0; reg < NUM_REGS; reg++)
+    mRef->readRegister (reg, mRefRegs[reg]);
+
+}	// Cosim::readRefRegs ()
+
+
+//! Start checking afresh from the current state of the reference model
+
+void
+Cosim::restart ()
+{
+  readRefRegs ();
+
+  for (int  reg = 0; reg < NUM_REGS; reg++)
+    {
+      mWriterInstr[reg] = NO_WRITER;
+      mWriterPc[reg] = 0;
+    }
+
+  mStores.clear ();
+  mStoreInstrs.clear ();
+  mStorePcs.clear ();
+  mSinceCheck = 0;
+
+}	// Cosim::restart ()
+
+
+//! Give the reference model the state of the RTL model
+
+//! The general registers and PC are copied, along with every page of memory
+//! the reference model has used. CSRs are left alone.
+
+void
+Cosim::resync ()
+{
+  vector<uint32_t>  pages;
+  uint8_t  buf[PAGE_SIZE];
+
+  mRef->pages (pages);
+
+  for (auto it = pages.begin (); it != pages.end (); it++)
+    {
+      mRtl->read (*it, buf, PAGE_SIZE);
+      mRef->write (*it, buf, PAGE_SIZE);
+    }
+
+  for (int  reg = 1; reg < NUM_REGS; reg++)
+    {
+      uint_reg_t  val;
+
+      mRtl->readRegister (reg, val);
+      mRef->writeRegister (reg, val);
+    }
+
+  restart ();
+
+}	// Cosim::resync ()
+
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// show-trailing-whitespace: t
+// End:
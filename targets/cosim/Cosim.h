@@ -0,0 +1,273 @@
+// GDB RSP server lockstep co-simulation target: declaration
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef COSIM_H
+#define COSIM_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ITarget.h"
+
+
+class Iss;
+
+
+//! A target which checks an RTL model against the ISS as it runs.
+
+//! Where the RTL model can record the PC of each instruction it retires,
+//! it runs freely while continuing, a batch of instructions at a time, and
+//! the ISS, as a reference, then steps through the same instructions,
+//! comparing the PC of each. Otherwise the RTL model is stepped an
+//! instruction at a time, with the ISS stepping alongside it. Either way the
+//! general registers and the memory written by stores are compared in
+//! batches, since reading them from the RTL model costs clock cycles. The
+//! first difference found stops execution with ResumeRes::DIVERGED, and a
+//! report of what differs.
+
+//! There are no Verilator details here, so there is no separate
+//! implementation class.
+
+class Cosim final : public ITarget
+{
+ public:
+
+  // Constructor and destructor
+
+  Cosim (const TraceFlags * flags,
+	 ITarget *          rtl);
+  ~Cosim ();
+
+  virtual ResumeRes  resume (ResumeType step);
+  virtual ResumeRes  resume (ResumeType step,
+                             std::chrono::duration <double>  timeout);
+
+  virtual ResumeRes  terminate (void);
+  virtual ResumeRes  reset (ITarget::ResetType  type);
+
+  virtual uint64_t  getCycleCount (void) const;
+  virtual uint64_t  getInstrCount (void) const;
+  virtual bool  countsInstrs () const;
+
+  // Limit on continuing
+
+  virtual void  setLimit (LimitType  type,
+			  uint64_t  count);
+
+  // Read contents of a target register.
+
+  virtual std::size_t  readRegister (const int  reg,
+				     uint_reg_t & value) const;
+
+  // Write data to a target register.
+
+  virtual std::size_t  writeRegister (const int  reg,
+				      const uint_reg_t  value);
+
+  // Read data from memory.
+
+  virtual std::size_t  read (const uint32_t  addr,
+			     uint8_t * buffer,
+			     const std::size_t  size) const;
+
+  // Write data to memory.
+
+  virtual std::size_t  write (const uint32_t  addr,
+			      const uint8_t * buffer,
+			      const std::size_t  size);
+
+  // Insert and remove a matchpoint (breakpoint or watchpoint) at the given
+  // address.  Return value indicates whether the operation was successful.
+
+  virtual bool  insertMatchpoint (const uint32_t  addr,
+				  const MatchType  matchType);
+  virtual bool  removeMatchpoint (const uint32_t  addr,
+				  const MatchType  matchType);
+
+  // Monitor commands
+
+  virtual void  registerCommands (CommandRegistry & reg);
+
+  // Checkpoint files
+
+  virtual bool  saveCheckpoint (const std::string & filename);
+  virtual bool  restoreCheckpoint (const std::string & filename);
+
+  // Snapshots
+
+  virtual bool  saveSnapshot (std::vector<uint8_t> & state);
+  virtual bool  restoreSnapshot (const std::vector<uint8_t> & state);
+
+  // Threads
+
+  virtual bool  threaded () const;
+
+  // Retired instructions
+
+  virtual bool  traceRetired (std::vector<uint32_t> * pcs);
+
+  // Identify the server
+
+  void gdbServer (GdbServer *server);
+
+  // Verilator support
+
+  virtual double timeStamp ();
+
+
+ private:
+
+  //! GDB register number of the program counter
+
+  static const int  REG_PC = 32;
+
+  //! Number of registers compared: the general registers and the PC
+
+  static const int  NUM_REGS = 33;
+
+  //! Default instructions between comparisons of the general registers,
+  //! when the RTL model is stepped
+
+  static const unsigned int  DEFAULT_INTERVAL = 64;
+
+  //! Default instructions between comparisons of the general registers,
+  //! when the RTL model runs freely. Each batch costs halting the RTL model
+  //! and reading its registers through the debug unit, a hundred or so
+  //! cycles.
+
+  static const unsigned int  DEFAULT_BATCH = 1024;
+
+  //! Most stores held before they are compared
+
+  static const std::size_t  STORE_BATCH = 256;
+
+  //! Instructions to run between checks for timeout
+
+  static const uint64_t  RUN_SAMPLE_INSNS = 1000;
+
+  //! Bytes in a page of ISS memory
+
+  static const std::size_t  PAGE_SIZE = 4096;
+
+  //! Marks a register with no change seen since checking restarted
+
+  static const uint64_t  NO_WRITER = UINT64_MAX;
+
+  //! The RTL model being checked
+
+  ITarget * mRtl;
+
+  //! The reference model
+
+  Iss * mRef;
+
+  //! Cycle and instruction counts at which continuing stops
+
+  uint64_t  mCycleLimit;
+  uint64_t  mInstrLimit;
+
+  //! Can the RTL model run freely, recording what it retires?
+
+  bool  mFreeRun;
+
+  //! Instructions between comparisons of the general registers
+
+  unsigned int  mInterval;
+
+  //! Instructions since the general registers were last compared
+
+  unsigned int  mSinceCheck;
+
+  //! Instructions checked since cold reset
+
+  uint64_t  mChecked;
+
+  //! Divergences found since cold reset
+
+  uint64_t  mDivergences;
+
+  //! Report of the last divergence
+
+  std::string  mReport;
+
+  //! Registers of the RTL model, when last compared
+
+  uint_reg_t  mRtlRegs[NUM_REGS];
+
+  //! Registers of the reference model, kept up to date after every step
+
+  uint_reg_t  mRefRegs[NUM_REGS];
+
+  //! Instruction count of the last instruction to change each register
+
+  uint64_t  mWriterInstr[NUM_REGS];
+
+  //! PC of the last instruction to change each register
+
+  uint_reg_t  mWriterPc[NUM_REGS];
+
+  //! Stores by the reference model not yet compared
+
+  std::vector<std::pair<uint32_t, std::size_t> >  mStores;
+
+  //! Instruction count of each store in mStores
+
+  std::vector<uint64_t>  mStoreInstrs;
+
+  //! PC of each store in mStores
+
+  std::vector<uint_reg_t>  mStorePcs;
+
+  //! PC of each instruction retired by the RTL model in this batch
+
+  std::vector<uint32_t>  mRetired;
+
+  //! Bytes stored on the RTL model, gathered for comparison
+
+  std::vector<uint8_t>  mRtlBytes;
+
+  //! Bytes stored on the reference model, gathered for comparison
+
+  std::vector<uint8_t>  mRefBytes;
+
+  // Helper functions
+
+  ResumeRes  runBatches (std::chrono::duration <double>  timeout);
+  ResumeRes  followRetired (ResumeRes  rtlRes);
+  ResumeRes  stepBoth ();
+  ResumeRes  stepRef ();
+  bool  checkRegs ();
+  bool  checkStores ();
+  bool  check ();
+  void  diverged (const std::string & report);
+  void  readRefRegs ();
+  void  restart ();
+  void  resync ();
+
+};	// class Cosim
+
+
+#endif	// COSIM_H
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// show-trailing-whitespace: t
+// End:
@@ -20,6 +20,8 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <iostream>
+
 #include "GdbServer.h"
 #include "GdbSim.h"
 #include "GdbSimImpl.h"
@@ -139,6 +141,34 @@ GdbSim::getInstrCount (void) const
 }	// GdbSim::getInstrCount ()
 
 
+//! Does the target count instructions?
+
+//! @return  TRUE, since we count every step.
+
+bool
+GdbSim::countsInstrs () const
+{
+  return  true;
+
+}	// GdbSim::countsInstrs ()
+
+
+//! Set a limit on continuing
+
+//! Wrapper for the implementation class.
+
+//! @param[in] type   Whether the limit is on cycles or instructions
+//! @param[in] count  The count at which to stop, or NO_LIMIT
+
+void
+GdbSim::setLimit (LimitType  type,
+		  uint64_t  count)
+{
+  mGdbSimImpl->setLimit (type, count);
+
+}	// GdbSim::setLimit ()
+
+
 //! Read a register
 
 //! Wrapper for the implementation class.
@@ -245,21 +275,117 @@ GdbSim::removeMatchpoint (const uint32_t  addr,
 }	// GdbSim::removeMatchpoint ()
 
 
-//! Pass a command through to the target
+//! Add the target's monitor commands to a registry
 
 //! Wrapper for the implementation class.
 
-//! @param[in]  cmd  The command being passed
-//! @param[out] stream  Stream on which to write any response.
-//! @return  TRUE if the command succeeded, FALSE otherwise.
+//! @param[in] reg  The registry
+
+void
+GdbSim::registerCommands (CommandRegistry & reg)
+{
+  mGdbSimImpl->registerCommands (reg);
+
+}	// GdbSim::registerCommands ()
+
+
+//! Save a checkpoint file
+
+//! The GDB simulator has no way to save its state.
+
+//! @param[in] filename  The file to write
+//! @return  FALSE, since we can never save a checkpoint.
+
+bool
+GdbSim::saveCheckpoint (const std::string & filename  __attribute__ ((unused)))
+{
+  std::cerr << "Warning: GDB simulator does not support checkpoint files"
+	    << std::endl;
+  return  false;
+
+}	// GdbSim::saveCheckpoint ()
+
+
+//! Restore a checkpoint file
+
+//! The GDB simulator has no way to restore its state.
+
+//! @param[in] filename  The file to read
+//! @return  FALSE, since we can never restore a checkpoint.
+
+bool
+GdbSim::restoreCheckpoint (const std::string & filename
+			   __attribute__ ((unused)))
+{
+  std::cerr << "Warning: GDB simulator does not support checkpoint files"
+	    << std::endl;
+  return  false;
+
+}	// GdbSim::restoreCheckpoint ()
+
+
+//! Save a snapshot
+
+//! The GDB simulator has no way to save its state.
+
+//! @param[out] state  The saved state
+//! @return  FALSE, since we can never take a snapshot.
+
+bool
+GdbSim::saveSnapshot (std::vector<uint8_t> & state  __attribute__ ((unused)))
+{
+  std::cerr << "Warning: GDB simulator does not support snapshots"
+	    << std::endl;
+  return  false;
+
+}	// GdbSim::saveSnapshot ()
+
+
+//! Restore a snapshot
+
+//! The GDB simulator has no way to restore its state.
+
+//! @param[in] state  State saved by saveSnapshot ()
+//! @return  FALSE, since we can never restore a snapshot.
+
+bool
+GdbSim::restoreSnapshot (const std::vector<uint8_t> & state
+			 __attribute__ ((unused)))
+{
+  std::cerr << "Warning: GDB simulator does not support snapshots"
+	    << std::endl;
+  return  false;
+
+}	// GdbSim::restoreSnapshot ()
+
+
+//! Does the target have threads of its own running?
+
+//! GDB's simulator runs on our thread.
+
+//! @return  FALSE
+
+bool
+GdbSim::threaded () const
+{
+  return  false;
+
+}	// GdbSim::threaded ()
+
+
+//! Record the PC of each instruction retired while continuing
+
+//! GDB's simulator cannot tell us.
+
+//! @param[in] pcs  Where to record the PCs, or nullptr
+//! @return  FALSE, since we do not record them.
 
 bool
-GdbSim::command (const std::string  cmd,
-		std::ostream & stream)
+GdbSim::traceRetired (std::vector<uint32_t> * pcs __attribute__ ((unused)))
 {
-  return  mGdbSimImpl->command (cmd, stream);
+  return  false;
 
-}	// GdbSim::command ()
+}	// GdbSim::traceRetired ()
 
 
 //! Wrapper for the implementation class
@@ -52,6 +52,12 @@ class GdbSim final : public ITarget
 
   virtual uint64_t  getCycleCount (void) const;
   virtual uint64_t  getInstrCount (void) const;
+  virtual bool  countsInstrs () const;
+
+  // Limit on continuing
+
+  virtual void  setLimit (LimitType  type,
+			  uint64_t  count);
 
   // Read contents of a target register.
 
@@ -83,10 +89,27 @@ class GdbSim final : public ITarget
   virtual bool  removeMatchpoint (const uint32_t  addr,
 				  const MatchType  matchType);
 
-  // Generic pass through of command
+  // Monitor commands
+
+  virtual void  registerCommands (CommandRegistry & reg);
+
+  // Checkpoint files
+
+  virtual bool  saveCheckpoint (const std::string & filename);
+  virtual bool  restoreCheckpoint (const std::string & filename);
+
+  // Snapshots
+
+  virtual bool  saveSnapshot (std::vector<uint8_t> & state);
+  virtual bool  restoreSnapshot (const std::vector<uint8_t> & state);
+
+  // Threads
+
+  virtual bool  threaded () const;
+
+  // Retired instructions
 
-  virtual bool command (const std::string  cmd,
-			std::ostream & stream);
+  virtual bool  traceRetired (std::vector<uint32_t> * pcs);
 
   // Identify the server
 
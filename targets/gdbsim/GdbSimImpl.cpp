@@ -20,6 +20,7 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <cstdint>
@@ -27,6 +28,7 @@
 #include <sstream>
 #include <cstring>
 
+#include "CommandRegistry.h"
 #include "GdbServer.h"
 #include "GdbSimImpl.h"
 #include "TraceFlags.h"
@@ -43,7 +45,11 @@
 
 GdbSimImpl::GdbSimImpl (const TraceFlags *flags)
   : mFlags (flags),
-    mHaveReset (false)
+    mHaveReset (false),
+    mInstrCnt (0),
+    mCycleLimit (ITarget::NO_LIMIT),
+    mInstrLimit (ITarget::NO_LIMIT),
+    mSpin (8 * sizeof (uint_reg_t))
 {
   reset (ITarget::ResetType::COLD);
 }	// GdbSimImpl::GdbSimImpl ()
@@ -126,10 +132,13 @@ GdbSimImpl::terminate ()
 //! @return  Whether the reset was successful, which is always SUCCESS
 
 ITarget::ResumeRes
-GdbSimImpl::reset (ITarget::ResetType type __attribute__ ((unused)))
+GdbSimImpl::reset (ITarget::ResetType type)
 {
   char * const sim_argv[] = { strdup ("gdbsim"), NULL };
 
+  if (type == ITarget::ResetType::COLD)
+    mInstrCnt = 0;
+
   if (mHaveReset)
     gdb_callback.shutdown (&gdb_callback);
   mHaveReset = true;
@@ -149,7 +158,8 @@ GdbSimImpl::reset (ITarget::ResetType type __attribute__ ((unused)))
 
 //! Accessor for the cycle count
 
-//! The value is set during the execution of the model.
+//! The GDB simulator has no timing model, so every instruction takes one
+//! cycle.
 
 //! @return  The number of cycles executed since startup or the last cold
 //!          reset.
@@ -157,15 +167,14 @@ GdbSimImpl::reset (ITarget::ResetType type __attribute__ ((unused)))
 uint64_t
 GdbSimImpl::getCycleCount () const
 {
-  std::cerr << "In " << __PRETTY_FUNCTION__ << std::endl;
-  abort ();
-  return 0;
+  return mInstrCnt;
 }	// GdbSimImpl::getCycleCount ()
 
 
 //! Accessor for the instruction count
 
-//! The value is set during the execution of the model.
+//! The simulator is always run a step at a time, so each step completed is
+//! counted.
 
 //! @return  The number of instructions executed since startup or the last cold
 //!          reset.
@@ -173,12 +182,25 @@ GdbSimImpl::getCycleCount () const
 uint64_t
 GdbSimImpl::getInstrCount () const
 {
-  std::cerr << "In " << __PRETTY_FUNCTION__ << std::endl;
-  abort ();
-  return 0;
+  return mInstrCnt;
 }	// GdbSimImpl::getInstrCount ()
 
 
+//! Set a limit on continuing
+
+//! @param[in] type   Whether the limit is on cycles or instructions
+//! @param[in] count  The count at which to stop, or NO_LIMIT
+
+void
+GdbSimImpl::setLimit (ITarget::LimitType type, uint64_t count)
+{
+  if (ITarget::LimitType::CYCLES == type)
+    mCycleLimit = count;
+  else
+    mInstrLimit = count;
+}	// GdbSimImpl::setLimit ()
+
+
 //! Read a register
 
 //! We assume that the core is halted. If not we have a problem.  We use the
@@ -310,8 +332,6 @@ bool
 GdbSimImpl::insertMatchpoint (const uint32_t  addr __attribute__ ((unused)),
 			     const ITarget::MatchType  matchType __attribute__ ((unused)))
 {
-  std::cerr << "In " << __PRETTY_FUNCTION__ << std::endl;
-  abort ();
   return  false;
 }	// GdbSimImpl::insertMatchpoint ()
 
@@ -331,32 +351,32 @@ bool
 GdbSimImpl::removeMatchpoint (const uint32_t  addr __attribute__ ((unused)),
 			     const ITarget::MatchType  matchType __attribute__ ((unused)) )
 {
-  std::cerr << "In " << __PRETTY_FUNCTION__ << std::endl;
-  abort ();
   return  false;
 }	// GdbSimImpl::removeMatchpoint ()
 
 
-//! Generic pass through of command
+//! Add the target's monitor commands to a registry
 
-//! @todo
-
-//! For now we have no commands, so we should never receive this, and thus
-//! always fail.
+//! The commands are those of the spin loop detector, which also adds to the
+//! "stats" command.
 
-//!@param[in]  cmd     The command to process
-//!@param[out] stream  A stream to write any output from the command
-//!@return  TRUE if the command was handled successfully, FALSE otherwise. We
-//!         awlways return FALSE.
+//! @param[in] reg  The registry
 
-bool
-GdbSimImpl::command (const std::string  cmd __attribute__ ((unused)),
-		    std::ostream & stream __attribute__ ((unused)))
+void
+GdbSimImpl::registerCommands (CommandRegistry & reg)
 {
-  std::cerr << "In " << __PRETTY_FUNCTION__ << std::endl;
-  abort ();
-  return false;
-}	// GdbSimImpl::command ()
+  reg.add ("spin", SpinDetector::HELP,
+	   [this] (const CommandArgs & args, std::ostream & stream)
+	   { return mSpin.command (args, stream); });
+  reg.add ("stats", nullptr,
+	   [this] (const CommandArgs & args __attribute__ ((unused)),
+		   std::ostream & stream)
+	   {
+	     mSpin.report (stream);
+	     return true;
+	   });
+
+}	// GdbSimImpl::registerCommands ()
 
 
 //! Record the server we are associated with.
@@ -405,6 +425,7 @@ GdbSimImpl::doOneStep (std::chrono::duration <double> timeout)
   if (insn == 0x00000073 /* ECALL */)
     {
       writeRegister (SIM_RISCV_PC_REGNUM, (stepAddr + 4));
+      mInstrCnt++;
       return ITarget::ResumeRes::SYSCALL;
     }
 
@@ -432,6 +453,7 @@ GdbSimImpl::doOneStep (std::chrono::duration <double> timeout)
             return ITarget::ResumeRes::INTERRUPTED;
 
           /* We must have just completed a step.  */
+          mInstrCnt++;
           return ITarget::ResumeRes::STEPPED;
         }
       else
@@ -481,6 +503,16 @@ GdbSimImpl::doRunToBreak (std::chrono::duration <double> timeout)
 
   do
     {
+      // Skip any spin loop we are at the head of.
+      uint_reg_t pc;
+      readRegister (SIM_RISCV_PC_REGNUM, pc);
+      if (mSpin.watch (pc, mInstrCnt, mInstrCnt))
+        skipSpin ();
+
+      // Stop before the step which would take us past a limit.
+      if ((mInstrCnt >= mCycleLimit) || (mInstrCnt >= mInstrLimit))
+        return ITarget::ResumeRes::LIMIT;
+
       // Step without a timeout.
       ITarget::ResumeRes res
         = doOneStep (std::chrono::duration <double>::zero ());
@@ -497,6 +529,45 @@ GdbSimImpl::doRunToBreak (std::chrono::duration <double> timeout)
   while (true);
 }
 
+
+//! Skip iterations of a spin loop
+
+//! Called at the head of a loop the spin detector wants examined. Every
+//! instruction takes a cycle, so only the instruction count moves on, as far
+//! as the limits allow. A loop which never ends is only skipped up to a
+//! limit.
+
+void
+GdbSimImpl::skipSpin ()
+{
+  uint64_t regs[SpinDetector::NUM_REGS];
+  uint8_t code[SpinDetector::MAX_CODE];
+
+  for (unsigned int r = 0; r < SpinDetector::NUM_REGS; r++)
+    {
+      uint_reg_t val;
+      readRegister (r, val);
+      regs[r] = val;
+    }
+
+  read (mSpin.head (), code, sizeof (code));
+
+  SpinDetector::Verdict v = mSpin.examine (regs, code);
+  uint64_t iters = SpinDetector::within (v.iters, mInstrCnt,
+                                         std::min (mCycleLimit, mInstrLimit),
+                                         v.instrs);
+
+  if ((0 == iters) || (SpinDetector::FOREVER == iters))
+    return;
+
+  if (SpinDetector::Kind::COUNTDOWN == v.kind)
+    writeRegister (v.reg,
+                   static_cast <uint_reg_t> (regs[v.reg] + iters * v.delta));
+
+  mInstrCnt += iters * v.instrs;
+  mSpin.skipped (iters);
+}	// GdbSimImpl::skipSpin ()
+
 // Local Variables:
 // mode: C++
 // c-file-style: "gnu"
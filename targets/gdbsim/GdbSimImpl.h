@@ -27,6 +27,7 @@
 #include <fstream>
 
 #include "ITarget.h"
+#include "SpinDetector.h"
 #include "gdb/remote-sim.h"
 #include "gdb/callback.h"
 
@@ -50,6 +51,8 @@ class GdbSimImpl final
 
   uint64_t  getCycleCount () const;
   uint64_t  getInstrCount () const;
+  void  setLimit (ITarget::LimitType  type,
+		  uint64_t  count);
 
   // Read contents of a target register.
 
@@ -81,10 +84,9 @@ class GdbSimImpl final
   bool  removeMatchpoint (const uint32_t  addr,
 			  const ITarget::MatchType  matchType);
 
-  // Generic pass through of command
+  // Monitor commands
 
-  bool command (const std::string  cmd,
-		std::ostream & stream);
+  void  registerCommands (CommandRegistry & reg);
 
   // Identify the server
 
@@ -114,8 +116,23 @@ class GdbSimImpl final
 
   bool mHaveReset;
 
+  //! Instructions stepped since cold reset
+
+  uint64_t mInstrCnt;
+
+  //! Cycle and instruction counts at which continuing stops. Each
+  //! instruction takes a cycle, so both are on the instruction count.
+
+  uint64_t mCycleLimit;
+  uint64_t mInstrLimit;
+
+  //! Spin loops found while continuing
+
+  SpinDetector mSpin;
+
   ITarget::ResumeRes doOneStep (std::chrono::duration <double>);
   ITarget::ResumeRes doRunToBreak (std::chrono::duration <double>);
+  void skipSpin ();
 };
 
 #endif	// GDBSIM_IMPL_H
@@ -0,0 +1,703 @@
+// GDB RSP server fast forwarding target: definition
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <iostream>
+
+#include "CommandRegistry.h"
+#include "GdbServer.h"
+#include "Hybrid.h"
+#include "Iss.h"
+#include "TraceFlags.h"
+
+using std::chrono::duration;
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::hex;
+using std::dec;
+using std::vector;
+
+
+//! Constructor.
+
+//! We start on the ISS, so set it up to stop where we should switch.
+
+//! @param[in] flags      The trace flags
+//! @param[in] rtl        The RTL model to switch to. We take ownership.
+//! @param[in] when       When to switch
+//! @param[in] switchVal  The PC or instruction count at which to switch
+
+Hybrid::Hybrid (const TraceFlags * flags,
+		ITarget *          rtl,
+		SwitchWhen         when,
+		uint64_t           switchVal) :
+  ITarget (flags),
+  mFlags (flags),
+  mRtl (rtl),
+  mOnRtl (false),
+  mWhen (when),
+  mSwitchVal (switchVal),
+  mIssCycles (0),
+  mIssInstrs (0),
+  mRtlCycleBase (0),
+  mRtlInstrBase (0),
+  mCycleLimit (NO_LIMIT),
+  mInstrLimit (NO_LIMIT)
+{
+  mIss = new Iss (flags);
+  armSwitch ();
+
+}	// Hybrid::Hybrid ()
+
+
+//! Destructor
+
+//! Free both models
+
+Hybrid::~Hybrid ()
+{
+  delete mIss;
+  delete mRtl;
+
+}	// Hybrid::~Hybrid ()
+
+
+//! Resume execution
+
+//! @param[in] step  Type of resumption required
+//! @return The type of termination encountered.
+
+ITarget::ResumeRes
+Hybrid::resume (ResumeType  step)
+{
+  return resume (step, duration <double>::zero ());
+
+}	// Hybrid::resume ()
+
+
+//! Resume execution
+
+//! If the ISS reaches the switch point, we switch. Stopping only to switch
+//! is not a stop GDB should see, so a continue carries on using the RTL
+//! model.
+
+//! @param[in] step     Type of resumption required
+//! @param[in] timeout  Timeout requested
+//! @return The type of termination encountered.
+
+ITarget::ResumeRes
+Hybrid::resume (ResumeType  step,
+		duration <double>  timeout)
+{
+  if (mOnRtl || (ResumeType::STOP == step))
+    return current ()->resume (step, timeout);
+
+  ResumeRes  res = mIss->resume (step, timeout);
+
+  if (! atSwitchPoint ())
+    return res;
+
+  switchToRtl ();
+
+  if (! mFlags->traceSilent ())
+    {
+      uint_reg_t  pc;
+
+      mRtl->readRegister (REG_PC, pc);
+      cout << "Switched to the RTL model at PC 0x" << hex << pc << dec
+	   << " after " << mIssInstrs << " instructions" << endl;
+    }
+
+  if ((ResumeType::CONTINUE == step) && (ResumeRes::INTERRUPTED == res))
+    return mRtl->resume (step, timeout);
+  else
+    return res;
+
+}	// Hybrid::resume ()
+
+
+//! Terminate
+
+//! @return  Whatever the current model returns
+
+ITarget::ResumeRes
+Hybrid::terminate ()
+{
+  return current ()->terminate ();
+
+}	// Hybrid::terminate ()
+
+
+//! Reset execution
+
+//! A cold reset goes back to the ISS, so the next run is fast forwarded
+//! again. A warm reset stays on the current model.
+
+//! @param[in] type  The type of reset
+//! @return  Result of reset
+
+ITarget::ResumeRes
+Hybrid::reset (ITarget::ResetType  type)
+{
+  if (ITarget::ResetType::WARM == type)
+    return current ()->reset (type);
+
+  if (mOnRtl)
+    {
+      mRtl->reset (type);
+      mOnRtl = false;
+    }
+
+  ResumeRes  res = mIss->reset (type);
+
+  armSwitch ();
+  return res;
+
+}	// Hybrid::reset ()
+
+
+//! Get count of cycles since startup or reset
+
+//! Cycles on the ISS are added to those on the RTL model since the switch.
+
+//! @return  Cycle count since startup or reset
+
+uint64_t
+Hybrid::getCycleCount (void) const
+{
+  if (mOnRtl)
+    return mIssCycles + mRtl->getCycleCount () - mRtlCycleBase;
+  else
+    return mIss->getCycleCount ();
+
+}	// Hybrid::getCycleCount ()
+
+
+//! Get count of instructions since startup or reset
+
+//! @return  Instruction count since startup or reset
+
+uint64_t
+Hybrid::getInstrCount (void) const
+{
+  if (mOnRtl)
+    return mIssInstrs + mRtl->getInstrCount () - mRtlInstrBase;
+  else
+    return mIss->getInstrCount ();
+
+}	// Hybrid::getInstrCount ()
+
+
+//! Does the target count instructions?
+
+//! The count carries on from the ISS on the RTL model, so is only right if
+//! that counts too.
+
+//! @return  Whether the RTL model counts instructions
+
+bool
+Hybrid::countsInstrs () const
+{
+  return  mRtl->countsInstrs ();
+
+}	// Hybrid::countsInstrs ()
+
+
+//! Set a limit on continuing
+
+//! @param[in] type   Whether the limit is on cycles or instructions
+//! @param[in] count  The count at which to stop, or NO_LIMIT
+
+void
+Hybrid::setLimit (LimitType  type,
+		  uint64_t  count)
+{
+  if (LimitType::CYCLES == type)
+    mCycleLimit = count;
+  else
+    mInstrLimit = count;
+
+  passLimits ();
+
+}	// Hybrid::setLimit ()
+
+
+//! Read a register
+
+//! @param[in] reg     Register to read
+//! @param[out] value  Where to put the result of the read
+//! @return  Number of bytes read into the register
+
+std::size_t
+Hybrid::readRegister (const int  reg,
+		      uint_reg_t & value) const
+{
+  return current ()->readRegister (reg, value);
+
+}	// Hybrid::readRegister ()
+
+
+//! Write a register
+
+//! @param[in] reg    Register to write
+//! @param[in] value  Value to write
+//! @return  Number of bytes written into the register
+
+std::size_t
+Hybrid::writeRegister (const int  reg,
+		       const uint_reg_t  value)
+{
+  return current ()->writeRegister (reg, value);
+
+}	// Hybrid::writeRegister ()
+
+
+//! Read from memory
+
+//! @param[in]  addr    Address to read
+//! @param[out] buffer  Where to put the result of the read
+//! @param[in]  size    Number of bytes to read
+//! @return  Number of bytes read
+
+std::size_t
+Hybrid::read (const uint32_t addr,
+	      uint8_t * buffer,
+	      const std::size_t  size) const
+{
+  return current ()->read (addr, buffer, size);
+
+}	// Hybrid::read ()
+
+
+//! Write to memory
+
+//! @param[in]  addr    Address to write
+//! @param[in]  buffer  Data to write
+//! @param[in]  size    Number of bytes to write
+//! @return  Number of bytes written
+
+std::size_t
+Hybrid::write (const uint32_t  addr,
+	       const uint8_t * buffer,
+	       const std::size_t size)
+{
+  return current ()->write (addr, buffer, size);
+
+}	// Hybrid::write ()
+
+
+//! Insert a matchpoint
+
+//! The matchpoint goes into both models, so it is already in place after a
+//! switch or a cold reset. If either model cannot hold it, neither does, and
+//! GDB falls back to writing EBREAK into memory, which the switch copies.
+
+//! @param[in] addr       Address at which to set the matchpoint
+//! @param[in] matchType  Type of matchpoint (breakpoint or watchpoint)
+//! @return  TRUE if the matchpoint was set, FALSE otherwise.
+
+bool
+Hybrid::insertMatchpoint (const uint32_t  addr,
+			  const MatchType  matchType)
+{
+  if (! mRtl->insertMatchpoint (addr, matchType))
+    return false;
+
+  if (! mIss->insertMatchpoint (addr, matchType))
+    {
+      mRtl->removeMatchpoint (addr, matchType);
+      return false;
+    }
+
+  mMatchpoints.insert (std::make_pair (addr, matchType));
+  return true;
+
+}	// Hybrid::insertMatchpoint ()
+
+
+//! Remove a matchpoint
+
+//! The ISS keeps its breakpoint at the switch PC.
+
+//! @param[in] addr       Address from which to clear the matchpoint
+//! @param[in] matchType  Type of matchpoint (breakpoint or watchpoint)
+//! @return  TRUE if the matchpoint was removed, FALSE otherwise.
+
+bool
+Hybrid::removeMatchpoint (const uint32_t  addr,
+			  const MatchType  matchType)
+{
+  if (mMatchpoints.erase (std::make_pair (addr, matchType)) == 0)
+    return false;
+
+  mRtl->removeMatchpoint (addr, matchType);
+
+  if ((SwitchWhen::PC != mWhen)
+      || (static_cast<uint32_t> (mSwitchVal) != addr))
+    mIss->removeMatchpoint (addr, matchType);
+
+  return true;
+
+}	// Hybrid::removeMatchpoint ()
+
+
+//! Add the target's monitor commands to a registry
+
+//! "switch-to rtl" is ours. The commands of both models follow, each going
+//! to whichever model is in use, since that changes after the registry has
+//! been built.
+
+//! @param[in] reg  The registry
+
+void
+Hybrid::registerCommands (CommandRegistry & reg)
+{
+  reg.add ("switch-to",
+	   "  switch-to rtl\n"
+	   "    Copy the ISS state to the RTL model and continue there\n",
+	   [this] (const CommandArgs & args, std::ostream & stream)
+	   {
+	     if ((2 != args.size ()) || !args.is (1, "rtl"))
+	       {
+		 stream << "Unrecognized switch-to command: " << args.cmd ()
+			<< endl;
+		 return false;
+	       }
+
+	     if (mOnRtl)
+	       stream << "Already using the RTL model" << endl;
+	     else
+	       {
+		 switchToRtl ();
+		 stream << "Switched to the RTL model after " << mIssInstrs
+			<< " instructions" << endl;
+	       }
+
+	     return true;
+	   });
+
+  mIssCommands.clear ();
+  mRtlCommands.clear ();
+  mIss->registerCommands (mIssCommands);
+  mRtl->registerCommands (mRtlCommands);
+
+  CommandRegistry::Handler  forward =
+    [this] (const CommandArgs & args, std::ostream & stream)
+    {
+      const CommandRegistry & cmds = mOnRtl ? mRtlCommands : mIssCommands;
+
+      switch (cmds.run (args, stream))
+	{
+	case CommandRegistry::Result::OK:
+	  return true;
+
+	case CommandRegistry::Result::FAILED:
+	  return false;
+
+	default:
+	  stream << "Not available on the " << (mOnRtl ? "RTL" : "ISS")
+		 << " model" << endl;
+	  return false;
+	}
+    };
+
+  for (auto it = mIssCommands.begin (); it != mIssCommands.end (); it++)
+    reg.add (it->name, it->help, forward);
+
+  for (auto it = mRtlCommands.begin (); it != mRtlCommands.end (); it++)
+    reg.add (it->name, it->help, forward);
+
+}	// Hybrid::registerCommands ()
+
+
+//! Save a checkpoint file
+
+//! @param[in] filename  The file to write
+//! @return  TRUE if the checkpoint was saved, FALSE otherwise.
+
+bool
+Hybrid::saveCheckpoint (const std::string & filename)
+{
+  return current ()->saveCheckpoint (filename);
+
+}	// Hybrid::saveCheckpoint ()
+
+
+//! Restore a checkpoint file
+
+//! The checkpoint must be from the model currently in use.
+
+//! @param[in] filename  The file to read
+//! @return  TRUE if the checkpoint was restored, FALSE otherwise.
+
+bool
+Hybrid::restoreCheckpoint (const std::string & filename)
+{
+  return current ()->restoreCheckpoint (filename);
+
+}	// Hybrid::restoreCheckpoint ()
+
+
+//! Save a snapshot
+
+//! A final byte records which model the snapshot is from.
+
+//! @param[out] state  The saved state
+//! @return  TRUE if the snapshot was taken, FALSE otherwise.
+
+bool
+Hybrid::saveSnapshot (std::vector<uint8_t> & state)
+{
+  if (! current ()->saveSnapshot (state))
+    return false;
+
+  state.push_back (mOnRtl ? 1 : 0);
+  return true;
+
+}	// Hybrid::saveSnapshot ()
+
+
+//! Restore a snapshot
+
+//! A snapshot taken before the switch cannot be restored after it.
+
+//! @param[in] state  State previously saved by saveSnapshot
+//! @return  TRUE if the snapshot was restored, FALSE otherwise.
+
+bool
+Hybrid::restoreSnapshot (const std::vector<uint8_t> & state)
+{
+  if (state.empty () || ((state.back () != 0) != mOnRtl))
+    {
+      cerr << "Warning: Snapshot is from the other model: not restored"
+	   << endl;
+      return false;
+    }
+
+  vector<uint8_t>  inner (state.begin (), state.end () - 1);
+
+  return current ()->restoreSnapshot (inner);
+
+}	// Hybrid::restoreSnapshot ()
+
+
+//! Does either model have threads of its own running?
+
+//! Both models are kept, whichever is in use.
+
+//! @return  TRUE if either model has threads of its own running, FALSE
+//!          otherwise.
+
+bool
+Hybrid::threaded () const
+{
+  return  mRtl->threaded () || mIss->threaded ();
+
+}	// Hybrid::threaded ()
+
+
+//! Record the PC of each instruction retired while continuing
+
+//! Nothing checks a fast forwarded target against another.
+
+//! @param[in] pcs  Where to record the PCs, or nullptr
+//! @return  FALSE, since we do not record them.
+
+bool
+Hybrid::traceRetired (std::vector<uint32_t> * pcs __attribute__ ((unused)))
+{
+  return  false;
+
+}	// Hybrid::traceRetired ()
+
+
+//! Identify the server to both models
+
+//! @param[in] server  The server to use
+
+void
+Hybrid::gdbServer (GdbServer * server)
+{
+  mIss->gdbServer (server);
+  mRtl->gdbServer (server);
+
+}	// Hybrid::gdbServer ()
+
+
+//! Return a timestamp.
+
+//! Only the RTL model has Verilog needing the time, including while it is
+//! being reset on the ISS.
+
+//! @return  The current simulation time in seconds.
+
+double
+Hybrid::timeStamp ()
+{
+  return mRtl->timeStamp ();
+
+}	// Hybrid::timeStamp ()
+
+
+//! The model in use
+
+//! @return  The RTL model once we have switched, otherwise the ISS
+
+ITarget *
+Hybrid::current () const
+{
+  return mOnRtl ? mRtl : static_cast<ITarget *> (mIss);
+
+}	// Hybrid::current ()
+
+
+//! Has the ISS reached the point where we switch?
+
+//! @return  TRUE if we should switch now, FALSE otherwise.
+
+bool
+Hybrid::atSwitchPoint () const
+{
+  switch (mWhen)
+    {
+    case SwitchWhen::PC:
+
+      {
+	uint_reg_t  pc;
+
+	mIss->readRegister (REG_PC, pc);
+	return static_cast<uint32_t> (pc) == static_cast<uint32_t> (mSwitchVal);
+      }
+
+    case SwitchWhen::COUNT:
+
+      return mIss->getInstrCount () >= mSwitchVal;
+
+    default:
+
+      return false;
+    }
+}	// Hybrid::atSwitchPoint ()
+
+
+//! Set up the ISS to stop where we switch
+
+//! A breakpoint for a PC, or a stop for an instruction count.
+
+void
+Hybrid::armSwitch ()
+{
+  switch (mWhen)
+    {
+    case SwitchWhen::PC:
+
+      mIss->insertMatchpoint (static_cast<uint32_t> (mSwitchVal),
+			      MatchType::BREAK);
+      break;
+
+    case SwitchWhen::COUNT:
+
+      mIss->stopAt (mSwitchVal);
+      break;
+
+    default:
+
+      break;
+    }
+}	// Hybrid::armSwitch ()
+
+
+//! Switch from the ISS to the RTL model
+
+//! Every page of memory the ISS has allocated is copied, then the general
+//! registers and PC. CSRs are not copied, so the RTL model keeps its own.
+
+void
+Hybrid::switchToRtl ()
+{
+  vector<uint32_t>  pages;
+  uint8_t  buf[COPY_SIZE];
+
+  mIss->pages (pages);
+
+  for (auto it = pages.begin (); it != pages.end (); it++)
+    {
+      mIss->read (*it, buf, COPY_SIZE);
+      mRtl->write (*it, buf, COPY_SIZE);
+    }
+
+  for (int  reg = 1; reg <= REG_PC; reg++)
+    {
+      uint_reg_t  val;
+
+      mIss->readRegister (reg, val);
+      mRtl->writeRegister (reg, val);
+    }
+
+  mIssCycles = mIss->getCycleCount ();
+  mIssInstrs = mIss->getInstrCount ();
+  mRtlCycleBase = mRtl->getCycleCount ();
+  mRtlInstrBase = mRtl->getInstrCount ();
+  mOnRtl = true;
+  passLimits ();
+
+}	// Hybrid::switchToRtl ()
+
+
+//! Pass our limits on to the current model
+
+//! Until we switch, our counts are those of the ISS. After, the RTL model
+//! counts from its own base, so its limits are moved by the difference. A
+//! limit we have already passed stops the RTL model at once.
+
+void
+Hybrid::passLimits ()
+{
+  if (! mOnRtl)
+    {
+      mIss->setLimit (LimitType::CYCLES, mCycleLimit);
+      mIss->setLimit (LimitType::INSTRS, mInstrLimit);
+      return;
+    }
+
+  auto rtlLimit = [] (uint64_t  limit,
+		      uint64_t  issCount,
+		      uint64_t  rtlBase) -> uint64_t
+    {
+      if (limit <= issCount)
+	return rtlBase;
+      else if (limit - issCount > NO_LIMIT - rtlBase)
+	return NO_LIMIT;
+      else
+	return limit - issCount + rtlBase;
+    };
+
+  mRtl->setLimit (LimitType::CYCLES,
+		  rtlLimit (mCycleLimit, mIssCycles, mRtlCycleBase));
+  mRtl->setLimit (LimitType::INSTRS,
+		  rtlLimit (mInstrLimit, mIssInstrs, mRtlInstrBase));
+
+}	// Hybrid::passLimits ()
+
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// show-trailing-whitespace: t
+// End:
@@ -0,0 +1,223 @@
+// GDB RSP server fast forwarding target: declaration
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HYBRID_H
+#define HYBRID_H
+
+#include <set>
+#include <utility>
+
+#include "CommandRegistry.h"
+#include "ITarget.h"
+
+
+class Iss;
+
+
+//! A target which runs on the ISS, then switches to an RTL model.
+
+//! The program runs on the instruction set simulator until it reaches a
+//! given PC or instruction count, or until told to switch by "monitor
+//! switch-to rtl". The registers and memory are then copied into the RTL
+//! model, which runs from there on. A cold reset goes back to the ISS.
+
+//! There are no Verilator details here, so there is no separate
+//! implementation class.
+
+class Hybrid final : public ITarget
+{
+ public:
+
+  //! When to switch to the RTL model
+
+  enum class SwitchWhen
+    {
+      MANUAL,			//!< Only when told to
+      PC,			//!< When the PC reaches an address
+      COUNT			//!< When an instruction count is reached
+    };
+
+  // Constructor and destructor
+
+  Hybrid (const TraceFlags * flags,
+	  ITarget *          rtl,
+	  SwitchWhen         when,
+	  uint64_t           switchVal);
+  ~Hybrid ();
+
+  virtual ResumeRes  resume (ResumeType step);
+  virtual ResumeRes  resume (ResumeType step,
+                             std::chrono::duration <double>  timeout);
+
+  virtual ResumeRes  terminate (void);
+  virtual ResumeRes  reset (ITarget::ResetType  type);
+
+  virtual uint64_t  getCycleCount (void) const;
+  virtual uint64_t  getInstrCount (void) const;
+  virtual bool  countsInstrs () const;
+
+  // Limit on continuing
+
+  virtual void  setLimit (LimitType  type,
+			  uint64_t  count);
+
+  // Read contents of a target register.
+
+  virtual std::size_t  readRegister (const int  reg,
+				     uint_reg_t & value) const;
+
+  // Write data to a target register.
+
+  virtual std::size_t  writeRegister (const int  reg,
+				      const uint_reg_t  value);
+
+  // Read data from memory.
+
+  virtual std::size_t  read (const uint32_t  addr,
+			     uint8_t * buffer,
+			     const std::size_t  size) const;
+
+  // Write data to memory.
+
+  virtual std::size_t  write (const uint32_t  addr,
+			      const uint8_t * buffer,
+			      const std::size_t  size);
+
+  // Insert and remove a matchpoint (breakpoint or watchpoint) at the given
+  // address.  Return value indicates whether the operation was successful.
+
+  virtual bool  insertMatchpoint (const uint32_t  addr,
+				  const MatchType  matchType);
+  virtual bool  removeMatchpoint (const uint32_t  addr,
+				  const MatchType  matchType);
+
+  // Monitor commands
+
+  virtual void  registerCommands (CommandRegistry & reg);
+
+  // Checkpoint files
+
+  virtual bool  saveCheckpoint (const std::string & filename);
+  virtual bool  restoreCheckpoint (const std::string & filename);
+
+  // Snapshots
+
+  virtual bool  saveSnapshot (std::vector<uint8_t> & state);
+  virtual bool  restoreSnapshot (const std::vector<uint8_t> & state);
+
+  // Threads
+
+  virtual bool  threaded () const;
+
+  // Retired instructions
+
+  virtual bool  traceRetired (std::vector<uint32_t> * pcs);
+
+  // Identify the server
+
+  void gdbServer (GdbServer *server);
+
+  // Verilator support
+
+  virtual double timeStamp ();
+
+
+ private:
+
+  //! GDB register number of the program counter
+
+  static const int  REG_PC = 32;
+
+  //! Bytes of memory copied at a time. The same as an ISS page.
+
+  static const std::size_t  COPY_SIZE = 4096;
+
+  //! Our trace flags
+
+  const TraceFlags * mFlags;
+
+  //! The instruction set simulator
+
+  Iss * mIss;
+
+  //! The RTL model
+
+  ITarget * mRtl;
+
+  //! Are we running on the RTL model yet?
+
+  bool  mOnRtl;
+
+  //! When to switch
+
+  SwitchWhen  mWhen;
+
+  //! The PC or instruction count to switch at
+
+  uint64_t  mSwitchVal;
+
+  //! Cycles run on the ISS before switching
+
+  uint64_t  mIssCycles;
+
+  //! Instructions run on the ISS before switching
+
+  uint64_t  mIssInstrs;
+
+  //! RTL cycle count when we switched
+
+  uint64_t  mRtlCycleBase;
+
+  //! RTL instruction count when we switched
+
+  uint64_t  mRtlInstrBase;
+
+  //! Cycle and instruction counts at which continuing stops, as we count
+  //! them
+
+  uint64_t  mCycleLimit;
+  uint64_t  mInstrLimit;
+
+  //! Matchpoints inserted by GDB, which both models hold
+
+  std::set<std::pair<uint32_t, MatchType> >  mMatchpoints;
+
+  //! Monitor commands of the ISS and of the RTL model
+
+  CommandRegistry  mIssCommands;
+  CommandRegistry  mRtlCommands;
+
+  // Helper functions
+
+  ITarget * current () const;
+  bool  atSwitchPoint () const;
+  void  armSwitch ();
+  void  switchToRtl ();
+  void  passLimits ();
+
+};	// class Hybrid
+
+
+#endif	// HYBRID_H
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// show-trailing-whitespace: t
+// End:
@@ -0,0 +1,449 @@
+// GDB RSP server instruction set simulator wrapper: definition
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "GdbServer.h"
+#include "Iss.h"
+#include "IssImpl.h"
+#include "TraceFlags.h"
+
+
+//! Constructor.
+
+//! We only instantiate the implementation class.
+
+//! @param[in] flags  The trace flags
+
+Iss::Iss (const TraceFlags * flags) :
+  ITarget (flags)
+{
+  mIssImpl = new IssImpl (flags);
+
+}	// Iss::Iss ()
+
+
+//! Destructor
+
+//! Free the implementation class
+
+Iss::~Iss ()
+{
+  delete mIssImpl;
+
+}	// Iss::~Iss ()
+
+
+//! Resume execution
+
+//! Wrapper for the implementation class
+
+//! @param[in] step         Type of resumption required
+//! @return The type of termination encountered.
+
+ITarget::ResumeRes
+Iss::resume (ResumeType  step)
+{
+  return mIssImpl->resume (step);
+
+}	// Iss::resume ()
+
+
+//! Resume execution
+
+//! Wrapper for the implementation class
+
+//! @param[in] step         Type of resumption required
+//! @param[in] timeout      Timeout requested
+//! @return The type of termination encountered.
+
+ITarget::ResumeRes
+Iss::resume (ResumeType  step,
+	       std::chrono::duration <double>  timeout)
+{
+  return mIssImpl->resume (step, timeout);
+
+}	// Iss::resume ()
+
+
+//! Terminate execution
+
+//! Wrapper for the implementation class.
+
+//! @return  Result of termination
+
+ITarget::ResumeRes
+Iss::terminate (void)
+{
+  return  mIssImpl->terminate ();
+
+}	// Iss::terminate ()
+
+
+//! Reset execution
+
+//! Wrapper for the implementation class.
+
+//! @return  Result of reset
+
+ITarget::ResumeRes
+Iss::reset (ITarget::ResetType  type)
+{
+  return mIssImpl->reset (type);
+
+}	// Iss::reset ()
+
+
+//! Get count of cycles since startup or reset
+
+//! Wrapper for the implementation class.
+
+//! @return  Cycle count since startup or reset
+
+uint64_t
+Iss::getCycleCount (void) const
+{
+  return mIssImpl->getCycleCount ();
+
+}	// Iss::getCycleCount ()
+
+
+//! Get count of instructions since startup or reset
+
+//! Wrapper for the implementation class.
+
+//! @return  Instruction count since startup or reset
+
+uint64_t
+Iss::getInstrCount (void) const
+{
+  return mIssImpl->getInstrCount ();
+
+}	// Iss::getInstrCount ()
+
+
+//! Does the target count instructions?
+
+//! @return  TRUE, since every instruction is executed by us.
+
+bool
+Iss::countsInstrs () const
+{
+  return  true;
+
+}	// Iss::countsInstrs ()
+
+
+//! Set a limit on continuing
+
+//! Wrapper for the implementation class.
+
+//! @param[in] type   Whether the limit is on cycles or instructions
+//! @param[in] count  The count at which to stop, or NO_LIMIT
+
+void
+Iss::setLimit (LimitType  type,
+	       uint64_t  count)
+{
+  mIssImpl->setLimit (type, count);
+
+}	// Iss::setLimit ()
+
+
+//! Read a register
+
+//! Wrapper for the implementation class.
+
+//! @param[in] reg     Register to read
+//! @param[out] value  Where to put the result of the read
+//! @return  Number of bytes read into the register
+
+std::size_t
+Iss::readRegister (const int  reg,
+		     uint_reg_t & value) const
+{
+  return mIssImpl->readRegister (reg, value);
+
+}	// Iss::readRegister ()
+
+
+//! Write a register
+
+//! Wrapper for the implementation class.
+
+//! @param[in] reg    Register to write
+//! @param[in] value  Value to write
+//! @return  Number of bytes written into the register
+
+std::size_t
+Iss::writeRegister (const int  reg,
+		      const uint_reg_t  value)
+{
+  return mIssImpl->writeRegister (reg, value);
+
+}	// Iss::writeRegister ()
+
+
+//! Read from memory
+
+//! Wrapper for the implementation class.
+
+//! @param[in]  addr    Address to read
+//! @param[out] buffer  Where to put the result of the read
+//! @param[in]  size    Number of bytes to read
+//! @return  Number of bytes read
+
+std::size_t
+Iss::read (const uint32_t addr,
+	     uint8_t * buffer,
+	     const std::size_t  size) const
+{
+  return mIssImpl->read (addr, buffer, size);
+
+}	// Iss::read ()
+
+
+//! Write to memory
+
+//! Wrapper for the implementation class.
+
+//! @param[in]  addr    Address to write
+//! @param[in]  buffer  Data to write
+//! @param[in]  size    Number of bytes to write
+//! @return  Number of bytes written
+
+std::size_t
+Iss::write (const uint32_t  addr,
+	      const uint8_t * buffer,
+	      const std::size_t size)
+{
+  return mIssImpl->write (addr, buffer, size);
+
+}	// Iss::write ()
+
+
+//! Insert a matchpoint
+
+//! Wrapper for the implementation class.
+
+//! @param[in] addr  Address at which to set the matchpoint
+//! @param[in] matchType  Type of matchpoint (breakpoint or watchpoint)
+//! @return  TRUE if watchpoint set, FALSE otherwise.
+
+bool
+Iss::insertMatchpoint (const uint32_t  addr,
+			 const MatchType  matchType)
+{
+  return mIssImpl->insertMatchpoint (addr, matchType);
+
+}	// Iss::insertMatchpoint ()
+
+
+//! Remove a matchpoint
+
+//! Wrapper for the implementation class.
+
+//! @param[in] addr  Address from which to clear the matchpoint
+//! @param[in] matchType  Type of matchpoint (breakpoint or watchpoint)
+//! @return  TRUE if watchpoint set, FALSE otherwise.
+
+bool
+Iss::removeMatchpoint (const uint32_t  addr,
+			 const MatchType matchType)
+{
+  return mIssImpl->removeMatchpoint (addr, matchType);
+
+}	// Iss::removeMatchpoint ()
+
+
+//! Add the target's monitor commands to a registry
+
+//! Wrapper for the implementation class.
+
+//! @param[in] reg  The registry
+
+void
+Iss::registerCommands (CommandRegistry & reg)
+{
+  mIssImpl->registerCommands (reg);
+
+}	// Iss::registerCommands ()
+
+
+//! Save a checkpoint file
+
+//! Wrapper for the implementation class.
+
+//! @param[in] filename  The file to write
+//! @return  TRUE if the checkpoint was saved, FALSE otherwise.
+
+bool
+Iss::saveCheckpoint (const std::string & filename)
+{
+  return  mIssImpl->saveCheckpoint (filename);
+
+}	// Iss::saveCheckpoint ()
+
+
+//! Restore a checkpoint file
+
+//! Wrapper for the implementation class.
+
+//! @param[in] filename  The file to read
+//! @return  TRUE if the checkpoint was restored, FALSE otherwise.
+
+bool
+Iss::restoreCheckpoint (const std::string & filename)
+{
+  return  mIssImpl->restoreCheckpoint (filename);
+
+}	// Iss::restoreCheckpoint ()
+
+
+//! Save a snapshot
+
+//! Wrapper for the implementation class.
+
+//! @param[out] state  The saved state
+//! @return  TRUE if the snapshot was taken, FALSE otherwise.
+
+bool
+Iss::saveSnapshot (std::vector<uint8_t> & state)
+{
+  return  mIssImpl->saveSnapshot (state);
+
+}	// Iss::saveSnapshot ()
+
+
+//! Restore a snapshot
+
+//! Wrapper for the implementation class.
+
+//! @param[in] state  State saved by saveSnapshot ()
+//! @return  TRUE if the snapshot was restored, FALSE otherwise.
+
+bool
+Iss::restoreSnapshot (const std::vector<uint8_t> & state)
+{
+  return  mIssImpl->restoreSnapshot (state);
+
+}	// Iss::restoreSnapshot ()
+
+
+//! Wrapper for the implementation class
+
+//! @return  TRUE if the target has threads of its own running, FALSE
+//!          otherwise.
+
+bool
+Iss::threaded () const
+{
+  return  mIssImpl->threaded ();
+
+}	// Iss::threaded ()
+
+
+//! Record the PC of each instruction retired while continuing
+
+//! The ISS is cheap to step, so is never asked to.
+
+//! @param[in] pcs  Where to record the PCs, or nullptr
+//! @return  FALSE, since we do not record them.
+
+bool
+Iss::traceRetired (std::vector<uint32_t> * pcs __attribute__ ((unused)))
+{
+  return  false;
+
+}	// Iss::traceRetired ()
+
+
+//! Wrapper for the implementation class
+
+//! @param[in] server  The server to use
+
+void
+Iss::gdbServer (GdbServer * server)
+{
+  mIssImpl->gdbServer (server);
+
+}	// Iss::gdbServer ()
+
+
+//! Return a timestamp.
+
+//! There is no Verilog here, but the interface needs a time.
+
+//! Pass through to the implementation class.
+
+//! @return  The current simulation time in seconds.
+
+double
+Iss::timeStamp ()
+{
+  return mIssImpl->timeStamp ();
+
+}	// Iss::timeStamp ()
+
+
+//! Stop continuing once a number of instructions have run
+
+//! Wrapper for the implementation class.
+
+//! @param[in] instrCount  Instruction count at which to stop
+
+void
+Iss::stopAt (uint64_t  instrCount)
+{
+  mIssImpl->stopAt (instrCount);
+
+}	// Iss::stopAt ()
+
+
+//! Find all the memory in use
+
+//! Wrapper for the implementation class.
+
+//! @param[out] addrs  The address of every page allocated
+
+void
+Iss::pages (std::vector<uint32_t> & addrs) const
+{
+  mIssImpl->pages (addrs);
+
+}	// Iss::pages ()
+
+
+//! Record stores made by the program
+
+//! Wrapper for the implementation class.
+
+//! @param[in] log  Where to record stores, or nullptr to stop recording.
+
+void
+Iss::logStores (std::vector<std::pair<uint32_t, std::size_t> > * log)
+{
+  mIssImpl->logStores (log);
+
+}	// Iss::logStores ()
+
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// show-trailing-whitespace: t
+// End:
@@ -0,0 +1,143 @@
+// GDB RSP server instruction set simulator wrapper: declaration
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef ISS_H
+#define ISS_H
+
+#include <utility>
+
+#include "ITarget.h"
+
+
+class IssImpl;
+
+
+//! The top level instruction set simulator class.
+
+//! We hide the details away in a separate implementation class, so that this
+//! header has minimal other dependencies.
+
+class Iss final : public ITarget
+{
+ public:
+
+  // Constructor and destructor
+
+  Iss (const TraceFlags * flags);
+  ~Iss ();
+
+  virtual ResumeRes  resume (ResumeType step);
+  virtual ResumeRes  resume (ResumeType step,
+                             std::chrono::duration <double>  timeout);
+
+  virtual ResumeRes  terminate (void);
+  virtual ResumeRes  reset (ITarget::ResetType  type);
+
+  virtual uint64_t  getCycleCount (void) const;
+  virtual uint64_t  getInstrCount (void) const;
+  virtual bool  countsInstrs () const;
+
+  // Limit on continuing
+
+  virtual void  setLimit (LimitType  type,
+			  uint64_t  count);
+
+  // Read contents of a target register.
+
+  virtual std::size_t  readRegister (const int  reg,
+				     uint_reg_t & value) const;
+
+  // Write data to a target register.
+
+  virtual std::size_t  writeRegister (const int  reg,
+				      const uint_reg_t  value);
+
+  // Read data from memory.
+
+  virtual std::size_t  read (const uint32_t  addr,
+			     uint8_t * buffer,
+			     const std::size_t  size) const;
+
+  // Write data to memory.
+
+  virtual std::size_t  write (const uint32_t  addr,
+			      const uint8_t * buffer,
+			      const std::size_t  size);
+
+  // Insert and remove a matchpoint (breakpoint or watchpoint) at the given
+  // address.  Return value indicates whether the operation was successful.
+
+  virtual bool  insertMatchpoint (const uint32_t  addr,
+				  const MatchType  matchType);
+  virtual bool  removeMatchpoint (const uint32_t  addr,
+				  const MatchType  matchType);
+
+  // Monitor commands
+
+  virtual void  registerCommands (CommandRegistry & reg);
+
+  // Checkpoint files
+
+  virtual bool  saveCheckpoint (const std::string & filename);
+  virtual bool  restoreCheckpoint (const std::string & filename);
+
+  // Snapshots
+
+  virtual bool  saveSnapshot (std::vector<uint8_t> & state);
+  virtual bool  restoreSnapshot (const std::vector<uint8_t> & state);
+
+  // Threads
+
+  virtual bool  threaded () const;
+
+  // Retired instructions
+
+  virtual bool  traceRetired (std::vector<uint32_t> * pcs);
+
+  // Identify the server
+
+  void gdbServer (GdbServer *server);
+
+  // Verilator support
+
+  virtual double timeStamp ();
+
+  // Support for use alongside another target
+
+  void  stopAt (uint64_t  instrCount);
+  void  pages (std::vector<uint32_t> & addrs) const;
+  void  logStores (std::vector<std::pair<uint32_t, std::size_t> > * log);
+
+
+ private:
+
+  //! The implementation class for Iss
+
+  IssImpl * mIssImpl;
+
+};	// class Iss
+
+
+#endif	// ISS_H
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// show-trailing-whitespace: t
+// End:
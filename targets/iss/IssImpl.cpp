@@ -0,0 +1,2307 @@
+// GDB RSP server instruction set simulator: definition
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+#include "CheckpointFile.h"
+#include "CommandRegistry.h"
+#include "GdbServer.h"
+#include "InstrTrace.h"
+#include "IssImpl.h"
+#include "TraceFlags.h"
+
+using std::chrono::duration;
+using std::chrono::system_clock;
+using std::chrono::time_point;
+using std::cerr;
+using std::endl;
+using std::string;
+using std::vector;
+
+
+//! Constructor.
+
+//! Memory starts empty, and is allocated as it is written.
+
+//! @param[in] flags  The trace flags
+
+IssImpl::IssImpl (const TraceFlags * flags) :
+  mStopCount (std::numeric_limits<uint64_t>::max ()),
+  mCycleLimit (ITarget::NO_LIMIT),
+  mInstrLimit (ITarget::NO_LIMIT),
+  mStoreLog (nullptr),
+  mProfiler (1.0e9),
+  mTrace (nullptr),
+  mFlags (flags),
+  mServer (nullptr)
+{
+  for (uint32_t  i = 0; i < DIR_SIZE; i++)
+    mPageDir[i] = nullptr;
+
+  for (std::size_t  i = 0; i < BLOCK_CACHE_SIZE; i++)
+    mBlockCache[i] = nullptr;
+
+  mInstrCnt = 0;
+  resetState ();
+
+  if (mFlags->traceDisas ())
+    mTrace = new InstrTrace ("gdbserver-iss.trace", sizeof (uint_reg_t));
+
+}	// IssImpl::IssImpl ()
+
+
+//! Destructor
+
+IssImpl::~IssImpl ()
+{
+  delete mTrace;
+  clearMemory ();
+
+}	// IssImpl::~IssImpl ()
+
+
+//! Resume execution with no timeout
+
+//! @param[in]  step  The type of resume to carry out.
+//! @return Why the target stopped.
+
+ITarget::ResumeRes
+IssImpl::resume (ITarget::ResumeType step)
+{
+  return resume (step, duration <double>::zero());
+
+}	// IssImpl::resume ()
+
+
+//! Resume execution with timeout
+
+//! A single step executes one instruction. Continuing runs until a
+//! breakpoint, a syscall, an illegal instruction, the instruction count
+//! set by stopAt or a limit set by setLimit, checking for timeout every so
+//! many instructions.
+
+//! @param[in]  step     The type of resume to carry out.
+//! @param[in]  timeout  Maximum time for execution to continue.
+//! @return Why the target stopped.
+
+ITarget::ResumeRes
+IssImpl::resume (ITarget::ResumeType step,
+		 duration <double>  timeout)
+{
+  switch (step)
+    {
+    case ITarget::ResumeType::STEP:
+
+      {
+	ITarget::ResumeRes  res = execute (1, true);
+	return (ITarget::ResumeRes::NONE == res)
+	  ? ITarget::ResumeRes::STEPPED : res;
+      }
+
+    case ITarget::ResumeType::CONTINUE:
+
+      {
+	bool haveTimeout = duration <double>::zero() != timeout;
+	time_point <system_clock, duration <double> > timeout_end;
+
+	if (haveTimeout)
+	  timeout_end = system_clock::now () + timeout;
+
+	bool  skipBreak = true;
+	uint64_t  limit = std::min (mCycleLimit, mInstrLimit);
+
+	while (true)
+	  {
+	    uint64_t  budget = RUN_SAMPLE_INSNS;
+
+	    if (mInstrCnt >= mStopCount)
+	      return ITarget::ResumeRes::INTERRUPTED;
+	    else if (mStopCount - mInstrCnt < budget)
+	      budget = mStopCount - mInstrCnt;
+
+	    if (mInstrCnt >= limit)
+	      return ITarget::ResumeRes::LIMIT;
+	    else if (limit - mInstrCnt < budget)
+	      budget = limit - mInstrCnt;
+
+	    ITarget::ResumeRes  res = execute (budget, skipBreak);
+
+	    if (ITarget::ResumeRes::NONE != res)
+	      return res;
+
+	    skipBreak = false;
+
+	    if (haveTimeout && (system_clock::now () > timeout_end))
+	      return ITarget::ResumeRes::TIMEOUT;
+	  }
+      }
+
+    case ITarget::ResumeType::STOP:
+
+      // We are never left running, so there is nothing to stop.
+
+      return ITarget::ResumeRes::SUCCESS;
+
+    default:
+
+      // Eek!
+
+      cerr << "*** ABORT ***: Unknown step type when resuming: "
+	   << static_cast<int> (step) << endl;
+      exit (EXIT_FAILURE);
+    }
+}	// IssImpl::resume ()
+
+
+//! Terminate.
+
+//! This has no meaning for an embedded system, so it does nothing.
+
+ITarget::ResumeRes
+IssImpl::terminate ()
+{
+  return  ITarget::ResumeRes::NONE;
+
+}	// IssImpl::terminate ()
+
+
+//! Reset
+
+//! A warm reset puts the registers back to their reset values. A cold reset
+//! also clears memory and the counters, as if the target had been recreated.
+
+//! @param[in]  type  Type of reset (can be warm or cold)
+//! @return  Whether the reset was successful, which is always SUCCESS
+
+ITarget::ResumeRes
+IssImpl::reset (ITarget::ResetType  type)
+{
+  if (type == ITarget::ResetType::COLD)
+    {
+      clearMemory ();
+      mInstrCnt = 0;
+    }
+
+  resetState ();
+  return ITarget::ResumeRes::SUCCESS;
+
+}	// IssImpl::reset ()
+
+
+//! Accessor for the cycle count
+
+//! Every instruction takes one cycle.
+
+//! @return  The number of cycles executed since startup or the last cold
+//!          reset.
+
+uint64_t
+IssImpl::getCycleCount () const
+{
+  return mInstrCnt;
+
+}	// IssImpl::getCycleCount ()
+
+
+//! Accessor for the instruction count
+
+//! @return  The number of instructions executed since startup or the last
+//!          cold reset.
+
+uint64_t
+IssImpl::getInstrCount () const
+{
+  return mInstrCnt;
+
+}	// IssImpl::getInstrCount ()
+
+
+//! Set a limit on continuing
+
+//! Each instruction takes a cycle, so both limits are on the instruction
+//! count.
+
+//! @param[in] type   Whether the limit is on cycles or instructions
+//! @param[in] count  The count at which to stop, or NO_LIMIT
+
+void
+IssImpl::setLimit (ITarget::LimitType  type,
+		   uint64_t  count)
+{
+  if (ITarget::LimitType::CYCLES == type)
+    mCycleLimit = count;
+  else
+    mInstrLimit = count;
+
+}	// IssImpl::setLimit ()
+
+
+//! Read a register
+
+//! GDB numbers the CSRs from 65.
+
+//! @param[in]  reg    The register to read
+//! @param[out] value  The value read
+//! @return  The size of the register read in bytes
+
+std::size_t
+IssImpl::readRegister (const int  reg,
+		       uint_reg_t & value) const
+{
+  if ((REG_R0 <= reg) && (reg <= REG_R31))
+    value = mX[reg];
+  else if (REG_PC == reg)
+    value = mPc;
+  else if ((REG_CSR0 <= reg) && (reg <= REG_CSR4095))
+    value = readCsr (static_cast<uint16_t> (reg - REG_CSR0));
+  else
+    {
+      cerr << "Warning: Attempt to read non-existent register "
+           << reg << ": zero returned."
+	   << endl;
+      value = 0;
+    }
+
+  return sizeof (uint_reg_t);
+
+}	// IssImpl::readRegister ()
+
+
+//! Write a register
+
+//! @param[in]  reg    The register to write
+//! @param[in]  value  The value to write
+//! @return  The size of the register written in bytes
+
+std::size_t
+IssImpl::writeRegister (const int  reg,
+			const uint_reg_t  value)
+{
+  if ((REG_R0 < reg) && (reg <= REG_R31))
+    mX[reg] = value;
+  else if (REG_R0 == reg)
+    ;					// Writes to x0 are ignored
+  else if (REG_PC == reg)
+    mPc = value;
+  else if ((REG_CSR0 <= reg) && (reg <= REG_CSR4095))
+    writeCsr (static_cast<uint16_t> (reg - REG_CSR0), value);
+  else
+    cerr << "Warning: Attempt to write non-existent register "
+	 << reg << ": ignored." << endl;
+
+  return sizeof (uint_reg_t);
+
+}	// IssImpl::writeRegister ()
+
+
+//! Read from memory
+
+//! Memory which has never been written reads as zero.
+
+//! @param[in]  addr    Address to read
+//! @param[out] buffer  Where to put the result of the read
+//! @param[in]  size    Number of bytes to read
+//! @return  Number of bytes read
+
+std::size_t
+IssImpl::read (const uint32_t addr,
+	       uint8_t * buffer,
+	       const std::size_t  size) const
+{
+  std::size_t  done = 0;
+
+  while (done < size)
+    {
+      uint32_t  a = addr + done;
+      uint32_t  off = a & (PAGE_SIZE - 1);
+      std::size_t  n = std::min (size - done,
+				 static_cast<std::size_t> (PAGE_SIZE - off));
+      const Page * page = findPage (a);
+
+      if (nullptr == page)
+	memset (buffer + done, 0, n);
+      else
+	memcpy (buffer + done, page->data + off, n);
+
+      done += n;
+    }
+
+  return size;
+
+}	// IssImpl::read ()
+
+
+//! Write to memory
+
+//! Any decoded code in the memory written is thrown away.
+
+//! @param[in]  addr    Address to write
+//! @param[in]  buffer  Data to write
+//! @param[in]  size    Number of bytes to write
+//! @return  Number of bytes written
+
+std::size_t
+IssImpl::write (const uint32_t  addr,
+		const uint8_t * buffer,
+		const std::size_t size)
+{
+  std::size_t  done = 0;
+
+  while (done < size)
+    {
+      uint32_t  a = addr + done;
+      uint32_t  off = a & (PAGE_SIZE - 1);
+      std::size_t  n = std::min (size - done,
+				 static_cast<std::size_t> (PAGE_SIZE - off));
+      Page * page = getPage (a);
+
+      memcpy (page->data + off, buffer + done, n);
+
+      if (page->hasCode)
+	invalidatePage (page);
+
+      done += n;
+    }
+
+  return size;
+
+}	// IssImpl::write ()
+
+
+//! Insert a matchpoint
+
+//! Only breakpoints are supported. Blocks end before a breakpoint, so the
+//! decoded code is thrown away.
+
+//! @param[in] addr       Address at which to set the matchpoint
+//! @param[in] matchType  Type of matchpoint (breakpoint or watchpoint)
+//! @return  TRUE if the matchpoint was set, FALSE otherwise.
+
+bool
+IssImpl::insertMatchpoint (const uint32_t  addr,
+			   const ITarget::MatchType  matchType)
+{
+  switch (matchType)
+    {
+    case ITarget::MatchType::BREAK:
+    case ITarget::MatchType::BREAK_HW:
+
+      mBreakpoints.insert (addr);
+      flushBlocks ();
+      return true;
+
+    default:
+
+      return false;
+    }
+}	// IssImpl::insertMatchpoint ()
+
+
+//! Remove a matchpoint
+
+//! @param[in] addr       Address from which to clear the matchpoint
+//! @param[in] matchType  Type of matchpoint (breakpoint or watchpoint)
+//! @return  TRUE if the matchpoint was removed, FALSE otherwise.
+
+bool
+IssImpl::removeMatchpoint (const uint32_t  addr,
+			   const ITarget::MatchType  matchType)
+{
+  switch (matchType)
+    {
+    case ITarget::MatchType::BREAK:
+    case ITarget::MatchType::BREAK_HW:
+
+      if (mBreakpoints.erase (addr) == 0)
+	return false;
+
+      flushBlocks ();
+      return true;
+
+    default:
+
+      return false;
+    }
+}	// IssImpl::removeMatchpoint ()
+
+
+//! Add the target's monitor commands to a registry
+
+//! The commands are those of the profiler and coverage.
+
+//! @param[in] reg  The registry
+
+void
+IssImpl::registerCommands (CommandRegistry & reg)
+{
+  reg.add ("profile", Profiler::HELP,
+	   [this] (const CommandArgs & args, std::ostream & stream)
+	   { return mProfiler.command (args, stream); });
+  reg.add ("coverage", Coverage::HELP,
+	   [this] (const CommandArgs & args, std::ostream & stream)
+	   { return mCoverage.command (args, stream); });
+
+}	// IssImpl::registerCommands ()
+
+
+//! Save a checkpoint file
+
+//! The state is the same as a snapshot. The checkpoint file code comes with
+//! Verilator's save and restore support, so is only there for savable
+//! builds.
+
+//! @param[in] filename  The file to write
+//! @return  TRUE if the checkpoint was saved, FALSE otherwise.
+
+bool
+IssImpl::saveCheckpoint (const std::string & filename)
+{
+#ifdef HAVE_SAVABLE_MODELS
+  vector<uint8_t>  state;
+  CheckpointWriter  ckpt;
+
+  saveSnapshot (state);
+
+  if (! ckpt.open (filename, "ISS", mInstrCnt, mInstrCnt, mInstrCnt))
+    return  false;
+
+  uint64_t  stateSize = state.size ();
+
+  ckpt.write (&stateSize, sizeof (stateSize));
+  ckpt.write (state.data (), state.size ());
+  ckpt.close ();
+  return  ckpt.ok ();
+
+#else
+  cerr << "Warning: Checkpoint files need savable models: checkpoint "
+       << filename << " not written" << endl;
+  return  false;
+
+#endif
+}	// IssImpl::saveCheckpoint ()
+
+
+//! Restore a checkpoint file
+
+//! @param[in] filename  The file to read
+//! @return  TRUE if the checkpoint was restored, FALSE otherwise.
+
+bool
+IssImpl::restoreCheckpoint (const std::string & filename)
+{
+#ifdef HAVE_SAVABLE_MODELS
+  CheckpointReader  ckpt;
+
+  if (! ckpt.open (filename, "ISS"))
+    return  false;
+
+  uint64_t  stateSize = 0;
+
+  ckpt.read (&stateSize, sizeof (stateSize));
+
+  vector<uint8_t>  state (stateSize);
+
+  ckpt.read (state.data (), state.size ());
+
+  if (! ckpt.complete () || ! restoreSnapshot (state))
+    {
+      cerr << "Warning: Checkpoint " << filename
+	   << " does not match model: state undefined" << endl;
+      return  false;
+    }
+
+  return  true;
+
+#else
+  cerr << "Warning: Checkpoint files need savable models: checkpoint "
+       << filename << " not restored" << endl;
+  return  false;
+
+#endif
+}	// IssImpl::restoreCheckpoint ()
+
+
+//! Save a snapshot
+
+//! The registers, CSRs and counters, followed by every page of memory.
+
+//! @param[out] state  The saved state
+//! @return  TRUE if the snapshot was taken, which it always is.
+
+bool
+IssImpl::saveSnapshot (std::vector<uint8_t> & state)
+{
+  state.clear ();
+
+  auto put = [&state] (const void * p, std::size_t  n)
+    {
+      const uint8_t * b = static_cast<const uint8_t *> (p);
+      state.insert (state.end (), b, b + n);
+    };
+
+  uint32_t  version = STATE_VERSION;
+  uint32_t  xlen = XLEN;
+  uint32_t  numCsrs = mCsrs.size ();
+
+  put (&version, sizeof (version));
+  put (&xlen, sizeof (xlen));
+  put (mX, sizeof (mX));
+  put (&mPc, sizeof (mPc));
+  put (&mInstrCnt, sizeof (mInstrCnt));
+  put (&numCsrs, sizeof (numCsrs));
+
+  for (auto it = mCsrs.begin (); it != mCsrs.end (); it++)
+    {
+      put (&(it->first), sizeof (it->first));
+      put (&(it->second), sizeof (it->second));
+    }
+
+  for (uint32_t  d = 0; d < DIR_SIZE; d++)
+    {
+      if (nullptr == mPageDir[d])
+	continue;
+
+      for (uint32_t  p = 0; p < DIR_SIZE; p++)
+	{
+	  const Page * page = mPageDir[d][p];
+
+	  if (nullptr == page)
+	    continue;
+
+	  uint32_t  addr = ((d << DIR_BITS) | p) << PAGE_BITS;
+
+	  put (&addr, sizeof (addr));
+	  put (page->data, PAGE_SIZE);
+	}
+    }
+
+  return  true;
+
+}	// IssImpl::saveSnapshot ()
+
+
+//! Restore a snapshot
+
+//! Memory is cleared first, so pages allocated since the snapshot go.
+
+//! @param[in] state  State previously saved by saveSnapshot
+//! @return  TRUE if the snapshot was restored, FALSE otherwise.
+
+bool
+IssImpl::restoreSnapshot (const std::vector<uint8_t> & state)
+{
+  std::size_t  pos = 0;
+
+  auto get = [&state, &pos] (void * p, std::size_t  n)
+    {
+      if (pos + n > state.size ())
+	return false;
+
+      memcpy (p, state.data () + pos, n);
+      pos += n;
+      return true;
+    };
+
+  uint32_t  version;
+  uint32_t  xlen;
+  uint32_t  numCsrs;
+
+  if (! get (&version, sizeof (version)) || (STATE_VERSION != version)
+      || ! get (&xlen, sizeof (xlen)) || (XLEN != xlen))
+    {
+      cerr << "Warning: Snapshot is not for this ISS: not restored" << endl;
+      return  false;
+    }
+
+  clearMemory ();
+  mCsrs.clear ();
+
+  bool  ok = get (mX, sizeof (mX))
+    && get (&mPc, sizeof (mPc))
+    && get (&mInstrCnt, sizeof (mInstrCnt))
+    && get (&numCsrs, sizeof (numCsrs));
+
+  for (uint32_t  i = 0; ok && (i < numCsrs); i++)
+    {
+      uint16_t  csr;
+      uint_reg_t  val;
+
+      ok = get (&csr, sizeof (csr)) && get (&val, sizeof (val));
+
+      if (ok)
+	mCsrs[csr] = val;
+    }
+
+  while (ok && (pos < state.size ()))
+    {
+      uint32_t  addr;
+
+      ok = get (&addr, sizeof (addr)) && get (getPage (addr)->data, PAGE_SIZE);
+    }
+
+  if (! ok)
+    {
+      cerr << "Warning: Snapshot does not match ISS: state undefined" << endl;
+      return  false;
+    }
+
+  return  true;
+
+}	// IssImpl::restoreSnapshot ()
+
+
+//! Does the target have threads of its own running?
+
+//! The instruction trace is written by a thread of its own.
+
+//! @return  TRUE if the target has threads of its own running, FALSE
+//!          otherwise.
+
+bool
+IssImpl::threaded () const
+{
+  return  nullptr != mTrace;
+
+}	// IssImpl::threaded ()
+
+
+//! Wrapper for the implementation class
+
+//! @param[in] server  The server to use
+
+void
+IssImpl::gdbServer (GdbServer * server)
+{
+  mServer = server;
+
+}	// IssImpl::gdbServer ()
+
+
+//! Provide a time stamp
+
+//! We count in nanoseconds since (cold) reset, as if at 1 GHz.
+
+//! @return  The time in nanoseconds
+
+double
+IssImpl::timeStamp ()
+{
+  return static_cast<double> (mInstrCnt);
+
+}	// IssImpl::timeStamp ()
+
+
+//! Stop continuing once a number of instructions have run
+
+//! Continuing from this count or beyond stops at once, as if interrupted.
+
+//! @param[in] instrCount  Instruction count at which to stop
+
+void
+IssImpl::stopAt (uint64_t  instrCount)
+{
+  mStopCount = instrCount;
+
+}	// IssImpl::stopAt ()
+
+
+//! Find all the memory in use
+
+//! Memory outside these pages has never been written, so reads as zero.
+
+//! @param[out] addrs  The address of every page allocated, in order
+
+void
+IssImpl::pages (std::vector<uint32_t> & addrs) const
+{
+  addrs.clear ();
+
+  for (uint32_t  d = 0; d < DIR_SIZE; d++)
+    if (nullptr != mPageDir[d])
+      for (uint32_t  p = 0; p < DIR_SIZE; p++)
+	if (nullptr != mPageDir[d][p])
+	  addrs.push_back (((d << DIR_BITS) | p) << PAGE_BITS);
+
+}	// IssImpl::pages ()
+
+
+//! Record stores made by the program
+
+//! Each store the program makes is appended to the log, until a null log is
+//! given. Writes by the debugger are not recorded.
+
+//! @param[in] log  Where to record the address and size of each store, or
+//!                 nullptr to stop recording.
+
+void
+IssImpl::logStores (std::vector<std::pair<uint32_t, std::size_t> > * log)
+{
+  mStoreLog = log;
+
+}	// IssImpl::logStores ()
+
+
+//! Sign extend the low 32 bits of a value
+
+static inline uint_reg_t
+sext32 (uint_reg_t  val)
+{
+  return static_cast<uint_reg_t> (static_cast<int32_t> (val));
+
+}	// sext32 ()
+
+
+//! Upper half of a signed multiply
+
+template <typename S, typename W>
+static inline S
+mulhs (S  a,
+       S  b)
+{
+  return static_cast<S> ((static_cast<W> (a) * static_cast<W> (b))
+			 >> (sizeof (S) * 8));
+
+}	// mulhs ()
+
+
+//! Signed division, with the RISC-V results for divide by zero and overflow
+
+template <typename S>
+static inline S
+divs (S  a,
+      S  b)
+{
+  if (0 == b)
+    return -1;
+  else if ((-1 == b) && (std::numeric_limits<S>::min () == a))
+    return a;
+  else
+    return a / b;
+
+}	// divs ()
+
+
+//! Signed remainder, with the RISC-V results for divide by zero and overflow
+
+template <typename S>
+static inline S
+rems (S  a,
+      S  b)
+{
+  if (0 == b)
+    return a;
+  else if ((-1 == b) && (std::numeric_limits<S>::min () == a))
+    return 0;
+  else
+    return a % b;
+
+}	// rems ()
+
+
+//! Run instructions
+
+//! Whole blocks are run at a time, ending early only when the budget of
+//! instructions runs out, or a store writes the block being run. Anything
+//! which stops execution is always the last instruction in its block. A
+//! breakpoint or illegal instruction stops without being executed.
+
+//! @param[in] maxInsns   The most instructions to run
+//! @param[in] skipBreak  If TRUE, a breakpoint at the current PC is ignored,
+//!                       so we can resume from it.
+//! @return  Why we stopped, or NONE if we ran all the instructions.
+
+ITarget::ResumeRes
+IssImpl::execute (uint64_t  maxInsns,
+		  bool      skipBreak)
+{
+  uint_reg_t * x = mX;
+  uint_reg_t  pc = mPc;
+  uint64_t  done = 0;
+  InstrTrace * const  trace = mTrace;
+  ITarget::ResumeRes  res = ITarget::ResumeRes::NONE;
+
+  while ((done < maxInsns) && (ITarget::ResumeRes::NONE == res))
+    {
+      uint32_t  pc32 = static_cast<uint32_t> (pc);
+
+      if (! skipBreak && ! mBreakpoints.empty ()
+	  && (mBreakpoints.count (pc32) > 0))
+	{
+	  res = ITarget::ResumeRes::INTERRUPTED;
+	  break;
+	}
+
+      skipBreak = false;
+
+      Block * blk = lookupBlock (pc32);
+      const Insn * start = blk->insns.data ();
+      const Insn * end = start + blk->insns.size ();
+      const Insn * in;
+
+      if (static_cast<uint64_t> (end - start) > maxInsns - done)
+	end = start + (maxInsns - done);
+
+      for (in = start; in < end; in++)
+	{
+	  uint_reg_t  npc = pc + in->len;
+	  uint_reg_t  a;
+
+	  switch (in->op)
+	    {
+	    case Op::NOP:
+	      break;
+
+	    case Op::LUI:
+	      x[in->rd] = in->imm;
+	      break;
+
+	    case Op::AUIPC:
+	      x[in->rd] = pc + in->imm;
+	      break;
+
+	    case Op::JAL:
+	      x[in->rd] = npc;
+	      npc = pc + in->imm;
+	      break;
+
+	    case Op::JALR:
+	      a = (x[in->rs1] + in->imm) & ~static_cast<uint_reg_t> (1);
+	      x[in->rd] = npc;
+	      npc = a;
+	      break;
+
+	    case Op::BEQ:
+	      if (x[in->rs1] == x[in->rs2])
+		npc = pc + in->imm;
+	      break;
+
+	    case Op::BNE:
+	      if (x[in->rs1] != x[in->rs2])
+		npc = pc + in->imm;
+	      break;
+
+	    case Op::BLT:
+	      if (static_cast<sreg_t> (x[in->rs1])
+		  < static_cast<sreg_t> (x[in->rs2]))
+		npc = pc + in->imm;
+	      break;
+
+	    case Op::BGE:
+	      if (static_cast<sreg_t> (x[in->rs1])
+		  >= static_cast<sreg_t> (x[in->rs2]))
+		npc = pc + in->imm;
+	      break;
+
+	    case Op::BLTU:
+	      if (x[in->rs1] < x[in->rs2])
+		npc = pc + in->imm;
+	      break;
+
+	    case Op::BGEU:
+	      if (x[in->rs1] >= x[in->rs2])
+		npc = pc + in->imm;
+	      break;
+
+	    case Op::LB:
+	      x[in->rd] = static_cast<sreg_t> (static_cast<int8_t> (
+		load<uint8_t> (x[in->rs1] + in->imm)));
+	      break;
+
+	    case Op::LH:
+	      x[in->rd] = static_cast<sreg_t> (static_cast<int16_t> (
+		load<uint16_t> (x[in->rs1] + in->imm)));
+	      break;
+
+	    case Op::LW:
+	      x[in->rd] = static_cast<sreg_t> (static_cast<int32_t> (
+		load<uint32_t> (x[in->rs1] + in->imm)));
+	      break;
+
+	    case Op::LBU:
+	      x[in->rd] = load<uint8_t> (x[in->rs1] + in->imm);
+	      break;
+
+	    case Op::LHU:
+	      x[in->rd] = load<uint16_t> (x[in->rs1] + in->imm);
+	      break;
+
+	    case Op::LWU:
+	      x[in->rd] = load<uint32_t> (x[in->rs1] + in->imm);
+	      break;
+
+	    case Op::LD:
+	      x[in->rd] = static_cast<uint_reg_t> (
+		load<uint64_t> (x[in->rs1] + in->imm));
+	      break;
+
+	    case Op::SB:
+	      store<uint8_t> (x[in->rs1] + in->imm, x[in->rs2]);
+	      if (! blk->valid)
+		end = in + 1;
+	      break;
+
+	    case Op::SH:
+	      store<uint16_t> (x[in->rs1] + in->imm, x[in->rs2]);
+	      if (! blk->valid)
+		end = in + 1;
+	      break;
+
+	    case Op::SW:
+	      store<uint32_t> (x[in->rs1] + in->imm, x[in->rs2]);
+	      if (! blk->valid)
+		end = in + 1;
+	      break;
+
+	    case Op::SD:
+	      store<uint64_t> (x[in->rs1] + in->imm, x[in->rs2]);
+	      if (! blk->valid)
+		end = in + 1;
+	      break;
+
+	    case Op::ADDI:
+	      x[in->rd] = x[in->rs1] + in->imm;
+	      break;
+
+	    case Op::SLTI:
+	      x[in->rd] = static_cast<sreg_t> (x[in->rs1]) < in->imm;
+	      break;
+
+	    case Op::SLTIU:
+	      x[in->rd] = x[in->rs1] < static_cast<uint_reg_t> (in->imm);
+	      break;
+
+	    case Op::XORI:
+	      x[in->rd] = x[in->rs1] ^ in->imm;
+	      break;
+
+	    case Op::ORI:
+	      x[in->rd] = x[in->rs1] | in->imm;
+	      break;
+
+	    case Op::ANDI:
+	      x[in->rd] = x[in->rs1] & in->imm;
+	      break;
+
+	    case Op::SLLI:
+	      x[in->rd] = x[in->rs1] << in->imm;
+	      break;
+
+	    case Op::SRLI:
+	      x[in->rd] = x[in->rs1] >> in->imm;
+	      break;
+
+	    case Op::SRAI:
+	      x[in->rd] = static_cast<sreg_t> (x[in->rs1]) >> in->imm;
+	      break;
+
+	    case Op::ADD:
+	      x[in->rd] = x[in->rs1] + x[in->rs2];
+	      break;
+
+	    case Op::SUB:
+	      x[in->rd] = x[in->rs1] - x[in->rs2];
+	      break;
+
+	    case Op::SLL:
+	      x[in->rd] = x[in->rs1] << (x[in->rs2] & (XLEN - 1));
+	      break;
+
+	    case Op::SLT:
+	      x[in->rd] = static_cast<sreg_t> (x[in->rs1])
+		< static_cast<sreg_t> (x[in->rs2]);
+	      break;
+
+	    case Op::SLTU:
+	      x[in->rd] = x[in->rs1] < x[in->rs2];
+	      break;
+
+	    case Op::XOR:
+	      x[in->rd] = x[in->rs1] ^ x[in->rs2];
+	      break;
+
+	    case Op::SRL:
+	      x[in->rd] = x[in->rs1] >> (x[in->rs2] & (XLEN - 1));
+	      break;
+
+	    case Op::SRA:
+	      x[in->rd] = static_cast<sreg_t> (x[in->rs1])
+		>> (x[in->rs2] & (XLEN - 1));
+	      break;
+
+	    case Op::OR:
+	      x[in->rd] = x[in->rs1] | x[in->rs2];
+	      break;
+
+	    case Op::AND:
+	      x[in->rd] = x[in->rs1] & x[in->rs2];
+	      break;
+
+	    case Op::ADDIW:
+	      x[in->rd] = sext32 (x[in->rs1] + in->imm);
+	      break;
+
+	    case Op::SLLIW:
+	      x[in->rd] = sext32 (static_cast<uint32_t> (x[in->rs1])
+				  << in->imm);
+	      break;
+
+	    case Op::SRLIW:
+	      x[in->rd] = sext32 (static_cast<uint32_t> (x[in->rs1])
+				  >> in->imm);
+	      break;
+
+	    case Op::SRAIW:
+	      x[in->rd] = sext32 (static_cast<int32_t> (x[in->rs1])
+				  >> in->imm);
+	      break;
+
+	    case Op::ADDW:
+	      x[in->rd] = sext32 (x[in->rs1] + x[in->rs2]);
+	      break;
+
+	    case Op::SUBW:
+	      x[in->rd] = sext32 (x[in->rs1] - x[in->rs2]);
+	      break;
+
+	    case Op::SLLW:
+	      x[in->rd] = sext32 (static_cast<uint32_t> (x[in->rs1])
+				  << (x[in->rs2] & 31));
+	      break;
+
+	    case Op::SRLW:
+	      x[in->rd] = sext32 (static_cast<uint32_t> (x[in->rs1])
+				  >> (x[in->rs2] & 31));
+	      break;
+
+	    case Op::SRAW:
+	      x[in->rd] = sext32 (static_cast<int32_t> (x[in->rs1])
+				  >> (x[in->rs2] & 31));
+	      break;
+
+	    case Op::MUL:
+	      x[in->rd] = x[in->rs1] * x[in->rs2];
+	      break;
+
+#ifdef BUILD_64_BIT
+	    case Op::MULH:
+	      x[in->rd] = mulhs<int64_t, __int128> (x[in->rs1], x[in->rs2]);
+	      break;
+
+	    case Op::MULHSU:
+	      x[in->rd] = static_cast<uint64_t> (
+		(static_cast<__int128> (static_cast<int64_t> (x[in->rs1]))
+		 * static_cast<__int128> (x[in->rs2])) >> 64);
+	      break;
+
+	    case Op::MULHU:
+	      x[in->rd] = mulhs<uint64_t, unsigned __int128> (x[in->rs1],
+							      x[in->rs2]);
+	      break;
+#else
+	    case Op::MULH:
+	      x[in->rd] = mulhs<int32_t, int64_t> (x[in->rs1], x[in->rs2]);
+	      break;
+
+	    case Op::MULHSU:
+	      x[in->rd] = static_cast<uint32_t> (
+		(static_cast<int64_t> (static_cast<int32_t> (x[in->rs1]))
+		 * static_cast<int64_t> (x[in->rs2])) >> 32);
+	      break;
+
+	    case Op::MULHU:
+	      x[in->rd] = mulhs<uint32_t, uint64_t> (x[in->rs1], x[in->rs2]);
+	      break;
+#endif
+
+	    case Op::DIV:
+	      x[in->rd] = divs<sreg_t> (x[in->rs1], x[in->rs2]);
+	      break;
+
+	    case Op::DIVU:
+	      x[in->rd] = (0 == x[in->rs2])
+		? ~static_cast<uint_reg_t> (0) : x[in->rs1] / x[in->rs2];
+	      break;
+
+	    case Op::REM:
+	      x[in->rd] = rems<sreg_t> (x[in->rs1], x[in->rs2]);
+	      break;
+
+	    case Op::REMU:
+	      x[in->rd] = (0 == x[in->rs2])
+		? x[in->rs1] : x[in->rs1] % x[in->rs2];
+	      break;
+
+	    case Op::MULW:
+	      x[in->rd] = sext32 (static_cast<uint32_t> (x[in->rs1])
+				  * static_cast<uint32_t> (x[in->rs2]));
+	      break;
+
+	    case Op::DIVW:
+	      x[in->rd] = sext32 (divs<int32_t> (x[in->rs1], x[in->rs2]));
+	      break;
+
+	    case Op::DIVUW:
+	      {
+		uint32_t  a32 = x[in->rs1];
+		uint32_t  b32 = x[in->rs2];
+		x[in->rd] = sext32 ((0 == b32) ? ~0U : a32 / b32);
+	      }
+	      break;
+
+	    case Op::REMW:
+	      x[in->rd] = sext32 (rems<int32_t> (x[in->rs1], x[in->rs2]));
+	      break;
+
+	    case Op::REMUW:
+	      {
+		uint32_t  a32 = x[in->rs1];
+		uint32_t  b32 = x[in->rs2];
+		x[in->rd] = sext32 ((0 == b32) ? a32 : a32 % b32);
+	      }
+	      break;
+
+	    case Op::ECALL:
+	      res = ITarget::ResumeRes::SYSCALL;
+	      break;
+
+	    case Op::EBREAK:
+	      if (isSyscall (static_cast<uint32_t> (pc)))
+		res = ITarget::ResumeRes::SYSCALL;
+	      else
+		{
+		  // A breakpoint, which is not executed
+
+		  x[0] = 0;
+		  mPc = pc;
+		  mInstrCnt += done + (in - start);
+		  return ITarget::ResumeRes::INTERRUPTED;
+		}
+	      break;
+
+	    case Op::MRET:
+	      npc = readCsr (CSR_MEPC);
+	      break;
+
+	    case Op::WFI:
+	      break;
+
+	    case Op::CSRRW:
+	    case Op::CSRRWI:
+	      {
+		uint16_t  csr = static_cast<uint16_t> (in->imm);
+		uint_reg_t  val = (Op::CSRRW == in->op)
+		  ? x[in->rs1] : in->rs1;
+
+		if (0 != in->rd)
+		  x[in->rd] = readCsr (csr);
+
+		writeCsr (csr, val);
+	      }
+	      break;
+
+	    case Op::CSRRS:
+	    case Op::CSRRC:
+	    case Op::CSRRSI:
+	    case Op::CSRRCI:
+	      {
+		uint16_t  csr = static_cast<uint16_t> (in->imm);
+		uint_reg_t  old = readCsr (csr);
+		uint_reg_t  mask = ((Op::CSRRS == in->op)
+				    || (Op::CSRRC == in->op))
+		  ? x[in->rs1] : in->rs1;
+
+		if (0 != in->rs1)
+		  {
+		    if ((Op::CSRRS == in->op) || (Op::CSRRSI == in->op))
+		      writeCsr (csr, old | mask);
+		    else
+		      writeCsr (csr, old & ~mask);
+		  }
+
+		x[in->rd] = old;
+	      }
+	      break;
+
+	    case Op::ILLEGAL:
+	      cerr << "Warning: Illegal instruction at 0x" << std::hex
+		   << static_cast<uint32_t> (pc) << std::dec
+		   << ": execution stopped" << endl;
+	      x[0] = 0;
+	      mPc = pc;
+	      mInstrCnt += done + (in - start);
+	      return ITarget::ResumeRes::INTERRUPTED;
+	    }
+
+	  if (nullptr != trace)
+	    traceInsn (pc, *in);
+
+	  pc = npc;
+	}
+
+      x[0] = 0;
+      done += in - start;
+
+      // A block only needs covering once for each generation of the coverage
+      // bitmap, so the cost is per block, not per instruction.
+
+      if (blk->covered != mCoverage.generation ())
+	coverBlock (blk, in - start);
+
+      // Samples are attributed to the start of the block, which is close
+      // enough for a histogram of functions.
+
+      if (mProfiler.tick (in - start))
+	mProfiler.sample (pc32);
+    }
+
+  mPc = pc;
+  mInstrCnt += done;
+  return  res;
+
+}	// IssImpl::execute ()
+
+
+//! Record the instructions of a block as covered
+
+//! If the whole block was executed, it need not be covered again until the
+//! coverage bitmap is cleared.
+
+//! @param[in] blk  The block
+//! @param[in] n    Number of instructions of the block executed
+
+void
+IssImpl::coverBlock (Block *      blk,
+		     std::size_t  n)
+{
+  uint32_t  pc = blk->pc;
+
+  for (std::size_t  i = 0; i < n; i++)
+    {
+      mCoverage.hit (pc);
+      pc += blk->insns[i].len;
+    }
+
+  if (n == blk->insns.size ())
+    blk->covered = mCoverage.generation ();
+
+}	// IssImpl::coverBlock ()
+
+
+//! Record an instruction in the instruction trace
+
+//! The instruction is read back from memory, since only the decoded form is
+//! kept. Any register written is recorded with its new value.
+
+//! @param[in] pc  Address of the instruction
+//! @param[in] in  The decoded instruction, which has just been executed
+
+void
+IssImpl::traceInsn (uint_reg_t    pc,
+		    const Insn &  in)
+{
+  uint32_t  addr = static_cast<uint32_t> (pc);
+  uint32_t  insn = load<uint16_t> (addr);
+
+  if (3 == (insn & 3))
+    insn |= static_cast<uint32_t> (load<uint16_t> (addr + 2)) << 16;
+
+  switch (in.op)
+    {
+    case Op::NOP:
+    case Op::BEQ:    case Op::BNE:    case Op::BLT:    case Op::BGE:
+    case Op::BLTU:   case Op::BGEU:
+    case Op::SB:     case Op::SH:     case Op::SW:     case Op::SD:
+    case Op::ECALL:  case Op::EBREAK: case Op::MRET:   case Op::WFI:
+    case Op::ILLEGAL:
+      mTrace->record (addr, insn);
+      break;
+
+    default:
+      if (0 == in.rd)
+	mTrace->record (addr, insn);
+      else
+	mTrace->record (addr, insn, in.rd, mX[in.rd]);
+      break;
+    }
+}	// IssImpl::traceInsn ()
+
+
+//! Is an EBREAK a syscall?
+
+//! Syscalls are an EBREAK with a NOP either side, so they can be told apart
+//! from a breakpoint GDB has inserted.
+
+//! @param[in] addr  Address of the EBREAK
+//! @return  TRUE if this is a syscall, FALSE otherwise.
+
+bool
+IssImpl::isSyscall (uint32_t  addr) const
+{
+  const uint32_t  NOP = 0x00000013;
+  const uint32_t  EBREAK = 0x00100073;
+
+  return (load<uint32_t> (addr) == EBREAK)
+    && (load<uint32_t> (addr - 4) == NOP)
+    && (load<uint32_t> (addr + 4) == NOP);
+
+}	// IssImpl::isSyscall ()
+
+
+//! Find the decoded block starting at an address
+
+//! Blocks are decoded as they are first needed, or again if the code has
+//! been written since.
+
+//! @param[in] pc  Address of the block
+//! @return  The block
+
+IssImpl::Block *
+IssImpl::lookupBlock (uint32_t  pc)
+{
+  Block *& slot = mBlockCache[(pc >> 1) & (BLOCK_CACHE_SIZE - 1)];
+
+  if ((nullptr != slot) && (slot->pc == pc) && slot->valid)
+    return slot;
+
+  Block & blk = mBlocks[pc];
+
+  if (! blk.valid)
+    decodeBlock (pc, blk);
+
+  slot = &blk;
+  return slot;
+
+}	// IssImpl::lookupBlock ()
+
+
+//! Decode a block
+
+//! A block ends at anything which changes control flow or machine state,
+//! before a breakpoint, or when it gets too long. Each page the block uses is
+//! told, so writes to it can throw the block away.
+
+//! @param[in]  pc   Address of the block
+//! @param[out] blk  The decoded block
+
+void
+IssImpl::decodeBlock (uint32_t  pc,
+		      Block &   blk)
+{
+  uint32_t  addr = pc;
+  Page * lastPage = nullptr;
+
+  blk.pc = pc;
+  blk.valid = true;
+  blk.insns.clear ();
+
+  while (true)
+    {
+      // Tell each page the instruction is in
+
+      for (uint32_t  a = addr; a < addr + 4; a += 2)
+	{
+	  Page * page = getPage (a);
+
+	  if (page != lastPage)
+	    {
+	      page->hasCode = true;
+
+	      if (std::find (page->blocks.begin (), page->blocks.end (), pc)
+		  == page->blocks.end ())
+		page->blocks.push_back (pc);
+
+	      lastPage = page;
+	    }
+	}
+
+      Insn  in;
+      uint16_t  lo = load<uint16_t> (addr);
+
+      if ((lo & 0x3) != 0x3)
+	decodeCompressed (lo, in);
+      else
+	decode (load<uint32_t> (addr), in);
+
+      blk.insns.push_back (in);
+      addr += in.len;
+
+      bool  endsBlock;
+
+      switch (in.op)
+	{
+	case Op::JAL:     case Op::JALR:
+	case Op::BEQ:     case Op::BNE:     case Op::BLT:
+	case Op::BGE:     case Op::BLTU:    case Op::BGEU:
+	case Op::ECALL:   case Op::EBREAK:  case Op::MRET:
+	case Op::WFI:
+	case Op::CSRRW:   case Op::CSRRS:   case Op::CSRRC:
+	case Op::CSRRWI:  case Op::CSRRSI:  case Op::CSRRCI:
+	case Op::ILLEGAL:
+	  endsBlock = true;
+	  break;
+
+	default:
+	  endsBlock = false;
+	  break;
+	}
+
+      if (endsBlock || (blk.insns.size () >= MAX_BLOCK_INSNS)
+	  || (mBreakpoints.count (addr) > 0))
+	return;
+    }
+}	// IssImpl::decodeBlock ()
+
+
+//! Decode a 32-bit instruction
+
+//! Instructions writing x0 with no other effect become NOP, so x0 only needs
+//! zeroing at the end of each block.
+
+//! @param[in]  insn  The instruction
+//! @param[out] in    The decoded instruction
+
+void
+IssImpl::decode (uint32_t  insn,
+		 Insn &    in) const
+{
+  uint32_t  opcode = insn & 0x7f;
+  uint32_t  funct3 = (insn >> 12) & 0x7;
+  uint32_t  funct7 = insn >> 25;
+  int32_t  immI = static_cast<int32_t> (insn) >> 20;
+  int32_t  immS = ((static_cast<int32_t> (insn & 0xfe000000) >> 20)
+		   | ((insn >> 7) & 0x1f));
+  int32_t  immB = ((static_cast<int32_t> (insn & 0x80000000) >> 19)
+		   | ((insn & 0x80) << 4) | ((insn >> 20) & 0x7e0)
+		   | ((insn >> 7) & 0x1e));
+  int32_t  immU = static_cast<int32_t> (insn & 0xfffff000);
+  int32_t  immJ = ((static_cast<int32_t> (insn & 0x80000000) >> 11)
+		   | (insn & 0xff000) | ((insn >> 9) & 0x800)
+		   | ((insn >> 20) & 0x7fe));
+  uint32_t  shamt = (insn >> 20) & (XLEN - 1);
+  bool  shamtOk = (XLEN == 64) || (0 == (insn & 0x02000000));
+  bool  rv64 = (XLEN == 64);
+
+  in.op = Op::ILLEGAL;
+  in.rd = (insn >> 7) & 0x1f;
+  in.rs1 = (insn >> 15) & 0x1f;
+  in.rs2 = (insn >> 20) & 0x1f;
+  in.len = 4;
+  in.imm = 0;
+
+  switch (opcode)
+    {
+    case 0x37:
+      in.op = Op::LUI;
+      in.imm = immU;
+      break;
+
+    case 0x17:
+      in.op = Op::AUIPC;
+      in.imm = immU;
+      break;
+
+    case 0x6f:
+      in.op = Op::JAL;
+      in.imm = immJ;
+      break;
+
+    case 0x67:
+      if (0 == funct3)
+	{
+	  in.op = Op::JALR;
+	  in.imm = immI;
+	}
+      break;
+
+    case 0x63:
+      {
+	static const Op  ops[8] = { Op::BEQ, Op::BNE, Op::ILLEGAL,
+				    Op::ILLEGAL, Op::BLT, Op::BGE,
+				    Op::BLTU, Op::BGEU };
+	in.op = ops[funct3];
+	in.imm = immB;
+      }
+      break;
+
+    case 0x03:
+      {
+	static const Op  ops[8] = { Op::LB, Op::LH, Op::LW, Op::LD,
+				    Op::LBU, Op::LHU, Op::LWU, Op::ILLEGAL };
+	in.op = ops[funct3];
+	in.imm = immI;
+
+	if (! rv64 && ((Op::LD == in.op) || (Op::LWU == in.op)))
+	  in.op = Op::ILLEGAL;
+      }
+      break;
+
+    case 0x23:
+      {
+	static const Op  ops[8] = { Op::SB, Op::SH, Op::SW, Op::SD,
+				    Op::ILLEGAL, Op::ILLEGAL, Op::ILLEGAL,
+				    Op::ILLEGAL };
+	in.op = ops[funct3];
+	in.imm = immS;
+
+	if (! rv64 && (Op::SD == in.op))
+	  in.op = Op::ILLEGAL;
+      }
+      break;
+
+    case 0x13:
+      in.imm = immI;
+
+      switch (funct3)
+	{
+	case 0: in.op = Op::ADDI;  break;
+	case 2: in.op = Op::SLTI;  break;
+	case 3: in.op = Op::SLTIU; break;
+	case 4: in.op = Op::XORI;  break;
+	case 6: in.op = Op::ORI;   break;
+	case 7: in.op = Op::ANDI;  break;
+
+	case 1:
+	  if (shamtOk && (0 == (funct7 & 0x7e)))
+	    {
+	      in.op = Op::SLLI;
+	      in.imm = shamt;
+	    }
+	  break;
+
+	case 5:
+	  if (shamtOk && (0 == (funct7 & 0x5e)))
+	    {
+	      in.op = (funct7 & 0x20) ? Op::SRAI : Op::SRLI;
+	      in.imm = shamt;
+	    }
+	  break;
+	}
+      break;
+
+    case 0x1b:
+      if (! rv64)
+	break;
+
+      in.imm = immI;
+
+      if (0 == funct3)
+	in.op = Op::ADDIW;
+      else if ((1 == funct3) && (0 == funct7))
+	{
+	  in.op = Op::SLLIW;
+	  in.imm = in.rs2;
+	}
+      else if ((5 == funct3) && (0 == (funct7 & 0x5f)))
+	{
+	  in.op = (funct7 & 0x20) ? Op::SRAIW : Op::SRLIW;
+	  in.imm = in.rs2;
+	}
+      break;
+
+    case 0x33:
+      if (0 == funct7)
+	{
+	  static const Op  ops[8] = { Op::ADD, Op::SLL, Op::SLT, Op::SLTU,
+				      Op::XOR, Op::SRL, Op::OR, Op::AND };
+	  in.op = ops[funct3];
+	}
+      else if (0x20 == funct7)
+	{
+	  if (0 == funct3)
+	    in.op = Op::SUB;
+	  else if (5 == funct3)
+	    in.op = Op::SRA;
+	}
+      else if (1 == funct7)
+	{
+	  static const Op  ops[8] = { Op::MUL, Op::MULH, Op::MULHSU,
+				      Op::MULHU, Op::DIV, Op::DIVU,
+				      Op::REM, Op::REMU };
+	  in.op = ops[funct3];
+	}
+      break;
+
+    case 0x3b:
+      if (! rv64)
+	break;
+
+      if (0 == funct7)
+	{
+	  static const Op  ops[8] = { Op::ADDW, Op::SLLW, Op::ILLEGAL,
+				      Op::ILLEGAL, Op::ILLEGAL, Op::SRLW,
+				      Op::ILLEGAL, Op::ILLEGAL };
+	  in.op = ops[funct3];
+	}
+      else if (0x20 == funct7)
+	{
+	  if (0 == funct3)
+	    in.op = Op::SUBW;
+	  else if (5 == funct3)
+	    in.op = Op::SRAW;
+	}
+      else if (1 == funct7)
+	{
+	  static const Op  ops[8] = { Op::MULW, Op::ILLEGAL, Op::ILLEGAL,
+				      Op::ILLEGAL, Op::DIVW, Op::DIVUW,
+				      Op::REMW, Op::REMUW };
+	  in.op = ops[funct3];
+	}
+      break;
+
+    case 0x0f:
+      // FENCE has no effect on a single hart, and stores always throw away
+      // any code they overwrite, so FENCE.I has nothing to do either.
+
+      if ((0 == funct3) || (1 == funct3))
+	in.op = Op::NOP;
+      break;
+
+    case 0x73:
+      if (0 == funct3)
+	{
+	  switch (insn)
+	    {
+	    case 0x00000073: in.op = Op::ECALL;  break;
+	    case 0x00100073: in.op = Op::EBREAK; break;
+	    case 0x30200073: in.op = Op::MRET;   break;
+	    case 0x10500073: in.op = Op::WFI;    break;
+	    }
+	}
+      else if (4 != funct3)
+	{
+	  static const Op  ops[8] = { Op::ILLEGAL, Op::CSRRW, Op::CSRRS,
+				      Op::CSRRC, Op::ILLEGAL, Op::CSRRWI,
+				      Op::CSRRSI, Op::CSRRCI };
+	  in.op = ops[funct3];
+	  in.imm = insn >> 20;
+	}
+      break;
+    }
+
+  // Writes to x0 with no side effect
+
+  if (0 == in.rd)
+    switch (in.op)
+      {
+      case Op::LUI:   case Op::AUIPC:
+      case Op::LB:    case Op::LH:    case Op::LW:    case Op::LBU:
+      case Op::LHU:   case Op::LWU:   case Op::LD:
+      case Op::ADDI:  case Op::SLTI:  case Op::SLTIU: case Op::XORI:
+      case Op::ORI:   case Op::ANDI:  case Op::SLLI:  case Op::SRLI:
+      case Op::SRAI:  case Op::ADD:   case Op::SUB:   case Op::SLL:
+      case Op::SLT:   case Op::SLTU:  case Op::XOR:   case Op::SRL:
+      case Op::SRA:   case Op::OR:    case Op::AND:
+      case Op::ADDIW: case Op::SLLIW: case Op::SRLIW: case Op::SRAIW:
+      case Op::ADDW:  case Op::SUBW:  case Op::SLLW:  case Op::SRLW:
+      case Op::SRAW:
+      case Op::MUL:   case Op::MULH:  case Op::MULHSU: case Op::MULHU:
+      case Op::DIV:   case Op::DIVU:  case Op::REM:   case Op::REMU:
+      case Op::MULW:  case Op::DIVW:  case Op::DIVUW: case Op::REMW:
+      case Op::REMUW:
+	in.op = Op::NOP;
+	break;
+
+      default:
+	break;
+      }
+}	// IssImpl::decode ()
+
+
+//! Decode a 16-bit compressed instruction
+
+//! Each is expanded to the equivalent 32-bit operation.
+
+//! @param[in]  insn  The instruction
+//! @param[out] in    The decoded instruction
+
+void
+IssImpl::decodeCompressed (uint16_t  insn,
+			   Insn &    in) const
+{
+  // Pick out bits, and fields
+
+  auto bits = [insn] (unsigned int  hi, unsigned int  lo)
+    {
+      return (static_cast<uint32_t> (insn) >> lo) & ((1U << (hi - lo + 1)) - 1);
+    };
+
+  auto sext = [] (uint32_t  val, unsigned int  width)
+    {
+      return static_cast<sreg_t> (static_cast<int32_t> (val << (32 - width))
+				  >> (32 - width));
+    };
+
+  uint32_t  funct3 = bits (15, 13);
+  uint8_t  rd = bits (11, 7);
+  uint8_t  rs2 = bits (6, 2);
+  uint8_t  rdp = 8 + bits (4, 2);		// rd' and rs2'
+  uint8_t  rs1p = 8 + bits (9, 7);		// rs1' and rd'
+  sreg_t  imm6 = sext ((bits (12, 12) << 5) | bits (6, 2), 6);
+  uint32_t  shamt = (bits (12, 12) << 5) | bits (6, 2);
+  bool  shamtOk = (XLEN == 64) || (0 == bits (12, 12));
+  sreg_t  immJ = sext ((bits (12, 12) << 11) | (bits (11, 11) << 4)
+		       | (bits (10, 9) << 8) | (bits (8, 8) << 10)
+		       | (bits (7, 7) << 6) | (bits (6, 6) << 7)
+		       | (bits (5, 3) << 1) | (bits (2, 2) << 5), 12);
+  sreg_t  immB = sext ((bits (12, 12) << 8) | (bits (11, 10) << 3)
+		       | (bits (6, 5) << 6) | (bits (4, 3) << 1)
+		       | (bits (2, 2) << 5), 9);
+  uint32_t  uimmW = (bits (12, 10) << 3) | (bits (6, 6) << 2)
+    | (bits (5, 5) << 6);
+  uint32_t  uimmD = (bits (12, 10) << 3) | (bits (6, 5) << 6);
+  bool  rv64 = (XLEN == 64);
+
+  in.op = Op::ILLEGAL;
+  in.rd = 0;
+  in.rs1 = 0;
+  in.rs2 = 0;
+  in.len = 2;
+  in.imm = 0;
+
+  switch (insn & 0x3)
+    {
+    case 0:
+      switch (funct3)
+	{
+	case 0:				// C.ADDI4SPN
+	  in.imm = (bits (12, 11) << 4) | (bits (10, 7) << 6)
+	    | (bits (6, 6) << 2) | (bits (5, 5) << 3);
+
+	  if (0 != in.imm)
+	    {
+	      in.op = Op::ADDI;
+	      in.rd = rdp;
+	      in.rs1 = 2;
+	    }
+	  break;
+
+	case 2:				// C.LW
+	  in.op = Op::LW;
+	  in.rd = rdp;
+	  in.rs1 = rs1p;
+	  in.imm = uimmW;
+	  break;
+
+	case 3:				// C.LD
+	  if (rv64)
+	    {
+	      in.op = Op::LD;
+	      in.rd = rdp;
+	      in.rs1 = rs1p;
+	      in.imm = uimmD;
+	    }
+	  break;
+
+	case 6:				// C.SW
+	  in.op = Op::SW;
+	  in.rs1 = rs1p;
+	  in.rs2 = rdp;
+	  in.imm = uimmW;
+	  break;
+
+	case 7:				// C.SD
+	  if (rv64)
+	    {
+	      in.op = Op::SD;
+	      in.rs1 = rs1p;
+	      in.rs2 = rdp;
+	      in.imm = uimmD;
+	    }
+	  break;
+	}
+      break;
+
+    case 1:
+      switch (funct3)
+	{
+	case 0:				// C.ADDI, C.NOP
+	  in.op = (0 == rd) ? Op::NOP : Op::ADDI;
+	  in.rd = rd;
+	  in.rs1 = rd;
+	  in.imm = imm6;
+	  break;
+
+	case 1:
+	  if (rv64)
+	    {
+	      if (0 != rd)		// C.ADDIW
+		{
+		  in.op = Op::ADDIW;
+		  in.rd = rd;
+		  in.rs1 = rd;
+		  in.imm = imm6;
+		}
+	    }
+	  else				// C.JAL
+	    {
+	      in.op = Op::JAL;
+	      in.rd = 1;
+	      in.imm = immJ;
+	    }
+	  break;
+
+	case 2:				// C.LI
+	  in.op = (0 == rd) ? Op::NOP : Op::ADDI;
+	  in.rd = rd;
+	  in.imm = imm6;
+	  break;
+
+	case 3:
+	  if (2 == rd)			// C.ADDI16SP
+	    {
+	      in.imm = sext ((bits (12, 12) << 9) | (bits (6, 6) << 4)
+			     | (bits (5, 5) << 6) | (bits (4, 3) << 7)
+			     | (bits (2, 2) << 5), 10);
+
+	      if (0 != in.imm)
+		{
+		  in.op = Op::ADDI;
+		  in.rd = 2;
+		  in.rs1 = 2;
+		}
+	    }
+	  else if (0 != imm6)		// C.LUI
+	    {
+	      in.op = (0 == rd) ? Op::NOP : Op::LUI;
+	      in.rd = rd;
+	      in.imm = static_cast<sreg_t> (static_cast<uint_reg_t> (imm6)
+					    << 12);
+	    }
+	  break;
+
+	case 4:
+	  in.rd = rs1p;
+	  in.rs1 = rs1p;
+	  in.rs2 = rdp;
+
+	  switch (bits (11, 10))
+	    {
+	    case 0:			// C.SRLI
+	      if (shamtOk)
+		{
+		  in.op = Op::SRLI;
+		  in.imm = shamt;
+		}
+	      break;
+
+	    case 1:			// C.SRAI
+	      if (shamtOk)
+		{
+		  in.op = Op::SRAI;
+		  in.imm = shamt;
+		}
+	      break;
+
+	    case 2:			// C.ANDI
+	      in.op = Op::ANDI;
+	      in.imm = imm6;
+	      break;
+
+	    case 3:
+	      {
+		static const Op  ops[8] = { Op::SUB, Op::XOR, Op::OR, Op::AND,
+					    Op::SUBW, Op::ADDW, Op::ILLEGAL,
+					    Op::ILLEGAL };
+		uint32_t  i = (bits (12, 12) << 2) | bits (6, 5);
+
+		if (! rv64 && (i >= 4))
+		  break;
+
+		in.op = ops[i];
+	      }
+	      break;
+	    }
+	  break;
+
+	case 5:				// C.J
+	  in.op = Op::JAL;
+	  in.imm = immJ;
+	  break;
+
+	case 6:				// C.BEQZ
+	case 7:				// C.BNEZ
+	  in.op = (6 == funct3) ? Op::BEQ : Op::BNE;
+	  in.rs1 = rs1p;
+	  in.imm = immB;
+	  break;
+	}
+      break;
+
+    case 2:
+      switch (funct3)
+	{
+	case 0:				// C.SLLI
+	  if (shamtOk)
+	    {
+	      in.op = (0 == rd) ? Op::NOP : Op::SLLI;
+	      in.rd = rd;
+	      in.rs1 = rd;
+	      in.imm = shamt;
+	    }
+	  break;
+
+	case 2:				// C.LWSP
+	  if (0 != rd)
+	    {
+	      in.op = Op::LW;
+	      in.rd = rd;
+	      in.rs1 = 2;
+	      in.imm = (bits (12, 12) << 5) | (bits (6, 4) << 2)
+		| (bits (3, 2) << 6);
+	    }
+	  break;
+
+	case 3:				// C.LDSP
+	  if (rv64 && (0 != rd))
+	    {
+	      in.op = Op::LD;
+	      in.rd = rd;
+	      in.rs1 = 2;
+	      in.imm = (bits (12, 12) << 5) | (bits (6, 5) << 3)
+		| (bits (4, 2) << 6);
+	    }
+	  break;
+
+	case 4:
+	  if (0 == bits (12, 12))
+	    {
+	      if (0 == rs2)
+		{
+		  if (0 != rd)		// C.JR
+		    {
+		      in.op = Op::JALR;
+		      in.rs1 = rd;
+		    }
+		}
+	      else			// C.MV
+		{
+		  in.op = (0 == rd) ? Op::NOP : Op::ADD;
+		  in.rd = rd;
+		  in.rs2 = rs2;
+		}
+	    }
+	  else
+	    {
+	      if ((0 == rd) && (0 == rs2))	// C.EBREAK
+		in.op = Op::EBREAK;
+	      else if (0 == rs2)	// C.JALR
+		{
+		  in.op = Op::JALR;
+		  in.rd = 1;
+		  in.rs1 = rd;
+		}
+	      else			// C.ADD
+		{
+		  in.op = (0 == rd) ? Op::NOP : Op::ADD;
+		  in.rd = rd;
+		  in.rs1 = rd;
+		  in.rs2 = rs2;
+		}
+	    }
+	  break;
+
+	case 6:				// C.SWSP
+	  in.op = Op::SW;
+	  in.rs1 = 2;
+	  in.rs2 = rs2;
+	  in.imm = (bits (12, 9) << 2) | (bits (8, 7) << 6);
+	  break;
+
+	case 7:				// C.SDSP
+	  if (rv64)
+	    {
+	      in.op = Op::SD;
+	      in.rs1 = 2;
+	      in.rs2 = rs2;
+	      in.imm = (bits (12, 10) << 3) | (bits (9, 7) << 6);
+	    }
+	  break;
+	}
+      break;
+    }
+}	// IssImpl::decodeCompressed ()
+
+
+//! Throw away all decoded code
+
+void
+IssImpl::flushBlocks ()
+{
+  mBlocks.clear ();
+
+  for (std::size_t  i = 0; i < BLOCK_CACHE_SIZE; i++)
+    mBlockCache[i] = nullptr;
+
+  for (uint32_t  d = 0; d < DIR_SIZE; d++)
+    if (nullptr != mPageDir[d])
+      for (uint32_t  p = 0; p < DIR_SIZE; p++)
+	if (nullptr != mPageDir[d][p])
+	  {
+	    mPageDir[d][p]->hasCode = false;
+	    mPageDir[d][p]->blocks.clear ();
+	  }
+
+}	// IssImpl::flushBlocks ()
+
+
+//! Find the page holding an address
+
+//! @param[in] addr  The address
+//! @return  The page, or nullptr if it has never been written.
+
+IssImpl::Page *
+IssImpl::findPage (uint32_t  addr) const
+{
+  Page ** dir = mPageDir[addr >> (PAGE_BITS + DIR_BITS)];
+
+  return (nullptr == dir) ? nullptr : dir[(addr >> PAGE_BITS) & (DIR_SIZE - 1)];
+
+}	// IssImpl::findPage ()
+
+
+//! Find the page holding an address, allocating it if need be
+
+//! @param[in] addr  The address
+//! @return  The page
+
+IssImpl::Page *
+IssImpl::getPage (uint32_t  addr)
+{
+  Page **& dir = mPageDir[addr >> (PAGE_BITS + DIR_BITS)];
+
+  if (nullptr == dir)
+    dir = new Page * [DIR_SIZE] ();
+
+  Page *& page = dir[(addr >> PAGE_BITS) & (DIR_SIZE - 1)];
+
+  if (nullptr == page)
+    page = new Page ();
+
+  return page;
+
+}	// IssImpl::getPage ()
+
+
+//! Throw away all blocks decoded from a page
+
+//! The blocks are marked invalid rather than removed, since one may be
+//! running.
+
+//! @param[in] page  The page which has been written
+
+void
+IssImpl::invalidatePage (Page * page)
+{
+  for (auto it = page->blocks.begin (); it != page->blocks.end (); it++)
+    {
+      auto  blk = mBlocks.find (*it);
+
+      if (blk != mBlocks.end ())
+	blk->second.valid = false;
+    }
+
+  page->blocks.clear ();
+  page->hasCode = false;
+
+}	// IssImpl::invalidatePage ()
+
+
+//! Free all memory, and the code decoded from it
+
+void
+IssImpl::clearMemory ()
+{
+  flushBlocks ();
+
+  for (uint32_t  d = 0; d < DIR_SIZE; d++)
+    if (nullptr != mPageDir[d])
+      {
+	for (uint32_t  p = 0; p < DIR_SIZE; p++)
+	  delete mPageDir[d][p];
+
+	delete [] mPageDir[d];
+	mPageDir[d] = nullptr;
+      }
+
+}	// IssImpl::clearMemory ()
+
+
+//! Load from memory
+
+//! Memory is little endian, as is every host we build on. Only the low 32
+//! bits of the address are used.
+
+//! @param[in] addr  The address to load from
+//! @return  The value loaded
+
+template <typename T>
+T
+IssImpl::load (uint32_t  addr) const
+{
+  uint32_t  off = addr & (PAGE_SIZE - 1);
+  T  val = 0;
+
+  if (off <= PAGE_SIZE - sizeof (T))
+    {
+      const Page * page = findPage (addr);
+
+      if (nullptr != page)
+	memcpy (&val, page->data + off, sizeof (T));
+    }
+  else
+    read (addr, reinterpret_cast<uint8_t *> (&val), sizeof (T));
+
+  return val;
+
+}	// IssImpl::load ()
+
+
+//! Store to memory
+
+//! Stores to code throw the code away.
+
+//! @param[in] addr  The address to store to
+//! @param[in] val   The value to store
+
+template <typename T>
+void
+IssImpl::store (uint32_t  addr,
+		T         val)
+{
+  uint32_t  off = addr & (PAGE_SIZE - 1);
+
+  if (nullptr != mStoreLog)
+    mStoreLog->emplace_back (addr, sizeof (T));
+
+  if (off <= PAGE_SIZE - sizeof (T))
+    {
+      Page * page = getPage (addr);
+
+      memcpy (page->data + off, &val, sizeof (T));
+
+      if (page->hasCode)
+	invalidatePage (page);
+    }
+  else
+    write (addr, reinterpret_cast<const uint8_t *> (&val), sizeof (T));
+
+}	// IssImpl::store ()
+
+
+//! Read a CSR
+
+//! The counters and identification CSRs are computed. Everything else reads
+//! back what was last written.
+
+//! @param[in] csr  The CSR to read
+//! @return  Its value
+
+uint_reg_t
+IssImpl::readCsr (uint16_t  csr) const
+{
+  switch (csr)
+    {
+    case CSR_MISA:
+      return (static_cast<uint_reg_t> (XLEN / 32) << (XLEN - 2))
+	| (1 << ('C' - 'A')) | (1 << ('I' - 'A')) | (1 << ('M' - 'A'));
+
+    case CSR_MCYCLE:
+    case CSR_MINSTRET:
+    case CSR_CYCLE:
+    case CSR_TIME:
+    case CSR_INSTRET:
+      return static_cast<uint_reg_t> (mInstrCnt);
+
+    case CSR_MCYCLEH:
+    case CSR_MINSTRETH:
+    case CSR_CYCLEH:
+    case CSR_TIMEH:
+    case CSR_INSTRETH:
+      return static_cast<uint_reg_t> (mInstrCnt >> 32);
+
+    case CSR_MVENDORID:
+    case CSR_MHARTID:
+      return 0;
+
+    default:
+      {
+	auto it = mCsrs.find (csr);
+	return (it == mCsrs.end ()) ? 0 : it->second;
+      }
+    }
+}	// IssImpl::readCsr ()
+
+
+//! Write a CSR
+
+//! Writes to the counters and identification CSRs are ignored.
+
+//! @param[in] csr  The CSR to write
+//! @param[in] val  The value to write
+
+void
+IssImpl::writeCsr (uint16_t    csr,
+		   uint_reg_t  val)
+{
+  switch (csr)
+    {
+    case CSR_MISA:
+    case CSR_MCYCLE:
+    case CSR_MINSTRET:
+    case CSR_CYCLE:
+    case CSR_TIME:
+    case CSR_INSTRET:
+    case CSR_MCYCLEH:
+    case CSR_MINSTRETH:
+    case CSR_CYCLEH:
+    case CSR_TIMEH:
+    case CSR_INSTRETH:
+    case CSR_MVENDORID:
+    case CSR_MHARTID:
+      break;
+
+    default:
+      mCsrs[csr] = val;
+      break;
+    }
+}	// IssImpl::writeCsr ()
+
+
+//! Put the registers back to their reset values
+
+void
+IssImpl::resetState ()
+{
+  for (int  i = 0; i < 32; i++)
+    mX[i] = 0;
+
+  mPc = RESET_PC;
+  mCsrs.clear ();
+
+}	// IssImpl::resetState ()
+
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// End:
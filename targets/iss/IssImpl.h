@@ -0,0 +1,375 @@
+// GDB RSP server instruction set simulator: declaration
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef ISS_IMPL_H
+#define ISS_IMPL_H
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Coverage.h"
+#include "ITarget.h"
+#include "Profiler.h"
+
+
+class InstrTrace;
+
+
+//! The instruction set simulator implementation class.
+
+//! A functional model of RV32IMC (or RV64IMC when built for 64-bit), with
+//! just enough of the machine mode CSRs for bare metal programs. Every
+//! instruction takes one cycle.
+
+//! Instructions are decoded once, a basic block at a time, and the decoded
+//! blocks are kept until the memory holding them is written. Memory is
+//! paged, with pages allocated when first written, so any address may be
+//! used.
+
+class IssImpl final
+{
+ public:
+
+  IssImpl (const TraceFlags * flags);
+  ~IssImpl ();
+
+  ITarget::ResumeRes  resume (ITarget::ResumeType step);
+  ITarget::ResumeRes  resume (ITarget::ResumeType step,
+			      std::chrono::duration <double>  timeout);
+
+  ITarget::ResumeRes  terminate ();
+  ITarget::ResumeRes  reset (ITarget::ResetType  type);
+
+  uint64_t  getCycleCount () const;
+  uint64_t  getInstrCount () const;
+  void  setLimit (ITarget::LimitType  type,
+		  uint64_t  count);
+
+  // Read contents of a target register.
+
+  std::size_t  readRegister (const int  reg,
+			     uint_reg_t & value) const;
+
+  // Write data to a target register.
+
+  std::size_t  writeRegister (const int  reg,
+			      const uint_reg_t  value);
+
+  // Read data from memory.
+
+  std::size_t  read (const uint32_t  addr,
+		     uint8_t * buffer,
+		     const std::size_t  size) const;
+
+  // Write data to memory.
+
+  std::size_t  write (const uint32_t  addr,
+		      const uint8_t * buffer,
+		      const std::size_t  size);
+
+  // Insert and remove a matchpoint (breakpoint or watchpoint) at the given
+  // address.  Return value indicates whether the operation was successful.
+
+  bool  insertMatchpoint (const uint32_t  addr,
+			  const ITarget::MatchType  matchType);
+  bool  removeMatchpoint (const uint32_t  addr,
+			  const ITarget::MatchType  matchType);
+
+  // Monitor commands
+
+  void  registerCommands (CommandRegistry & reg);
+
+  // Checkpoint files
+
+  bool  saveCheckpoint (const std::string & filename);
+  bool  restoreCheckpoint (const std::string & filename);
+
+  // Snapshots
+
+  bool  saveSnapshot (std::vector<uint8_t> & state);
+  bool  restoreSnapshot (const std::vector<uint8_t> & state);
+
+  // Threads
+
+  bool  threaded () const;
+
+  // Identify the server
+
+  void gdbServer (GdbServer *server);
+
+  // Verilog support functions
+
+  double timeStamp ();
+
+  // Support for use alongside another target
+
+  void  stopAt (uint64_t  instrCount);
+  void  pages (std::vector<uint32_t> & addrs) const;
+  void  logStores (std::vector<std::pair<uint32_t, std::size_t> > * log);
+
+
+private:
+
+  //! Signed equivalent of a register
+
+  typedef std::make_signed<uint_reg_t>::type  sreg_t;
+
+  //! Register width in bits
+
+  static const unsigned int  XLEN = sizeof (uint_reg_t) * 8;
+
+  //! Bits of address within a page
+
+  static const unsigned int  PAGE_BITS = 12;
+
+  //! Bytes in a page
+
+  static const uint32_t  PAGE_SIZE = 1 << PAGE_BITS;
+
+  //! Bits of address indexing each level of the page table
+
+  static const unsigned int  DIR_BITS = (32 - PAGE_BITS) / 2;
+
+  //! Entries in each level of the page table
+
+  static const uint32_t  DIR_SIZE = 1 << DIR_BITS;
+
+  //! Most instructions in a block
+
+  static const std::size_t  MAX_BLOCK_INSNS = 64;
+
+  //! Entries in the direct mapped block lookup cache. Must be a power of 2.
+
+  static const std::size_t  BLOCK_CACHE_SIZE = 4096;
+
+  //! Instructions to run between checks for timeout
+
+  static const uint64_t  RUN_SAMPLE_INSNS = 1000000;
+
+  //! Where execution starts after reset
+
+  static const uint32_t  RESET_PC = 0;
+
+  //! Version of the saved state, so old snapshots are not misread
+
+  static const uint32_t  STATE_VERSION = 1;
+
+  // GDB register numbers
+
+  static const int  REG_R0  = 0;		//!< GDB R0 regnum
+  static const int  REG_R31 = 31;		//!< GDB R31 regnum
+  static const int  REG_PC  = 32;		//!< GDB PC regnum
+  static const int  REG_CSR0 = 65;		//!< GDB regnum of first CSR
+  static const int  REG_CSR4095 = REG_CSR0 + 4095;	//!< and of the last
+
+  // CSRs with behavior
+
+  static const uint16_t  CSR_MISA      = 0x301;	//!< ISA and extensions
+  static const uint16_t  CSR_MEPC      = 0x341;	//!< Exception PC
+  static const uint16_t  CSR_MCYCLE    = 0xb00;	//!< Cycle counter
+  static const uint16_t  CSR_MINSTRET  = 0xb02;	//!< Instructions retired
+  static const uint16_t  CSR_MCYCLEH   = 0xb80;	//!< Upper cycle counter
+  static const uint16_t  CSR_MINSTRETH = 0xb82;	//!< Upper instrs retired
+  static const uint16_t  CSR_CYCLE     = 0xc00;	//!< User cycle counter
+  static const uint16_t  CSR_TIME      = 0xc01;	//!< User timer
+  static const uint16_t  CSR_INSTRET   = 0xc02;	//!< User instrs retired
+  static const uint16_t  CSR_CYCLEH    = 0xc80;	//!< Upper user cycles
+  static const uint16_t  CSR_TIMEH     = 0xc81;	//!< Upper user timer
+  static const uint16_t  CSR_INSTRETH  = 0xc82;	//!< Upper user instrs
+  static const uint16_t  CSR_MVENDORID = 0xf11;	//!< Vendor ID
+  static const uint16_t  CSR_MHARTID   = 0xf14;	//!< Hart ID
+
+  //! Decoded operations. Compressed instructions decode to the equivalent
+  //! full size operation.
+
+  enum class Op : uint8_t
+    {
+      NOP, LUI, AUIPC, JAL, JALR,
+      BEQ, BNE, BLT, BGE, BLTU, BGEU,
+      LB, LH, LW, LBU, LHU, LWU, LD,
+      SB, SH, SW, SD,
+      ADDI, SLTI, SLTIU, XORI, ORI, ANDI, SLLI, SRLI, SRAI,
+      ADD, SUB, SLL, SLT, SLTU, XOR, SRL, SRA, OR, AND,
+      ADDIW, SLLIW, SRLIW, SRAIW, ADDW, SUBW, SLLW, SRLW, SRAW,
+      MUL, MULH, MULHSU, MULHU, DIV, DIVU, REM, REMU,
+      MULW, DIVW, DIVUW, REMW, REMUW,
+      ECALL, EBREAK, MRET, WFI,
+      CSRRW, CSRRS, CSRRC, CSRRWI, CSRRSI, CSRRCI,
+      ILLEGAL
+    };
+
+  //! A decoded instruction. CSR instructions keep the CSR number in the
+  //! immediate, and the immediate operand of CSRR*I in rs1.
+
+  struct Insn
+  {
+    Op       op;			//!< What to do
+    uint8_t  rd;			//!< Destination register
+    uint8_t  rs1;			//!< First source register
+    uint8_t  rs2;			//!< Second source register
+    uint8_t  len;			//!< Bytes in the instruction
+    sreg_t   imm;			//!< Sign extended immediate
+  };
+
+  //! A decoded basic block
+
+  struct Block
+  {
+    uint32_t  pc = 0;			//!< Address of the first instruction
+    bool  valid = false;		//!< Cleared when the code is written
+    uint64_t  covered = 0;		//!< Coverage generation when covered
+    std::vector<Insn>  insns;		//!< The instructions
+  };
+
+  //! A page of memory
+
+  struct Page
+  {
+    uint8_t  data[PAGE_SIZE];		//!< The contents
+    bool  hasCode;			//!< Set if any block was decoded here
+    std::vector<uint32_t>  blocks;	//!< Blocks which use this page
+  };
+
+  //! General registers. x0 is zeroed after every block.
+
+  uint_reg_t  mX[32];
+
+  //! Program counter
+
+  uint_reg_t  mPc;
+
+  //! CSRs with no behavior, which just hold what was written
+
+  std::map<uint16_t, uint_reg_t>  mCsrs;
+
+  //! Instructions executed since cold reset. This is also the cycle count.
+
+  uint64_t  mInstrCnt;
+
+  //! Instruction count at which continuing stops
+
+  uint64_t  mStopCount;
+
+  //! Cycle and instruction counts at which continuing stops, reporting the
+  //! limit was reached. Since each instruction takes a cycle, the lower is
+  //! the one which matters.
+
+  uint64_t  mCycleLimit;
+  uint64_t  mInstrLimit;
+
+  //! Where to record the address and size of each store, if anywhere
+
+  std::vector<std::pair<uint32_t, std::size_t> > * mStoreLog;
+
+  //! PC sampling profiler, counting instructions
+
+  Profiler  mProfiler;
+
+  //! Executed instruction coverage
+
+  Coverage  mCoverage;
+
+  //! Instruction trace, if enabled
+
+  InstrTrace * mTrace;
+
+  //! Two level page table, allocated on demand
+
+  Page ** mPageDir[DIR_SIZE];
+
+  //! Decoded blocks by start address. Blocks are never removed until the
+  //! whole cache is flushed, so pointers to them stay valid.
+
+  std::unordered_map<uint32_t, Block>  mBlocks;
+
+  //! Direct mapped cache in front of mBlocks
+
+  Block * mBlockCache[BLOCK_CACHE_SIZE];
+
+  //! Breakpoints set with insertMatchpoint
+
+  std::set<uint32_t>  mBreakpoints;
+
+  //! Our trace flags
+
+  const TraceFlags * mFlags;
+
+  //! The server using us
+
+  GdbServer * mServer;
+
+  // Execution
+
+  ITarget::ResumeRes  execute (uint64_t  maxInsns,
+			       bool      skipBreak);
+  bool  isSyscall (uint32_t  addr) const;
+  void  traceInsn (uint_reg_t    pc,
+		   const Insn &  in);
+  void  coverBlock (Block *      blk,
+		    std::size_t  n);
+
+  // Decoding
+
+  Block * lookupBlock (uint32_t  pc);
+  void  decodeBlock (uint32_t  pc,
+		     Block &   blk);
+  void  decode (uint32_t  insn,
+		Insn &    in) const;
+  void  decodeCompressed (uint16_t  insn,
+			  Insn &    in) const;
+  void  flushBlocks ();
+
+  // Memory
+
+  Page * findPage (uint32_t  addr) const;
+  Page * getPage (uint32_t  addr);
+  void  invalidatePage (Page * page);
+  void  clearMemory ();
+
+  template <typename T>
+  T  load (uint32_t  addr) const;
+
+  template <typename T>
+  void  store (uint32_t  addr,
+	       T         val);
+
+  // CSRs
+
+  uint_reg_t  readCsr (uint16_t  csr) const;
+  void  writeCsr (uint16_t    csr,
+		  uint_reg_t  val);
+
+  // State
+
+  void  resetState ();
+
+};	// IssImpl ()
+
+#endif	// ISS_IMPL_H
+
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// End:
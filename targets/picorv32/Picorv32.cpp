@@ -71,31 +71,44 @@ Picorv32::resume (ResumeType step,
 {
   time_point <system_clock, duration <double> > timeout_end =
     system_clock::now () + timeout;
+  ResumeRes res = ResumeRes::NONE;
 
   switch (step)
   {
   case ResumeType::STEP:
+    // A trap means we stopped at a breakpoint rather than stepping
     if (mPicorv32Impl->step ())
     {
-      return ResumeRes::TIMEOUT;
+      res = ResumeRes::INTERRUPTED;
     } else {
-      return ResumeRes::INTERRUPTED;
+      res = ResumeRes::STEPPED;
     }
     break;
   case ResumeType::CONTINUE:
-    for (;;)
+    while (ResumeRes::NONE == res)
     {
       for (size_t i = 0; i < RUN_SAMPLE_PERIOD; i++)
       {
+        // Any spin loop is skipped and the limit is checked before each
+        // instruction, so we never run past it
+        mPicorv32Impl->skipSpin ();
+
+        if (mPicorv32Impl->atLimit ())
+        {
+          res = ResumeRes::LIMIT;
+          break;
+        }
+
         if (mPicorv32Impl->step ())
         {
-          return ResumeRes::INTERRUPTED;
+          res = ResumeRes::INTERRUPTED;
+          break;
         }
       }
 
-      if (timeout_end < system_clock::now ())
+      if ((ResumeRes::NONE == res) && (timeout_end < system_clock::now ()))
       {
-        return ResumeRes::TIMEOUT;
+        res = ResumeRes::TIMEOUT;
       }
     }
     break;
@@ -103,7 +116,10 @@ Picorv32::resume (ResumeType step,
     // Do nothing. We are already "stopped"?
     break;
   }
-  return ResumeRes::NONE;
+
+  // Flush any waveform, so it can be viewed while GDB is still connected
+  mPicorv32Impl->flushWaveform ();
+  return res;
 }
 
 ITarget::ResumeRes
@@ -138,6 +154,25 @@ Picorv32::getInstrCount () const
   return mPicorv32Impl->getInstrCount ();
 }
 
+// Instructions are counted from the core's instruction counter, which can
+// only be read if the model was verilated with --public.
+
+bool
+Picorv32::countsInstrs () const
+{
+#ifdef HAVE_PUBLIC_MODELS
+  return true;
+#else
+  return false;
+#endif
+}
+
+void
+Picorv32::setLimit (LimitType type, uint64_t count)
+{
+  mPicorv32Impl->setLimit (type, count);
+}
+
 std::size_t
 Picorv32::readRegister (const int reg, uint32_t & value) const
 {
@@ -198,11 +233,10 @@ Picorv32::removeMatchpoint (const uint32_t  addr, const MatchType matchType)
   return false;
 }
 
-bool
-Picorv32::command (const std::string cmd, std::ostream & stream)
+void
+Picorv32::registerCommands (CommandRegistry & reg)
 {
-  std::cerr << "command NOT IMPLEMENTED" << std::endl;
-  return false;
+  mPicorv32Impl->registerCommands (reg);
 }
 
 
@@ -213,6 +247,94 @@ Picorv32::gdbServer (GdbServer *server)
 }
 
 
+//! Save a checkpoint file
+
+//! Pass through to the implementation class.
+
+//! @param[in] filename  The file to write
+//! @return  TRUE if the checkpoint was saved, FALSE otherwise.
+
+bool
+Picorv32::saveCheckpoint (const std::string & filename)
+{
+  return  mPicorv32Impl->saveCheckpoint (filename);
+
+}	// Picorv32::saveCheckpoint ()
+
+
+//! Restore a checkpoint file
+
+//! Pass through to the implementation class.
+
+//! @param[in] filename  The file to read
+//! @return  TRUE if the checkpoint was restored, FALSE otherwise.
+
+bool
+Picorv32::restoreCheckpoint (const std::string & filename)
+{
+  return  mPicorv32Impl->restoreCheckpoint (filename);
+
+}	// Picorv32::restoreCheckpoint ()
+
+
+//! Save a snapshot
+
+//! Wrapper for the implementation class.
+
+//! @param[out] state  The saved state
+//! @return  TRUE if the snapshot was taken, FALSE otherwise.
+
+bool
+Picorv32::saveSnapshot (std::vector<uint8_t> & state)
+{
+  return  mPicorv32Impl->saveSnapshot (state);
+
+}	// Picorv32::saveSnapshot ()
+
+
+//! Restore a snapshot
+
+//! Wrapper for the implementation class.
+
+//! @param[in] state  State saved by saveSnapshot ()
+//! @return  TRUE if the snapshot was restored, FALSE otherwise.
+
+bool
+Picorv32::restoreSnapshot (const std::vector<uint8_t> & state)
+{
+  return  mPicorv32Impl->restoreSnapshot (state);
+
+}	// Picorv32::restoreSnapshot ()
+
+
+//! Wrapper for the implementation class
+
+//! @return  TRUE if the target has threads of its own running, FALSE
+//!          otherwise.
+
+bool
+Picorv32::threaded () const
+{
+  return  mPicorv32Impl->threaded ();
+
+}	// Picorv32::threaded ()
+
+
+//! Record the PC of each instruction retired while continuing
+
+//! Not yet supported, so a co-simulation steps the core.
+
+//! @param[in] pcs  Where to record the PCs, or nullptr
+//! @return  FALSE, since we do not record them.
+
+bool
+Picorv32::traceRetired (std::vector<uint32_t> * pcs __attribute__ ((unused)))
+{
+  return  false;
+
+}	// Picorv32::traceRetired ()
+
+
 //! Return a timestamp.
 
 //! This is needed to support the $time function in Verilog.  This in turn is
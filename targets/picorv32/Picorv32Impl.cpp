@@ -20,57 +20,69 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <algorithm>
 #include <cstdint>
+#include <iostream>
 
+#include "CheckpointFile.h"
+#include "CommandRegistry.h"
 #include "Picorv32Impl.h"
+#include "StateBuffer.h"
 #include "Vtestbench__Syms.h"
+#include "Waveform.h"
 
 
 //! Constructor.
 
-//! Initialize the clock, instantiate the Verilator model and set up VCD
-//! tracing if requested.
+//! Initialize the clock, instantiate the Verilator model and start dumping
+//! the waveform if requested.
 
-//! @param[in] wantVcd  TRUE if we want a VCD generated, false otherwise.
+//! @param[in] flags  The trace flags
 
 Picorv32Impl::Picorv32Impl (TraceFlags * flags) :
-  mWantVcd (flags->traceVcd ()),
+  mWave (nullptr),
   mCpuTime (0),
   mClk (0),
-  mInstr (0)
+  mInstr (0),
+  mLastCountInstr (0),
+  mClkLimit (ITarget::NO_LIMIT),
+  mInstrLimit (ITarget::NO_LIMIT),
+  mProfiler (1.0e8),
+  mSpin (32),
+  mClockFn (CLOCK_FNS[0])
 {
   mCpu = new Vtestbench;
+  mLastCountInstr = readCountInstr ();
 
-  // Open VCD file if requested
+  // Start dumping the waveform if requested
 
-  if (mWantVcd)
+  if (flags->traceVcd ())
     {
-      Verilated::traceEverOn (true);
-      mTfp = new VerilatedVcdC;
-      mCpu->trace (mTfp, 99);
-      mTfp->open ("gdbserver.vcd");
+      mWave = new Waveform ("gdbserver");
+      mCpu->trace (mWave->traceFile (), 99);
+      mWave->start ();
     }
+
+  selectClock ();
+
 }	// Picorv32Impl::Picorv32Impl ()
 
 
 //! Destructor.
 
-// Delete the Verilator model and close the VCD if it was requested.
+// Delete the Verilator model and close any waveform.
 
 Picorv32Impl::~Picorv32Impl ()
 {
-  // Close VCD file if requested
-
-  if (mWantVcd)
-    mTfp->close ();
-
+  delete mWave;
   delete mCpu;
 }
 
 
 //! Accessor for the cycle count
 
-//! The value is set during the execution of the model.
+//! The value is set during the execution of the model. mClk counts clock
+//! edges, so there are two for each cycle.
 
 //! @return  The number of cycles executed since startup or the last cold
 //!          reset.
@@ -78,14 +90,15 @@ Picorv32Impl::~Picorv32Impl ()
 uint64_t
 Picorv32Impl::getCycleCount () const
 {
-  return mClk;
+  return mClk / 2;
 
 }	// Picorv32Impl::getCycleCount ()
 
 
 //! Accessor for the instruction count
 
-//! The value is set during the execution of the model.
+//! The value is taken from the core's own instruction counter as the model
+//! runs.
 
 //! @return  The number of instructions executed since startup or the last cold
 //!          reset.
@@ -98,21 +111,240 @@ Picorv32Impl::getInstrCount () const
 }	// Picorv32Impl::getInstrCount ()
 
 
+//! Set a limit on continuing
+
+//! The cycle limit is kept as a count of clock edges, so checking it needs
+//! no division.
+
+//! @param[in] type   Whether the limit is on cycles or instructions
+//! @param[in] count  The count at which to stop, or NO_LIMIT
+
+void
+Picorv32Impl::setLimit (ITarget::LimitType  type,
+			uint64_t  count)
+{
+  if (ITarget::LimitType::INSTRS == type)
+    mInstrLimit = count;
+  else if (count > ITarget::NO_LIMIT / 2)
+    mClkLimit = ITarget::NO_LIMIT;
+  else
+    mClkLimit = count * 2;
+
+}	// Picorv32Impl::setLimit ()
+
+
+//! Has continuing reached its limit?
+
+//! @return  TRUE if the cycle or instruction count has reached its limit,
+//!          FALSE otherwise.
+
+bool
+Picorv32Impl::atLimit () const
+{
+  return (mClk >= mClkLimit) || (mInstr >= mInstrLimit);
+
+}	// Picorv32Impl::atLimit ()
+
+
+//! Skip iterations of any spin loop at the PC
+
+//! Called before each instruction while continuing. When the spin detector
+//! wants a loop examined, as many iterations as possible are skipped, with
+//! the counters, the core's own counters among them, moved on as if they had
+//! been clocked. Each iteration must take whole cycles, no further than the
+//! limits, the next profiler sample or the next cycle the waveform wants, and
+//! nothing can be skipped while the memory trace is running. The core's
+//! counters are internal, so can only be moved on if the model was verilated
+//! with --public. Otherwise nothing is skipped.
+
+void
+Picorv32Impl::skipSpin ()
+{
+#ifdef HAVE_PUBLIC_MODELS
+  if (!mSpin.watch (readProgramAddr (), mInstr, mClk))
+    return;
+
+  uint64_t  regs[SpinDetector::NUM_REGS];
+  uint8_t  code[SpinDetector::MAX_CODE];
+
+  regs[0] = 0;
+
+  for (unsigned int  r = 1; r < SpinDetector::NUM_REGS; r++)
+    regs[r] = readReg (r);
+
+  for (uint32_t  i = 0; i < SpinDetector::MAX_CODE; i++)
+    code[i] = readMem (mSpin.head () + i);
+
+  SpinDetector::Verdict  v = mSpin.examine (regs, code);
+
+  if (mMemTrace.active () || (0 != (v.cycles & 1)))
+    return;
+
+  uint64_t  iters = SpinDetector::within (v.iters, mInstr, mInstrLimit,
+					  v.instrs);
+
+  iters = SpinDetector::within (iters, mClk, mClkLimit, v.cycles);
+
+  if ((0 == iters) || (SpinDetector::FOREVER == iters))
+    return;
+
+  uint64_t  cycles = v.cycles / 2;
+  uint64_t  now = getCycleCount ();
+
+  iters = std::min (iters, mProfiler.untilSample () / cycles);
+
+  if (nullptr != mWave)
+    {
+      uint64_t  next = mWave->nextWanted (now);
+
+      iters = (next <= now) ? 0 : std::min (iters, (next - now) / cycles);
+    }
+
+  if (0 == iters)
+    return;
+
+  if (SpinDetector::Kind::COUNTDOWN == v.kind)
+    writeReg (v.reg, static_cast<uint32_t> (regs[v.reg] + iters * v.delta));
+
+  auto uut = mCpu->testbench->uut;
+
+  uut->count_instr += iters * v.instrs;
+  uut->count_cycle += iters * cycles;
+  mLastCountInstr = uut->count_instr;
+  mInstr += iters * v.instrs;
+  mClk += iters * v.cycles;
+
+  if (nullptr != mWave)
+    mCpuTime += iters * v.cycles * 5;
+
+  if (mProfiler.tick (iters * cycles))
+    mProfiler.sample (mSpin.head ());
+
+  mSpin.skipped (iters);
+#endif
+
+}	// Picorv32Impl::skipSpin ()
+
+
 // ! Step one single clock of the processor
 
+// ! mClk counts clock edges, so the profiler is only ticked on rising edges.
+// ! Instructions are counted from the core's count_instr counter, which the
+// ! core may clear, so only increases are added. Any load or store is traced
+// ! before the rising edge which completes it.
+
+// ! This is specialized for the instrumentation to be fed, given by PROBES,
+// ! so the common case with none has nothing to test. clockStep () calls the
+// ! specialization chosen by selectClock ().
+
+template <unsigned int PROBES>
 void
-Picorv32Impl::clockStep ()
+Picorv32Impl::clockStepWith ()
 {
+  if ((PROBES & PROBE_MEMTRACE) && (mClk & 1))
+    traceMem ();
+
   mCpu->clk = mClk;
   mCpu->eval ();
   mClk++;
 
-  if (mWantVcd)
+  if (mCpu->clk)
+    {
+      uint64_t  countInstr = readCountInstr ();
+
+      if (countInstr > mLastCountInstr)
+	mInstr += countInstr - mLastCountInstr;
+
+      mLastCountInstr = countInstr;
+
+      if ((PROBES & PROBE_PROFILE) && mProfiler.tick ())
+	mProfiler.sample (readProgramAddr ());
+    }
+
+  if (PROBES & PROBE_WAVE)
     {
       mCpuTime += 5;			// in ns
-      mTfp->dump (mCpuTime);
+
+      if (mWave->wanted (getCycleCount (), readProgramAddr ()))
+	mWave->dump (mCpuTime);
     }
-}	// Picorv32Impl::clockStep ()
+}	// Picorv32Impl::clockStepWith ()
+
+
+//! Every specialization of clockStepWith ()
+
+const Picorv32Impl::ClockFn  Picorv32Impl::CLOCK_FNS[NUM_CLOCKS] =
+  {
+    &Picorv32Impl::clockStepWith<0>, &Picorv32Impl::clockStepWith<1>,
+    &Picorv32Impl::clockStepWith<2>, &Picorv32Impl::clockStepWith<3>,
+    &Picorv32Impl::clockStepWith<4>, &Picorv32Impl::clockStepWith<5>,
+    &Picorv32Impl::clockStepWith<6>, &Picorv32Impl::clockStepWith<7>
+  };
+
+
+// ! Choose the clock specialization
+
+// ! The waveform is fixed when we are constructed, but the memory trace and
+// ! profiler come and go with monitor commands, so this is called again
+// ! after those.
+
+void
+Picorv32Impl::selectClock ()
+{
+  unsigned int  probes = 0;
+
+  if (nullptr != mWave)
+    probes |= PROBE_WAVE;
+
+  if (mMemTrace.active ())
+    probes |= PROBE_MEMTRACE;
+
+  if (mProfiler.running ())
+    probes |= PROBE_PROFILE;
+
+  mClockFn = CLOCK_FNS[probes];
+
+}	// Picorv32Impl::selectClock ()
+
+
+// ! Record any load or store in the memory trace
+
+// ! A transfer completes when the memory is ready for a valid request, which
+// ! is data unless it is an instruction fetch. Loads always read the whole
+// ! word, while stores have a strobe for each byte written. The bus can only
+// ! be read if the model was verilated with --public, and the trace cannot
+// ! be started otherwise.
+
+void
+Picorv32Impl::traceMem ()
+{
+#ifdef HAVE_PUBLIC_MODELS
+  auto tb = mCpu->testbench;
+
+  if (!tb->mem_valid || !tb->mem_ready || tb->mem_instr)
+    return;
+
+  unsigned int  wstrb = tb->mem_wstrb & 0xf;
+
+  if (0 == wstrb)
+    mMemTrace.access (getCycleCount (), tb->mem_addr, 4, false);
+  else
+    mMemTrace.access (getCycleCount (),
+		      (tb->mem_addr & ~3U) + __builtin_ctz (wstrb),
+		      __builtin_popcount (wstrb), true);
+#endif
+}	// Picorv32Impl::traceMem ()
+
+
+//! Flush any waveform being dumped
+
+void
+Picorv32Impl::flushWaveform ()
+{
+  if (nullptr != mWave)
+    mWave->flush ();
+
+}	// Picorv32Impl::flushWaveform ()
 
 
 // ! If trap is set, then get the processor in the right state to
@@ -152,6 +384,8 @@ Picorv32Impl::clearTrapAndRestartInstruction ()
 
 //! Step one instruction execution
 
+//! Unless it traps, the instruction has executed, so is covered.
+
 bool
 Picorv32Impl::step ()
 {
@@ -161,7 +395,12 @@ Picorv32Impl::step ()
     clockStep ();
   }
   while (prev_pc == readProgramAddr () && haveTrap () == 0);
-  return haveTrap () == 1;
+
+  if (haveTrap () == 1)
+    return true;
+
+  mCoverage.hit (prev_pc);
+  return false;
 }	// Picorv32Impl::step ()
 
 
@@ -239,6 +478,86 @@ Picorv32Impl::readProgramAddr () const
 }	// Picorv32Impl::readProgramAddr ()
 
 
+//! Read the core's instruction counter
+
+//! The counter is internal to the core, so can only be read if the model was
+//! verilated with --public. Otherwise it always reads as zero, and no
+//! instructions are counted.
+
+uint64_t
+Picorv32Impl::readCountInstr () const
+{
+#ifdef HAVE_PUBLIC_MODELS
+  return  mCpu->testbench->uut->count_instr;
+#else
+  return  0;
+#endif
+}	// Picorv32Impl::readCountInstr ()
+
+
+//! Add the target's monitor commands to a registry
+
+//! The commands are those of the profiler, coverage, the memory trace, the
+//! spin loop detector, which also adds to the "stats" command, and, if the
+//! waveform is being dumped, its triggers. Starting or stopping the
+//! profiler or the memory trace changes the clock specialization. The memory
+//! trace taps the testbench's bus, so needs a public model.
+
+//! @param[in] reg  The registry
+
+void
+Picorv32Impl::registerCommands (CommandRegistry & reg)
+{
+  reg.add ("profile", Profiler::HELP,
+	   [this] (const CommandArgs & args, std::ostream & stream)
+	   {
+	     bool  ok = mProfiler.command (args, stream);
+
+	     selectClock ();
+	     return ok;
+	   });
+  reg.add ("coverage", Coverage::HELP,
+	   [this] (const CommandArgs & args, std::ostream & stream)
+	   { return mCoverage.command (args, stream); });
+  reg.add ("memtrace", MemTrace::HELP,
+	   [this] (const CommandArgs & args, std::ostream & stream)
+	   {
+#ifdef HAVE_PUBLIC_MODELS
+	     bool  ok = mMemTrace.command (args, stream);
+
+	     selectClock ();
+	     return ok;
+#else
+	     (void) args;
+	     stream << "No memory trace: the model is not public" << std::endl;
+	     return false;
+#endif
+	   });
+  reg.add ("vcd", Waveform::HELP,
+	   [this] (const CommandArgs & args, std::ostream & stream)
+	   {
+	     if (nullptr == mWave)
+	       {
+		 stream << "No waveform: use the vcd trace flag" << std::endl;
+		 return false;
+	       }
+
+	     return mWave->command (args, stream);
+	   });
+  reg.add ("spin", SpinDetector::HELP,
+	   [this] (const CommandArgs & args, std::ostream & stream)
+	   { return mSpin.command (args, stream); });
+  reg.add ("stats", nullptr,
+	   [this] (const CommandArgs & args __attribute__ ((unused)),
+		   std::ostream & stream)
+	   {
+	     mSpin.report (stream);
+	     return true;
+	   });
+
+}	// Picorv32Impl::registerCommands ()
+
+
 //! Write the PC
 
 void
@@ -255,6 +574,171 @@ Picorv32Impl::writeProgramAddr (uint32_t val)
 }	// Picorv32Impl::writeProgramAddr ()
 
 
+//! Save a checkpoint file
+
+//! Memory is part of the Verilator testbench, so the model is all the state
+//! there is. The counters go in the header.
+
+//! @param[in] filename  The file to write
+//! @return  TRUE if the checkpoint was saved, FALSE otherwise.
+
+bool
+Picorv32Impl::saveCheckpoint (const std::string & filename)
+{
+#ifdef HAVE_SAVABLE_MODELS
+  CheckpointWriter  ckpt;
+
+  if (! ckpt.open (filename, "PicoRV32", mClk, mInstr, mCpuTime))
+    return  false;
+
+  ckpt << *mCpu;
+  ckpt.close ();
+  return  ckpt.ok ();
+
+#else
+  std::cerr << "Warning: PicoRV32 model is not savable: checkpoint "
+	    << filename << " not written" << std::endl;
+  return  false;
+
+#endif
+}	// Picorv32Impl::saveCheckpoint ()
+
+
+//! Restore a checkpoint file
+
+//! If the file cannot be used, the model is left untouched. If it turns out
+//! to be corrupt part way through, the model is left in an unknown state.
+
+//! @param[in] filename  The file to read
+//! @return  TRUE if the checkpoint was restored, FALSE otherwise.
+
+bool
+Picorv32Impl::restoreCheckpoint (const std::string & filename)
+{
+#ifdef HAVE_SAVABLE_MODELS
+  CheckpointReader  ckpt;
+
+  if (! ckpt.open (filename, "PicoRV32"))
+    return  false;
+
+  ckpt >> *mCpu;
+
+  if (! ckpt.complete ())
+    {
+      std::cerr << "Warning: Checkpoint " << filename
+		<< " does not match model: state undefined" << std::endl;
+      return  false;
+    }
+
+  mClk = ckpt.cycleCnt ();
+  mInstr = ckpt.instrCnt ();
+  mCpuTime = ckpt.cpuTime ();
+  mLastCountInstr = readCountInstr ();
+  return  true;
+
+#else
+  std::cerr << "Warning: PicoRV32 model is not savable: checkpoint "
+	    << filename << " not restored" << std::endl;
+  return  false;
+
+#endif
+}	// Picorv32Impl::restoreCheckpoint ()
+
+
+//! Save a snapshot
+
+//! The same state as a checkpoint file, with the counters after it.
+
+//! @param[out] state  The saved state
+//! @return  TRUE if the snapshot was taken, FALSE otherwise.
+
+bool
+Picorv32Impl::saveSnapshot (std::vector<uint8_t> & state
+			    __attribute__ ((unused)))
+{
+#ifdef HAVE_SAVABLE_MODELS
+  StateWriter  snap;
+
+  snap.open (state);
+  snap << *mCpu;
+  snap.write (&mClk, sizeof (mClk));
+  snap.write (&mInstr, sizeof (mInstr));
+  snap.write (&mCpuTime, sizeof (mCpuTime));
+  snap.close ();
+  return  true;
+
+#else
+  std::cerr << "Warning: PicoRV32 model is not savable: snapshot not taken"
+	    << std::endl;
+  return  false;
+
+#endif
+}	// Picorv32Impl::saveSnapshot ()
+
+
+//! Restore a snapshot
+
+//! @param[in] state  State saved by saveSnapshot ()
+//! @return  TRUE if the snapshot was restored, FALSE otherwise.
+
+bool
+Picorv32Impl::restoreSnapshot (const std::vector<uint8_t> & state
+			       __attribute__ ((unused)))
+{
+#ifdef HAVE_SAVABLE_MODELS
+  StateReader  snap;
+
+  snap.open (state);
+  snap >> *mCpu;
+  snap.read (&mClk, sizeof (mClk));
+  snap.read (&mInstr, sizeof (mInstr));
+  snap.read (&mCpuTime, sizeof (mCpuTime));
+
+  if (! snap.complete ())
+    {
+      std::cerr << "Warning: Snapshot does not match model: state undefined"
+		<< std::endl;
+      return  false;
+    }
+
+  mLastCountInstr = readCountInstr ();
+  return  true;
+
+#else
+  std::cerr << "Warning: PicoRV32 model is not savable: snapshot not restored"
+	    << std::endl;
+  return  false;
+
+#endif
+}	// Picorv32Impl::restoreSnapshot ()
+
+
+//! Does the target have threads of its own running?
+
+//! Models verilated with --threads evaluate on Verilator's worker threads.
+//! A running memory trace is written by a thread of its own, as is the
+//! waveform of models verilated with --trace-threads.
+
+//! @return  TRUE if the target has threads of its own running, FALSE
+//!          otherwise.
+
+bool
+Picorv32Impl::threaded () const
+{
+#ifdef HAVE_THREADED_MODELS
+  return  true;
+#endif
+
+#ifdef HAVE_TRACE_THREADS
+  if (nullptr != mWave)
+    return  true;
+#endif
+
+  return  mMemTrace.active ();
+
+}	// Picorv32Impl::threaded ()
+
+
 //! Provide a time stamp (needed for $time)
 
 //! We count in nanoseconds.
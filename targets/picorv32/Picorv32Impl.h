@@ -24,11 +24,18 @@
 #define CPU_H
 
 #include <cstdint>
+#include <vector>
 
+#include "Coverage.h"
 #include "GdbServer.h"
+#include "ITarget.h"
+#include "MemTrace.h"
+#include "Profiler.h"
+#include "SpinDetector.h"
 #include "TraceFlags.h"
 #include "Vtestbench.h"
-#include "verilated_vcd_c.h"
+
+class Waveform;
 
 class Picorv32Impl final
 {
@@ -43,8 +50,13 @@ class Picorv32Impl final
 
   uint64_t  getCycleCount () const;
   uint64_t  getInstrCount () const;
+  void  setLimit (ITarget::LimitType  type,
+		  uint64_t  count);
+  bool  atLimit () const;
+  void  skipSpin ();
 
   void clearTrapAndRestartInstruction (void);
+  void flushWaveform ();
   bool step (void);
   bool inReset (void) const;
   bool haveTrap (void) const;
@@ -56,6 +68,25 @@ class Picorv32Impl final
 		 uint32_t     val);
   uint32_t readProgramAddr () const;
   void writeProgramAddr (uint32_t addr);
+  uint64_t readCountInstr () const;
+
+  // Monitor commands
+
+  void  registerCommands (CommandRegistry & reg);
+
+  // Checkpoint files
+
+  bool  saveCheckpoint (const std::string & filename);
+  bool  restoreCheckpoint (const std::string & filename);
+
+  // Snapshots
+
+  bool  saveSnapshot (std::vector<uint8_t> & state);
+  bool  restoreSnapshot (const std::vector<uint8_t> & state);
+
+  // Threads
+
+  bool  threaded () const;
 
   // Verilog support functions
 
@@ -68,15 +99,11 @@ class Picorv32Impl final
 
   Vtestbench * mCpu;
 
-  //! Do we want a VCD trace?
+  //! Waveform, if dumping one
 
-  bool  mWantVcd;
+  Waveform * mWave;
 
-  //! VCD trace file pointer
-
-  VerilatedVcdC * mTfp;
-
-  //! VCD time. This will be in ns and we have a 100MHz device
+  //! Waveform time. This will be in ns and we have a 100MHz device
 
   vluint64_t  mCpuTime;
 
@@ -84,13 +111,70 @@ class Picorv32Impl final
 
   uint64_t  mClk;
 
-  //! Clock
+  //! Instructions retired
 
   uint64_t  mInstr;
 
+  //! The core's instruction counter when last read
+
+  uint64_t  mLastCountInstr;
+
+  //! Clock edge count at which continuing stops
+
+  uint64_t  mClkLimit;
+
+  //! Instruction count at which continuing stops
+
+  uint64_t  mInstrLimit;
+
+  //! PC sampling profiler, counting cycles
+
+  Profiler  mProfiler;
+
+  //! Executed instruction coverage
+
+  Coverage  mCoverage;
+
+  //! Load and store trace
+
+  MemTrace  mMemTrace;
+
+  //! Spin loops found while continuing, timed in clock edges
+
+  SpinDetector  mSpin;
+
+  // Instrumentation fed as the clock advances. Each is a bit of the
+  // template argument of clockStepWith (), so a specialization only tests
+  // for what it feeds.
+
+  static const unsigned int  PROBE_WAVE     = 1 << 0;	//!< Waveform
+  static const unsigned int  PROBE_MEMTRACE = 1 << 1;	//!< Memory trace
+  static const unsigned int  PROBE_PROFILE  = 1 << 2;	//!< Profiler
+  static const unsigned int  NUM_CLOCKS     = 1 << 3;	//!< Specializations
+
+  //! A specialization of clockStepWith ()
+
+  typedef void (Picorv32Impl::*ClockFn) ();
+
+  //! Every specialization, indexed by the instrumentation it feeds
+
+  static const ClockFn  CLOCK_FNS[NUM_CLOCKS];
+
+  //! The specialization for the instrumentation in use
+
+  ClockFn  mClockFn;
+
   //! For advancing the clock
 
-  void clockStep (void);
+  void clockStep (void)
+  {
+    (this->*mClockFn) ();
+  }
+
+  template <unsigned int PROBES>
+  void clockStepWith (void);
+  void selectClock (void);
+  void traceMem (void);
 };
 
 #endif
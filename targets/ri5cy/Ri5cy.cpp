@@ -139,6 +139,40 @@ Ri5cy::getInstrCount (void) const
 }	// Ri5cy::getInstrCount ()
 
 
+//! Does the target count instructions?
+
+//! Instructions are counted from the decode stage, which can only be
+//! read if the model was verilated with --public.
+
+//! @return  TRUE if the model is public, FALSE otherwise.
+
+bool
+Ri5cy::countsInstrs () const
+{
+#ifdef HAVE_PUBLIC_MODELS
+  return  true;
+#else
+  return  false;
+#endif
+}	// Ri5cy::countsInstrs ()
+
+
+//! Set a limit on continuing
+
+//! Wrapper for the implementation class.
+
+//! @param[in] type   Whether the limit is on cycles or instructions
+//! @param[in] count  The count at which to stop, or NO_LIMIT
+
+void
+Ri5cy::setLimit (LimitType  type,
+		 uint64_t  count)
+{
+  mRi5cyImpl->setLimit (type, count);
+
+}	// Ri5cy::setLimit ()
+
+
 //! Read a register
 
 //! Wrapper for the implementation class.
@@ -245,21 +279,104 @@ Ri5cy::removeMatchpoint (const uint32_t  addr,
 }	// Ri5cy::removeMatchpoint ()
 
 
-//! Pass a command through to the target
+//! Add the target's monitor commands to a registry
+
+//! Wrapper for the implementation class.
+
+//! @param[in] reg  The registry
+
+void
+Ri5cy::registerCommands (CommandRegistry & reg)
+{
+  mRi5cyImpl->registerCommands (reg);
+
+}	// Ri5cy::registerCommands ()
+
+
+//! Save a checkpoint file
+
+//! Wrapper for the implementation class.
+
+//! @param[in] filename  The file to write
+//! @return  TRUE if the checkpoint was saved, FALSE otherwise.
+
+bool
+Ri5cy::saveCheckpoint (const std::string & filename)
+{
+  return  mRi5cyImpl->saveCheckpoint (filename);
+
+}	// Ri5cy::saveCheckpoint ()
+
+
+//! Restore a checkpoint file
 
 //! Wrapper for the implementation class.
 
-//! @param[in]  cmd  The command being passed
-//! @param[out] stream  Stream on which to write any response.
-//! @return  TRUE if the command succeeded, FALSE otherwise.
+//! @param[in] filename  The file to read
+//! @return  TRUE if the checkpoint was restored, FALSE otherwise.
+
+bool
+Ri5cy::restoreCheckpoint (const std::string & filename)
+{
+  return  mRi5cyImpl->restoreCheckpoint (filename);
+
+}	// Ri5cy::restoreCheckpoint ()
+
+
+//! Save a snapshot
+
+//! Wrapper for the implementation class.
+
+//! @param[out] state  The saved state
+//! @return  TRUE if the snapshot was taken, FALSE otherwise.
+
+bool
+Ri5cy::saveSnapshot (std::vector<uint8_t> & state)
+{
+  return  mRi5cyImpl->saveSnapshot (state);
+
+}	// Ri5cy::saveSnapshot ()
+
+
+//! Restore a snapshot
+
+//! Wrapper for the implementation class.
+
+//! @param[in] state  State saved by saveSnapshot ()
+//! @return  TRUE if the snapshot was restored, FALSE otherwise.
+
+bool
+Ri5cy::restoreSnapshot (const std::vector<uint8_t> & state)
+{
+  return  mRi5cyImpl->restoreSnapshot (state);
+
+}	// Ri5cy::restoreSnapshot ()
+
+
+//! Wrapper for the implementation class
+
+//! @return  TRUE if the target has threads of its own running, FALSE
+//!          otherwise.
+
+bool
+Ri5cy::threaded () const
+{
+  return  mRi5cyImpl->threaded ();
+
+}	// Ri5cy::threaded ()
+
+
+//! Wrapper for the implementation class
+
+//! @param[in] pcs  Where to record the PCs, or nullptr
+//! @return  TRUE if the PCs can be recorded, FALSE otherwise.
 
 bool
-Ri5cy::command (const std::string  cmd,
-		std::ostream & stream)
+Ri5cy::traceRetired (std::vector<uint32_t> * pcs)
 {
-  return  mRi5cyImpl->command (cmd, stream);
+  return  mRi5cyImpl->traceRetired (pcs);
 
-}	// Ri5cy::command ()
+}	// Ri5cy::traceRetired ()
 
 
 //! Wrapper for the implementation class
@@ -22,13 +22,18 @@
 
 #include <iostream>
 #include <cstdint>
+#include <algorithm>
 #include <cstdlib>
 #include <sstream>
 
+#include "CheckpointFile.h"
+#include "CommandRegistry.h"
 #include "GdbServer.h"
+#include "InstrTrace.h"
 #include "Ri5cyImpl.h"
+#include "StateBuffer.h"
 #include "TraceFlags.h"
-#include "verilated_vcd_c.h"
+#include "Waveform.h"
 #include "Vtop.h"
 #include "Vtop__Syms.h"
 
@@ -53,20 +58,41 @@ Ri5cyImpl::Ri5cyImpl (const TraceFlags * flags) :
   mCoreHalted (false),
   mCycleCnt (0),
   mInstrCnt (0),
-  mCpuTime (0)
+  mCycleLimit (ITarget::NO_LIMIT),
+  mInstrLimit (ITarget::NO_LIMIT),
+  mWave (nullptr),
+  mCpuTime (0),
+  mProfiler (1.0e9 / CLK_PERIOD_NS),
+  mTrace (nullptr),
+  mRetired (nullptr),
+  mClockFn (CLOCK_FNS[0])
 {
   mCpu = new Vtop;
 
-  // Open VCD file if requested
+  // Start dumping the waveform if requested
 
   if (mFlags->traceVcd ())
     {
-      Verilated::traceEverOn (true);
-      mTfp = new VerilatedVcdC;
-      mCpu->trace (mTfp, 99);
-      mTfp->open ("gdbserver.vcd");
+      mWave = new Waveform ("gdbserver");
+      mCpu->trace (mWave->traceFile (), 99);
+      mWave->start ();
     }
 
+  // Open instruction trace if requested. Instructions are taken from the
+  // decode stage, which is only visible in a public model.
+
+  if (mFlags->traceDisas ())
+    {
+#ifdef HAVE_PUBLIC_MODELS
+      mTrace = new InstrTrace ("gdbserver.trace", sizeof (uint_reg_t));
+#else
+      cerr << "Warning: RI5CY model is not public: no instruction trace"
+	   << endl;
+#endif
+    }
+
+  selectClock ();
+
   // Reset and halt the model
 
   resetModel ();
@@ -76,14 +102,12 @@ Ri5cyImpl::Ri5cyImpl (const TraceFlags * flags) :
 
 //! Destructor.
 
-//! Close VCD and delete the Verilator model.
+//! Close waveform and instruction trace and delete the Verilator model.
 
 Ri5cyImpl::~Ri5cyImpl ()
 {
-  // Close VCD file if requested
-
-  if (mFlags->traceVcd ())
-    mTfp->close ();
+  delete mWave;
+  delete mTrace;
 
   delete mCpu;
 
@@ -110,6 +134,9 @@ Ri5cyImpl::resume (ITarget::ResumeType step)
 
 //! @todo
 
+//! The waveform is flushed whenever execution stops, so it can be viewed
+//! while GDB is still connected.
+
 //! @param[in]  step         The type of resume to carry out. Initially just
 //!                          STEP and CONTINUE should suffice.
 //! @param[in]  timeout      Maximum time for execution to continue.
@@ -119,22 +146,27 @@ ITarget::ResumeRes
 Ri5cyImpl::resume (ITarget::ResumeType step,
 		   duration <double>  timeout)
 {
+  ITarget::ResumeRes  res;
+
   switch (step)
     {
     case ITarget::ResumeType::STEP:
 
-      return stepInstr (timeout);
+      res = stepInstr (timeout);
+      break;
 
     case ITarget::ResumeType::CONTINUE:
 
-      return runToBreak (timeout);
+      res = runToBreak (timeout);
+      break;
 
     case ITarget::ResumeType::STOP:
 
       // Request to halt the processor (typically due to a gross timeout)
 
       haltModel ();
-      return ITarget::ResumeRes::SUCCESS;
+      res = ITarget::ResumeRes::SUCCESS;
+      break;
 
     default:
 
@@ -144,6 +176,12 @@ Ri5cyImpl::resume (ITarget::ResumeType step,
 	   << static_cast<int> (step) << endl;
       exit (EXIT_FAILURE);
     }
+
+  if (nullptr != mWave)
+    mWave->flush ();
+
+  return res;
+
 }	// Ri5cyImpl::resume ()
 
 
@@ -216,6 +254,28 @@ Ri5cyImpl::getInstrCount () const
 }	// Ri5cyImpl::getInstrCount ()
 
 
+//! Set a limit on continuing
+
+//! The limit is checked each time round the run loop, and each check reads
+//! the debug unit, which clocks the model for a few cycles. Halting the core
+//! then takes a few more cycles. So continuing stops a few cycles, and maybe
+//! a few instructions, after the limit is reached, rather than exactly on it.
+
+//! @param[in] type   Whether the limit is on cycles or instructions
+//! @param[in] count  The count at which to stop, or NO_LIMIT
+
+void
+Ri5cyImpl::setLimit (ITarget::LimitType  type,
+		     uint64_t  count)
+{
+  if (ITarget::LimitType::CYCLES == type)
+    mCycleLimit = count;
+  else
+    mInstrLimit = count;
+
+}	// Ri5cyImpl::setLimit ()
+
+
 //! Read a register
 
 //! We assume that the core is halted. If not we have a problem.  We use the
@@ -402,25 +462,262 @@ Ri5cyImpl::removeMatchpoint (const uint32_t  addr __attribute__ ((unused)),
 }	// Ri5cyImpl::removeMatchpoint ()
 
 
-//! Generic pass through of command
+//! Add the target's monitor commands to a registry
 
-//! @todo
+//! The commands are those of the profiler, coverage, the memory trace and,
+//! if the waveform is being dumped, its triggers. Starting or stopping
+//! coverage or the memory trace changes the clock specialization. Coverage
+//! and the waveform's PC trigger take the PC from the decode stage, and the
+//! memory trace taps the RAM's ports, so they need a public model.
 
-//! For now we have no commands, so we should never receive this, and thus
-//! always fail.
+//! @param[in] reg  The registry
 
-//!@param[in]  cmd     The command to process
-//!@param[out] stream  A stream to write any output from the command
-//!@return  TRUE if the command was handled successfully, FALSE otherwise. We
-//!         awlways return FALSE.
+void
+Ri5cyImpl::registerCommands (CommandRegistry & reg)
+{
+  reg.add ("profile", Profiler::HELP,
+	   [this] (const CommandArgs & args, std::ostream & stream)
+	   { return mProfiler.command (args, stream); });
+  reg.add ("coverage", Coverage::HELP,
+	   [this] (const CommandArgs & args, std::ostream & stream)
+	   {
+#ifdef HAVE_PUBLIC_MODELS
+	     bool  ok = mCoverage.command (args, stream);
+
+	     selectClock ();
+	     return ok;
+#else
+	     (void) args;
+	     stream << "No coverage: the model is not public" << std::endl;
+	     return false;
+#endif
+	   });
+  reg.add ("memtrace", MemTrace::HELP,
+	   [this] (const CommandArgs & args, std::ostream & stream)
+	   {
+#ifdef HAVE_PUBLIC_MODELS
+	     bool  ok = mMemTrace.command (args, stream);
+
+	     selectClock ();
+	     return ok;
+#else
+	     (void) args;
+	     stream << "No memory trace: the model is not public" << std::endl;
+	     return false;
+#endif
+	   });
+  reg.add ("vcd", Waveform::HELP,
+	   [this] (const CommandArgs & args, std::ostream & stream)
+	   {
+	     if (nullptr == mWave)
+	       {
+		 stream << "No waveform: use the vcd trace flag" << std::endl;
+		 return false;
+	       }
+
+#ifndef HAVE_PUBLIC_MODELS
+	     if (args.is (1, "pc"))
+	       {
+		 stream << "No PC trigger: the model is not public" << std::endl;
+		 return false;
+	       }
+#endif
+
+	     return mWave->command (args, stream);
+	   });
+
+}	// Ri5cyImpl::registerCommands ()
+
+
+//! Save a checkpoint file
+
+//! Memory is part of the Verilator model, so the model and whether the core
+//! is halted are all the state there is. The counters go in the header.
+
+//! @param[in] filename  The file to write
+//! @return  TRUE if the checkpoint was saved, FALSE otherwise.
 
 bool
-Ri5cyImpl::command (const std::string  cmd __attribute__ ((unused)),
-		    std::ostream & stream __attribute__ ((unused)))
+Ri5cyImpl::saveCheckpoint (const std::string & filename)
 {
-  return false;
+#ifdef HAVE_SAVABLE_MODELS
+  CheckpointWriter  ckpt;
+
+  if (! ckpt.open (filename, "RI5CY", mCycleCnt, mInstrCnt, mCpuTime))
+    return  false;
+
+  ckpt << *mCpu;
+  ckpt << mCoreHalted;
+  ckpt.close ();
+  return  ckpt.ok ();
+
+#else
+  cerr << "Warning: RI5CY model is not savable: checkpoint " << filename
+       << " not written" << endl;
+  return  false;
+
+#endif
+}	// Ri5cyImpl::saveCheckpoint ()
+
+
+//! Restore a checkpoint file
+
+//! If the file cannot be used, the model is left untouched. If it turns out
+//! to be corrupt part way through, the model is left in an unknown state.
+
+//! @param[in] filename  The file to read
+//! @return  TRUE if the checkpoint was restored, FALSE otherwise.
+
+bool
+Ri5cyImpl::restoreCheckpoint (const std::string & filename)
+{
+#ifdef HAVE_SAVABLE_MODELS
+  CheckpointReader  ckpt;
+
+  if (! ckpt.open (filename, "RI5CY"))
+    return  false;
+
+  ckpt >> *mCpu;
+  ckpt >> mCoreHalted;
+
+  if (! ckpt.complete ())
+    {
+      cerr << "Warning: Checkpoint " << filename
+	   << " does not match model: state undefined" << endl;
+      return  false;
+    }
+
+  mCycleCnt = ckpt.cycleCnt ();
+  mInstrCnt = ckpt.instrCnt ();
+  mCpuTime = ckpt.cpuTime ();
+  return  true;
+
+#else
+  cerr << "Warning: RI5CY model is not savable: checkpoint " << filename
+       << " not restored" << endl;
+  return  false;
+
+#endif
+}	// Ri5cyImpl::restoreCheckpoint ()
+
+
+//! Save a snapshot
+
+//! The same state as a checkpoint file, with the counters after it.
+
+//! @param[out] state  The saved state
+//! @return  TRUE if the snapshot was taken, FALSE otherwise.
+
+bool
+Ri5cyImpl::saveSnapshot (std::vector<uint8_t> & state
+			 __attribute__ ((unused)))
+{
+#ifdef HAVE_SAVABLE_MODELS
+  StateWriter  snap;
+
+  snap.open (state);
+  snap << *mCpu;
+  snap << mCoreHalted;
+  snap.write (&mCycleCnt, sizeof (mCycleCnt));
+  snap.write (&mInstrCnt, sizeof (mInstrCnt));
+  snap.write (&mCpuTime, sizeof (mCpuTime));
+  snap.close ();
+  return  true;
+
+#else
+  cerr << "Warning: RI5CY model is not savable: snapshot not taken" << endl;
+  return  false;
+
+#endif
+}	// Ri5cyImpl::saveSnapshot ()
+
+
+//! Restore a snapshot
+
+//! @param[in] state  State saved by saveSnapshot ()
+//! @return  TRUE if the snapshot was restored, FALSE otherwise.
+
+bool
+Ri5cyImpl::restoreSnapshot (const std::vector<uint8_t> & state
+			    __attribute__ ((unused)))
+{
+#ifdef HAVE_SAVABLE_MODELS
+  StateReader  snap;
+
+  snap.open (state);
+  snap >> *mCpu;
+  snap >> mCoreHalted;
+  snap.read (&mCycleCnt, sizeof (mCycleCnt));
+  snap.read (&mInstrCnt, sizeof (mInstrCnt));
+  snap.read (&mCpuTime, sizeof (mCpuTime));
+
+  if (! snap.complete ())
+    {
+      cerr << "Warning: Snapshot does not match model: state undefined"
+	   << endl;
+      return  false;
+    }
+
+  return  true;
+
+#else
+  cerr << "Warning: RI5CY model is not savable: snapshot not restored"
+       << endl;
+  return  false;
+
+#endif
+}	// Ri5cyImpl::restoreSnapshot ()
+
+
+//! Does the target have threads of its own running?
+
+//! Models verilated with --threads evaluate on Verilator's worker threads.
+//! The instruction trace and a running memory trace are each written by a
+//! thread of their own, as is the waveform of models verilated with
+//! --trace-threads.
+
+//! @return  TRUE if the target has threads of its own running, FALSE
+//!          otherwise.
+
+bool
+Ri5cyImpl::threaded () const
+{
+#ifdef HAVE_THREADED_MODELS
+  return  true;
+#endif
+
+#ifdef HAVE_TRACE_THREADS
+  if (nullptr != mWave)
+    return  true;
+#endif
+
+  return  (nullptr != mTrace) || mMemTrace.active ();
+
+}	// Ri5cyImpl::threaded ()
+
+
+//! Record the PC of each instruction retired
+
+//! Instructions are taken as retired as they leave the decode stage, as they
+//! are when counted, so the PCs recorded while continuing to an instruction
+//! limit are exactly those counted. The decode stage is internal to the
+//! core, so can only be read if the model was verilated with --public.
 
-}	// Ri5cyImpl::command ()
+//! @param[in] pcs  Where to record the PCs, or nullptr to stop recording
+//! @return  TRUE if the PCs can be recorded, FALSE otherwise.
+
+bool
+Ri5cyImpl::traceRetired (std::vector<uint32_t> * pcs)
+{
+#ifdef HAVE_PUBLIC_MODELS
+  mRetired = pcs;
+  selectClock ();
+  return  true;
+#else
+  (void) pcs;
+  return  false;
+#endif
+}	// Ri5cyImpl::traceRetired ()
 
 
 //! Record the server we are associated with.
@@ -451,30 +748,178 @@ Ri5cyImpl::timeStamp ()
 
 //! Helper method to clock the model
 
-//! Clock the model through one full cycle, saving to VCD if requested.  It is
-//! up to the caller to set any other signals.
+//! Clock the model through one full cycle, saving to the waveform if its
+//! trigger wants the cycle.  It is up to the caller to set any other signals.
+
+//! An instruction retires when it leaves the decode stage on the rising
+//! edge, which is the event the core's own performance counters count. The
+//! decode stage is internal to the core, so instructions are only counted if
+//! the model was verilated with --public. The RAM also takes any load or
+//! store on the rising edge.
+
+//! This is specialized for the instrumentation to be fed, given by PROBES,
+//! so the common case with none has nothing to test. clockModel () calls the
+//! specialization chosen by selectClock ().
 
+template <unsigned int PROBES>
 void
-Ri5cyImpl::clockModel ()
+Ri5cyImpl::clockModelWith ()
 {
   mCpu->clk_i = 0;
   mCpu->eval ();
 
+#ifdef HAVE_PUBLIC_MODELS
+  if (mCpu->top->riscv_core_i->id_valid
+      && mCpu->top->riscv_core_i->is_decoding)
+    {
+      mInstrCnt++;
+
+      if (PROBES & PROBE_COVERAGE)
+	mCoverage.hit (mCpu->top->riscv_core_i->pc_id);
+
+      if (PROBES & PROBE_TRACE)
+	traceInsn (mCpu->top->riscv_core_i->pc_id);
+
+      if (PROBES & PROBE_RETIRED)
+	mRetired->push_back (mCpu->top->riscv_core_i->pc_id);
+    }
+#endif
+
+  if (PROBES & PROBE_MEMTRACE)
+    traceMem ();
+
   mCpuTime += CLK_PERIOD_NS / 2;
 
-  if (mFlags->traceVcd ())
-    mTfp->dump (mCpuTime);
+  bool  dumping = (PROBES & PROBE_WAVE)
+    && mWave->wanted (mCycleCnt, decodePc ());
+
+  if (dumping)
+    mWave->dump (mCpuTime);
 
   mCpu->clk_i = 1;
   mCpu->eval ();
 
   mCpuTime += CLK_PERIOD_NS / 2;
 
-  if (mFlags->traceVcd ())
-    mTfp->dump (mCpuTime);
+  if (dumping)
+    mWave->dump (mCpuTime);
 
   mCycleCnt++;
-}	// Ri5cyImpl::clockModel ()
+}	// Ri5cyImpl::clockModelWith ()
+
+
+//! Every specialization of clockModelWith ()
+
+const Ri5cyImpl::ClockFn  Ri5cyImpl::CLOCK_FNS[NUM_CLOCKS] =
+  {
+    &Ri5cyImpl::clockModelWith<0>,  &Ri5cyImpl::clockModelWith<1>,
+    &Ri5cyImpl::clockModelWith<2>,  &Ri5cyImpl::clockModelWith<3>,
+    &Ri5cyImpl::clockModelWith<4>,  &Ri5cyImpl::clockModelWith<5>,
+    &Ri5cyImpl::clockModelWith<6>,  &Ri5cyImpl::clockModelWith<7>,
+    &Ri5cyImpl::clockModelWith<8>,  &Ri5cyImpl::clockModelWith<9>,
+    &Ri5cyImpl::clockModelWith<10>, &Ri5cyImpl::clockModelWith<11>,
+    &Ri5cyImpl::clockModelWith<12>, &Ri5cyImpl::clockModelWith<13>,
+    &Ri5cyImpl::clockModelWith<14>, &Ri5cyImpl::clockModelWith<15>,
+    &Ri5cyImpl::clockModelWith<16>, &Ri5cyImpl::clockModelWith<17>,
+    &Ri5cyImpl::clockModelWith<18>, &Ri5cyImpl::clockModelWith<19>,
+    &Ri5cyImpl::clockModelWith<20>, &Ri5cyImpl::clockModelWith<21>,
+    &Ri5cyImpl::clockModelWith<22>, &Ri5cyImpl::clockModelWith<23>,
+    &Ri5cyImpl::clockModelWith<24>, &Ri5cyImpl::clockModelWith<25>,
+    &Ri5cyImpl::clockModelWith<26>, &Ri5cyImpl::clockModelWith<27>,
+    &Ri5cyImpl::clockModelWith<28>, &Ri5cyImpl::clockModelWith<29>,
+    &Ri5cyImpl::clockModelWith<30>, &Ri5cyImpl::clockModelWith<31>
+  };
+
+
+//! Helper method to choose the clock specialization
+
+//! The waveform and instruction trace are fixed when we are constructed,
+//! but coverage and the memory trace come and go with monitor commands, so
+//! this is called again after those.
+
+void
+Ri5cyImpl::selectClock ()
+{
+  unsigned int  probes = 0;
+
+  if (nullptr != mWave)
+    probes |= PROBE_WAVE;
+
+  if (nullptr != mTrace)
+    probes |= PROBE_TRACE;
+
+  if (mCoverage.active ())
+    probes |= PROBE_COVERAGE;
+
+  if (mMemTrace.active ())
+    probes |= PROBE_MEMTRACE;
+
+  if (nullptr != mRetired)
+    probes |= PROBE_RETIRED;
+
+  mClockFn = CLOCK_FNS[probes];
+
+}	// Ri5cyImpl::selectClock ()
+
+
+//! Helper method to read the PC of the decode stage
+
+//! The decode stage is internal to the core, so can only be read if the model
+//! was verilated with --public. Otherwise the PC always reads as zero.
+
+//! @return  The PC of the instruction in the decode stage
+
+uint32_t
+Ri5cyImpl::decodePc () const
+{
+#ifdef HAVE_PUBLIC_MODELS
+  return  mCpu->top->riscv_core_i->pc_id;
+#else
+  return  0;
+#endif
+}	// Ri5cyImpl::decodePc ()
+
+
+//! Helper method to record an instruction in the instruction trace
+
+//! The decode stage only holds the instruction after any compressed
+//! instruction has been expanded, so the original is read from memory.
+
+//! @param[in] pc  Address of the instruction leaving the decode stage
+
+void
+Ri5cyImpl::traceInsn (uint32_t  pc)
+{
+  auto ram = mCpu->top->ram_i->dp_ram_i;
+  uint32_t  insn = ram->readByte (pc) | (ram->readByte (pc + 1) << 8);
+
+  if (3 == (insn & 3))
+    insn |= (ram->readByte (pc + 2) << 16) | (ram->readByte (pc + 3) << 24);
+
+  mTrace->record (pc, insn);
+
+}	// Ri5cyImpl::traceInsn ()
+
+
+//! Helper method to record any load or store in the memory trace
+
+//! Port B of the RAM is the data port. The byte enables give the bytes of
+//! the word accessed, for loads as well as stores. The ports can only be
+//! read if the model was verilated with --public, and the trace cannot be
+//! started otherwise.
+
+void
+Ri5cyImpl::traceMem ()
+{
+#ifdef HAVE_PUBLIC_MODELS
+  auto ram = mCpu->top->ram_i->dp_ram_i;
+  unsigned int  be = ram->be_b_i & 0xf;
+
+  if (ram->en_b_i && (0 != be))
+    mMemTrace.access (mCycleCnt, (ram->addr_b_i & ~3U) + __builtin_ctz (be),
+		      __builtin_popcount (be), ram->we_b_i);
+#endif
+}	// Ri5cyImpl::traceMem ()
 
 
 //! Helper method to reset the model
@@ -543,6 +988,55 @@ Ri5cyImpl::waitForHalt ()
 }	// Ri5cyImpl::waitForHalt ()
 
 
+//! How many cycles can be skipped while the core sleeps
+
+//! A core which has executed WFI sleeps with its clock gated until an
+//! interrupt or a debug request. Our model has no timer and raises no
+//! interrupts, so only a debug request from us can wake it. The core is
+//! cheaply seen to be idle from its busy signal, then the debug unit is asked
+//! whether it is asleep. The busy signal is internal to the core, so can only
+//! be read if the model was verilated with --public. Asking the debug unit
+//! every cycle instead would slow down every run, so otherwise nothing is
+//! skipped.
+
+//! Cycles can be skipped up to the next which matters to us: the cycle
+//! limit, the next profiler sample or the next cycle of waveform to be
+//! dumped. No more than MAX_SLEEP_SKIP are skipped, so the run loop still
+//! checks for timeout, and hence for an interrupt from GDB.
+
+//! @return  The number of cycles which can be skipped, 0 if the core is
+//!          awake.
+
+uint64_t
+Ri5cyImpl::sleepSkip ()
+{
+#ifdef HAVE_PUBLIC_MODELS
+  if (mCpu->top->riscv_core_i->core_busy_o
+      || (0 == (readDebugReg (DBG_HIT) & DBG_HIT_SLEEP)))
+    return 0;
+#else
+  return 0;
+#endif
+
+  if (mCycleCnt >= mCycleLimit)
+    return 0;
+
+  uint64_t  skip = std::min (MAX_SLEEP_SKIP, mCycleLimit - mCycleCnt);
+
+  skip = std::min (skip, mProfiler.untilSample ());
+
+  if (nullptr != mWave)
+    {
+      uint64_t  next = mWave->nextWanted (mCycleCnt);
+
+      skip = (next <= mCycleCnt) ? 0 : std::min (skip, next - mCycleCnt);
+    }
+
+  return skip;
+
+}	// Ri5cyImpl::sleepSkip ()
+
+
 //! Helper function to read a debug register.
 
 //! This only sets the debug signals. It is up to the caller to set any other
@@ -625,6 +1119,8 @@ Ri5cyImpl::stepInstr (duration <double>  timeout)
 
   mCpu->fetch_enable_i = 1;
 
+  uint64_t  startCycle = mCycleCnt;
+
   writeDebugReg (DBG_CTRL, DBG_CTRL_SSTE);		// SSTE
   writeDebugReg (DBG_HIT, 0);				// Release
   waitForHalt ();
@@ -636,6 +1132,9 @@ Ri5cyImpl::stepInstr (duration <double>  timeout)
 
   uint32_t stoppedAddress = readDebugReg (DBG_PPC);
 
+  if (mProfiler.tick (mCycleCnt - startCycle))
+    mProfiler.sample (stoppedAddress);
+
   // If the instruction that we were just at was an EBREAK then we either
   // just hit a breakpoint, or we're at the syscall point.
   if (mCpu->top->ram_i->dp_ram_i->readByte (stoppedAddress + 0) == 0x73 &&
@@ -707,14 +1206,43 @@ Ri5cyImpl::runToBreak (duration <double>  timeout)
 
   // @todo this is a type of waitForHalt
 
+  // Reading a debug register clocks the model, so count cycles from the
+  // cycle count. The profiler reads the PC through the debug unit without
+  // halting the core.
+
+  uint64_t  lastCycle = mCycleCnt;
+
   while (DBG_CTRL_HALT != (readDebugReg (DBG_CTRL) & DBG_CTRL_HALT))
-    if (haveTimeout && (system_clock::now () > timeout_end))
+    if ((mCycleCnt >= mCycleLimit) || (mInstrCnt >= mInstrLimit))
+      {
+	haltModel ();
+	return ITarget::ResumeRes::LIMIT;
+      }
+    else if (haveTimeout && (system_clock::now () > timeout_end))
       {
 	haltModel ();
 	return ITarget::ResumeRes::TIMEOUT;
       }
     else
-      clockModel ();
+      {
+	uint64_t  skip = sleepSkip ();
+
+	if (0 == skip)
+	  clockModel ();
+	else
+	  {
+	    // Nothing changes while the core sleeps, so move time on as if
+	    // the cycles had been clocked.
+
+	    mCycleCnt += skip;
+	    mCpuTime += skip * CLK_PERIOD_NS;
+	  }
+
+	if (mProfiler.tick (mCycleCnt - lastCycle))
+	  mProfiler.sample (readDebugReg (DBG_PPC));
+
+	lastCycle = mCycleCnt;
+      }
 
   if (stoppedAtSyscall ())
     return ITarget::ResumeRes::SYSCALL;
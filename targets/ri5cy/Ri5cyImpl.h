@@ -24,11 +24,19 @@
 #define RI5CY_IMPL_H
 
 #include <cstdint>
+#include <vector>
 
+#include "Coverage.h"
 #include "ITarget.h"
+#include "MemTrace.h"
+#include "Profiler.h"
 #include "Vtop.h"
 
 
+class InstrTrace;
+class Waveform;
+
+
 //! The RI5CY implementation class.
 
 //! This class has all the operational implementation
@@ -49,6 +57,8 @@ class Ri5cyImpl final
 
   uint64_t  getCycleCount () const;
   uint64_t  getInstrCount () const;
+  void  setLimit (ITarget::LimitType  type,
+		  uint64_t  count);
 
   // Read contents of a target register.
 
@@ -80,10 +90,27 @@ class Ri5cyImpl final
   bool  removeMatchpoint (const uint32_t  addr,
 			  const ITarget::MatchType  matchType);
 
-  // Generic pass through of command
+  // Monitor commands
+
+  void  registerCommands (CommandRegistry & reg);
+
+  // Checkpoint files
+
+  bool  saveCheckpoint (const std::string & filename);
+  bool  restoreCheckpoint (const std::string & filename);
+
+  // Snapshots
+
+  bool  saveSnapshot (std::vector<uint8_t> & state);
+  bool  restoreSnapshot (const std::vector<uint8_t> & state);
+
+  // Threads
+
+  bool  threaded () const;
 
-  bool command (const std::string  cmd,
-		std::ostream & stream);
+  // Retired instructions
+
+  bool  traceRetired (std::vector<uint32_t> * pcs);
 
   // Identify the server
 
@@ -100,6 +127,11 @@ private:
 
   const unsigned int  CLK_PERIOD_NS = 20;
 
+  //! Most cycles skipped at once while the core sleeps, so the run loop
+  //! still checks for timeout
+
+  const uint64_t  MAX_SLEEP_SKIP = 1000000;
+
   //! How many cycles of reset
 
   const int RESET_CYCLES = 5;
@@ -171,20 +203,84 @@ private:
 
   uint64_t  mInstrCnt;
 
-  //! VCD trace file pointer
+  //! Cycle count at which continuing stops
+
+  uint64_t  mCycleLimit;
+
+  //! Instruction count at which continuing stops
 
-  VerilatedVcdC * mTfp;
+  uint64_t  mInstrLimit;
 
-  //! VCD time. This will be in ns and we have a 50MHz device
+  //! Waveform, if dumping one
+
+  Waveform * mWave;
+
+  //! Waveform time. This will be in ns and we have a 50MHz device
 
   vluint64_t  mCpuTime;
 
+  //! PC sampling profiler, counting cycles
+
+  Profiler  mProfiler;
+
+  //! Executed instruction coverage
+
+  Coverage  mCoverage;
+
+  //! Load and store trace
+
+  MemTrace  mMemTrace;
+
+  //! Instruction trace, if enabled
+
+  InstrTrace * mTrace;
+
+  //! Where to record the PC of each instruction retired, if anywhere
+
+  std::vector<uint32_t> * mRetired;
+
+  // Instrumentation fed as the model is clocked. Each is a bit of the
+  // template argument of clockModelWith (), so a specialization only tests
+  // for what it feeds.
+
+  static const unsigned int  PROBE_WAVE     = 1 << 0;	//!< Waveform
+  static const unsigned int  PROBE_TRACE    = 1 << 1;	//!< Instr trace
+  static const unsigned int  PROBE_COVERAGE = 1 << 2;	//!< Coverage
+  static const unsigned int  PROBE_MEMTRACE = 1 << 3;	//!< Memory trace
+  static const unsigned int  PROBE_RETIRED  = 1 << 4;	//!< Retired PCs
+  static const unsigned int  NUM_CLOCKS     = 1 << 5;	//!< Specializations
+
+  //! A specialization of clockModelWith ()
+
+  typedef void (Ri5cyImpl::*ClockFn) ();
+
+  //! Every specialization, indexed by the instrumentation it feeds
+
+  static const ClockFn  CLOCK_FNS[NUM_CLOCKS];
+
+  //! The specialization for the instrumentation in use
+
+  ClockFn  mClockFn;
+
   // Helper methods
 
-  void clockModel ();
+  //! Clock the model for one cycle
+
+  void clockModel ()
+  {
+    (this->*mClockFn) ();
+  }
+
+  template <unsigned int PROBES>
+  void clockModelWith ();
+  void selectClock ();
+  uint32_t decodePc () const;
+  void traceInsn (uint32_t  pc);
+  void traceMem ();
   void resetModel ();
   void haltModel ();
   void waitForHalt ();
+  uint64_t sleepSkip ();
   uint_reg_t readDebugReg (const uint16_t  dbg_reg);
   void writeDebugReg (const uint16_t  dbg_reg,
 		      const uint_reg_t  dbg_val);
@@ -0,0 +1,164 @@
+// Binary instruction trace: definition
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include "InstrTrace.h"
+
+using std::cerr;
+using std::endl;
+using std::lock_guard;
+using std::mutex;
+using std::string;
+using std::thread;
+using std::unique_lock;
+
+
+//! Constructor.
+
+//! Open the file, write the header and start the writer thread. If the file
+//! cannot be opened, the trace is discarded, with a warning.
+
+//! @param[in] filename  The file to write
+//! @param[in] regBytes  Bytes in a register
+
+InstrTrace::InstrTrace (const string & filename,
+			unsigned int   regBytes) :
+  mBuf (BLOCK_SIZE * NUM_BLOCKS),
+  mFilled (0),
+  mWritten (0),
+  mNextPc (0),
+  mStop (false)
+{
+  mFile = fopen (filename.c_str (), "wb");
+
+  if (nullptr == mFile)
+    cerr << "Warning: Unable to open instruction trace " << filename << ": "
+	 << strerror (errno) << endl;
+  else
+    {
+      uint8_t  header[16];
+
+      memset (header, 0, sizeof (header));
+      memcpy (header, "RVITRACE", 8);
+      header[8] = static_cast<uint8_t> (INSTRTRACE_VERSION);
+      header[9] = static_cast<uint8_t> (INSTRTRACE_VERSION >> 8);
+      header[10] = static_cast<uint8_t> (regBytes);
+      fwrite (header, 1, sizeof (header), mFile);
+    }
+
+  mCur = mBuf.data ();
+  mLimit = mCur + BLOCK_SIZE - MAX_RECORD;
+  mRec = mCur;
+  mWriter = thread (&InstrTrace::writer, this);
+
+}	// InstrTrace::InstrTrace ()
+
+
+//! Destructor.
+
+//! Hand over the last block, and wait for the writer thread to write
+//! everything out.
+
+InstrTrace::~InstrTrace ()
+{
+  {
+    lock_guard<mutex>  lock (mMutex);
+    uint8_t * blk = mBuf.data () + (mFilled % NUM_BLOCKS) * BLOCK_SIZE;
+
+    mUsed[mFilled % NUM_BLOCKS] = mCur - blk;
+    mFilled++;
+    mStop = true;
+  }
+
+  mChanged.notify_all ();
+  mWriter.join ();
+
+  if (nullptr != mFile)
+    fclose (mFile);
+
+}	// InstrTrace::~InstrTrace ()
+
+
+//! Hand over the current block and move to the next one
+
+//! If every block is waiting to be written, wait for the writer thread.
+
+void
+InstrTrace::nextBlock ()
+{
+  unique_lock<mutex>  lock (mMutex);
+  uint8_t * blk = mBuf.data () + (mFilled % NUM_BLOCKS) * BLOCK_SIZE;
+
+  mUsed[mFilled % NUM_BLOCKS] = mCur - blk;
+  mFilled++;
+  mChanged.notify_all ();
+  mChanged.wait (lock, [this] { return mFilled - mWritten < NUM_BLOCKS; });
+
+  mCur = mBuf.data () + (mFilled % NUM_BLOCKS) * BLOCK_SIZE;
+  mLimit = mCur + BLOCK_SIZE - MAX_RECORD;
+
+}	// InstrTrace::nextBlock ()
+
+
+//! The writer thread
+
+//! Write out each block as it is filled, until told to stop and there is
+//! nothing left to write.
+
+void
+InstrTrace::writer ()
+{
+  unique_lock<mutex>  lock (mMutex);
+
+  while (true)
+    {
+      mChanged.wait (lock, [this] { return mStop || (mWritten != mFilled); });
+
+      if (mWritten == mFilled)
+	return;
+
+      std::size_t  blk = mWritten % NUM_BLOCKS;
+
+      lock.unlock ();
+
+      if ((nullptr != mFile)
+	  && (fwrite (mBuf.data () + blk * BLOCK_SIZE, 1, mUsed[blk], mFile)
+	      != mUsed[blk]))
+	{
+	  cerr << "Warning: Unable to write instruction trace: "
+	       << strerror (errno) << ": trace abandoned" << endl;
+	  fclose (mFile);
+	  mFile = nullptr;
+	}
+
+      lock.lock ();
+      mWritten++;
+      mChanged.notify_all ();
+    }
+}	// InstrTrace::writer ()
+
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// show-trailing-whitespace: t
+// End:
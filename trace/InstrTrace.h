@@ -0,0 +1,268 @@
+// Binary instruction trace: declaration
+
+// Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+// This file is part of the RISC-V GDB server
+
+// This program is free software: you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or (at your
+// option) any later version.
+
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License for more details.
+
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef INSTR_TRACE_H
+#define INSTR_TRACE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+//! A compact binary trace of the instructions executed.
+
+//! The file starts with a 16 byte header: the magic "RVITRACE", a 16-bit
+//! version, the size of a register in bytes and 5 reserved bytes. Then there
+//! is a record for each instruction, which starts with a byte of flags:
+//! - bit 0 (SEQ) if the PC follows on from the last instruction
+//! - bit 1 (COMP) if the instruction is 16 bits
+//! - bit 2 (WB) if a register write follows
+//! - bits 3-7 the register written, if WB is set
+
+//! Unless SEQ is set, the difference of the PC from the one expected follows,
+//! zigzag encoded as an LEB128. Then there is the instruction, 2 or 4 bytes
+//! little endian, and if WB is set, the value written as an LEB128.
+
+//! Records are built in blocks, which a background thread writes to the
+//! file. The target only waits if all the blocks are waiting to be written.
+//! trace/rvtrace.py decodes and disassembles the file.
+
+class InstrTrace
+{
+public:
+
+  // Constructor and destructor
+
+  InstrTrace (const std::string & filename,
+	      unsigned int         regBytes);
+  ~InstrTrace ();
+
+  // Record an instruction
+
+  //! Record an instruction which writes no register
+
+  //! @param[in] pc    Address of the instruction
+  //! @param[in] insn  The instruction. The upper 16 bits are ignored if it
+  //!                  is compressed.
+
+  inline void  record (uint32_t  pc,
+		       uint32_t  insn)
+  {
+    uint8_t * p = start ();
+
+    *mRec = flags (pc, insn);
+    finish (p, pc, insn);
+  }
+
+  //! Record an instruction which writes a register
+
+  //! @param[in] pc     Address of the instruction
+  //! @param[in] insn   The instruction
+  //! @param[in] rd     The register written
+  //! @param[in] value  The value written
+
+  inline void  record (uint32_t  pc,
+		       uint32_t  insn,
+		       unsigned int  rd,
+		       uint64_t  value)
+  {
+    uint8_t * p = start ();
+
+    *mRec = flags (pc, insn) | FLAG_WB | (rd << RD_SHIFT);
+    p = finish (p, pc, insn);
+    mCur = putUleb (p, value);
+  }
+
+
+private:
+
+  //! Bytes in a block of records
+
+  static const std::size_t  BLOCK_SIZE = 64 * 1024;
+
+  //! Number of blocks
+
+  static const unsigned int  NUM_BLOCKS = 16;
+
+  //! Largest record: flags, PC delta, instruction and value
+
+  static const std::size_t  MAX_RECORD = 1 + 5 + 4 + 10;
+
+  //! Version of the file format
+
+  static const uint16_t  INSTRTRACE_VERSION = 1;
+
+  // Record flags
+
+  static const uint8_t  FLAG_SEQ  = 0x01;	//!< PC follows on
+  static const uint8_t  FLAG_COMP = 0x02;	//!< 16-bit instruction
+  static const uint8_t  FLAG_WB   = 0x04;	//!< Register write follows
+  static const unsigned int  RD_SHIFT = 3;	//!< Position of register
+
+  //! The trace file, or nullptr if it could not be opened
+
+  FILE * mFile;
+
+  //! All the blocks
+
+  std::vector<uint8_t>  mBuf;
+
+  //! Bytes used in each block, once it is full
+
+  std::size_t  mUsed[NUM_BLOCKS];
+
+  //! Where the next record goes
+
+  uint8_t * mCur;
+
+  //! The last place a record may start in the current block
+
+  uint8_t * mLimit;
+
+  //! Where the current record starts
+
+  uint8_t * mRec;
+
+  //! Blocks filled. The current block is mFilled % NUM_BLOCKS.
+
+  uint64_t  mFilled;
+
+  //! Blocks written to the file
+
+  uint64_t  mWritten;
+
+  //! The PC expected next
+
+  uint32_t  mNextPc;
+
+  //! Guard for mFilled, mWritten and mStop
+
+  std::mutex  mMutex;
+
+  //! Signalled when a block is filled or written, or on stopping
+
+  std::condition_variable  mChanged;
+
+  //! Set when the writer thread should finish
+
+  bool  mStop;
+
+  //! The writer thread
+
+  std::thread  mWriter;
+
+  // Helper functions
+
+  //! Start a record, moving to the next block if this one is full
+
+  //! @return  Where the rest of the record goes, after the flags
+
+  inline uint8_t * start ()
+  {
+    if (mCur > mLimit)
+      nextBlock ();
+
+    mRec = mCur;
+    return mCur + 1;
+  }
+
+  //! The flags for an instruction, without any register write
+
+  //! @param[in] pc    Address of the instruction
+  //! @param[in] insn  The instruction
+  //! @return  The flags
+
+  inline uint8_t  flags (uint32_t  pc,
+			 uint32_t  insn) const
+  {
+    return ((pc == mNextPc) ? FLAG_SEQ : 0)
+      | ((3 != (insn & 3)) ? FLAG_COMP : 0);
+  }
+
+  //! Add the PC and instruction to a record
+
+  //! @param[in] p     Where they go
+  //! @param[in] pc    Address of the instruction
+  //! @param[in] insn  The instruction
+  //! @return  Where the next part of the record goes
+
+  inline uint8_t * finish (uint8_t * p,
+			   uint32_t  pc,
+			   uint32_t  insn)
+  {
+    if (pc != mNextPc)
+      {
+	int32_t  delta = static_cast<int32_t> (pc - mNextPc);
+
+	p = putUleb (p, (static_cast<uint32_t> (delta) << 1)
+		     ^ static_cast<uint32_t> (delta >> 31));
+      }
+
+    *p++ = static_cast<uint8_t> (insn);
+    *p++ = static_cast<uint8_t> (insn >> 8);
+
+    if (3 == (insn & 3))
+      {
+	*p++ = static_cast<uint8_t> (insn >> 16);
+	*p++ = static_cast<uint8_t> (insn >> 24);
+	mNextPc = pc + 4;
+      }
+    else
+      mNextPc = pc + 2;
+
+    mCur = p;
+    return p;
+  }
+
+  //! Write an unsigned LEB128
+
+  //! @param[in] p    Where to write it
+  //! @param[in] val  The value to write
+  //! @return  Where the next byte goes
+
+  static inline uint8_t * putUleb (uint8_t * p,
+				   uint64_t  val)
+  {
+    while (val >= 0x80)
+      {
+	*p++ = static_cast<uint8_t> (val) | 0x80;
+	val >>= 7;
+      }
+
+    *p++ = static_cast<uint8_t> (val);
+    return p;
+  }
+
+  void  nextBlock ();
+  void  writer ();
+
+};	// class InstrTrace
+
+
+#endif	// INSTR_TRACE_H
+
+// Local Variables:
+// mode: C++
+// c-file-style: "gnu"
+// show-trailing-whitespace: t
+// End:
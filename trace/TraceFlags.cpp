@@ -140,6 +140,7 @@ TraceFlags::TraceFlags () :
       sFlagInfo.push_back ({ TRACE_BREAK,  "break"  });
       sFlagInfo.push_back ({ TRACE_VCD,    "vcd"    });
       sFlagInfo.push_back ({ TRACE_SILENT, "silent" });
+      sFlagInfo.push_back ({ TRACE_DISAS,  "disas"  });
     }
 }	// TraceFlags::TraceFlags ()
 
@@ -212,6 +213,18 @@ TraceFlags::traceSilent () const
 }	// TraceFlags::traceSilent ()
 
 
+//! Is instruction tracing enabled?
+
+//! @return  TRUE if the DISAS tracing flag is set, FALSE otherwise
+
+bool
+TraceFlags::traceDisas () const
+{
+  return (mFlags & TRACE_DISAS) == TRACE_DISAS;
+
+}	// TraceFlags::traceDisas ()
+
+
 //! Is this a real flag
 
 //! @param[in] flagName  Case insensitive name to check.
@@ -72,6 +72,7 @@ public:
   bool traceBreak () const;
   bool traceVcd () const;
   bool traceSilent () const;
+  bool traceDisas () const;
   bool isFlag (const char *flagName) const;
   void flag (const char *flagName,
 	     const bool  val);
@@ -92,7 +93,7 @@ private:
   static const unsigned int TRACE_BREAK  = 0x00000004;	//!< Trace breakpoints
   static const unsigned int TRACE_VCD    = 0x00000008;	//!< Generate VCD
   static const unsigned int TRACE_SILENT = 0x00000010;  //!< Reduce messages
-  static const unsigned int TRACE_DISAS  = 0x00000020;  //!< Reduce messages
+  static const unsigned int TRACE_DISAS  = 0x00000020;  //!< Trace instrs
 
   static const unsigned int TRACE_NONE   = 0x00000000;	//!< Trace nothing
   static const unsigned int TRACE_BAD    = 0xffffffff;	//!< Invalid flag bit
@@ -0,0 +1,368 @@
+#!/usr/bin/env python3
+# Decode and disassemble a binary instruction trace
+
+# Copyright (C) 2026  Embecosm Limited <info@embecosm.com>
+
+# This file is part of the RISC-V GDB server
+
+# This program is free software: you can redistribute it and/or modify it
+# under the terms of the GNU General Public License as published by the Free
+# Software Foundation, either version 3 of the License, or (at your option)
+# any later version.
+
+# This program is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+# more details.
+
+# You should have received a copy of the GNU General Public License along
+# with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+"""Decode a trace written with "-t disas" (see trace/InstrTrace.h).
+
+Each instruction is printed with its address, encoding and disassembly,
+followed by any register it wrote and the value written.  With --summary,
+only the number of instructions and the most frequent mnemonics are shown.
+"""
+
+import argparse
+import collections
+import mmap
+import struct
+import sys
+
+MAGIC = b'RVITRACE'
+VERSION = 1
+
+FLAG_SEQ = 0x01
+FLAG_COMP = 0x02
+FLAG_WB = 0x04
+RD_SHIFT = 3
+
+ABI = ['zero', 'ra', 'sp', 'gp', 'tp', 't0', 't1', 't2',
+       's0', 's1', 'a0', 'a1', 'a2', 'a3', 'a4', 'a5',
+       'a6', 'a7', 's2', 's3', 's4', 's5', 's6', 's7',
+       's8', 's9', 's10', 's11', 't3', 't4', 't5', 't6']
+
+CSRS = {0x300: 'mstatus', 0x301: 'misa', 0x304: 'mie', 0x305: 'mtvec',
+        0x340: 'mscratch', 0x341: 'mepc', 0x342: 'mcause', 0x343: 'mtval',
+        0x344: 'mip', 0xb00: 'mcycle', 0xb02: 'minstret',
+        0xc00: 'cycle', 0xc01: 'time', 0xc02: 'instret',
+        0xf11: 'mvendorid', 0xf12: 'marchid', 0xf13: 'mimpid',
+        0xf14: 'mhartid'}
+
+
+def bits(val, hi, lo):
+    """Extract bits hi to lo of val."""
+    return (val >> lo) & ((1 << (hi - lo + 1)) - 1)
+
+
+def sext(val, width):
+    """Sign extend a width bit value."""
+    sign = 1 << (width - 1)
+    return (val & (sign - 1)) - (val & sign)
+
+
+def csr_name(csr):
+    return CSRS.get(csr, '0x%03x' % csr)
+
+
+def disas32(insn, pc, xlen):
+    """Disassemble a 32-bit instruction, returning (mnemonic, operands)."""
+    opcode = bits(insn, 6, 0)
+    rd = ABI[bits(insn, 11, 7)]
+    rs1 = ABI[bits(insn, 19, 15)]
+    rs2 = ABI[bits(insn, 24, 20)]
+    f3 = bits(insn, 14, 12)
+    f7 = bits(insn, 31, 25)
+    imm_i = sext(bits(insn, 31, 20), 12)
+    imm_s = sext((bits(insn, 31, 25) << 5) | bits(insn, 11, 7), 12)
+    imm_b = sext((bits(insn, 31, 31) << 12) | (bits(insn, 7, 7) << 11)
+                 | (bits(insn, 30, 25) << 5) | (bits(insn, 11, 8) << 1), 13)
+    imm_u = bits(insn, 31, 12)
+    imm_j = sext((bits(insn, 31, 31) << 20) | (bits(insn, 19, 12) << 12)
+                 | (bits(insn, 20, 20) << 11) | (bits(insn, 30, 21) << 1), 21)
+    shamt = bits(insn, 25, 20) if xlen == 64 else bits(insn, 24, 20)
+    mask = (1 << 32) - 1
+
+    if opcode == 0x37:
+        return 'lui', '%s,0x%x' % (rd, imm_u)
+    if opcode == 0x17:
+        return 'auipc', '%s,0x%x' % (rd, imm_u)
+    if opcode == 0x6f:
+        return 'jal', '%s,%x' % (rd, (pc + imm_j) & mask)
+    if opcode == 0x67 and f3 == 0:
+        return 'jalr', '%s,%d(%s)' % (rd, imm_i, rs1)
+    if opcode == 0x63:
+        ops = ['beq', 'bne', None, None, 'blt', 'bge', 'bltu', 'bgeu']
+        if ops[f3]:
+            return ops[f3], '%s,%s,%x' % (rs1, rs2, (pc + imm_b) & mask)
+    if opcode == 0x03:
+        ops = ['lb', 'lh', 'lw', 'ld', 'lbu', 'lhu', 'lwu', None]
+        if ops[f3]:
+            return ops[f3], '%s,%d(%s)' % (rd, imm_i, rs1)
+    if opcode == 0x23:
+        ops = ['sb', 'sh', 'sw', 'sd', None, None, None, None]
+        if ops[f3]:
+            return ops[f3], '%s,%d(%s)' % (rs2, imm_s, rs1)
+    if opcode == 0x13:
+        if f3 == 1:
+            return 'slli', '%s,%s,%d' % (rd, rs1, shamt)
+        if f3 == 5:
+            op = 'srai' if bits(insn, 30, 30) else 'srli'
+            return op, '%s,%s,%d' % (rd, rs1, shamt)
+        ops = ['addi', None, 'slti', 'sltiu', 'xori', None, 'ori', 'andi']
+        return ops[f3], '%s,%s,%d' % (rd, rs1, imm_i)
+    if opcode == 0x1b:
+        if f3 == 0:
+            return 'addiw', '%s,%s,%d' % (rd, rs1, imm_i)
+        if f3 == 1:
+            return 'slliw', '%s,%s,%d' % (rd, rs1, bits(insn, 24, 20))
+        if f3 == 5:
+            op = 'sraiw' if bits(insn, 30, 30) else 'srliw'
+            return op, '%s,%s,%d' % (rd, rs1, bits(insn, 24, 20))
+    if opcode == 0x33 or opcode == 0x3b:
+        if f7 == 1:
+            ops = ['mul', 'mulh', 'mulhsu', 'mulhu',
+                   'div', 'divu', 'rem', 'remu']
+        elif f7 == 0x20:
+            ops = ['sub', None, None, None, None, 'sra', None, None]
+        elif f7 == 0:
+            ops = ['add', 'sll', 'slt', 'sltu', 'xor', 'srl', 'or', 'and']
+        else:
+            ops = [None] * 8
+        op = ops[f3]
+        if op and opcode == 0x3b:
+            op = op + 'w' if op in ('add', 'sub', 'sll', 'srl', 'sra',
+                                    'mul', 'div', 'divu', 'rem',
+                                    'remu') else None
+        if op:
+            return op, '%s,%s,%s' % (rd, rs1, rs2)
+    if opcode == 0x0f:
+        return 'fence.i' if f3 == 1 else 'fence', ''
+    if opcode == 0x73:
+        if f3 == 0:
+            return {0x00000073: ('ecall', ''),
+                    0x00100073: ('ebreak', ''),
+                    0x30200073: ('mret', ''),
+                    0x10500073: ('wfi', '')}.get(insn, ('unknown', ''))
+        csr = csr_name(bits(insn, 31, 20))
+        ops = [None, 'csrrw', 'csrrs', 'csrrc',
+               None, 'csrrwi', 'csrrsi', 'csrrci']
+        if ops[f3]:
+            src = rs1 if f3 < 4 else str(bits(insn, 19, 15))
+            return ops[f3], '%s,%s,%s' % (rd, csr, src)
+
+    return 'unknown', ''
+
+
+def disas16(insn, pc, xlen):
+    """Disassemble a 16-bit instruction, returning (mnemonic, operands)."""
+    quad = bits(insn, 1, 0)
+    f3 = bits(insn, 15, 13)
+    rd = ABI[bits(insn, 11, 7)]
+    rs2 = ABI[bits(insn, 6, 2)]
+    rdp = ABI[8 + bits(insn, 4, 2)]
+    rs1p = ABI[8 + bits(insn, 9, 7)]
+    imm6 = sext((bits(insn, 12, 12) << 5) | bits(insn, 6, 2), 6)
+    mask = (1 << 32) - 1
+
+    if insn == 0:
+        return 'unknown', ''
+
+    if quad == 0:
+        lw_off = (bits(insn, 5, 5) << 6) | (bits(insn, 12, 10) << 3) \
+            | (bits(insn, 6, 6) << 2)
+        ld_off = (bits(insn, 6, 5) << 6) | (bits(insn, 12, 10) << 3)
+        if f3 == 0:
+            nzuimm = (bits(insn, 10, 7) << 6) | (bits(insn, 12, 11) << 4) \
+                | (bits(insn, 5, 5) << 3) | (bits(insn, 6, 6) << 2)
+            return 'c.addi4spn', '%s,sp,%d' % (rdp, nzuimm)
+        if f3 == 2:
+            return 'c.lw', '%s,%d(%s)' % (rdp, lw_off, rs1p)
+        if f3 == 3 and xlen == 64:
+            return 'c.ld', '%s,%d(%s)' % (rdp, ld_off, rs1p)
+        if f3 == 6:
+            return 'c.sw', '%s,%d(%s)' % (rdp, lw_off, rs1p)
+        if f3 == 7 and xlen == 64:
+            return 'c.sd', '%s,%d(%s)' % (rdp, ld_off, rs1p)
+
+    if quad == 1:
+        j_off = sext((bits(insn, 12, 12) << 11) | (bits(insn, 8, 8) << 10)
+                     | (bits(insn, 10, 9) << 8) | (bits(insn, 6, 6) << 7)
+                     | (bits(insn, 7, 7) << 6) | (bits(insn, 2, 2) << 5)
+                     | (bits(insn, 11, 11) << 4) | (bits(insn, 5, 3) << 1),
+                     12)
+        b_off = sext((bits(insn, 12, 12) << 8) | (bits(insn, 6, 5) << 6)
+                     | (bits(insn, 2, 2) << 5) | (bits(insn, 11, 10) << 3)
+                     | (bits(insn, 4, 3) << 1), 9)
+        if f3 == 0:
+            if bits(insn, 11, 7) == 0:
+                return 'c.nop', ''
+            return 'c.addi', '%s,%d' % (rd, imm6)
+        if f3 == 1:
+            if xlen == 64:
+                return 'c.addiw', '%s,%d' % (rd, imm6)
+            return 'c.jal', '%x' % ((pc + j_off) & mask)
+        if f3 == 2:
+            return 'c.li', '%s,%d' % (rd, imm6)
+        if f3 == 3:
+            if bits(insn, 11, 7) == 2:
+                imm = sext((bits(insn, 12, 12) << 9) | (bits(insn, 4, 3) << 7)
+                           | (bits(insn, 5, 5) << 6) | (bits(insn, 2, 2) << 5)
+                           | (bits(insn, 6, 6) << 4), 10)
+                return 'c.addi16sp', 'sp,%d' % imm
+            return 'c.lui', '%s,0x%x' % (rd, imm6 & 0xfffff)
+        if f3 == 4:
+            f2 = bits(insn, 11, 10)
+            shamt = (bits(insn, 12, 12) << 5) | bits(insn, 6, 2)
+            if f2 == 0:
+                return 'c.srli', '%s,%d' % (rs1p, shamt)
+            if f2 == 1:
+                return 'c.srai', '%s,%d' % (rs1p, shamt)
+            if f2 == 2:
+                return 'c.andi', '%s,%d' % (rs1p, imm6)
+            ops = ['c.sub', 'c.xor', 'c.or', 'c.and',
+                   'c.subw', 'c.addw', None, None]
+            op = ops[(bits(insn, 12, 12) << 2) | bits(insn, 6, 5)]
+            if op:
+                return op, '%s,%s' % (rs1p, rdp)
+        if f3 == 5:
+            return 'c.j', '%x' % ((pc + j_off) & mask)
+        if f3 == 6:
+            return 'c.beqz', '%s,%x' % (rs1p, (pc + b_off) & mask)
+        if f3 == 7:
+            return 'c.bnez', '%s,%x' % (rs1p, (pc + b_off) & mask)
+
+    if quad == 2:
+        if f3 == 0:
+            shamt = (bits(insn, 12, 12) << 5) | bits(insn, 6, 2)
+            return 'c.slli', '%s,%d' % (rd, shamt)
+        if f3 == 2:
+            off = (bits(insn, 3, 2) << 6) | (bits(insn, 12, 12) << 5) \
+                | (bits(insn, 6, 4) << 2)
+            return 'c.lwsp', '%s,%d(sp)' % (rd, off)
+        if f3 == 3 and xlen == 64:
+            off = (bits(insn, 4, 2) << 6) | (bits(insn, 12, 12) << 5) \
+                | (bits(insn, 6, 5) << 3)
+            return 'c.ldsp', '%s,%d(sp)' % (rd, off)
+        if f3 == 4:
+            if bits(insn, 12, 12) == 0:
+                if bits(insn, 6, 2) == 0:
+                    return 'c.jr', rd
+                return 'c.mv', '%s,%s' % (rd, rs2)
+            if bits(insn, 11, 2) == 0:
+                return 'c.ebreak', ''
+            if bits(insn, 6, 2) == 0:
+                return 'c.jalr', rd
+            return 'c.add', '%s,%s' % (rd, rs2)
+        if f3 == 6:
+            off = (bits(insn, 8, 7) << 6) | (bits(insn, 12, 9) << 2)
+            return 'c.swsp', '%s,%d(sp)' % (rs2, off)
+        if f3 == 7 and xlen == 64:
+            off = (bits(insn, 9, 7) << 6) | (bits(insn, 12, 10) << 3)
+            return 'c.sdsp', '%s,%d(sp)' % (rs2, off)
+
+    return 'unknown', ''
+
+
+def read_uleb(data, pos):
+    """Read an unsigned LEB128, returning (value, new position)."""
+    val = 0
+    shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        val |= (byte & 0x7f) << shift
+        shift += 7
+        if byte < 0x80:
+            return val, pos
+
+
+def records(data):
+    """Generate (pc, insn, length, rd, value) for each record.
+
+    rd is None if no register was written."""
+    if data[0:8] != MAGIC:
+        raise ValueError('not an instruction trace')
+    version, reg_bytes = struct.unpack_from('<HB', data, 8)
+    if version != VERSION:
+        raise ValueError('unsupported trace version %d' % version)
+
+    pos = 16
+    next_pc = 0
+    end = len(data)
+    while pos < end:
+        flags = data[pos]
+        pos += 1
+        pc = next_pc
+        if not flags & FLAG_SEQ:
+            zz, pos = read_uleb(data, pos)
+            pc = (next_pc + ((zz >> 1) ^ -(zz & 1))) & 0xffffffff
+        if flags & FLAG_COMP:
+            insn = data[pos] | (data[pos + 1] << 8)
+            length = 2
+        else:
+            insn = struct.unpack_from('<I', data, pos)[0]
+            length = 4
+        pos += length
+        next_pc = (pc + length) & 0xffffffff
+        rd = None
+        value = None
+        if flags & FLAG_WB:
+            rd = flags >> RD_SHIFT
+            value, pos = read_uleb(data, pos)
+        yield pc, insn, length, rd, value
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('trace', help='trace file, for example gdbserver.trace')
+    parser.add_argument('--summary', action='store_true',
+                        help='only count the instructions')
+    parser.add_argument('--limit', type=int, default=0,
+                        help='stop after this many instructions')
+    args = parser.parse_args()
+
+    with open(args.trace, 'rb') as f:
+        data = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+
+    xlen = data[10] * 8 if len(data) > 10 else 32
+    counts = collections.Counter()
+    total = 0
+    out = sys.stdout
+
+    try:
+        for pc, insn, length, rd, value in records(data):
+            if length == 2:
+                op, args_str = disas16(insn, pc, xlen)
+            else:
+                op, args_str = disas32(insn, pc, xlen)
+            total += 1
+            if args.summary:
+                counts[op] += 1
+            else:
+                enc = ('%04x    ' if length == 2 else '%08x') % insn
+                line = '%08x: %s  %-10s %s' % (pc, enc, op, args_str)
+                if rd is not None:
+                    line = '%-52s %s=0x%0*x' % (line, ABI[rd], xlen // 4,
+                                                value)
+                out.write(line.rstrip() + '\n')
+            if args.limit and total >= args.limit:
+                break
+    except (IndexError, struct.error):
+        sys.stderr.write('Warning: trace truncated after %d instructions\n'
+                         % total)
+    except BrokenPipeError:
+        return 0
+
+    if args.summary:
+        print('%d instructions' % total)
+        for op, n in counts.most_common(20):
+            print('  %-12s %10d  %5.1f%%' % (op, n, 100.0 * n / total))
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())